@@ -117,6 +117,7 @@ const char *const forced_keyframes_const_names[] = {
     "prev_forced_n",
     "prev_forced_t",
     "t",
+    "scene",
     NULL
 };
 
@@ -1163,8 +1164,12 @@ static void do_video_out(AVFormatContext *s,
             ost->forced_kf_index++;
             forced_keyframe = 1;
         } else if (ost->forced_keyframes_pexpr) {
+            AVDictionaryEntry *scene = av_dict_get(av_frame_get_metadata(in_picture),
+                                                   "lavfi.scene_score", NULL, 0);
             double res;
             ost->forced_keyframes_expr_const_values[FKF_T] = pts_time;
+            ost->forced_keyframes_expr_const_values[FKF_SCENE] =
+                scene ? av_strtod(scene->value, NULL) : NAN;
             res = av_expr_eval(ost->forced_keyframes_pexpr,
                                ost->forced_keyframes_expr_const_values, NULL);
             ff_dlog(NULL, "force_key_frame: n:%f n_forced:%f prev_forced_n:%f t:%f prev_forced_t:%f -> res:%f\n",
@@ -3229,6 +3234,7 @@ static int transcode_init(void)
                         ost->forced_keyframes_expr_const_values[FKF_N_FORCED] = 0;
                         ost->forced_keyframes_expr_const_values[FKF_PREV_FORCED_N] = NAN;
                         ost->forced_keyframes_expr_const_values[FKF_PREV_FORCED_T] = NAN;
+                        ost->forced_keyframes_expr_const_values[FKF_SCENE] = NAN;
 
                         // Don't parse the 'forced_keyframes' in case of 'keep-source-keyframes',
                         // parse it only for static kf timings
@@ -388,6 +388,7 @@ enum forced_keyframes_const {
     FKF_PREV_FORCED_N,
     FKF_PREV_FORCED_T,
     FKF_T,
+    FKF_SCENE,
     FKF_NB
 };
 
@@ -550,6 +551,7 @@ extern int stdin_interaction;
 extern int frame_bits_per_raw_sample;
 extern AVIOContext *progress_avio;
 extern float max_error_rate;
+extern int filter_audio_frame_size;
 extern char *videotoolbox_pixfmt;
 
 extern const AVIOInterruptCB int_cb;
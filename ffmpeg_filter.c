@@ -986,6 +986,8 @@ int configure_filtergraph(FilterGraph *fg)
     avfilter_graph_free(&fg->graph);
     if (!(fg->graph = avfilter_graph_alloc()))
         return AVERROR(ENOMEM);
+    if (filter_audio_frame_size)
+        av_opt_set_int(fg->graph, "audio_frame_size", filter_audio_frame_size, 0);
 
     if (simple) {
         OutputStream *ost = fg->outputs[0]->ost;
@@ -119,6 +119,7 @@ int qp_hist           = 0;
 int stdin_interaction = 1;
 int frame_bits_per_raw_sample = 0;
 float max_error_rate  = 2.0/3;
+int filter_audio_frame_size = 0;
 
 
 static int intra_only         = 0;
@@ -3364,6 +3365,8 @@ const OptionDef options[] = {
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_script", HAS_ARG | OPT_EXPERT,                 { .func_arg = opt_filter_complex_script },
         "read complex filtergraph description from a file", "filename" },
+    { "filter_audio_frame_size", HAS_ARG | OPT_INT | OPT_EXPERT,     { &filter_audio_frame_size },
+        "coalesce the audio entering the filtergraphs into frames of that many samples", "samples" },
     { "stats",          OPT_BOOL,                                    { &print_stats },
         "print progress report during encoding", },
     { "attach",         HAS_ARG | OPT_PERFILE | OPT_EXPERT |
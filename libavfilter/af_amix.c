@@ -34,11 +34,11 @@
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
-#include "libavutil/float_dsp.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/samplefmt.h"
 
+#include "amix.h"
 #include "audio.h"
 #include "avfilter.h"
 #include "formats.h"
@@ -152,9 +152,19 @@ static int frame_list_add_frame(FrameList *frame_list, int nb_samples, int64_t p
 }
 
 
+/* inputs are mixed in blocks of that many samples in the C version,
+ * so that the partial sums stay in the cache */
+#define MIX_BLOCK 256
+
+typedef struct ThreadData {
+    AVFrame *out;
+    int nb_src;
+    int nb_samples;
+} ThreadData;
+
 typedef struct MixContext {
     const AVClass *class;       /**< class for AVOptions */
-    AVFloatDSPContext *fdsp;
+    AMixDSPContext dsp;
 
     int nb_inputs;              /**< number of inputs */
     int active_inputs;          /**< number of input currently active */
@@ -164,12 +174,23 @@ typedef struct MixContext {
     int nb_channels;            /**< number of channels */
     int sample_rate;            /**< sample rate */
     int planar;
+    int sample_size;            /**< size of a sample of all channels in a plane */
     AVAudioFifo **fifos;        /**< audio fifo for each input */
+    AVFrame **pending;          /**< last frame of each input, not copied to its fifo */
+    int *pending_offset;        /**< samples of the pending frames already mixed */
+    uint8_t **planes;           /**< plane pointers of a pending frame written to a fifo */
     uint8_t *input_state;       /**< current state of each input */
     float *input_scale;         /**< mixing scale factor for each input */
     float scale_norm;           /**< normalization factor for all inputs */
     int64_t next_pts;           /**< calculated pts for next output frame */
     FrameList *frame_list;      /**< list of frame info for the first input */
+
+    int nb_threads;             /**< maximum number of jobs mixing a frame */
+    AVFrame **src_frames;       /**< frames mixed into the current output frame */
+    int *src_offset;            /**< byte offsets of the samples in src_frames */
+    int *src_input;             /**< input of each of src_frames */
+    float *src_scale;           /**< scale factor of each of src_frames */
+    const float **src;          /**< per job input sample pointers */
 } MixContext;
 
 #define OFFSET(x) offsetof(MixContext, x)
@@ -177,7 +198,7 @@ typedef struct MixContext {
 #define F AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption amix_options[] = {
     { "inputs", "Number of inputs.",
-            OFFSET(nb_inputs), AV_OPT_TYPE_INT, { .i64 = 2 }, 1, 32, A|F },
+            OFFSET(nb_inputs), AV_OPT_TYPE_INT, { .i64 = 2 }, 1, 1024, A|F },
     { "duration", "How to determine the end-of-stream.",
             OFFSET(duration_mode), AV_OPT_TYPE_INT, { .i64 = DURATION_LONGEST }, 0,  2, A|F, "duration" },
         { "longest",  "Duration of longest input.",  0, AV_OPT_TYPE_CONST, { .i64 = DURATION_LONGEST  }, INT_MIN, INT_MAX, A|F, "duration" },
@@ -191,6 +212,31 @@ static const AVOption amix_options[] = {
 
 AVFILTER_DEFINE_CLASS(amix);
 
+static int mix_c(float *dst, const float **src, const float *scale,
+                 int nb_src, int len)
+{
+    int i, j, k;
+
+    for (i = 0; i < len; i += MIX_BLOCK) {
+        const int n = FFMIN(len - i, MIX_BLOCK);
+
+        for (k = 0; k < n; k++)
+            dst[i + k] = src[0][i + k] * scale[0];
+        for (j = 1; j < nb_src; j++)
+            for (k = 0; k < n; k++)
+                dst[i + k] += src[j][i + k] * scale[j];
+    }
+    return len;
+}
+
+av_cold void ff_amix_init(AMixDSPContext *dsp)
+{
+    dsp->mix = mix_c;
+
+    if (ARCH_X86)
+        ff_amix_init_x86(dsp);
+}
+
 /**
  * Update the scaling factors to apply to each input during mixing.
  *
@@ -223,6 +269,8 @@ static int config_output(AVFilterLink *outlink)
     char buf[64];
 
     s->planar          = av_sample_fmt_is_planar(outlink->format);
+    s->sample_size     = av_get_bytes_per_sample(outlink->format) *
+                         (s->planar ? 1 : outlink->channels);
     s->sample_rate     = outlink->sample_rate;
     outlink->time_base = (AVRational){ 1, outlink->sample_rate };
     s->next_pts        = AV_NOPTS_VALUE;
@@ -242,6 +290,19 @@ static int config_output(AVFilterLink *outlink)
             return AVERROR(ENOMEM);
     }
 
+    s->nb_threads     = ff_filter_get_nb_threads(ctx);
+    s->pending        = av_mallocz_array(s->nb_inputs, sizeof(*s->pending));
+    s->pending_offset = av_mallocz_array(s->nb_inputs, sizeof(*s->pending_offset));
+    s->planes         = av_mallocz_array(s->nb_channels, sizeof(*s->planes));
+    s->src_frames     = av_mallocz_array(s->nb_inputs, sizeof(*s->src_frames));
+    s->src_offset     = av_mallocz_array(s->nb_inputs, sizeof(*s->src_offset));
+    s->src_input      = av_mallocz_array(s->nb_inputs, sizeof(*s->src_input));
+    s->src_scale      = av_mallocz_array(s->nb_inputs, sizeof(*s->src_scale));
+    s->src            = av_mallocz_array(s->nb_inputs * s->nb_threads, sizeof(*s->src));
+    if (!s->pending || !s->pending_offset || !s->planes || !s->src_frames ||
+        !s->src_offset || !s->src_input || !s->src_scale || !s->src)
+        return AVERROR(ENOMEM);
+
     s->input_state = av_malloc(s->nb_inputs);
     if (!s->input_state)
         return AVERROR(ENOMEM);
@@ -265,15 +326,89 @@ static int config_output(AVFilterLink *outlink)
 
 static int calc_active_inputs(MixContext *s);
 
+/**
+ * Number of samples queued on an input, in its fifo and pending frame.
+ */
+static int input_size(MixContext *s, int i)
+{
+    int size = av_audio_fifo_size(s->fifos[i]);
+
+    if (s->pending[i])
+        size += s->pending[i]->nb_samples - s->pending_offset[i];
+    return size;
+}
+
+/**
+ * Move the samples of the pending frame of an input to its fifo.
+ */
+static int flush_pending(MixContext *s, int i)
+{
+    AVFrame *frame = s->pending[i];
+    int planes = s->planar ? s->nb_channels : 1;
+    int ret, p;
+
+    if (!frame)
+        return 0;
+
+    for (p = 0; p < planes; p++)
+        s->planes[p] = frame->extended_data[p] + s->pending_offset[i] * s->sample_size;
+    ret = av_audio_fifo_write(s->fifos[i], (void **)s->planes,
+                              frame->nb_samples - s->pending_offset[i]);
+    av_frame_free(&s->pending[i]);
+
+    return ret < 0 ? ret : 0;
+}
+
+static int mix_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MixContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const float **src = s->src + jobnr * s->nb_inputs;
+    const int planes = s->planar ? s->nb_channels : 1;
+    const int len = td->nb_samples * (s->planar ? 1 : s->nb_channels);
+    int start = 0, end = len, p_start = 0, p_end = 1;
+    int p, k, n;
+
+    /* planar frames are split by channels, packed ones by samples */
+    if (s->planar) {
+        p_start = (planes *  jobnr     ) / nb_jobs;
+        p_end   = (planes * (jobnr + 1)) / nb_jobs;
+    } else {
+        start = ((int64_t)len *  jobnr     ) / nb_jobs;
+        end   = ((int64_t)len * (jobnr + 1)) / nb_jobs;
+    }
+
+    for (p = p_start; p < p_end; p++) {
+        float *dst = (float *)td->out->extended_data[p] + start;
+
+        for (k = 0; k < td->nb_src; k++)
+            src[k] = (const float *)(s->src_frames[k]->extended_data[p] +
+                                     s->src_offset[k]) + start;
+        n = s->dsp.mix(dst, src, s->src_scale, td->nb_src, end - start);
+        if (n < end - start) {
+            for (k = 0; k < td->nb_src; k++)
+                src[k] += n;
+            mix_c(dst + n, src, s->src_scale, td->nb_src, end - start - n);
+        }
+    }
+
+    return 0;
+}
+
 /**
  * Read samples from the input FIFOs, mix, and write to the output link.
+ *
+ * Inputs with an empty fifo are mixed straight from their pending frame,
+ * which is the case whenever their frames are at least as large as the ones
+ * of the first input.
  */
 static int output_frame(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     MixContext      *s = ctx->priv;
-    AVFrame *out_buf, *in_buf;
-    int nb_samples, ns, ret, i;
+    AVFrame *out_buf;
+    ThreadData td;
+    int nb_samples, ns, ret, i, k, nb_src = 0;
 
     ret = calc_active_inputs(s);
     if (ret < 0)
@@ -284,7 +419,7 @@ static int output_frame(AVFilterLink *outlink)
         nb_samples = frame_list_next_frame_size(s->frame_list);
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = input_size(s, i);
                 if (ns < nb_samples) {
                     if (!(s->input_state[i] & INPUT_EOF))
                         /* unclosed input with not enough samples */
@@ -299,7 +434,7 @@ static int output_frame(AVFilterLink *outlink)
         nb_samples = INT_MAX;
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = input_size(s, i);
                 nb_samples = FFMIN(nb_samples, ns);
             }
         }
@@ -319,31 +454,63 @@ static int output_frame(AVFilterLink *outlink)
     if (!out_buf)
         return AVERROR(ENOMEM);
 
-    in_buf = ff_get_audio_buffer(outlink, nb_samples);
-    if (!in_buf) {
-        av_frame_free(&out_buf);
-        return AVERROR(ENOMEM);
-    }
-
     for (i = 0; i < s->nb_inputs; i++) {
-        if (s->input_state[i] & INPUT_ON) {
-            int planes, plane_size, p;
+        AVFrame *frame;
+        int offset = 0;
+
+        if (!(s->input_state[i] & INPUT_ON))
+            continue;
 
-            av_audio_fifo_read(s->fifos[i], (void **)in_buf->extended_data,
+        if (!av_audio_fifo_size(s->fifos[i])) {
+            av_assert1(s->pending[i]);
+            frame  = s->pending[i];
+            offset = s->pending_offset[i];
+        } else {
+            if (av_audio_fifo_size(s->fifos[i]) < nb_samples &&
+                (ret = flush_pending(s, i)) < 0)
+                goto fail;
+            frame = ff_get_audio_buffer(outlink, nb_samples);
+            if (!frame) {
+                ret = AVERROR(ENOMEM);
+                goto fail;
+            }
+            av_audio_fifo_read(s->fifos[i], (void **)frame->extended_data,
                                nb_samples);
+        }
+        s->src_frames[nb_src] = frame;
+        s->src_offset[nb_src] = offset * s->sample_size;
+        s->src_input [nb_src] = i;
+        s->src_scale [nb_src] = s->input_scale[i];
+        nb_src++;
+    }
 
-            planes     = s->planar ? s->nb_channels : 1;
-            plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
-            plane_size = FFALIGN(plane_size, 16);
+    if (nb_src) {
+        int nb_jobs = s->planar ? s->nb_channels :
+                      FFMAX(1, nb_samples * s->nb_channels / MIX_BLOCK);
 
-            for (p = 0; p < planes; p++) {
-                s->fdsp->vector_fmac_scalar((float *)out_buf->extended_data[p],
-                                           (float *) in_buf->extended_data[p],
-                                           s->input_scale[i], plane_size);
-            }
+        td.out        = out_buf;
+        td.nb_src     = nb_src;
+        td.nb_samples = nb_samples;
+        ctx->internal->execute(ctx, mix_slice, &td, NULL,
+                               FFMIN(nb_jobs, s->nb_threads));
+    }
+    ret = 0;
+
+fail:
+    for (k = 0; k < nb_src; k++) {
+        i = s->src_input[k];
+        if (s->src_frames[k] != s->pending[i]) {
+            av_frame_free(&s->src_frames[k]);
+        } else if (!ret) {
+            s->pending_offset[i] += nb_samples;
+            if (s->pending_offset[i] == s->pending[i]->nb_samples)
+                av_frame_free(&s->pending[i]);
         }
     }
-    av_frame_free(&in_buf);
+    if (ret < 0) {
+        av_frame_free(&out_buf);
+        return ret;
+    }
 
     out_buf->pts = s->next_pts;
     if (s->next_pts != AV_NOPTS_VALUE)
@@ -366,12 +533,12 @@ static int request_samples(AVFilterContext *ctx, int min_samples)
         ret = 0;
         if (!(s->input_state[i] & INPUT_ON))
             continue;
-        if (av_audio_fifo_size(s->fifos[i]) >= min_samples)
+        if (input_size(s, i) >= min_samples)
             continue;
         ret = ff_request_frame(ctx->inputs[i]);
         if (ret == AVERROR_EOF) {
             s->input_state[i] |= INPUT_EOF;
-            if (av_audio_fifo_size(s->fifos[i]) == 0) {
+            if (input_size(s, i) == 0) {
                 s->input_state[i] = 0;
                 continue;
             }
@@ -457,10 +624,14 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
             goto fail;
     }
 
-    ret = av_audio_fifo_write(s->fifos[i], (void **)buf->extended_data,
-                              buf->nb_samples);
+    /* the frame is only copied to the fifo when the next one arrives
+     * before it was mixed */
+    ret = flush_pending(s, i);
+    if (ret < 0)
+        goto fail;
+    s->pending[i]        = buf;
+    s->pending_offset[i] = 0;
 
-    av_frame_free(&buf);
     return output_frame(outlink);
 
 fail:
@@ -488,9 +659,7 @@ static av_cold int init(AVFilterContext *ctx)
         ff_insert_inpad(ctx, i, &pad);
     }
 
-    s->fdsp = avpriv_float_dsp_alloc(0);
-    if (!s->fdsp)
-        return AVERROR(ENOMEM);
+    ff_amix_init(&s->dsp);
 
     return 0;
 }
@@ -505,11 +674,22 @@ static av_cold void uninit(AVFilterContext *ctx)
             av_audio_fifo_free(s->fifos[i]);
         av_freep(&s->fifos);
     }
+    if (s->pending) {
+        for (i = 0; i < s->nb_inputs; i++)
+            av_frame_free(&s->pending[i]);
+        av_freep(&s->pending);
+    }
+    av_freep(&s->pending_offset);
+    av_freep(&s->planes);
+    av_freep(&s->src_frames);
+    av_freep(&s->src_offset);
+    av_freep(&s->src_input);
+    av_freep(&s->src_scale);
+    av_freep(&s->src);
     frame_list_clear(s->frame_list);
     av_freep(&s->frame_list);
     av_freep(&s->input_state);
     av_freep(&s->input_scale);
-    av_freep(&s->fdsp);
 
     for (i = 0; i < ctx->nb_inputs; i++)
         av_freep(&ctx->input_pads[i].name);
@@ -561,5 +741,6 @@ AVFilter ff_af_amix = {
     .query_formats  = query_formats,
     .inputs         = NULL,
     .outputs        = avfilter_af_amix_outputs,
-    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS |
+                      AVFILTER_FLAG_SLICE_THREADS,
 };
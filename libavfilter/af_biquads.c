@@ -62,10 +62,13 @@
  *               V
  */
 
+#include "libavutil/attributes.h"
 #include "libavutil/avassert.h"
+#include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "audio.h"
 #include "avfilter.h"
+#include "biquads.h"
 #include "internal.h"
 
 enum FilterType {
@@ -112,9 +115,18 @@ typedef struct BiquadsContext {
     ChanCache *cache;
     int clippings;
 
+    /* b0, b1, b2, -a1, -a2 for the channel lanes of filter4() */
+    DECLARE_ALIGNED(32, double, coeffs4)[5][4];
+    BiquadsDSPContext dsp;
+
     void (*filter)(struct BiquadsContext *s, const void *ibuf, void *obuf, int len,
                    double *i1, double *i2, double *o1, double *o2,
                    double b0, double b1, double b2, double a1, double a2);
+    int (*filter4)(uint8_t *const *dst, const uint8_t *const *src, int len,
+                   double *state, const double *coeffs);
+    int (*filter4_c)(uint8_t *const *dst, const uint8_t *const *src, int len,
+                     double *state, const double *coeffs);
+    int sample_size;
 } BiquadsContext;
 
 static av_cold int init(AVFilterContext *ctx)
@@ -235,6 +247,107 @@ BIQUAD_FILTER(s32, int32_t, INT32_MIN, INT32_MAX, 1)
 BIQUAD_FILTER(flt, float,   -1., 1., 0)
 BIQUAD_FILTER(dbl, double,  -1., 1., 0)
 
+/* The same recursion as BIQUAD_FILTER() on 4 channels, in the same order
+ * of operations, so that the results do not depend on the lane width. */
+#define BIQUAD_FILTER4(name, type)                                            \
+static int biquad4_## name ##_c(uint8_t *const *output,                      \
+                                const uint8_t *const *input, int len,         \
+                                double *state, const double *c)               \
+{                                                                             \
+    const type *ibuf[4];                                                      \
+    type *obuf[4];                                                            \
+    double i1[4], i2[4], o1[4], o2[4];                                        \
+    int i, k;                                                                 \
+                                                                              \
+    for (k = 0; k < 4; k++) {                                                 \
+        ibuf[k] = (const type *)input[k];                                     \
+        obuf[k] = (type *)output[k];                                          \
+        i1[k] = state[k];                                                     \
+        i2[k] = state[4 + k];                                                 \
+        o1[k] = state[8 + k];                                                 \
+        o2[k] = state[12 + k];                                                \
+    }                                                                         \
+                                                                              \
+    for (i = 0; i + 1 < len; i += 2) {                                        \
+        for (k = 0; k < 4; k++) {                                             \
+            o2[k] = i2[k] * c[8 + k] + i1[k] * c[4 + k] + ibuf[k][i] * c[k] + \
+                    o2[k] * c[16 + k] + o1[k] * c[12 + k];                    \
+            i2[k] = ibuf[k][i];                                               \
+            obuf[k][i] = o2[k];                                               \
+            o1[k] = i1[k] * c[8 + k] + i2[k] * c[4 + k] +                     \
+                    ibuf[k][i + 1] * c[k] +                                   \
+                    o1[k] * c[16 + k] + o2[k] * c[12 + k];                    \
+            i1[k] = ibuf[k][i + 1];                                           \
+            obuf[k][i + 1] = o1[k];                                           \
+        }                                                                     \
+    }                                                                         \
+    if (i < len) {                                                            \
+        for (k = 0; k < 4; k++) {                                             \
+            double o0 = ibuf[k][i] * c[k] + i1[k] * c[4 + k] +                \
+                        i2[k] * c[8 + k] +                                    \
+                        o1[k] * c[12 + k] + o2[k] * c[16 + k];                \
+            i2[k] = i1[k];                                                    \
+            i1[k] = ibuf[k][i];                                               \
+            o2[k] = o1[k];                                                    \
+            o1[k] = o0;                                                       \
+            obuf[k][i] = o0;                                                  \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    for (k = 0; k < 4; k++) {                                                 \
+        state[k]      = i1[k];                                                \
+        state[4 + k]  = i2[k];                                                \
+        state[8 + k]  = o1[k];                                                \
+        state[12 + k] = o2[k];                                                \
+    }                                                                         \
+    return len;                                                               \
+}
+
+BIQUAD_FILTER4(flt, float)
+BIQUAD_FILTER4(dbl, double)
+
+av_cold void ff_biquads_init(BiquadsDSPContext *dsp)
+{
+    dsp->filter4_flt = biquad4_flt_c;
+    dsp->filter4_dbl = biquad4_dbl_c;
+
+    if (ARCH_X86)
+        ff_biquads_init_x86(dsp);
+}
+
+static void filter4(BiquadsContext *s, AVFrame *in, AVFrame *out, int ch, int len)
+{
+    double state[16];
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int k, n;
+
+    for (k = 0; k < 4; k++) {
+        state[k]      = s->cache[ch + k].i1;
+        state[4 + k]  = s->cache[ch + k].i2;
+        state[8 + k]  = s->cache[ch + k].o1;
+        state[12 + k] = s->cache[ch + k].o2;
+    }
+
+    n = s->filter4(out->extended_data + ch,
+                   (const uint8_t *const *)in->extended_data + ch,
+                   len, state, s->coeffs4[0]);
+    if (n < len) {
+        for (k = 0; k < 4; k++) {
+            src[k] = in->extended_data[ch + k]  + n * s->sample_size;
+            dst[k] = out->extended_data[ch + k] + n * s->sample_size;
+        }
+        s->filter4_c(dst, src, len - n, state, s->coeffs4[0]);
+    }
+
+    for (k = 0; k < 4; k++) {
+        s->cache[ch + k].i1 = state[k];
+        s->cache[ch + k].i2 = state[4 + k];
+        s->cache[ch + k].o1 = state[8 + k];
+        s->cache[ch + k].o2 = state[12 + k];
+    }
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     AVFilterContext *ctx    = outlink->src;
@@ -243,6 +356,7 @@ static int config_output(AVFilterLink *outlink)
     double A = exp(s->gain / 40 * log(10.));
     double w0 = 2 * M_PI * s->frequency / inlink->sample_rate;
     double alpha;
+    int k;
 
     if (w0 > M_PI) {
         av_log(ctx, AV_LOG_ERROR,
@@ -380,11 +494,31 @@ static int config_output(AVFilterLink *outlink)
         return AVERROR(ENOMEM);
     memset(s->cache, 0, sizeof(ChanCache) * inlink->channels);
 
+    for (k = 0; k < 4; k++) {
+        s->coeffs4[0][k] =  s->b0;
+        s->coeffs4[1][k] =  s->b1;
+        s->coeffs4[2][k] =  s->b2;
+        s->coeffs4[3][k] = -s->a1;
+        s->coeffs4[4][k] = -s->a2;
+    }
+
+    ff_biquads_init(&s->dsp);
+    s->filter4 = s->filter4_c = NULL;
+    s->sample_size = av_get_bytes_per_sample(inlink->format);
+
     switch (inlink->format) {
     case AV_SAMPLE_FMT_S16P: s->filter = biquad_s16; break;
     case AV_SAMPLE_FMT_S32P: s->filter = biquad_s32; break;
-    case AV_SAMPLE_FMT_FLTP: s->filter = biquad_flt; break;
-    case AV_SAMPLE_FMT_DBLP: s->filter = biquad_dbl; break;
+    case AV_SAMPLE_FMT_FLTP:
+        s->filter    = biquad_flt;
+        s->filter4   = s->dsp.filter4_flt;
+        s->filter4_c = biquad4_flt_c;
+        break;
+    case AV_SAMPLE_FMT_DBLP:
+        s->filter    = biquad_dbl;
+        s->filter4   = s->dsp.filter4_dbl;
+        s->filter4_c = biquad4_dbl_c;
+        break;
     default: av_assert0(0);
     }
 
@@ -398,7 +532,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
     AVFilterLink *outlink = ctx->outputs[0];
     AVFrame *out_buf;
     int nb_samples = buf->nb_samples;
-    int ch;
+    int channels = av_frame_get_channels(buf);
+    int ch = 0;
 
     if (av_frame_is_writable(buf)) {
         out_buf = buf;
@@ -411,7 +546,13 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
         av_frame_copy_props(out_buf, buf);
     }
 
-    for (ch = 0; ch < av_frame_get_channels(buf); ch++)
+    /* the clipping formats are filtered one channel at a time */
+    if (s->filter4) {
+        for (; ch + 4 <= channels; ch += 4)
+            filter4(s, buf, out_buf, ch, nb_samples);
+    }
+
+    for (; ch < channels; ch++)
         s->filter(s, buf->extended_data[ch],
                   out_buf->extended_data[ch], nb_samples,
                   &s->cache[ch].i1, &s->cache[ch].i2,
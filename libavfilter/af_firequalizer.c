@@ -25,10 +25,17 @@
 #include "avfilter.h"
 #include "internal.h"
 #include "audio.h"
+#include "firequalizer.h"
 
 #define RDFT_BITS_MIN 4
 #define RDFT_BITS_MAX 16
 
+/* kernels needing a single block rdft of at least 1 << PART_RDFT_BITS_MIN
+ * samples are split in partitions of 1 << (rdft_bits - PART_SPLIT_BITS)
+ * samples, the input frames being much shorter than them */
+#define PART_RDFT_BITS_MIN 15
+#define PART_SPLIT_BITS    4
+
 enum WindowFunc {
     WFUNC_MIN,
     WFUNC_RECTANGULAR = WFUNC_MIN,
@@ -52,6 +59,8 @@ typedef struct {
 typedef struct {
     int buf_idx;
     int overlap_idx;
+    int part_idx;           ///< slot of the current block in the delay line
+    int block_pos;          ///< number of samples of the current block
 } OverlapIndex;
 
 typedef struct {
@@ -68,8 +77,12 @@ typedef struct {
     float         *kernel_buf;
     float         *conv_buf;
     OverlapIndex  *conv_idx;
+    float         *fdl_buf;
     int           fir_len;
     int           nsamples_max;
+    int           part_len;
+    int           nb_parts;
+    FIREqualizerDSPContext dsp;
     int64_t       next_pts;
     int           frame_nsamples_max;
     int           remaining;
@@ -128,6 +141,7 @@ static void common_uninit(FIREqualizerContext *s)
     av_freep(&s->kernel_buf);
     av_freep(&s->conv_buf);
     av_freep(&s->conv_idx);
+    av_freep(&s->fdl_buf);
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -208,6 +222,99 @@ static void fast_convolute(FIREqualizerContext *s, const float *kernel_buf, floa
     }
 }
 
+static int fcmul_add_c(float *sum, const float *t, const float *c, int len)
+{
+    int k;
+
+    for (k = 0; k < 2 * len; k += 2) {
+        sum[k]   += t[k] * c[k]   - t[k+1] * c[k+1];
+        sum[k+1] += t[k] * c[k+1] + t[k+1] * c[k];
+    }
+    return len;
+}
+
+av_cold void ff_firequalizer_init(FIREqualizerDSPContext *dsp)
+{
+    dsp->fcmul_add = fcmul_add_c;
+
+    if (ARCH_X86)
+        ff_firequalizer_init_x86(dsp);
+}
+
+/* sum += t * c, on spectra packed by av_rdft_calc() */
+static void spectrum_mul_add(FIREqualizerContext *s, float *sum, const float *t, const float *c)
+{
+    const int len = s->rdft_len / 2 - 1;
+    int k = s->dsp.fcmul_add(sum + 2, t + 2, c + 2, len);
+
+    if (k < len)
+        fcmul_add_c(sum + 2 + 2 * k, t + 2 + 2 * k, c + 2 + 2 * k, len - k);
+    sum[0] += t[0] * c[0];
+    sum[1] += t[1] * c[1];
+}
+
+/*
+ * Uniformly partitioned convolution: the kernel is split in nb_parts
+ * partitions of part_len samples, and the input in blocks of part_len
+ * samples whose spectra are kept in a delay line. The contribution of the
+ * past blocks to the current one is accumulated once per block, so that a
+ * frame only costs the transforms of 2 * part_len samples and the product
+ * of the current block with the first partition.
+ *
+ * conv_buf holds the accumulated spectrum, the output of the block, its
+ * input samples and the overlap from the previous block.
+ */
+static void partitioned_convolute(FIREqualizerContext *s, const float *kernel_buf, float *conv_buf,
+                                  float *fdl_buf, OverlapIndex *idx, float *data, int nsamples)
+{
+    const int part_len = s->part_len;
+    float *acc = conv_buf;
+    float *obuf = conv_buf + s->rdft_len;
+    float *ibuf = conv_buf + 2 * s->rdft_len;
+    float *overlap = ibuf + part_len;
+
+    while (nsamples > 0) {
+        const int pos = idx->block_pos;
+        const int n = FFMIN(nsamples, part_len - pos);
+        float *cur = fdl_buf + idx->part_idx * s->rdft_len;
+        int k, p;
+
+        /* the block is transformed again as it fills, the later samples
+         * only contribute to the later outputs */
+        memcpy(ibuf + pos, data, n * sizeof(*data));
+        memcpy(cur, ibuf, (pos + n) * sizeof(*cur));
+        memset(cur + pos + n, 0, (s->rdft_len - pos - n) * sizeof(*cur));
+        av_rdft_calc(s->rdft, cur);
+
+        memcpy(obuf, acc, s->rdft_len * sizeof(*obuf));
+        spectrum_mul_add(s, obuf, cur, kernel_buf);
+        av_rdft_calc(s->irdft, obuf);
+
+        for (k = 0; k < n; k++)
+            data[k] = obuf[pos + k] + overlap[pos + k];
+
+        idx->block_pos += n;
+        if (idx->block_pos == part_len) {
+            memcpy(overlap, obuf + part_len, part_len * sizeof(*overlap));
+
+            memset(acc, 0, s->rdft_len * sizeof(*acc));
+            for (p = 1; p < s->nb_parts; p++) {
+                int slot = idx->part_idx - p + 1;
+                if (slot < 0)
+                    slot += s->nb_parts;
+                spectrum_mul_add(s, acc, fdl_buf + slot * s->rdft_len,
+                                 kernel_buf + p * s->rdft_len);
+            }
+
+            idx->part_idx = idx->part_idx + 1 < s->nb_parts ? idx->part_idx + 1 : 0;
+            idx->block_pos = 0;
+        }
+
+        data += n;
+        nsamples -= n;
+    }
+}
+
 static double entry_func(void *p, double freq, double gain)
 {
     AVFilterContext *ctx = p;
@@ -401,23 +508,45 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
         for (k = 1; k <= center; k++)
             s->analysis_buf[center + k] = s->analysis_buf[center - k];
 
-        memset(s->analysis_buf + s->fir_len, 0, (s->rdft_len - s->fir_len) * sizeof(*s->analysis_buf));
-        av_rdft_calc(s->rdft, s->analysis_buf);
+        if (s->nb_parts) {
+            float *kernel = s->kernel_tmp_buf + ch * s->nb_parts * s->rdft_len;
+            int p;
 
-        for (k = 0; k < s->rdft_len; k++) {
-            if (isnan(s->analysis_buf[k]) || isinf(s->analysis_buf[k])) {
-                av_log(ctx, AV_LOG_ERROR, "filter kernel contains nan or infinity.\n");
-                av_expr_free(gain_expr);
-                return AVERROR(EINVAL);
+            for (p = 0; p < s->nb_parts; p++, kernel += s->rdft_len) {
+                int len = FFMIN(s->part_len, s->fir_len - p * s->part_len);
+
+                memcpy(kernel, s->analysis_buf + p * s->part_len, len * sizeof(*kernel));
+                memset(kernel + len, 0, (s->rdft_len - len) * sizeof(*kernel));
+                av_rdft_calc(s->rdft, kernel);
+
+                for (k = 0; k < s->rdft_len; k++) {
+                    if (isnan(kernel[k]) || isinf(kernel[k])) {
+                        av_log(ctx, AV_LOG_ERROR, "filter kernel contains nan or infinity.\n");
+                        av_expr_free(gain_expr);
+                        return AVERROR(EINVAL);
+                    }
+                }
+            }
+        } else {
+            memset(s->analysis_buf + s->fir_len, 0, (s->rdft_len - s->fir_len) * sizeof(*s->analysis_buf));
+            av_rdft_calc(s->rdft, s->analysis_buf);
+
+            for (k = 0; k < s->rdft_len; k++) {
+                if (isnan(s->analysis_buf[k]) || isinf(s->analysis_buf[k])) {
+                    av_log(ctx, AV_LOG_ERROR, "filter kernel contains nan or infinity.\n");
+                    av_expr_free(gain_expr);
+                    return AVERROR(EINVAL);
+                }
             }
-        }
 
-        memcpy(s->kernel_tmp_buf + ch * s->rdft_len, s->analysis_buf, s->rdft_len * sizeof(*s->analysis_buf));
+            memcpy(s->kernel_tmp_buf + ch * s->rdft_len, s->analysis_buf, s->rdft_len * sizeof(*s->analysis_buf));
+        }
         if (!s->multi)
             break;
     }
 
-    memcpy(s->kernel_buf, s->kernel_tmp_buf, (s->multi ? inlink->channels : 1) * s->rdft_len * sizeof(*s->kernel_buf));
+    memcpy(s->kernel_buf, s->kernel_tmp_buf, (s->multi ? inlink->channels : 1) * FFMAX(s->nb_parts, 1) *
+           s->rdft_len * sizeof(*s->kernel_buf));
     av_expr_free(gain_expr);
     return 0;
 }
@@ -426,7 +555,7 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     FIREqualizerContext *s = ctx->priv;
-    int rdft_bits;
+    int rdft_bits, part_bits, kernel_len;
 
     common_uninit(s);
 
@@ -448,7 +577,18 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(EINVAL);
     }
 
-    if (!(s->rdft = av_rdft_init(rdft_bits, DFT_R2C)) || !(s->irdft = av_rdft_init(rdft_bits, IDFT_C2R)))
+    /* the blocks of the partitioned convolution are zero padded to twice
+     * the partition length */
+    part_bits = rdft_bits;
+    s->part_len = s->nb_parts = 0;
+    if (rdft_bits >= PART_RDFT_BITS_MIN) {
+        part_bits = rdft_bits - PART_SPLIT_BITS + 1;
+        s->rdft_len = 1 << part_bits;
+        s->part_len = s->nsamples_max = s->rdft_len / 2;
+        s->nb_parts = (s->fir_len + s->part_len - 1) / s->part_len;
+    }
+
+    if (!(s->rdft = av_rdft_init(part_bits, DFT_R2C)) || !(s->irdft = av_rdft_init(part_bits, IDFT_C2R)))
         return AVERROR(ENOMEM);
 
     for ( ; rdft_bits <= RDFT_BITS_MAX; rdft_bits++) {
@@ -465,16 +605,25 @@ static int config_input(AVFilterLink *inlink)
     if (!(s->analysis_irdft = av_rdft_init(rdft_bits, IDFT_C2R)))
         return AVERROR(ENOMEM);
 
+    kernel_len = s->rdft_len * FFMAX(s->nb_parts, 1);
     s->analysis_buf = av_malloc_array(s->analysis_rdft_len, sizeof(*s->analysis_buf));
-    s->kernel_tmp_buf = av_malloc_array(s->rdft_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_tmp_buf));
-    s->kernel_buf = av_malloc_array(s->rdft_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_buf));
-    s->conv_buf   = av_calloc(2 * s->rdft_len * inlink->channels, sizeof(*s->conv_buf));
+    s->kernel_tmp_buf = av_malloc_array(kernel_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_tmp_buf));
+    s->kernel_buf = av_malloc_array(kernel_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_buf));
+    s->conv_buf   = av_calloc((s->nb_parts ? 3 : 2) * s->rdft_len * inlink->channels, sizeof(*s->conv_buf));
     s->conv_idx   = av_calloc(inlink->channels, sizeof(*s->conv_idx));
     if (!s->analysis_buf || !s->kernel_tmp_buf || !s->kernel_buf || !s->conv_buf || !s->conv_idx)
         return AVERROR(ENOMEM);
 
-    av_log(ctx, AV_LOG_DEBUG, "sample_rate = %d, channels = %d, analysis_rdft_len = %d, rdft_len = %d, fir_len = %d, nsamples_max = %d.\n",
-           inlink->sample_rate, inlink->channels, s->analysis_rdft_len, s->rdft_len, s->fir_len, s->nsamples_max);
+    if (s->nb_parts) {
+        s->fdl_buf = av_calloc(kernel_len * inlink->channels, sizeof(*s->fdl_buf));
+        if (!s->fdl_buf)
+            return AVERROR(ENOMEM);
+    }
+
+    ff_firequalizer_init(&s->dsp);
+
+    av_log(ctx, AV_LOG_DEBUG, "sample_rate = %d, channels = %d, analysis_rdft_len = %d, rdft_len = %d, fir_len = %d, nsamples_max = %d, nb_parts = %d.\n",
+           inlink->sample_rate, inlink->channels, s->analysis_rdft_len, s->rdft_len, s->fir_len, s->nsamples_max, s->nb_parts);
 
     if (s->fixed)
         inlink->min_samples = inlink->max_samples = inlink->partial_buf_size = s->nsamples_max;
@@ -490,9 +639,18 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     int ch;
 
     for (ch = 0; ch < inlink->channels; ch++) {
-        fast_convolute(s, s->kernel_buf + (s->multi ? ch * s->rdft_len : 0),
-                       s->conv_buf + 2 * ch * s->rdft_len, s->conv_idx + ch,
-                       (float *) frame->extended_data[ch], frame->nb_samples);
+        if (s->nb_parts) {
+            const int kernel_len = s->nb_parts * s->rdft_len;
+
+            partitioned_convolute(s, s->kernel_buf + (s->multi ? ch * kernel_len : 0),
+                                  s->conv_buf + 3 * ch * s->rdft_len,
+                                  s->fdl_buf + ch * kernel_len, s->conv_idx + ch,
+                                  (float *) frame->extended_data[ch], frame->nb_samples);
+        } else {
+            fast_convolute(s, s->kernel_buf + (s->multi ? ch * s->rdft_len : 0),
+                           s->conv_buf + 2 * ch * s->rdft_len, s->conv_idx + ch,
+                           (float *) frame->extended_data[ch], frame->nb_samples);
+        }
     }
 
     s->next_pts = AV_NOPTS_VALUE;
@@ -24,13 +24,130 @@
 #include "avfilter.h"
 #include "internal.h"
 #include "audio.h"
+
+/* The loudness is measured by libebur128 if it is enabled, and otherwise by
+ * the internal engine shared with the ebur128 filter, which is GPL. */
+#if CONFIG_LIBEBUR128
 #include <ebur128.h>
 
+typedef struct R128State {
+    ebur128_state *st;
+} R128State;
+
+static int r128_init(R128State *r, AVFilterLink *inlink, int nb_threads)
+{
+    r->st = ebur128_init(inlink->channels, inlink->sample_rate,
+                         EBUR128_MODE_I | EBUR128_MODE_S | EBUR128_MODE_LRA |
+                         EBUR128_MODE_SAMPLE_PEAK);
+    return r->st ? 0 : AVERROR(ENOMEM);
+}
+
+static void r128_set_dual_mono(R128State *r)
+{
+    ebur128_set_channel(r->st, 0, EBUR128_DUAL_MONO);
+}
+
+static void r128_add_frames(R128State *r, AVFilterContext *ctx,
+                            const double *src, int nb_samples)
+{
+    ebur128_add_frames_double(r->st, src, nb_samples);
+}
+
+#define R128_GETTER(name, func)                     \
+static double r128_ ## name(const R128State *r)     \
+{                                                   \
+    double v;                                       \
+    func(r->st, &v);                                \
+    return v;                                       \
+}
+
+R128_GETTER(global,             ebur128_loudness_global)
+R128_GETTER(shortterm,          ebur128_loudness_shortterm)
+R128_GETTER(range,              ebur128_loudness_range)
+R128_GETTER(relative_threshold, ebur128_relative_threshold)
+
+static double r128_sample_peak(const R128State *r, int c)
+{
+    double v;
+    ebur128_sample_peak(r->st, c, &v);
+    return v;
+}
+
+static int r128_initialized(const R128State *r)
+{
+    return !!r->st;
+}
+
+static void r128_uninit(R128State *r)
+{
+    if (r->st)
+        ebur128_destroy(&r->st);
+}
+#else
+#include "ebur128.h"
+
+typedef EBUR128State R128State;
+
+static int r128_init(R128State *r, AVFilterLink *inlink, int nb_threads)
+{
+    return ff_ebur128_init(r, inlink->channels, inlink->channel_layout,
+                           inlink->sample_rate, EBUR128_FLAG_SAMPLE_PEAK,
+                           nb_threads);
+}
+
+static void r128_set_dual_mono(R128State *r)
+{
+    ff_ebur128_set_channel_weight(r, 0, 2.0);
+}
+
+static void r128_add_frames(R128State *r, AVFilterContext *ctx,
+                            const double *src, int nb_samples)
+{
+    ff_ebur128_add_frames_double(r, ctx, src, nb_samples);
+}
+
+static double r128_global(const R128State *r)
+{
+    return ff_ebur128_loudness_global(r);
+}
+
+static double r128_shortterm(const R128State *r)
+{
+    return ff_ebur128_loudness_shortterm(r);
+}
+
+static double r128_range(const R128State *r)
+{
+    return ff_ebur128_loudness_range(r, NULL, NULL);
+}
+
+static double r128_relative_threshold(const R128State *r)
+{
+    return ff_ebur128_relative_threshold(r);
+}
+
+static double r128_sample_peak(const R128State *r, int c)
+{
+    return r->sample_peaks[c];
+}
+
+static int r128_initialized(const R128State *r)
+{
+    return !!r->sample_peaks;
+}
+
+static void r128_uninit(R128State *r)
+{
+    ff_ebur128_uninit(r);
+}
+#endif
+
 enum FrameType {
     FIRST_FRAME,
     INNER_FRAME,
     FINAL_FRAME,
     LINEAR_MODE,
+    ANALYSIS_MODE,
     FRAME_NB
 };
 
@@ -61,6 +178,7 @@ typedef struct LoudNormContext {
     double offset;
     int linear;
     int dual_mono;
+    int analysis;
     enum PrintFormat print_format;
 
     double *buf;
@@ -91,8 +209,8 @@ typedef struct LoudNormContext {
     int prev_nb_samples;
     int channels;
 
-    ebur128_state *r128_in;
-    ebur128_state *r128_out;
+    R128State r128_in;
+    R128State r128_out;
 } LoudNormContext;
 
 #define OFFSET(x) offsetof(LoudNormContext, x)
@@ -115,6 +233,7 @@ static const AVOption loudnorm_options[] = {
     { "offset",           "set offset gain",                   OFFSET(offset),           AV_OPT_TYPE_DOUBLE,  {.dbl =  0.},    -99.,       99.,  FLAGS },
     { "linear",           "normalize linearly if possible",    OFFSET(linear),           AV_OPT_TYPE_BOOL,    {.i64 =  1},        0,         1,  FLAGS },
     { "dual_mono",        "treat mono input as dual-mono",     OFFSET(dual_mono),        AV_OPT_TYPE_BOOL,    {.i64 =  0},        0,         1,  FLAGS },
+    { "analysis",         "only measure the input",            OFFSET(analysis),         AV_OPT_TYPE_BOOL,    {.i64 =  0},        0,         1,  FLAGS },
     { "print_format",     "set print format for stats",        OFFSET(print_format),     AV_OPT_TYPE_INT,     {.i64 =  NONE},  NONE,  PF_NB -1,  FLAGS, "print_format" },
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, "print_format" },
     {     "json",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  JSON},     0,         0,  FLAGS, "print_format" },
@@ -418,7 +537,13 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     double *limiter_buf;
     int i, n, c, subframe_length, src_index;
     double gain, gain_next, env_global, env_shortterm,
-    global, shortterm, lra, relative_threshold;
+    global, shortterm, relative_threshold;
+
+    if (s->frame_type == ANALYSIS_MODE) {
+        r128_add_frames(&s->r128_in, ctx, (const double *)in->data[0],
+                        in->nb_samples);
+        return ff_filter_frame(outlink, in);
+    }
 
     if (av_frame_is_writable(in)) {
         out = in;
@@ -437,15 +562,14 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     buf = s->buf;
     limiter_buf = s->limiter_buf;
 
-    ebur128_add_frames_double(s->r128_in, src, in->nb_samples);
+    r128_add_frames(&s->r128_in, ctx, src, in->nb_samples);
 
     if (s->frame_type == FIRST_FRAME && in->nb_samples < frame_size(inlink->sample_rate, 3000)) {
         double offset, offset_tp, true_peak;
 
-        ebur128_loudness_global(s->r128_in, &global);
+        global = r128_global(&s->r128_in);
         for (c = 0; c < inlink->channels; c++) {
-            double tmp;
-            ebur128_sample_peak(s->r128_in, c, &tmp);
+            double tmp = r128_sample_peak(&s->r128_in, c);
             if (c == 0 || tmp > true_peak)
                 true_peak = tmp;
         }
@@ -467,7 +591,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             s->buf_index += inlink->channels;
         }
 
-        ebur128_loudness_shortterm(s->r128_in, &shortterm);
+        shortterm = r128_shortterm(&s->r128_in);
 
         if (shortterm < s->measured_thresh) {
             s->above_threshold = 0;
@@ -497,7 +621,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
         subframe_length = frame_size(inlink->sample_rate, 100);
         true_peak_limiter(s, dst, subframe_length, inlink->channels);
-        ebur128_add_frames_double(s->r128_out, dst, subframe_length);
+        r128_add_frames(&s->r128_out, ctx, dst, subframe_length);
 
         s->pts +=
         out->nb_samples =
@@ -536,12 +660,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         s->limiter_buf_index = s->limiter_buf_index + subframe_length < s->limiter_buf_size ? s->limiter_buf_index + subframe_length : s->limiter_buf_index + subframe_length - s->limiter_buf_size;
 
         true_peak_limiter(s, dst, in->nb_samples, inlink->channels);
-        ebur128_add_frames_double(s->r128_out, dst, in->nb_samples);
+        r128_add_frames(&s->r128_out, ctx, dst, in->nb_samples);
 
-        ebur128_loudness_range(s->r128_in, &lra);
-        ebur128_loudness_global(s->r128_in, &global);
-        ebur128_loudness_shortterm(s->r128_in, &shortterm);
-        ebur128_relative_threshold(s->r128_in, &relative_threshold);
+        global             = r128_global(&s->r128_in);
+        shortterm          = r128_shortterm(&s->r128_in);
+        relative_threshold = r128_relative_threshold(&s->r128_in);
 
         if (s->above_threshold == 0) {
             double shortterm_out;
@@ -549,7 +672,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             if (shortterm > s->measured_thresh)
                 s->prev_delta *= 1.0058;
 
-            ebur128_loudness_shortterm(s->r128_out, &shortterm_out);
+            shortterm_out = r128_shortterm(&s->r128_out);
             if (shortterm_out >= s->target_i)
                 s->above_threshold = 1;
         }
@@ -611,7 +734,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
 
         dst = (double *)out->data[0];
-        ebur128_add_frames_double(s->r128_out, dst, in->nb_samples);
+        r128_add_frames(&s->r128_out, ctx, dst, in->nb_samples);
         break;
 
     case LINEAR_MODE:
@@ -624,7 +747,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
 
         dst = (double *)out->data[0];
-        ebur128_add_frames_double(s->r128_out, dst, in->nb_samples);
+        r128_add_frames(&s->r128_out, ctx, dst, in->nb_samples);
         s->pts += in->nb_samples;
         break;
     }
@@ -682,6 +805,7 @@ static int request_frame(AVFilterLink *outlink)
 
 static int query_formats(AVFilterContext *ctx)
 {
+    LoudNormContext *s = ctx->priv;
     AVFilterFormats *formats;
     AVFilterChannelLayouts *layouts;
     AVFilterLink *inlink = ctx->inputs[0];
@@ -707,6 +831,14 @@ static int query_formats(AVFilterContext *ctx)
     if (ret < 0)
         return ret;
 
+    /* the analysis mode passes the input through at its own rate */
+    if (s->analysis) {
+        formats = ff_all_samplerates();
+        if (!formats)
+            return AVERROR(ENOMEM);
+        return ff_set_common_samplerates(ctx, formats);
+    }
+
     formats = ff_make_format_list(input_srate);
     if (!formats)
         return AVERROR(ENOMEM);
@@ -724,18 +856,20 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     LoudNormContext *s = ctx->priv;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    int ret;
 
-    s->r128_in = ebur128_init(inlink->channels, inlink->sample_rate, EBUR128_MODE_I | EBUR128_MODE_S | EBUR128_MODE_LRA | EBUR128_MODE_SAMPLE_PEAK);
-    if (!s->r128_in)
-        return AVERROR(ENOMEM);
+    ret = r128_init(&s->r128_in, inlink, nb_threads);
+    if (ret < 0)
+        return ret;
 
-    s->r128_out = ebur128_init(inlink->channels, inlink->sample_rate, EBUR128_MODE_I | EBUR128_MODE_S | EBUR128_MODE_LRA | EBUR128_MODE_SAMPLE_PEAK);
-    if (!s->r128_out)
-        return AVERROR(ENOMEM);
+    ret = r128_init(&s->r128_out, inlink, nb_threads);
+    if (ret < 0)
+        return ret;
 
     if (inlink->channels == 1 && s->dual_mono) {
-        ebur128_set_channel(s->r128_in,  0, EBUR128_DUAL_MONO);
-        ebur128_set_channel(s->r128_out, 0, EBUR128_DUAL_MONO);
+        r128_set_dual_mono(&s->r128_in);
+        r128_set_dual_mono(&s->r128_out);
     }
 
     s->buf_size = frame_size(inlink->sample_rate, 3000) * inlink->channels;
@@ -769,7 +903,10 @@ static int config_input(AVFilterLink *inlink)
         }
     }
 
-    if (s->frame_type != LINEAR_MODE) {
+    if (s->analysis)
+        s->frame_type = ANALYSIS_MODE;
+
+    if (s->frame_type != LINEAR_MODE && s->frame_type != ANALYSIS_MODE) {
         inlink->min_samples =
         inlink->max_samples =
         inlink->partial_buf_size = frame_size(inlink->sample_rate, 3000);
@@ -796,25 +933,27 @@ static av_cold void uninit(AVFilterContext *ctx)
     double i_in, i_out, lra_in, lra_out, thresh_in, thresh_out, tp_in, tp_out;
     int c;
 
-    if (!s->r128_in || !s->r128_out)
+    const R128State *r128_out;
+
+    if (!r128_initialized(&s->r128_in) || !r128_initialized(&s->r128_out))
         goto end;
 
-    ebur128_loudness_range(s->r128_in, &lra_in);
-    ebur128_loudness_global(s->r128_in, &i_in);
-    ebur128_relative_threshold(s->r128_in, &thresh_in);
+    lra_in    = r128_range(&s->r128_in);
+    i_in      = r128_global(&s->r128_in);
+    thresh_in = r128_relative_threshold(&s->r128_in);
     for (c = 0; c < s->channels; c++) {
-        double tmp;
-        ebur128_sample_peak(s->r128_in, c, &tmp);
+        double tmp = r128_sample_peak(&s->r128_in, c);
         if ((c == 0) || (tmp > tp_in))
             tp_in = tmp;
     }
 
-    ebur128_loudness_range(s->r128_out, &lra_out);
-    ebur128_loudness_global(s->r128_out, &i_out);
-    ebur128_relative_threshold(s->r128_out, &thresh_out);
+    /* the analysis mode passes the input through */
+    r128_out   = s->frame_type == ANALYSIS_MODE ? &s->r128_in : &s->r128_out;
+    lra_out    = r128_range(r128_out);
+    i_out      = r128_global(r128_out);
+    thresh_out = r128_relative_threshold(r128_out);
     for (c = 0; c < s->channels; c++) {
-        double tmp;
-        ebur128_sample_peak(s->r128_out, c, &tmp);
+        double tmp = r128_sample_peak(r128_out, c);
         if ((c == 0) || (tmp > tp_out))
             tp_out = tmp;
     }
@@ -845,7 +984,8 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "linear" : "dynamic",
+            s->frame_type == LINEAR_MODE   ? "linear"   :
+            s->frame_type == ANALYSIS_MODE ? "analysis" : "dynamic",
             s->target_i - i_out
         );
         break;
@@ -873,17 +1013,16 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "Linear" : "Dynamic",
+            s->frame_type == LINEAR_MODE   ? "Linear"   :
+            s->frame_type == ANALYSIS_MODE ? "Analysis" : "Dynamic",
             s->target_i - i_out
         );
         break;
     }
 
 end:
-    if (s->r128_in)
-        ebur128_destroy(&s->r128_in);
-    if (s->r128_out)
-        ebur128_destroy(&s->r128_out);
+    r128_uninit(&s->r128_in);
+    r128_uninit(&s->r128_out);
     av_freep(&s->limiter_buf);
     av_freep(&s->prev_smp);
     av_freep(&s->buf);
@@ -917,4 +1056,5 @@ AVFilter ff_af_loudnorm = {
     .uninit        = uninit,
     .inputs        = avfilter_af_loudnorm_inputs,
     .outputs       = avfilter_af_loudnorm_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -0,0 +1,37 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_AMIX_H
+#define AVFILTER_AMIX_H
+
+typedef struct AMixDSPContext {
+    /**
+     * Mix the samples of several inputs, each multiplied by its own scale
+     * factor, in a single pass over dst. The pointers need no alignment.
+     *
+     * @param nb_src number of inputs, at least 1
+     * @return number of samples written, the caller mixes the remaining ones
+     */
+    int (*mix)(float *dst, const float **src, const float *scale,
+               int nb_src, int len);
+} AMixDSPContext;
+
+void ff_amix_init(AMixDSPContext *dsp);
+void ff_amix_init_x86(AMixDSPContext *dsp);
+
+#endif /* AVFILTER_AMIX_H */
@@ -27,6 +27,7 @@
 #include "audio.h"
 #include "avfilter.h"
 #include "internal.h"
+#include "thread.h"
 
 AVFrame *ff_null_get_audio_buffer(AVFilterLink *link, int nb_samples)
 {
@@ -66,11 +67,19 @@ AVFrame *ff_get_audio_buffer(AVFilterLink *link, int nb_samples)
 {
     AVFrame *ret = NULL;
 
+    /* the jobs of a frame threaded source filter request buffers
+     * concurrently */
+    if (link->src->internal->frame_thread)
+        ff_filter_frame_thread_lock(link->src);
+
     if (link->dstpad->get_audio_buffer)
         ret = link->dstpad->get_audio_buffer(link, nb_samples);
 
     if (!ret)
         ret = ff_default_get_audio_buffer(link, nb_samples);
 
+    if (link->src->internal->frame_thread)
+        ff_filter_frame_thread_unlock(link->src);
+
     return ret;
 }
@@ -387,6 +387,13 @@ int ff_request_frame_to_filter(AVFilterLink *link)
         ret = link->srcpad->request_frame(link);
     else if (link->src->inputs[0])
         ret = ff_request_frame(link->src->inputs[0]);
+    if (ret == AVERROR_EOF && link->src->internal->frame_thread) {
+        /* send the frames still being filtered before the EOF */
+        ret = ff_filter_frame_thread_flush(link->src);
+        if (ret)
+            return FFMIN(ret, 0);
+        ret = AVERROR_EOF;
+    }
     if (ret == AVERROR_EOF && link->partial_buf) {
         AVFrame *pbuf = link->partial_buf;
         link->partial_buf = NULL;
@@ -491,6 +498,14 @@ void ff_update_link_current_pts(AVFilterLink *link, int64_t pts)
 
 int avfilter_process_command(AVFilterContext *filter, const char *cmd, const char *arg, char *res, int res_len, int flags)
 {
+    if (filter->graph && filter->graph->thread_type & AVFILTER_THREAD_FRAME) {
+        int ret = ff_filter_frame_thread_flush_inputs(filter);
+        if (ret < 0)
+            return ret;
+    }
+    if (filter->internal->frame_thread)
+        ff_filter_frame_thread_wait(filter);
+
     if(!strcmp(cmd, "ping")){
         char local_res[256] = {0};
 
@@ -615,6 +630,7 @@ static const AVOption avfilter_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .unit = "thread_type" },
+        { "frame", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FRAME }, .unit = "thread_type" },
     { "enable", "set enable expression", OFFSET(enable_str), AV_OPT_TYPE_STRING, {.str=NULL}, .flags = FLAGS },
     { "threads", "Allowed number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, FLAGS },
@@ -751,6 +767,8 @@ void avfilter_free(AVFilterContext *filter)
     if (filter->graph)
         ff_filter_graph_remove_filter(filter->graph, filter);
 
+    ff_filter_frame_thread_free(filter);
+
     if (filter->filter->uninit)
         filter->filter->uninit(filter);
 
@@ -885,7 +903,12 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         return ret;
     }
 
-    if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
+    if (ctx->filter->flags & AVFILTER_FLAG_FRAME_THREADS &&
+        ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_FRAME &&
+        ctx->nb_inputs == 1 && ctx->graph->internal->thread_execute &&
+        ff_filter_get_nb_threads(ctx) > 1) {
+        ctx->thread_type = AVFILTER_THREAD_FRAME;
+    } else if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
         ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_SLICE &&
         ctx->graph->internal->thread_execute) {
         ctx->thread_type       = AVFILTER_THREAD_SLICE;
@@ -909,6 +932,9 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
     else if (ctx->filter->init_dict)
         ret = ctx->filter->init_dict(ctx, options);
 
+    if (ret >= 0 && ctx->thread_type == AVFILTER_THREAD_FRAME)
+        ret = ff_filter_frame_thread_init(ctx);
+
     return ret;
 }
 
@@ -1064,6 +1090,9 @@ static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
     if (!(filter_frame = dst->filter_frame))
         filter_frame = default_filter_frame;
 
+    if (link->in_place && link->graph && av_frame_is_writable(frame))
+        avpriv_atomic_int_add_and_fetch(&link->graph->internal->nb_frames_in_place, 1);
+
     /* copy the frame if needed */
     if (dst->needs_writable && !av_frame_is_writable(frame)) {
         av_log(link->dst, AV_LOG_DEBUG, "Copying data in avfilter.\n");
@@ -1131,7 +1160,10 @@ static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
             (dstctx->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC))
             filter_frame = default_filter_frame;
     }
-    ret = filter_frame(link, out);
+    if (dstctx->internal->frame_thread)
+        ret = ff_filter_frame_thread_submit(link, out, filter_frame);
+    else
+        ret = filter_frame(link, out);
     link->frame_count++;
     ff_update_link_current_pts(link, pts);
     return ret;
@@ -1190,6 +1222,13 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
 {
     FF_TPRINTF_START(NULL, filter_frame); ff_tlog_link(NULL, link, 1); ff_tlog(NULL, " "); ff_tlog_ref(NULL, frame, 1);
 
+    /* frames output by frame threads are sent on by the submitting thread */
+    if (link->src->internal->frame_thread) {
+        int ret = ff_filter_frame_thread_capture(link, frame);
+        if (ret)
+            return FFMIN(ret, 0);
+    }
+
     /* Consistency checks */
     if (link->type == AVMEDIA_TYPE_VIDEO) {
         if (strcmp(link->dst->filter->name, "buffersink") &&
@@ -114,6 +114,14 @@ enum AVMediaType avfilter_pad_get_type(const AVFilterPad *pads, int pad_idx);
  * and processing them concurrently.
  */
 #define AVFILTER_FLAG_SLICE_THREADS         (1 << 2)
+/**
+ * The filter output for a frame only depends on that frame and on state set
+ * up before filtering started, so several frames can be filtered
+ * concurrently. Such filters must have a single input, must output frames
+ * only from their filter_frame() callback and must not modify their private
+ * context or read AVFilterContext.is_disabled there.
+ */
+#define AVFILTER_FLAG_FRAME_THREADS         (1 << 3)
 /**
  * Some filters support a generic "enable" expression option that can be used
  * to enable or disable a filter in the timeline. Filters supporting this
@@ -301,6 +309,14 @@ typedef struct AVFilter {
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Process multiple frames concurrently, for filters supporting it. This adds
+ * a delay of up to the number of threads frames to the filter output. Unlike
+ * AVFILTER_THREAD_SLICE, it is not allowed by default and must be set in
+ * both AVFilterGraph.thread_type and AVFilterContext.thread_type.
+ */
+#define AVFILTER_THREAD_FRAME (1 << 1)
+
 typedef struct AVFilterInternal AVFilterInternal;
 
 /** An instance of a filter */
@@ -559,6 +575,15 @@ struct AVFilterLink {
      * AVHWFramesContext describing the frames.
      */
     AVBufferRef *hw_frames_ctx;
+
+    /**
+     * True if the destination filter can process writable frames in place
+     * instead of allocating a new output buffer. May be set by the
+     * destination filter in query_formats(); filters distributing the same
+     * frame to several outputs use it to hand the last reference to such a
+     * filter.
+     */
+    int in_place;
 };
 
 /**
@@ -840,6 +865,16 @@ typedef struct AVFilterGraph {
 
     char *aresample_swr_opts; ///< swr options to use for the auto-inserted aresample filters, Access ONLY through AVOptions
 
+    /**
+     * Number of samples per frame the audio is coalesced into after the
+     * buffer sources, unless the filter they feed sets its own frame size.
+     * Larger frames reduce the per-frame overhead of long audio chains,
+     * at the cost of latency. 0 (the default) leaves the frames as they
+     * are sent. Must be set before avfilter_graph_config().
+     * Access ONLY through AVOptions.
+     */
+    int audio_frame_size;
+
     /**
      * Private fields
      *
@@ -1119,6 +1154,26 @@ char *avfilter_graph_dump(AVFilterGraph *graph, const char *options);
  */
 int avfilter_graph_request_oldest(AVFilterGraph *graph);
 
+/**
+ * Get the statistics of the video frame pools shared by the links of a
+ * graph, since the graph was allocated.
+ *
+ * The buffer allocations avoided by the pools are nb_requested minus
+ * nb_allocated. Any of the pointers may be NULL.
+ *
+ * @param graph        the graph
+ * @param nb_requested set to the number of video buffers requested from the
+ *                     pools
+ * @param nb_allocated set to the number of video buffers the pools had to
+ *                     allocate
+ * @param nb_in_place  set to the number of frames that reached a filter able
+ *                     to process them in place (see AVFilterLink.in_place)
+ *                     while writable
+ */
+void avfilter_graph_get_frame_pool_stats(AVFilterGraph *graph,
+                                         int *nb_requested, int *nb_allocated,
+                                         int *nb_in_place);
+
 /**
  * @}
  */
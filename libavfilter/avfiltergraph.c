@@ -24,6 +24,7 @@
 
 #include <string.h>
 
+#include "libavutil/atomic.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/bprint.h"
@@ -31,24 +32,42 @@
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
 
 #include "avfilter.h"
 #include "formats.h"
+#include "framepool.h"
 #include "internal.h"
 #include "thread.h"
 
+#define MAX_FRAME_POOLS 16
+
+typedef struct FFGraphFramePools {
+    /* one pool per distinct configuration, least recently used first */
+    FFVideoFramePool *pools[MAX_FRAME_POOLS];
+    int nb_pools;
+    AVMutex lock;
+
+    /* buffer counts of the pools that were already released */
+    int nb_requested;
+    int nb_allocated;
+} FFGraphFramePools;
+
 #define OFFSET(x) offsetof(AVFilterGraph, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "frame", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FRAME }, .flags = FLAGS, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads),
         AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, FLAGS },
     {"scale_sws_opts"       , "default scale filter options"        , OFFSET(scale_sws_opts)        ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, FLAGS },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, FLAGS },
+    { "audio_frame_size", "number of samples per frame audio is coalesced into after the sources", OFFSET(audio_frame_size),
+        AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, FLAGS },
     { NULL },
 };
 
@@ -71,6 +90,48 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_filter_frame_thread_init(AVFilterContext *ctx)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_filter_frame_thread_free(AVFilterContext *ctx)
+{
+}
+
+int ff_filter_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                  int (*filter_frame)(AVFilterLink *, AVFrame *))
+{
+    return filter_frame(link, frame);
+}
+
+int ff_filter_frame_thread_capture(AVFilterLink *link, AVFrame *frame)
+{
+    return 0;
+}
+
+void ff_filter_frame_thread_lock(AVFilterContext *ctx)
+{
+}
+
+void ff_filter_frame_thread_unlock(AVFilterContext *ctx)
+{
+}
+
+int ff_filter_frame_thread_flush(AVFilterContext *ctx)
+{
+    return 0;
+}
+
+int ff_filter_frame_thread_flush_inputs(AVFilterContext *ctx)
+{
+    return 0;
+}
+
+void ff_filter_frame_thread_wait(AVFilterContext *ctx)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -85,6 +146,15 @@ AVFilterGraph *avfilter_graph_alloc(void)
         return NULL;
     }
 
+    ret->internal->frame_pools = av_mallocz(sizeof(*ret->internal->frame_pools));
+    if (!ret->internal->frame_pools ||
+        ff_mutex_init(&ret->internal->frame_pools->lock, NULL)) {
+        av_freep(&ret->internal->frame_pools);
+        av_freep(&ret->internal);
+        av_freep(&ret);
+        return NULL;
+    }
+
     ret->av_class = &filtergraph_class;
     av_opt_set_defaults(ret);
 
@@ -109,6 +179,113 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
     }
 }
 
+static void frame_pools_release(FFGraphFramePools *fp, int idx)
+{
+    int nb_requested, nb_allocated;
+
+    if (ff_video_frame_pool_get_stats(fp->pools[idx], &nb_requested,
+                                      &nb_allocated) >= 0) {
+        fp->nb_requested += nb_requested;
+        fp->nb_allocated += nb_allocated;
+    }
+    ff_video_frame_pool_uninit(&fp->pools[idx]);
+    memmove(fp->pools + idx, fp->pools + idx + 1,
+            (fp->nb_pools - idx - 1) * sizeof(*fp->pools));
+    fp->nb_pools--;
+}
+
+void avfilter_graph_get_frame_pool_stats(AVFilterGraph *graph,
+                                         int *nb_requested, int *nb_allocated,
+                                         int *nb_in_place)
+{
+    FFGraphFramePools *fp = graph->internal->frame_pools;
+    int requested, allocated, i;
+
+    ff_mutex_lock(&fp->lock);
+    requested = fp->nb_requested;
+    allocated = fp->nb_allocated;
+    for (i = 0; i < fp->nb_pools; i++) {
+        int pool_requested, pool_allocated;
+
+        if (ff_video_frame_pool_get_stats(fp->pools[i], &pool_requested,
+                                          &pool_allocated) >= 0) {
+            requested += pool_requested;
+            allocated += pool_allocated;
+        }
+    }
+    ff_mutex_unlock(&fp->lock);
+
+    if (nb_requested)
+        *nb_requested = requested;
+    if (nb_allocated)
+        *nb_allocated = allocated;
+    if (nb_in_place)
+        *nb_in_place = avpriv_atomic_int_get(&graph->internal->nb_frames_in_place);
+}
+
+static void frame_pools_free(AVFilterGraph *graph)
+{
+    FFGraphFramePools *fp = graph->internal->frame_pools;
+    int nb_requested, nb_allocated, nb_in_place;
+
+    avfilter_graph_get_frame_pool_stats(graph, &nb_requested, &nb_allocated,
+                                        &nb_in_place);
+    if (nb_requested || nb_in_place)
+        av_log(graph, AV_LOG_VERBOSE,
+               "Frame pools: %d buffers requested, %d allocated, "
+               "%d frames processed in place\n",
+               nb_requested, nb_allocated, nb_in_place);
+
+    while (fp->nb_pools)
+        frame_pools_release(fp, 0);
+
+    ff_mutex_destroy(&fp->lock);
+    av_freep(&graph->internal->frame_pools);
+}
+
+AVFrame *ff_filter_graph_get_video_buffer(AVFilterGraph *graph, int w, int h,
+                                          enum AVPixelFormat format, int align)
+{
+    FFGraphFramePools *fp = graph->internal->frame_pools;
+    FFVideoFramePool *pool = NULL;
+    AVFrame *frame = NULL;
+    int i;
+
+    ff_mutex_lock(&fp->lock);
+
+    for (i = fp->nb_pools - 1; i >= 0; i--) {
+        int pool_w, pool_h, pool_align;
+        enum AVPixelFormat pool_format;
+
+        if (ff_video_frame_pool_get_config(fp->pools[i], &pool_w, &pool_h,
+                                           &pool_format, &pool_align) < 0)
+            continue;
+        if (pool_w == w && pool_h == h &&
+            pool_format == format && pool_align == align) {
+            pool = fp->pools[i];
+            memmove(fp->pools + i, fp->pools + i + 1,
+                    (fp->nb_pools - i - 1) * sizeof(*fp->pools));
+            fp->pools[fp->nb_pools - 1] = pool;
+            break;
+        }
+    }
+
+    if (!pool) {
+        if (fp->nb_pools == MAX_FRAME_POOLS)
+            frame_pools_release(fp, 0);
+        pool = ff_video_frame_pool_init(av_buffer_allocz, w, h, format, align);
+        if (pool)
+            fp->pools[fp->nb_pools++] = pool;
+    }
+
+    if (pool)
+        frame = ff_video_frame_pool_get(pool);
+
+    ff_mutex_unlock(&fp->lock);
+
+    return frame;
+}
+
 void avfilter_graph_free(AVFilterGraph **graph)
 {
     if (!*graph)
@@ -118,6 +295,7 @@ void avfilter_graph_free(AVFilterGraph **graph)
         avfilter_free((*graph)->filters[0]);
 
     ff_graph_thread_free(*graph);
+    frame_pools_free(*graph);
 
     av_freep(&(*graph)->sink_links);
 
@@ -1214,6 +1392,52 @@ static int graph_config_pointers(AVFilterGraph *graph,
     return 0;
 }
 
+/**
+ * Mark the links whose destination can work in place. Filters may set
+ * in_place themselves in query_formats(), inputs that require writable
+ * frames always are.
+ */
+static void graph_config_in_place(AVFilterGraph *graph)
+{
+    int i, j;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        for (j = 0; j < f->nb_inputs; j++)
+            if (f->inputs[j]->dstpad->needs_writable)
+                f->inputs[j]->in_place = 1;
+    }
+}
+
+/**
+ * Make the links leaving the audio buffer sources coalesce the frames into
+ * frames of audio_frame_size samples, unless their destination already
+ * requires a frame size of its own. The frames are split again only by the
+ * filters and sinks that set a smaller size on their inputs.
+ */
+static void graph_config_audio_framing(AVFilterGraph *graph)
+{
+    int i;
+
+    if (!graph->audio_frame_size)
+        return;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+        AVFilterLink *link;
+
+        if (strcmp(f->filter->name, "abuffer") || !f->nb_outputs)
+            continue;
+        link = f->outputs[0];
+        if (link->min_samples)
+            continue;
+        link->min_samples      =
+        link->max_samples      =
+        link->partial_buf_size = graph->audio_frame_size;
+    }
+}
+
 static int graph_insert_fifos(AVFilterGraph *graph, AVClass *log_ctx)
 {
     AVFilterContext *f;
@@ -1262,8 +1486,10 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_formats(graphctx, log_ctx)))
         return ret;
+    graph_config_in_place(graphctx);
     if ((ret = graph_config_links(graphctx, log_ctx)))
         return ret;
+    graph_config_audio_framing(graphctx);
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
 
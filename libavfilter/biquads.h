@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_BIQUADS_H
+#define AVFILTER_BIQUADS_H
+
+#include <stdint.h>
+
+typedef struct BiquadsDSPContext {
+    /**
+     * Filter 4 planar channels with the same coefficients, one channel per
+     * lane of the vectors. The results are the same as filtering the
+     * channels one by one.
+     *
+     * @param dst    output planes, of floats or doubles
+     * @param src    input planes, may be equal to dst
+     * @param state  i1, i2, o1 and o2 of the 4 channels, as 4 arrays of 4
+     * @param coeffs b0, b1, b2, -a1 and -a2, each repeated 4 times
+     * @return number of samples filtered, the caller filters the remaining
+     *         ones starting from the updated state
+     */
+    int (*filter4_flt)(uint8_t *const *dst, const uint8_t *const *src, int len,
+                       double *state, const double *coeffs);
+    int (*filter4_dbl)(uint8_t *const *dst, const uint8_t *const *src, int len,
+                       double *state, const double *coeffs);
+} BiquadsDSPContext;
+
+void ff_biquads_init(BiquadsDSPContext *dsp);
+void ff_biquads_init_x86(BiquadsDSPContext *dsp);
+
+#endif /* AVFILTER_BIQUADS_H */
@@ -0,0 +1,41 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_BOXBLUR_H
+#define AVFILTER_BOXBLUR_H
+
+#include <stdint.h>
+
+typedef struct BoxBlurDSPContext {
+    /**
+     * Move the running sums of a row of columns down by one row:
+     * sum[i] += (add[i] - sub[i]) * inv and dst[i] = sum[i] >> 16, in
+     * wrapping 32-bit arithmetic.
+     *
+     * @return number of samples processed, the caller handles the remaining ones
+     */
+    int (*blur_row8)(uint32_t *sum, uint8_t *dst, const uint8_t *add,
+                     const uint8_t *sub, int inv, int width);
+    int (*blur_row16)(uint32_t *sum, uint16_t *dst, const uint16_t *add,
+                      const uint16_t *sub, int inv, int width);
+} BoxBlurDSPContext;
+
+void ff_boxblur_init(BoxBlurDSPContext *dsp);
+void ff_boxblur_init_x86(BoxBlurDSPContext *dsp);
+
+#endif /* AVFILTER_BOXBLUR_H */
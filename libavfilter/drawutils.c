@@ -21,6 +21,7 @@
 
 #include <string.h>
 
+#include "config.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
 #include "libavutil/colorspace.h"
@@ -173,6 +174,53 @@ void ff_copy_rectangle(uint8_t *dst[4], int dst_linesize[4],
     }
 }
 
+static int blend_mask_row_1x1_c(uint8_t *dst, const uint8_t *mask,
+                                ptrdiff_t mask_linesize,
+                                const uint8_t *color, unsigned alpha, int w)
+{
+    unsigned src = color[0];
+    int x;
+
+    for (x = 0; x < w; x++) {
+        unsigned a = mask[x] * alpha;
+        dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24;
+    }
+    return w;
+}
+
+static int blend_mask_row_2x2_c(uint8_t *dst, const uint8_t *mask,
+                                ptrdiff_t mask_linesize,
+                                const uint8_t *color, unsigned alpha, int w)
+{
+    const uint8_t *mask2 = mask + mask_linesize;
+    unsigned src = color[0];
+    int x;
+
+    for (x = 0; x < w; x++) {
+        unsigned a = ((mask[2 * x] + mask[2 * x + 1] +
+                       mask2[2 * x] + mask2[2 * x + 1]) >> 2) * alpha;
+        dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24;
+    }
+    return w;
+}
+
+static int blend_mask_row_2x2_uv_c(uint8_t *dst, const uint8_t *mask,
+                                   ptrdiff_t mask_linesize,
+                                   const uint8_t *color, unsigned alpha, int w)
+{
+    const uint8_t *mask2 = mask + mask_linesize;
+    unsigned u = color[0], v = color[1];
+    int x;
+
+    for (x = 0; x < w; x++) {
+        unsigned a = ((mask[2 * x] + mask[2 * x + 1] +
+                       mask2[2 * x] + mask2[2 * x + 1]) >> 2) * alpha;
+        dst[2 * x    ] = ((0x1010101 - a) * dst[2 * x    ] + a * u) >> 24;
+        dst[2 * x + 1] = ((0x1010101 - a) * dst[2 * x + 1] + a * v) >> 24;
+    }
+    return w;
+}
+
 int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
@@ -218,6 +266,21 @@ int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags)
     for (i = 0; i < (desc->nb_components - !!(desc->flags & AV_PIX_FMT_FLAG_ALPHA && !(flags & FF_DRAW_PROCESS_ALPHA))); i++)
         draw->comp_mask[desc->comp[i].plane] |=
             1 << desc->comp[i].offset;
+    if (desc->comp[0].depth == 8) {
+        for (i = 0; i < nb_planes; i++) {
+            /* only planes whose components are all blended */
+            if (draw->comp_mask[i] != (1 << pixelstep[i]) - 1)
+                continue;
+            if (pixelstep[i] == 1 && !draw->hsub[i] && !draw->vsub[i])
+                draw->blend_mask_row[i] = blend_mask_row_1x1_c;
+            else if (pixelstep[i] == 1 && draw->hsub[i] == 1 && draw->vsub[i] == 1)
+                draw->blend_mask_row[i] = blend_mask_row_2x2_c;
+            else if (pixelstep[i] == 2 && draw->hsub[i] == 1 && draw->vsub[i] == 1)
+                draw->blend_mask_row[i] = blend_mask_row_2x2_uv_c;
+        }
+        if (ARCH_X86)
+            ff_draw_init_x86(draw);
+    }
     return 0;
 }
 
@@ -609,6 +672,41 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
                     right, hband, hsub + vsub, xm);
 }
 
+/**
+ * Blend the rows of a plane made of full subsampling blocks with the
+ * blend_mask_row function of the plane, for a 8 bits mask.
+ */
+static void blend_mask_rows(FFDrawContext *draw, FFDrawColor *color,
+                            unsigned plane, uint8_t *p, int linesize,
+                            const uint8_t *m, int mask_linesize,
+                            int w, int h, int xm, int left, int right,
+                            unsigned alpha)
+{
+    const unsigned hsub = draw->hsub[plane], vsub = draw->vsub[plane];
+    const int step = draw->pixelstep[plane];
+    const int xm_row = xm + left;
+    uint8_t *row = p + (left ? step : 0);
+    int y, n, comp;
+
+    for (y = 0; y < h; y++) {
+        n = draw->blend_mask_row[plane](row, m + xm_row, mask_linesize,
+                                        color->comp[plane].u8, alpha, w);
+        for (comp = 0; comp < step; comp++) {
+            if (left)
+                blend_line_hv(p + comp, step, color->comp[plane].u8[comp], alpha,
+                              m, mask_linesize, 3, 0, hsub, vsub,
+                              xm, left, 0, 1 << vsub);
+            blend_line_hv(row + n * step + comp, step,
+                          color->comp[plane].u8[comp], alpha,
+                          m, mask_linesize, 3, w - n, hsub, vsub,
+                          xm_row + (n << hsub), 0, right, 1 << vsub);
+        }
+        p   += linesize;
+        row += linesize;
+        m   += mask_linesize << vsub;
+    }
+}
+
 void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                    uint8_t *dst[], int dst_linesize[], int dst_w, int dst_h,
                    const uint8_t *mask,  int mask_linesize, int mask_w, int mask_h,
@@ -618,6 +716,8 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
     int xm0, ym0, w_sub, h_sub, x_sub, y_sub, left, right, top, bottom, y;
     uint8_t *p0, *p;
     const uint8_t *m;
+    int (*row_fn)(uint8_t *dst, const uint8_t *mask, ptrdiff_t mask_linesize,
+                  const uint8_t *color, unsigned alpha, int w);
 
     clip_interval(dst_w, &x0, &mask_w, &xm0);
     clip_interval(dst_h, &y0, &mask_h, &ym0);
@@ -642,6 +742,12 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
         y_sub = y0;
         subsampling_bounds(draw->hsub[plane], &x_sub, &w_sub, &left, &right);
         subsampling_bounds(draw->vsub[plane], &y_sub, &h_sub, &top, &bottom);
+        row_fn = l2depth == 3 ? draw->blend_mask_row[plane] : NULL;
+        if (row_fn)
+            blend_mask_rows(draw, color, plane,
+                            p0 + (top ? dst_linesize[plane] : 0), dst_linesize[plane],
+                            mask + top * mask_linesize, mask_linesize,
+                            w_sub, h_sub, xm0, left, right, alpha);
         for (comp = 0; comp < nb_comp; comp++) {
             const int depth = draw->desc->comp[comp].depth;
 
@@ -666,7 +772,11 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                 p += dst_linesize[plane];
                 m += top * mask_linesize;
             }
-            if (depth <= 8) {
+            if (row_fn) {
+                /* the whole plane is blended by blend_mask_rows() */
+                p += h_sub * dst_linesize[plane];
+                m += (mask_linesize << draw->vsub[plane]) * h_sub;
+            } else if (depth <= 8) {
                 for (y = 0; y < h_sub; y++) {
                     blend_line_hv(p, draw->pixelstep[plane],
                                   color->comp[plane].u8[comp], alpha,
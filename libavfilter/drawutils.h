@@ -24,6 +24,7 @@
  * misc drawing utilities
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include "avfilter.h"
 #include "libavutil/pixfmt.h"
@@ -56,6 +57,20 @@ typedef struct FFDrawContext {
     uint8_t hsub_max;
     uint8_t vsub_max;
     unsigned flags;
+
+    /**
+     * Blend color into w pixels of one row of a plane of 8 bits components,
+     * weighted by a 8 bits mask times alpha as ff_blend_mask() does.
+     * Subsampled planes average the mask block at mask and
+     * mask + mask_linesize; interleaved planes blend all their components
+     * from color.
+     *
+     * @return the number of pixels blended, the caller blends the rest
+     */
+    int (*blend_mask_row[MAX_PLANES])(uint8_t *dst, const uint8_t *mask,
+                                      ptrdiff_t mask_linesize,
+                                      const uint8_t *color, unsigned alpha,
+                                      int w);
 } FFDrawContext;
 
 typedef struct FFDrawColor {
@@ -82,6 +97,8 @@ typedef struct FFDrawColor {
  */
 int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags);
 
+void ff_draw_init_x86(FFDrawContext *draw);
+
 /**
  * Prepare a color.
  */
@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2012 Clément Bœsch
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * @file
+ * EBU R128 loudness measurement, as specified by ITU-R BS.1770 and EBU 3342
+ *
+ * The K-weighted energies are summed over blocks of 100ms, from which the
+ * momentary (400ms) and short-term (3s) windows, overlapping by 75% and
+ * 96.7% as the specifications require, are computed.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/ffmath.h"
+#include "libavutil/mem.h"
+#include "ebur128.h"
+#include "internal.h"
+
+/* pre-filter coefficients at 48kHz, from BS.1770 */
+#define PRE_B0  1.53512485958697
+#define PRE_B1 -2.69169618940638
+#define PRE_B2  1.19839281085285
+#define PRE_A1 -1.69065929318241
+#define PRE_A2  0.73248077421585
+
+/* RLB-filter coefficients at 48kHz, b0 and b2 are 1.0 at all rates */
+#define RLB_B1 -2.0
+#define RLB_A1 -1.99004745483398
+#define RLB_A2  0.99007225036621
+
+#define I_GATE_THRES   -10      ///< relative gate of the integrated loudness, in LU
+#define LRA_GATE_THRES -20      ///< relative gate of the loudness range, in LU
+#define LRA_LOWER_PRC   10
+#define LRA_HIGHER_PRC  95
+
+#define ENERGY(loudness) (ff_exp10(((loudness) + 0.691) / 10.))
+#define LOUDNESS(energy) (-0.691 + 10 * log10(energy))
+#define HIST_LOUDNESS(i) ((i) / (double)EBUR128_HIST_GRAIN + EBUR128_ABS_THRES)
+#define HIST_POS(loudness) av_clip((int)(((loudness) - EBUR128_ABS_THRES) * EBUR128_HIST_GRAIN), \
+                                   0, EBUR128_HIST_SIZE - 1)
+
+#define BACK_MASK (AV_CH_BACK_LEFT    |AV_CH_BACK_CENTER    |AV_CH_BACK_RIGHT| \
+                   AV_CH_TOP_BACK_LEFT|AV_CH_TOP_BACK_CENTER|AV_CH_TOP_BACK_RIGHT| \
+                   AV_CH_SIDE_LEFT                          |AV_CH_SIDE_RIGHT| \
+                   AV_CH_SURROUND_DIRECT_LEFT               |AV_CH_SURROUND_DIRECT_RIGHT)
+
+/**
+ * K-weight one channel, its filter memories and energy being the first of
+ * the pairs of kweight2().
+ */
+static void kweight_c(const double *src, ptrdiff_t stride, int nb_samples,
+                      double *state, double *energy, const double *c)
+{
+    double x1 = state[0], x2 = state[2];
+    double y1 = state[4], y2 = state[6];
+    double z1 = state[8], z2 = state[10];
+    double sum = 0;
+    int i;
+
+    for (i = 0; i < nb_samples; i++) {
+        const double x0 = src[i * stride];
+        /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
+        const double y0 = x0 * c[0] + x1 * c[2] + x2 * c[4] - y1 * c[6] - y2 * c[8];
+        const double z0 = y0 + y1 * c[10] + y2 - z1 * c[12] - z2 * c[14];
+
+        sum += z0 * z0;
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        z2 = z1;
+        z1 = z0;
+    }
+
+    state[0] = x1; state[2] = x2;
+    state[4] = y1; state[6] = y2;
+    state[8] = z1; state[10] = z2;
+    *energy += sum;
+}
+
+static void kweight2_c(const double *src, ptrdiff_t stride, int nb_samples,
+                       double *state, double *energy, const double *c)
+{
+    double x1[2] = { state[0], state[1] }, x2[2] = { state[2],  state[3]  };
+    double y1[2] = { state[4], state[5] }, y2[2] = { state[6],  state[7]  };
+    double z1[2] = { state[8], state[9] }, z2[2] = { state[10], state[11] };
+    double sum[2] = { 0 };
+    int i, k;
+
+    /* the two channels are independent chains, which the CPU can overlap */
+    for (i = 0; i < nb_samples; i++) {
+        for (k = 0; k < 2; k++) {
+            const double x0 = src[i * stride + k];
+            const double y0 = x0 * c[0] + x1[k] * c[2] + x2[k] * c[4] - y1[k] * c[6] - y2[k] * c[8];
+            const double z0 = y0 + y1[k] * c[10] + y2[k] - z1[k] * c[12] - z2[k] * c[14];
+
+            sum[k] += z0 * z0;
+            x2[k] = x1[k];
+            x1[k] = x0;
+            y2[k] = y1[k];
+            y1[k] = y0;
+            z2[k] = z1[k];
+            z1[k] = z0;
+        }
+    }
+
+    for (k = 0; k < 2; k++) {
+        state[0 + k] = x1[k]; state[2 + k]  = x2[k];
+        state[4 + k] = y1[k]; state[6 + k]  = y2[k];
+        state[8 + k] = z1[k]; state[10 + k] = z2[k];
+        energy[k] += sum[k];
+    }
+}
+
+av_cold void ff_ebur128_dsp_init(EBUR128DSPContext *dsp)
+{
+    dsp->kweight2 = kweight2_c;
+
+    if (ARCH_X86)
+        ff_ebur128_dsp_init_x86(dsp);
+}
+
+static void init_coeffs(EBUR128State *st)
+{
+    double c[8];
+    int i;
+
+    if (st->sample_rate == 48000) {
+        c[0] = PRE_B0; c[1] = PRE_B1; c[2] = PRE_B2; c[3] = PRE_A1; c[4] = PRE_A2;
+        c[5] = RLB_B1; c[6] = RLB_A1; c[7] = RLB_A2;
+    } else {
+        /* the analog prototypes of the two filters, bilinear transformed */
+        const double f0 = 1681.974450955533, Q = 0.7071752369554196;
+        const double G  = 3.999843853973347;
+        const double K  = tan(M_PI * f0 / st->sample_rate);
+        const double Vh = pow(10.0, G / 20.0);
+        const double Vb = pow(Vh, 0.4996667741545416);
+        const double a0 = 1.0 + K / Q + K * K;
+        const double rlb_f0 = 38.13547087602444, rlb_Q = 0.5003270373238773;
+        const double rlb_K  = tan(M_PI * rlb_f0 / st->sample_rate);
+        const double rlb_a0 = 1.0 + rlb_K / rlb_Q + rlb_K * rlb_K;
+
+        c[0] = (Vh + Vb * K / Q + K * K) / a0;
+        c[1] = 2.0 * (K * K - Vh) / a0;
+        c[2] = (Vh - Vb * K / Q + K * K) / a0;
+        c[3] = 2.0 * (K * K - 1.0) / a0;
+        c[4] = (1.0 - K / Q + K * K) / a0;
+        c[5] = RLB_B1;
+        c[6] = 2.0 * (rlb_K * rlb_K - 1.0) / rlb_a0;
+        c[7] = (1.0 - rlb_K / rlb_Q + rlb_K * rlb_K) / rlb_a0;
+    }
+
+    for (i = 0; i < 8; i++)
+        st->coeffs[i][0] = st->coeffs[i][1] = c[i];
+}
+
+int ff_ebur128_init(EBUR128State *st, int channels, uint64_t channel_layout,
+                    int sample_rate, int flags, int nb_threads)
+{
+    const int pairs = (channels + 1) / 2;
+    int i;
+
+    memset(st, 0, sizeof(*st));
+    st->channels    = channels;
+    st->sample_rate = sample_rate;
+    st->flags       = flags;
+    st->block_size  = FFMAX(1, (sample_rate + 5) / 10);
+    st->nb_jobs     = av_clip(nb_threads, 1, pairs);
+
+    if (av_get_channel_layout_nb_channels(channel_layout) != channels)
+        channel_layout = av_get_default_channel_layout(channels);
+
+    st->weights      = av_malloc_array(channels, sizeof(*st->weights));
+    st->state        = av_calloc(pairs, 12 * sizeof(*st->state));
+    st->energy       = av_calloc(pairs * 2, sizeof(*st->energy));
+    st->sample_peaks = av_calloc(channels, sizeof(*st->sample_peaks));
+    st->gate400.histogram  = av_calloc(EBUR128_HIST_SIZE, sizeof(*st->gate400.histogram));
+    st->gate3000.histogram = av_calloc(EBUR128_HIST_SIZE, sizeof(*st->gate3000.histogram));
+    st->hist_energy  = av_malloc_array(EBUR128_HIST_SIZE, sizeof(*st->hist_energy));
+    if (!st->weights || !st->state || !st->energy || !st->sample_peaks ||
+        !st->gate400.histogram || !st->gate3000.histogram || !st->hist_energy) {
+        ff_ebur128_uninit(st);
+        return AVERROR(ENOMEM);
+    }
+
+    for (i = 0; i < channels; i++) {
+        const uint64_t chl = av_channel_layout_extract_channel(channel_layout, i);
+
+        if (chl & (AV_CH_LOW_FREQUENCY | AV_CH_LOW_FREQUENCY_2))
+            st->weights[i] = 0;
+        else if (chl & BACK_MASK)
+            st->weights[i] = 1.41;
+        else
+            st->weights[i] = 1.0;
+    }
+
+    for (i = 0; i < EBUR128_HIST_SIZE; i++)
+        st->hist_energy[i] = ENERGY(HIST_LOUDNESS(i));
+
+    init_coeffs(st);
+    ff_ebur128_dsp_init(&st->dsp);
+
+    return 0;
+}
+
+void ff_ebur128_set_channel_weight(EBUR128State *st, int channel, double weight)
+{
+    if (channel >= 0 && channel < st->channels)
+        st->weights[channel] = weight;
+}
+
+static int kweight_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    EBUR128State *st = arg;
+    const int channels = st->channels;
+    const int pairs = (channels + 1) / 2;
+    const int start = (pairs *  jobnr     ) / nb_jobs;
+    const int end   = (pairs * (jobnr + 1)) / nb_jobs;
+    const double *src = st->src;
+    int p, i, ch;
+
+    for (p = start; p < end; p++) {
+        double *state  = st->state  + p * 12;
+        double *energy = st->energy + p * 2;
+
+        ch = 2 * p;
+        /* LFE channels are not measured */
+        if (ch + 1 < channels && st->weights[ch] && st->weights[ch + 1]) {
+            st->dsp.kweight2(src + ch, channels, st->nb_samples, state, energy,
+                             st->coeffs[0]);
+        } else {
+            if (st->weights[ch])
+                kweight_c(src + ch, channels, st->nb_samples, state, energy,
+                          st->coeffs[0]);
+            if (ch + 1 < channels && st->weights[ch + 1])
+                kweight_c(src + ch + 1, channels, st->nb_samples, state + 1,
+                          energy + 1, st->coeffs[0]);
+        }
+
+        if (st->flags & EBUR128_FLAG_SAMPLE_PEAK) {
+            for (; ch < FFMIN(2 * p + 2, channels); ch++) {
+                double peak = st->sample_peaks[ch];
+
+                for (i = 0; i < st->nb_samples; i++)
+                    peak = FFMAX(peak, fabs(src[i * channels + ch]));
+                st->sample_peaks[ch] = peak;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void gate_add(EBUR128Gate *gate, double power, double loudness)
+{
+    gate->histogram[HIST_POS(loudness)]++;
+    gate->sum_kept_powers += power;
+    gate->nb_kept_powers++;
+}
+
+/**
+ * @return power of the last nb_blocks completed blocks, 1e-12 if there
+ *         are not that many blocks yet
+ */
+static double window_power(const EBUR128State *st, int nb_blocks)
+{
+    double sum = 0;
+    int i;
+
+    if (st->nb_blocks < nb_blocks)
+        return 1e-12;
+    for (i = 1; i <= nb_blocks; i++)
+        sum += st->blocks[(st->nb_blocks - i) % EBUR128_SHORTTERM_BLOCKS];
+    return 1e-12 + sum / ((double)nb_blocks * st->block_size);
+}
+
+static void block_complete(EBUR128State *st)
+{
+    double energy = 0, power, loudness;
+    int ch;
+
+    for (ch = 0; ch < st->channels; ch++) {
+        energy += st->weights[ch] * st->energy[ch];
+        st->energy[ch] = 0;
+    }
+    st->blocks[st->nb_blocks % EBUR128_SHORTTERM_BLOCKS] = energy;
+    st->nb_blocks++;
+
+    /* the gating blocks overlap by 75% for the integrated loudness
+     * (BS.1770-2 p5), and are the short-term windows every 100ms for the
+     * loudness range */
+    if (st->nb_blocks >= EBUR128_MOMENTARY_BLOCKS) {
+        power    = window_power(st, EBUR128_MOMENTARY_BLOCKS);
+        loudness = LOUDNESS(power);
+        if (loudness >= EBUR128_ABS_THRES)
+            gate_add(&st->gate400, power, loudness);
+    }
+    if (st->nb_blocks >= EBUR128_SHORTTERM_BLOCKS) {
+        power    = window_power(st, EBUR128_SHORTTERM_BLOCKS);
+        loudness = LOUDNESS(power);
+        /* XXX: example code in EBU 3342 is ">=" but formula in BS.1770
+         * specs is ">" */
+        if (loudness >= EBUR128_ABS_THRES)
+            gate_add(&st->gate3000, power, loudness);
+    }
+}
+
+void ff_ebur128_add_frames_double(EBUR128State *st, AVFilterContext *ctx,
+                                  const double *src, int nb_samples)
+{
+    while (nb_samples > 0) {
+        const int n = FFMIN(nb_samples, st->block_size - st->block_pos);
+
+        st->src        = src;
+        st->nb_samples = n;
+        if (ctx && st->nb_jobs > 1)
+            ctx->internal->execute(ctx, kweight_slice, st, NULL, st->nb_jobs);
+        else
+            kweight_slice(NULL, st, 0, 1);
+        st->src = NULL;
+
+        src          += n * st->channels;
+        nb_samples   -= n;
+        st->block_pos += n;
+        if (st->block_pos == st->block_size) {
+            block_complete(st);
+            st->block_pos = 0;
+        }
+    }
+}
+
+double ff_ebur128_loudness_momentary(const EBUR128State *st)
+{
+    return LOUDNESS(window_power(st, EBUR128_MOMENTARY_BLOCKS));
+}
+
+double ff_ebur128_loudness_shortterm(const EBUR128State *st)
+{
+    return LOUDNESS(window_power(st, EBUR128_SHORTTERM_BLOCKS));
+}
+
+/**
+ * @return histogram position of the relative gate of a gate
+ */
+static int gate_position(const EBUR128Gate *gate, int gate_thres)
+{
+    double relative_threshold = gate->sum_kept_powers / gate->nb_kept_powers;
+
+    if (!relative_threshold)
+        relative_threshold = 1e-12;
+    return HIST_POS(LOUDNESS(relative_threshold) + gate_thres);
+}
+
+static double gate_threshold(const EBUR128Gate *gate, int gate_thres)
+{
+    double relative_threshold;
+
+    if (!gate->nb_kept_powers)
+        return EBUR128_ABS_THRES;
+    relative_threshold = gate->sum_kept_powers / gate->nb_kept_powers;
+    if (!relative_threshold)
+        relative_threshold = 1e-12;
+    return LOUDNESS(relative_threshold) + gate_thres;
+}
+
+double ff_ebur128_loudness_global(const EBUR128State *st)
+{
+    const EBUR128Gate *gate = &st->gate400;
+    double integrated_sum = 0;
+    int nb_integrated = 0;
+    int i;
+
+    if (!gate->nb_kept_powers)
+        return EBUR128_ABS_THRES;
+
+    /* sum the histogram values above the relative threshold */
+    for (i = gate_position(gate, I_GATE_THRES); i < EBUR128_HIST_SIZE; i++) {
+        const int nb_v = gate->histogram[i];
+        nb_integrated  += nb_v;
+        integrated_sum += nb_v * st->hist_energy[i];
+    }
+    if (!nb_integrated)
+        return EBUR128_ABS_THRES;
+    return LOUDNESS(integrated_sum / nb_integrated);
+}
+
+double ff_ebur128_relative_threshold(const EBUR128State *st)
+{
+    return gate_threshold(&st->gate400, I_GATE_THRES);
+}
+
+double ff_ebur128_loudness_range(const EBUR128State *st, double *low, double *high)
+{
+    const EBUR128Gate *gate = &st->gate3000;
+    double lra_low = 0, lra_high = 0;
+    int nb_powers = 0, gate_hist_pos, i, n, nb_pow;
+
+    if (gate->nb_kept_powers) {
+        gate_hist_pos = gate_position(gate, LRA_GATE_THRES);
+        for (i = gate_hist_pos; i < EBUR128_HIST_SIZE; i++)
+            nb_powers += gate->histogram[i];
+    }
+
+    if (nb_powers) {
+        /* get lower loudness to consider */
+        n = 0;
+        nb_pow = LRA_LOWER_PRC  * nb_powers / 100. + 0.5;
+        for (i = gate_hist_pos; i < EBUR128_HIST_SIZE; i++) {
+            n += gate->histogram[i];
+            if (n >= nb_pow) {
+                lra_low = HIST_LOUDNESS(i);
+                break;
+            }
+        }
+
+        /* get higher loudness to consider */
+        n = nb_powers;
+        nb_pow = LRA_HIGHER_PRC * nb_powers / 100. + 0.5;
+        for (i = EBUR128_HIST_SIZE - 1; i >= 0; i--) {
+            n -= gate->histogram[i];
+            if (n < nb_pow) {
+                lra_high = HIST_LOUDNESS(i);
+                break;
+            }
+        }
+    }
+
+    if (low)
+        *low = lra_low;
+    if (high)
+        *high = lra_high;
+    return lra_high - lra_low;
+}
+
+double ff_ebur128_range_threshold(const EBUR128State *st)
+{
+    return gate_threshold(&st->gate3000, LRA_GATE_THRES);
+}
+
+void ff_ebur128_uninit(EBUR128State *st)
+{
+    av_freep(&st->weights);
+    av_freep(&st->state);
+    av_freep(&st->energy);
+    av_freep(&st->sample_peaks);
+    av_freep(&st->gate400.histogram);
+    av_freep(&st->gate3000.histogram);
+    av_freep(&st->hist_energy);
+}
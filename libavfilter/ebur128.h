@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2012 Clément Bœsch
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_EBUR128_H
+#define AVFILTER_EBUR128_H
+
+/**
+ * @file
+ * EBU R128 loudness measurement shared by the ebur128 and loudnorm filters
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/mem.h"
+#include "avfilter.h"
+
+#define EBUR128_ABS_THRES   -70     ///< silence gate: blocks below this loudness (LUFS) are ignored
+#define EBUR128_ABS_UP_THRES 10     ///< upper loudness of the histograms
+#define EBUR128_HIST_GRAIN  100     ///< number of histogram entries per LU
+#define EBUR128_HIST_SIZE   ((EBUR128_ABS_UP_THRES - EBUR128_ABS_THRES) * EBUR128_HIST_GRAIN + 1)
+
+#define EBUR128_MOMENTARY_BLOCKS  4 ///< number of 100ms blocks of the momentary window
+#define EBUR128_SHORTTERM_BLOCKS 30 ///< number of 100ms blocks of the short-term window
+
+/** measure the sample peak of each channel */
+#define EBUR128_FLAG_SAMPLE_PEAK 1
+
+typedef struct EBUR128DSPContext {
+    /**
+     * K-weight the samples of two adjacent channels of interleaved audio and
+     * add the sums of their squares to the energies of the two channels.
+     *
+     * The filters must be evaluated in the order of the C version, so that
+     * all versions are bit-exact.
+     *
+     * @param src    first sample of the first of the two channels
+     * @param stride distance between two samples of a channel, in samples
+     * @param state  memories of the filters, x[-1], x[-2], y[-1], y[-2],
+     *               z[-1], z[-2], each as a pair of the two channels
+     * @param energy energies of the two channels
+     * @param coeffs b0, b1, b2, a1, a2 of the pre-filter, then b1, a1, a2 of
+     *               the RLB filter, each duplicated, 16 byte aligned
+     */
+    void (*kweight2)(const double *src, ptrdiff_t stride, int nb_samples,
+                     double *state, double *energy, const double *coeffs);
+} EBUR128DSPContext;
+
+/**
+ * Histogram of the loudnesses of the gating blocks of one length, from
+ * EBUR128_ABS_THRES to EBUR128_ABS_UP_THRES with an accuracy of
+ * 1/EBUR128_HIST_GRAIN LU, which avoids keeping a growing list of blocks.
+ */
+typedef struct EBUR128Gate {
+    int *histogram;                 ///< number of blocks of each loudness
+    double sum_kept_powers;         ///< sum of the powers of the blocks above the silence gate
+    int nb_kept_powers;             ///< number of blocks above the silence gate
+} EBUR128Gate;
+
+typedef struct EBUR128State {
+    int channels;
+    int sample_rate;
+    int flags;
+    int block_size;                 ///< number of samples of a 100ms block
+    int block_pos;                  ///< samples of the current block already measured
+    int64_t nb_blocks;              ///< number of completed blocks
+
+    double *weights;                ///< weight of each channel
+    double *state;                  ///< filter memories of each pair of channels
+    double *energy;                 ///< energy of each channel in the current block
+    double *sample_peaks;           ///< sample peak of each channel
+    double blocks[EBUR128_SHORTTERM_BLOCKS]; ///< weighted energies of the last blocks
+    DECLARE_ALIGNED(16, double, coeffs)[8][2];
+
+    EBUR128Gate gate400;            ///< 400ms blocks, for the integrated loudness
+    EBUR128Gate gate3000;           ///< 3s blocks, for the loudness range
+    double *hist_energy;            ///< energy of the loudness of each histogram entry
+
+    EBUR128DSPContext dsp;
+    int nb_jobs;
+    const double *src;              ///< samples being measured by the jobs
+    int nb_samples;
+} EBUR128State;
+
+/**
+ * Initialize a loudness measurement.
+ *
+ * @param channel_layout layout giving the channel weights, the default
+ *                       layout of the channel count if 0
+ * @param flags          EBUR128_FLAG_*
+ * @param nb_threads     maximum number of slice jobs measuring a frame
+ */
+int ff_ebur128_init(EBUR128State *st, int channels, uint64_t channel_layout,
+                    int sample_rate, int flags, int nb_threads);
+
+/**
+ * Set the weight of a channel, 2.0 to measure a mono channel as dual mono.
+ */
+void ff_ebur128_set_channel_weight(EBUR128State *st, int channel, double weight);
+
+/**
+ * Measure interleaved samples, with the slice threads of ctx if not NULL.
+ * The channels are filtered in parallel by pairs.
+ */
+void ff_ebur128_add_frames_double(EBUR128State *st, AVFilterContext *ctx,
+                                  const double *src, int nb_samples);
+
+/**
+ * @return loudness of the last 400ms in LUFS, measured at the end of the
+ *         last completed block
+ */
+double ff_ebur128_loudness_momentary(const EBUR128State *st);
+
+/**
+ * @return loudness of the last 3s in LUFS, measured at the end of the last
+ *         completed block
+ */
+double ff_ebur128_loudness_shortterm(const EBUR128State *st);
+
+/**
+ * @return integrated loudness in LUFS
+ */
+double ff_ebur128_loudness_global(const EBUR128State *st);
+
+/**
+ * @return relative gate of the integrated loudness in LUFS
+ */
+double ff_ebur128_relative_threshold(const EBUR128State *st);
+
+/**
+ * @param low  if not NULL, set to the low end of the range in LUFS
+ * @param high if not NULL, set to the high end of the range in LUFS
+ * @return loudness range in LU
+ */
+double ff_ebur128_loudness_range(const EBUR128State *st, double *low, double *high);
+
+/**
+ * @return relative gate of the loudness range in LUFS
+ */
+double ff_ebur128_range_threshold(const EBUR128State *st);
+
+void ff_ebur128_uninit(EBUR128State *st);
+
+void ff_ebur128_dsp_init(EBUR128DSPContext *dsp);
+void ff_ebur128_dsp_init_x86(EBUR128DSPContext *dsp);
+
+#endif /* AVFILTER_EBUR128_H */
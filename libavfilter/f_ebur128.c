@@ -33,60 +33,17 @@
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/dict.h"
-#include "libavutil/ffmath.h"
 #include "libavutil/xga_font_data.h"
 #include "libavutil/opt.h"
 #include "libavutil/timestamp.h"
 #include "libswresample/swresample.h"
 #include "audio.h"
 #include "avfilter.h"
+#include "ebur128.h"
 #include "formats.h"
 #include "internal.h"
 
-#define MAX_CHANNELS 63
-
-/* pre-filter coefficients */
-#define PRE_B0  1.53512485958697
-#define PRE_B1 -2.69169618940638
-#define PRE_B2  1.19839281085285
-#define PRE_A1 -1.69065929318241
-#define PRE_A2  0.73248077421585
-
-/* RLB-filter coefficients */
-#define RLB_B0  1.0
-#define RLB_B1 -2.0
-#define RLB_B2  1.0
-#define RLB_A1 -1.99004745483398
-#define RLB_A2  0.99007225036621
-
-#define ABS_THRES    -70            ///< silence gate: we discard anything below this absolute (LUFS) threshold
-#define ABS_UP_THRES  10            ///< upper loud limit to consider (ABS_THRES being the minimum)
-#define HIST_GRAIN   100            ///< defines histogram precision
-#define HIST_SIZE  ((ABS_UP_THRES - ABS_THRES) * HIST_GRAIN + 1)
-
-/**
- * A histogram is an array of HIST_SIZE hist_entry storing all the energies
- * recorded (with an accuracy of 1/HIST_GRAIN) of the loudnesses from ABS_THRES
- * (at 0) to ABS_UP_THRES (at HIST_SIZE-1).
- * This fixed-size system avoids the need of a list of energies growing
- * infinitely over the time and is thus more scalable.
- */
-struct hist_entry {
-    int count;                      ///< how many times the corresponding value occurred
-    double energy;                  ///< E = 10^((L + 0.691) / 10)
-    double loudness;                ///< L = -0.691 + 10 * log10(E)
-};
-
-struct integrator {
-    double *cache[MAX_CHANNELS];    ///< window of filtered samples (N ms)
-    int cache_pos;                  ///< focus on the last added bin in the cache array
-    double sum[MAX_CHANNELS];       ///< sum of the last N ms filtered samples (cache content)
-    int filled;                     ///< 1 if the cache is completely filled, 0 otherwise
-    double rel_threshold;           ///< relative threshold
-    double sum_kept_powers;         ///< sum of the powers (weighted sums) above absolute threshold
-    int nb_kept_powers;             ///< number of sum above absolute threshold
-    struct hist_entry *histogram;   ///< histogram of the powers, used to compute LRA and I
-};
+#define ABS_THRES EBUR128_ABS_THRES ///< silence gate: we discard anything below this absolute (LUFS) threshold
 
 struct rect { int x, y, w, h; };
 
@@ -96,7 +53,7 @@ typedef struct {
     /* peak metering */
     int peak_mode;                  ///< enabled peak modes
     double *true_peaks;             ///< true peaks per channel
-    double *sample_peaks;           ///< sample peaks per channel
+    double *sample_peaks;           ///< sample peaks per channel, measured by r128
     double *true_peaks_per_frame;   ///< true peaks in a frame per channel
 #if CONFIG_SWRESAMPLE
     SwrContext *swr_ctx;            ///< over-sampling context for true peak metering
@@ -118,19 +75,7 @@ typedef struct {
 
     /* audio */
     int nb_channels;                ///< number of channels in the input
-    double *ch_weighting;           ///< channel weighting mapping
-    int sample_count;               ///< sample count used for refresh frequency, reset at refresh
-
-    /* Filter caches.
-     * The mult by 3 in the following is for X[i], X[i-1] and X[i-2] */
-    double x[MAX_CHANNELS * 3];     ///< 3 input samples cache for each channel
-    double y[MAX_CHANNELS * 3];     ///< 3 pre-filter samples cache for each channel
-    double z[MAX_CHANNELS * 3];     ///< 3 RLB-filter samples cache for each channel
-
-#define I400_BINS  (48000 * 4 / 10)
-#define I3000_BINS (48000 * 3)
-    struct integrator i400;         ///< 400ms integrator, used for Momentary loudness  (M), and Integrated loudness (I)
-    struct integrator i3000;        ///<    3s integrator, used for Short term loudness (S), and Loudness Range      (LRA)
+    EBUR128State r128;              ///< K-weighting and gating of the loudness measurement
 
     /* I and LRA specific */
     double integrated_loudness;     ///< integrated loudness in LUFS (I)
@@ -365,41 +310,20 @@ static int config_audio_input(AVFilterLink *inlink)
 
 static int config_audio_output(AVFilterLink *outlink)
 {
-    int i;
     AVFilterContext *ctx = outlink->src;
     EBUR128Context *ebur128 = ctx->priv;
     const int nb_channels = av_get_channel_layout_nb_channels(outlink->channel_layout);
+    int ret;
 
-#define BACK_MASK (AV_CH_BACK_LEFT    |AV_CH_BACK_CENTER    |AV_CH_BACK_RIGHT| \
-                   AV_CH_TOP_BACK_LEFT|AV_CH_TOP_BACK_CENTER|AV_CH_TOP_BACK_RIGHT| \
-                   AV_CH_SIDE_LEFT                          |AV_CH_SIDE_RIGHT| \
-                   AV_CH_SURROUND_DIRECT_LEFT               |AV_CH_SURROUND_DIRECT_RIGHT)
-
-    ebur128->nb_channels  = nb_channels;
-    ebur128->ch_weighting = av_calloc(nb_channels, sizeof(*ebur128->ch_weighting));
-    if (!ebur128->ch_weighting)
-        return AVERROR(ENOMEM);
-
-    for (i = 0; i < nb_channels; i++) {
-        /* channel weighting */
-        const uint16_t chl = av_channel_layout_extract_channel(outlink->channel_layout, i);
-        if (chl & (AV_CH_LOW_FREQUENCY|AV_CH_LOW_FREQUENCY_2)) {
-            ebur128->ch_weighting[i] = 0;
-        } else if (chl & BACK_MASK) {
-            ebur128->ch_weighting[i] = 1.41;
-        } else {
-            ebur128->ch_weighting[i] = 1.0;
-        }
-
-        if (!ebur128->ch_weighting[i])
-            continue;
-
-        /* bins buffer for the two integration window (400ms and 3s) */
-        ebur128->i400.cache[i]  = av_calloc(I400_BINS,  sizeof(*ebur128->i400.cache[0]));
-        ebur128->i3000.cache[i] = av_calloc(I3000_BINS, sizeof(*ebur128->i3000.cache[0]));
-        if (!ebur128->i400.cache[i] || !ebur128->i3000.cache[i])
-            return AVERROR(ENOMEM);
-    }
+    ebur128->nb_channels = nb_channels;
+    ff_ebur128_uninit(&ebur128->r128);
+    ret = ff_ebur128_init(&ebur128->r128, nb_channels, outlink->channel_layout,
+                          outlink->sample_rate,
+                          ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS ?
+                          EBUR128_FLAG_SAMPLE_PEAK : 0,
+                          ff_filter_get_nb_threads(ctx));
+    if (ret < 0)
+        return ret;
 
 #if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS) {
@@ -427,33 +351,14 @@ static int config_audio_output(AVFilterLink *outlink)
     }
 #endif
 
-    if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
-        ebur128->sample_peaks = av_calloc(nb_channels, sizeof(*ebur128->sample_peaks));
-        if (!ebur128->sample_peaks)
-            return AVERROR(ENOMEM);
-    }
+    if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
+        ebur128->sample_peaks = ebur128->r128.sample_peaks;
 
     return 0;
 }
 
-#define ENERGY(loudness) (ff_exp10(((loudness) + 0.691) / 10.))
-#define LOUDNESS(energy) (-0.691 + 10 * log10(energy))
 #define DBFS(energy) (20 * log10(energy))
 
-static struct hist_entry *get_histogram(void)
-{
-    int i;
-    struct hist_entry *h = av_calloc(HIST_SIZE, sizeof(*h));
-
-    if (!h)
-        return NULL;
-    for (i = 0; i < HIST_SIZE; i++) {
-        h[i].loudness = i / (double)HIST_GRAIN + ABS_THRES;
-        h[i].energy   = ENERGY(h[i].loudness);
-    }
-    return h;
-}
-
 static av_cold int init(AVFilterContext *ctx)
 {
     EBUR128Context *ebur128 = ctx->priv;
@@ -477,11 +382,6 @@ static av_cold int init(AVFilterContext *ctx)
     // if meter is +18 scale, scale range is from -36 LU to +18 LU (or 3*18)
     ebur128->scale_range = 3 * ebur128->meter;
 
-    ebur128->i400.histogram  = get_histogram();
-    ebur128->i3000.histogram = get_histogram();
-    if (!ebur128->i400.histogram || !ebur128->i3000.histogram)
-        return AVERROR(ENOMEM);
-
     ebur128->integrated_loudness = ABS_THRES;
     ebur128->loudness_range = 0;
 
@@ -511,36 +411,9 @@ static av_cold int init(AVFilterContext *ctx)
     return 0;
 }
 
-#define HIST_POS(power) (int)(((power) - ABS_THRES) * HIST_GRAIN)
-
-/* loudness and power should be set such as loudness = -0.691 +
- * 10*log10(power), we just avoid doing that calculus two times */
-static int gate_update(struct integrator *integ, double power,
-                       double loudness, int gate_thres)
-{
-    int ipower;
-    double relative_threshold;
-    int gate_hist_pos;
-
-    /* update powers histograms by incrementing current power count */
-    ipower = av_clip(HIST_POS(loudness), 0, HIST_SIZE - 1);
-    integ->histogram[ipower].count++;
-
-    /* compute relative threshold and get its position in the histogram */
-    integ->sum_kept_powers += power;
-    integ->nb_kept_powers++;
-    relative_threshold = integ->sum_kept_powers / integ->nb_kept_powers;
-    if (!relative_threshold)
-        relative_threshold = 1e-12;
-    integ->rel_threshold = LOUDNESS(relative_threshold) + gate_thres;
-    gate_hist_pos = av_clip(HIST_POS(integ->rel_threshold), 0, HIST_SIZE - 1);
-
-    return gate_hist_pos;
-}
-
 static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
 {
-    int i, ch, idx_insample;
+    int ch, idx_insample;
     AVFilterContext *ctx = inlink->dst;
     EBUR128Context *ebur128 = ctx->priv;
     const int nb_channels = ebur128->nb_channels;
@@ -568,154 +441,39 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     }
 #endif
 
-    for (idx_insample = 0; idx_insample < nb_samples; idx_insample++) {
-        const int bin_id_400  = ebur128->i400.cache_pos;
-        const int bin_id_3000 = ebur128->i3000.cache_pos;
-
-#define MOVE_TO_NEXT_CACHED_ENTRY(time) do {                \
-    ebur128->i##time.cache_pos++;                           \
-    if (ebur128->i##time.cache_pos == I##time##_BINS) {     \
-        ebur128->i##time.filled    = 1;                     \
-        ebur128->i##time.cache_pos = 0;                     \
-    }                                                       \
-} while (0)
-
-        MOVE_TO_NEXT_CACHED_ENTRY(400);
-        MOVE_TO_NEXT_CACHED_ENTRY(3000);
-
-        for (ch = 0; ch < nb_channels; ch++) {
-            double bin;
-
-            if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
-                ebur128->sample_peaks[ch] = FFMAX(ebur128->sample_peaks[ch], fabs(*samples));
-
-            ebur128->x[ch * 3] = *samples++; // set X[i]
-
-            if (!ebur128->ch_weighting[ch])
-                continue;
+    for (idx_insample = 0; idx_insample < nb_samples; ) {
+        EBUR128State *r128 = &ebur128->r128;
+        const int n = FFMIN(nb_samples - idx_insample, r128->block_size - r128->block_pos);
 
-            /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
-#define FILTER(Y, X, name) do {                                                 \
-            double *dst = ebur128->Y + ch*3;                                    \
-            double *src = ebur128->X + ch*3;                                    \
-            dst[2] = dst[1];                                                    \
-            dst[1] = dst[0];                                                    \
-            dst[0] = src[0]*name##_B0 + src[1]*name##_B1 + src[2]*name##_B2     \
-                                      - dst[1]*name##_A1 - dst[2]*name##_A2;    \
-} while (0)
-
-            // TODO: merge both filters in one?
-            FILTER(y, x, PRE);  // apply pre-filter
-            ebur128->x[ch * 3 + 2] = ebur128->x[ch * 3 + 1];
-            ebur128->x[ch * 3 + 1] = ebur128->x[ch * 3    ];
-            FILTER(z, y, RLB);  // apply RLB-filter
-
-            bin = ebur128->z[ch * 3] * ebur128->z[ch * 3];
-
-            /* add the new value, and limit the sum to the cache size (400ms or 3s)
-             * by removing the oldest one */
-            ebur128->i400.sum [ch] = ebur128->i400.sum [ch] + bin - ebur128->i400.cache [ch][bin_id_400];
-            ebur128->i3000.sum[ch] = ebur128->i3000.sum[ch] + bin - ebur128->i3000.cache[ch][bin_id_3000];
-
-            /* override old cache entry with the new value */
-            ebur128->i400.cache [ch][bin_id_400 ] = bin;
-            ebur128->i3000.cache[ch][bin_id_3000] = bin;
-        }
+        ff_ebur128_add_frames_double(r128, ctx, samples + idx_insample * nb_channels, n);
+        idx_insample += n;
 
         /* For integrated loudness, gating blocks are 400ms long with 75%
          * overlap (see BS.1770-2 p5), so a re-computation is needed each 100ms
          * (4800 samples at 48kHz). */
-        if (++ebur128->sample_count == 4800) {
+        if (!r128->block_pos) {
             double loudness_400, loudness_3000;
-            double power_400 = 1e-12, power_3000 = 1e-12;
             AVFilterLink *outlink = ctx->outputs[0];
             const int64_t pts = insamples->pts +
-                av_rescale_q(idx_insample, (AVRational){ 1, inlink->sample_rate },
+                av_rescale_q(idx_insample - 1, (AVRational){ 1, inlink->sample_rate },
                              outlink->time_base);
 
-            ebur128->sample_count = 0;
-
-#define COMPUTE_LOUDNESS(m, time) do {                                              \
-    if (ebur128->i##time.filled) {                                                  \
-        /* weighting sum of the last <time> ms */                                   \
-        for (ch = 0; ch < nb_channels; ch++)                                        \
-            power_##time += ebur128->ch_weighting[ch] * ebur128->i##time.sum[ch];   \
-        power_##time /= I##time##_BINS;                                             \
-    }                                                                               \
-    loudness_##time = LOUDNESS(power_##time);                                       \
-} while (0)
-
-            COMPUTE_LOUDNESS(M,  400);
-            COMPUTE_LOUDNESS(S, 3000);
+            loudness_400  = ff_ebur128_loudness_momentary(r128);
+            loudness_3000 = ff_ebur128_loudness_shortterm(r128);
 
             /* Integrated loudness */
-#define I_GATE_THRES -10  // initially defined to -8 LU in the first EBU standard
-
             if (loudness_400 >= ABS_THRES) {
-                double integrated_sum = 0;
-                int nb_integrated = 0;
-                int gate_hist_pos = gate_update(&ebur128->i400, power_400,
-                                                loudness_400, I_GATE_THRES);
-
-                /* compute integrated loudness by summing the histogram values
-                 * above the relative threshold */
-                for (i = gate_hist_pos; i < HIST_SIZE; i++) {
-                    const int nb_v = ebur128->i400.histogram[i].count;
-                    nb_integrated  += nb_v;
-                    integrated_sum += nb_v * ebur128->i400.histogram[i].energy;
-                }
-                if (nb_integrated) {
-                    ebur128->integrated_loudness = LOUDNESS(integrated_sum / nb_integrated);
-                    /* dual-mono correction */
-                    if (nb_channels == 1 && ebur128->dual_mono) {
-                        ebur128->integrated_loudness -= ebur128->pan_law;
-                    }
+                ebur128->integrated_loudness = ff_ebur128_loudness_global(r128);
+                /* dual-mono correction */
+                if (nb_channels == 1 && ebur128->dual_mono) {
+                    ebur128->integrated_loudness -= ebur128->pan_law;
                 }
             }
 
             /* LRA */
-#define LRA_GATE_THRES -20
-#define LRA_LOWER_PRC   10
-#define LRA_HIGHER_PRC  95
-
-            /* XXX: example code in EBU 3342 is ">=" but formula in BS.1770
-             * specs is ">" */
-            if (loudness_3000 >= ABS_THRES) {
-                int nb_powers = 0;
-                int gate_hist_pos = gate_update(&ebur128->i3000, power_3000,
-                                                loudness_3000, LRA_GATE_THRES);
-
-                for (i = gate_hist_pos; i < HIST_SIZE; i++)
-                    nb_powers += ebur128->i3000.histogram[i].count;
-                if (nb_powers) {
-                    int n, nb_pow;
-
-                    /* get lower loudness to consider */
-                    n = 0;
-                    nb_pow = LRA_LOWER_PRC  * nb_powers / 100. + 0.5;
-                    for (i = gate_hist_pos; i < HIST_SIZE; i++) {
-                        n += ebur128->i3000.histogram[i].count;
-                        if (n >= nb_pow) {
-                            ebur128->lra_low = ebur128->i3000.histogram[i].loudness;
-                            break;
-                        }
-                    }
-
-                    /* get higher loudness to consider */
-                    n = nb_powers;
-                    nb_pow = LRA_HIGHER_PRC * nb_powers / 100. + 0.5;
-                    for (i = HIST_SIZE - 1; i >= 0; i--) {
-                        n -= ebur128->i3000.histogram[i].count;
-                        if (n < nb_pow) {
-                            ebur128->lra_high = ebur128->i3000.histogram[i].loudness;
-                            break;
-                        }
-                    }
-
-                    // XXX: show low & high on the graph?
-                    ebur128->loudness_range = ebur128->lra_high - ebur128->lra_low;
-                }
-            }
+            if (loudness_3000 >= ABS_THRES)
+                ebur128->loudness_range = ff_ebur128_loudness_range(r128, &ebur128->lra_low,
+                                                                    &ebur128->lra_high);
 
             /* dual-mono correction */
             if (nb_channels == 1 && ebur128->dual_mono) {
@@ -867,11 +625,13 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     int i;
     EBUR128Context *ebur128 = ctx->priv;
+    double i_threshold   = ff_ebur128_relative_threshold(&ebur128->r128);
+    double lra_threshold = ff_ebur128_range_threshold(&ebur128->r128);
 
     /* dual-mono correction */
     if (ebur128->nb_channels == 1 && ebur128->dual_mono) {
-        ebur128->i400.rel_threshold -= ebur128->pan_law;
-        ebur128->i3000.rel_threshold -= ebur128->pan_law;
+        i_threshold   -= ebur128->pan_law;
+        lra_threshold -= ebur128->pan_law;
         ebur128->lra_low -= ebur128->pan_law;
         ebur128->lra_high -= ebur128->pan_law;
     }
@@ -885,8 +645,8 @@ static av_cold void uninit(AVFilterContext *ctx)
            "    Threshold: %5.1f LUFS\n"
            "    LRA low:   %5.1f LUFS\n"
            "    LRA high:  %5.1f LUFS",
-           ebur128->integrated_loudness, ebur128->i400.rel_threshold,
-           ebur128->loudness_range,      ebur128->i3000.rel_threshold,
+           ebur128->integrated_loudness, i_threshold,
+           ebur128->loudness_range,      lra_threshold,
            ebur128->lra_low, ebur128->lra_high);
 
 #define PRINT_PEAK_SUMMARY(str, sp, ptype) do {                  \
@@ -907,16 +667,9 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_log(ctx, AV_LOG_INFO, "\n");
 
     av_freep(&ebur128->y_line_ref);
-    av_freep(&ebur128->ch_weighting);
     av_freep(&ebur128->true_peaks);
-    av_freep(&ebur128->sample_peaks);
     av_freep(&ebur128->true_peaks_per_frame);
-    av_freep(&ebur128->i400.histogram);
-    av_freep(&ebur128->i3000.histogram);
-    for (i = 0; i < ebur128->nb_channels; i++) {
-        av_freep(&ebur128->i400.cache[i]);
-        av_freep(&ebur128->i3000.cache[i]);
-    }
+    ff_ebur128_uninit(&ebur128->r128);
     for (i = 0; i < ctx->nb_outputs; i++)
         av_freep(&ctx->output_pads[i].name);
     av_frame_free(&ebur128->outpicref);
@@ -946,5 +699,5 @@ AVFilter ff_af_ebur128 = {
     .inputs        = ebur128_inputs,
     .outputs       = NULL,
     .priv_class    = &ebur128_class,
-    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -33,6 +33,7 @@
 #include "audio.h"
 #include "formats.h"
 #include "internal.h"
+#include "scene_detect.h"
 #include "video.h"
 
 static const char *const var_names[] = {
@@ -148,20 +149,19 @@ typedef struct SelectContext {
     av_pixelutils_sad_fn sad;       ///< Sum of the absolute difference function (scene detect only)
     double prev_mafd;               ///< previous MAFD                           (scene detect only)
     AVFrame *prev_picref;           ///< previous frame                          (scene detect only)
+    int scene_scale;                ///< downscaling factor of the scene detection, 1 for the full resolution RGB SAD
+    SceneDetectContext sd;          ///< downscaled luma scene detection         (scene detect only)
     double select;
     int select_out;                 ///< mark the selected output pad index
     int nb_outputs;
 } SelectContext;
 
 #define OFFSET(x) offsetof(SelectContext, x)
-#define DEFINE_OPTIONS(filt_name, FLAGS)                            \
-static const AVOption filt_name##_options[] = {                     \
+#define COMMON_OPTIONS(FLAGS)                                       \
     { "expr", "set an expression to use for selecting frames", OFFSET(expr_str), AV_OPT_TYPE_STRING, { .str = "1" }, .flags=FLAGS }, \
     { "e",    "set an expression to use for selecting frames", OFFSET(expr_str), AV_OPT_TYPE_STRING, { .str = "1" }, .flags=FLAGS }, \
     { "outputs", "set the number of outputs", OFFSET(nb_outputs), AV_OPT_TYPE_INT, {.i64 = 1}, 1, INT_MAX, .flags=FLAGS }, \
-    { "n",       "set the number of outputs", OFFSET(nb_outputs), AV_OPT_TYPE_INT, {.i64 = 1}, 1, INT_MAX, .flags=FLAGS }, \
-    { NULL }                                                            \
-}
+    { "n",       "set the number of outputs", OFFSET(nb_outputs), AV_OPT_TYPE_INT, {.i64 = 1}, 1, INT_MAX, .flags=FLAGS },
 
 static int request_frame(AVFilterLink *outlink);
 
@@ -198,7 +198,8 @@ static av_cold int init(AVFilterContext *ctx)
 
 static int config_input(AVFilterLink *inlink)
 {
-    SelectContext *select = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    SelectContext *select = ctx->priv;
 
     select->var_values[VAR_N]          = 0.0;
     select->var_values[VAR_SELECTED_N] = 0.0;
@@ -238,7 +239,11 @@ static int config_input(AVFilterLink *inlink)
     select->var_values[VAR_SAMPLE_RATE] =
         inlink->type == AVMEDIA_TYPE_AUDIO ? inlink->sample_rate : NAN;
 
-    if (select->do_scene_detect) {
+    if (select->do_scene_detect && select->scene_scale > 1) {
+        ff_scene_detect_uninit(&select->sd);
+        return ff_scene_detect_init(&select->sd, ctx, inlink->w, inlink->h, inlink->format,
+                                    select->scene_scale, ff_filter_get_nb_threads(ctx));
+    } else if (select->do_scene_detect) {
         select->sad = av_pixelutils_get_sad_fn(3, 3, 2, select); // 8x8 both sources aligned
         if (!select->sad)
             return AVERROR(EINVAL);
@@ -252,6 +257,9 @@ static double get_scene_score(AVFilterContext *ctx, AVFrame *frame)
     SelectContext *select = ctx->priv;
     AVFrame *prev_picref = select->prev_picref;
 
+    if (select->scene_scale > 1)
+        return ff_scene_detect_frame(&select->sd, ctx, frame);
+
     if (prev_picref &&
         frame->height == prev_picref->height &&
         frame->width  == prev_picref->width) {
@@ -424,6 +432,7 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     if (select->do_scene_detect) {
         av_frame_free(&select->prev_picref);
+        ff_scene_detect_uninit(&select->sd);
     }
 }
 
@@ -433,6 +442,12 @@ static int query_formats(AVFilterContext *ctx)
 
     if (!select->do_scene_detect) {
         return ff_default_query_formats(ctx);
+    } else if (select->scene_scale > 1) {
+        AVFilterFormats *fmts_list = ff_scene_detect_formats();
+
+        if (!fmts_list)
+            return AVERROR(ENOMEM);
+        return ff_set_common_formats(ctx, fmts_list);
     } else {
         int ret;
         static const enum AVPixelFormat pix_fmts[] = {
@@ -452,7 +467,10 @@ static int query_formats(AVFilterContext *ctx)
 
 #if CONFIG_ASELECT_FILTER
 
-DEFINE_OPTIONS(aselect, AV_OPT_FLAG_AUDIO_PARAM|AV_OPT_FLAG_FILTERING_PARAM);
+static const AVOption aselect_options[] = {
+    COMMON_OPTIONS(AV_OPT_FLAG_AUDIO_PARAM|AV_OPT_FLAG_FILTERING_PARAM)
+    { NULL }
+};
 AVFILTER_DEFINE_CLASS(aselect);
 
 static av_cold int aselect_init(AVFilterContext *ctx)
@@ -495,7 +513,11 @@ AVFilter ff_af_aselect = {
 
 #if CONFIG_SELECT_FILTER
 
-DEFINE_OPTIONS(select, AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM);
+static const AVOption select_options[] = {
+    COMMON_OPTIONS(AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM)
+    { "scene_scale", "set the downscaling factor of the scene detection", OFFSET(scene_scale), AV_OPT_TYPE_INT, {.i64 = 1}, 1, 16, .flags=AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM },
+    { NULL }
+};
 AVFILTER_DEFINE_CLASS(select);
 
 static av_cold int select_init(AVFilterContext *ctx)
@@ -527,6 +549,6 @@ AVFilter ff_vf_select = {
     .priv_size     = sizeof(SelectContext),
     .priv_class    = &select_class,
     .inputs        = avfilter_vf_select_inputs,
-    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif /* CONFIG_SELECT_FILTER */
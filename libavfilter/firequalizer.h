@@ -0,0 +1,37 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_FIREQUALIZER_H
+#define AVFILTER_FIREQUALIZER_H
+
+typedef struct FIREqualizerDSPContext {
+    /**
+     * Multiply-accumulate interleaved complex numbers: sum += t * c.
+     * The pointers need no alignment.
+     *
+     * @param len number of complex numbers
+     * @return number of complex numbers processed, the caller processes the
+     *         remaining ones
+     */
+    int (*fcmul_add)(float *sum, const float *t, const float *c, int len);
+} FIREqualizerDSPContext;
+
+void ff_firequalizer_init(FIREqualizerDSPContext *dsp);
+void ff_firequalizer_init_x86(FIREqualizerDSPContext *dsp);
+
+#endif /* AVFILTER_FIREQUALIZER_H */
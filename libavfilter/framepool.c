@@ -19,6 +19,7 @@
  */
 
 #include "framepool.h"
+#include "libavutil/atomic.h"
 #include "libavutil/avassert.h"
 #include "libavutil/buffer.h"
 #include "libavutil/frame.h"
@@ -35,8 +36,21 @@ struct FFVideoFramePool {
     int linesize[4];
     AVBufferPool *pools[4];
 
+    AVBufferRef* (*alloc)(int size);
+    volatile int nb_requested;
+    volatile int nb_allocated;
 };
 
+static AVBufferRef *pool_alloc(void *opaque, int size)
+{
+    FFVideoFramePool *pool = opaque;
+    AVBufferRef *buf = pool->alloc ? pool->alloc(size) : av_buffer_alloc(size);
+
+    if (buf)
+        avpriv_atomic_int_add_and_fetch(&pool->nb_allocated, 1);
+    return buf;
+}
+
 FFVideoFramePool *ff_video_frame_pool_init(AVBufferRef* (*alloc)(int size),
                                            int width,
                                            int height,
@@ -58,6 +72,7 @@ FFVideoFramePool *ff_video_frame_pool_init(AVBufferRef* (*alloc)(int size),
     pool->height = height;
     pool->format = format;
     pool->align = align;
+    pool->alloc = alloc;
 
     if ((ret = av_image_check_size(width, height, 0, NULL)) < 0) {
         goto fail;
@@ -84,15 +99,15 @@ FFVideoFramePool *ff_video_frame_pool_init(AVBufferRef* (*alloc)(int size),
         if (i == 1 || i == 2)
             h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
 
-        pool->pools[i] = av_buffer_pool_init(pool->linesize[i] * h + 16 + 16 - 1,
-                                             alloc);
+        pool->pools[i] = av_buffer_pool_init2(pool->linesize[i] * h + 16 + 16 - 1,
+                                              pool, pool_alloc, NULL);
         if (!pool->pools[i])
             goto fail;
     }
 
     if (desc->flags & AV_PIX_FMT_FLAG_PAL ||
         desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL) {
-        pool->pools[1] = av_buffer_pool_init(AVPALETTE_SIZE, alloc);
+        pool->pools[1] = av_buffer_pool_init2(AVPALETTE_SIZE, pool, pool_alloc, NULL);
         if (!pool->pools[1])
             goto fail;
     }
@@ -121,6 +136,19 @@ int ff_video_frame_pool_get_config(FFVideoFramePool *pool,
     return 0;
 }
 
+int ff_video_frame_pool_get_stats(FFVideoFramePool *pool,
+                                  int *nb_requested,
+                                  int *nb_allocated)
+{
+    if (!pool)
+        return AVERROR(EINVAL);
+
+    *nb_requested = avpriv_atomic_int_get(&pool->nb_requested);
+    *nb_allocated = avpriv_atomic_int_get(&pool->nb_allocated);
+
+    return 0;
+}
+
 
 AVFrame *ff_video_frame_pool_get(FFVideoFramePool *pool)
 {
@@ -151,6 +179,7 @@ AVFrame *ff_video_frame_pool_get(FFVideoFramePool *pool)
         if (!frame->buf[i]) {
             goto fail;
         }
+        avpriv_atomic_int_add_and_fetch(&pool->nb_requested, 1);
 
         frame->data[i] = frame->buf[i]->data;
     }
@@ -72,6 +72,18 @@ int ff_video_frame_pool_get_config(FFVideoFramePool *pool,
                                    enum AVPixelFormat *format,
                                    int *align);
 
+/**
+ * Get the number of buffers handed out by the pool and the number of
+ * them that had to be newly allocated rather than reused.
+ *
+ * @param nb_requested number of buffers returned by ff_video_frame_pool_get()
+ * @param nb_allocated number of buffers allocated with the alloc function
+ * @return 0 on success, a negative AVERROR otherwise.
+ */
+int ff_video_frame_pool_get_stats(FFVideoFramePool *pool,
+                                  int *nb_requested,
+                                  int *nb_allocated);
+
 /**
  * Allocate a new AVFrame, reussing old buffers from the pool when available.
  * This function may be called simultaneously from multiple threads.
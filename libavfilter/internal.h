@@ -147,10 +147,27 @@ struct AVFilterPad {
 struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
+
+    /**
+     * Video frame pools shared by all the links of the graph.
+     */
+    struct FFGraphFramePools *frame_pools;
+
+    /**
+     * Number of frames that reached a filter able to work in place while
+     * being writable, i.e. for which no output buffer had to be allocated.
+     */
+    volatile int nb_frames_in_place;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /**
+     * Frame threading state, set if the filter runs with
+     * AVFILTER_THREAD_FRAME.
+     */
+    struct FrameThreadContext *frame_thread;
 };
 
 /**
@@ -381,6 +398,13 @@ AVFilterContext *ff_filter_alloc(const AVFilter *filter, const char *inst_name);
  */
 void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter);
 
+/**
+ * Get a video buffer from the frame pool of the graph matching the given
+ * properties, creating the pool if needed.
+ */
+AVFrame *ff_filter_graph_get_video_buffer(AVFilterGraph *graph, int w, int h,
+                                          enum AVPixelFormat format, int align);
+
 /**
  * Run one round of processing on a filter graph.
  */
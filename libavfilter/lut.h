@@ -0,0 +1,45 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_LUT_H
+#define AVFILTER_LUT_H
+
+#include <stdint.h>
+
+typedef struct LutDSPContext {
+    /**
+     * Map a row of 8-bit samples through a table of 256 entries, which must
+     * be readable one entry past the last one.
+     *
+     * @return number of samples written, the caller maps the remaining ones
+     */
+    int (*lut_row8)(uint8_t *dst, const uint8_t *src, const uint16_t *lut, int width);
+
+    /**
+     * Map a row of native endian 16-bit samples through a table of 65536
+     * entries, which must be readable one entry past the last one.
+     *
+     * @return number of samples written, the caller maps the remaining ones
+     */
+    int (*lut_row16)(uint16_t *dst, const uint16_t *src, const uint16_t *lut, int width);
+} LutDSPContext;
+
+void ff_lut_init(LutDSPContext *dsp);
+void ff_lut_init_x86(LutDSPContext *dsp);
+
+#endif /* AVFILTER_LUT_H */
@@ -0,0 +1,67 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_LUT3D_H
+#define AVFILTER_LUT3D_H
+
+#include <stdint.h>
+
+/* fractional bits of the interpolation weights */
+#define LUT3D_FRAC_BITS 10
+
+/* fractional bits of the 8-bit fixed point table entries */
+#define LUT3D_LUT_BITS 6
+
+/* layout of the coordinate table entries */
+#define LUT3D_COORD_NEXT  (1 << LUT3D_FRAC_BITS)
+#define LUT3D_COORD_SHIFT (LUT3D_FRAC_BITS + 1)
+
+enum {
+    LUT3D_STRIDE_R,     ///< table entries between two consecutive red levels
+    LUT3D_STRIDE_G,
+    LUT3D_STRIDE_B,
+    LUT3D_SHIFT_R,      ///< bit position of red in a little endian pixel
+    LUT3D_SHIFT_G,
+    LUT3D_SHIFT_B,
+    LUT3D_ALPHA_MASK,   ///< bits of a pixel copied from the source
+    LUT3D_NB_PARAMS
+};
+
+typedef struct LUT3DDSPContext {
+    /**
+     * Tetrahedral interpolation of a row of 32-bit RGB pixels, in fixed point.
+     *
+     * @param lut    table of the 3 components and a 0 padding word of each
+     *               point, scaled by 255 << LUT3D_LUT_BITS
+     * @param coord  3 tables of 256 entries, one per component, mapping a
+     *               source value to the interpolation weight of the next
+     *               level in its LUT3D_FRAC_BITS low bits, LUT3D_COORD_NEXT
+     *               if there is a next level, and the table offset of the
+     *               previous level shifted left by LUT3D_COORD_SHIFT
+     * @param params LUT3D_NB_PARAMS values describing the table and pixels
+     * @return number of pixels written, the caller handles the remaining ones
+     */
+    int (*interp_tetrahedral_row)(uint8_t *dst, const uint8_t *src, int width,
+                                  const int16_t *lut, const uint32_t *coord,
+                                  const uint32_t *params);
+} LUT3DDSPContext;
+
+void ff_lut3d_init(LUT3DDSPContext *dsp);
+void ff_lut3d_init_x86(LUT3DDSPContext *dsp);
+
+#endif /* AVFILTER_LUT3D_H */
@@ -45,6 +45,8 @@ if (x >= x_min && x <= x_max && y >= y_min && y <= y_max)\
 void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_param,
                         int width, int height, int x_min, int x_max, int y_min, int y_max)
 {
+    int i;
+
     me_ctx->width = width;
     me_ctx->height = height;
     me_ctx->mb_size = mb_size;
@@ -54,26 +56,49 @@ void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_para
     me_ctx->x_max = x_max;
     me_ctx->y_min = y_min;
     me_ctx->y_max = y_max;
+
+    /* blocks up to 32x32, both unaligned */
+    for (i = 1; i < FF_ARRAY_ELEMS(me_ctx->sad); i++)
+        me_ctx->sad[i] = av_pixelutils_get_sad_fn(i, i, 0, NULL);
 }
 
-uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv)
+uint64_t ff_me_sad_block(AVMotionEstContext *me_ctx, const uint8_t *src1,
+                         const uint8_t *src2, int size)
 {
     const int linesize = me_ctx->linesize;
-    uint8_t *data_ref = me_ctx->data_ref;
-    uint8_t *data_cur = me_ctx->data_cur;
+    const int n = av_log2(size);
     uint64_t sad = 0;
     int i, j;
 
-    data_ref += y_mv * linesize;
-    data_cur += y_mb * linesize;
+    if (size == 1 << n && n < FF_ARRAY_ELEMS(me_ctx->sad) && me_ctx->sad[n])
+        return me_ctx->sad[n](src1, linesize, src2, linesize);
 
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sad += FFABS(data_ref[x_mv + i + j * linesize] - data_cur[x_mb + i + j * linesize]);
+    for (j = 0; j < size; j++) {
+        for (i = 0; i < size; i++)
+            sad += FFABS(src1[i] - src2[i]);
+        src1 += linesize;
+        src2 += linesize;
+    }
 
     return sad;
 }
 
+uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv)
+{
+    const int linesize = me_ctx->linesize;
+
+    return ff_me_sad_block(me_ctx, me_ctx->data_ref + x_mv + y_mv * linesize,
+                           me_ctx->data_cur + x_mb + y_mb * linesize,
+                           me_ctx->mb_size);
+}
+
+void ff_me_wavefront_rows(int wave, int b_width, int b_height,
+                          int *mb_y_start, int *mb_y_end)
+{
+    *mb_y_start = FFMAX(0, (wave - b_width + 2) >> 1);
+    *mb_y_end   = FFMIN(b_height, (wave >> 1) + 1);
+}
+
 uint64_t ff_me_search_esa(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int *mv)
 {
     int x, y;
@@ -22,6 +22,7 @@
 #define AVFILTER_MOTION_ESTIMATION_H
 
 #include "libavutil/avutil.h"
+#include "libavutil/pixelutils.h"
 
 #define AV_ME_METHOD_ESA        1
 #define AV_ME_METHOD_TSS        2
@@ -57,6 +58,8 @@ typedef struct AVMotionEstContext {
     int pred_y;     ///< median predictor y
     AVMotionEstPredictor preds[2];
 
+    av_pixelutils_sad_fn sad[6];    ///< SAD of 1 << n sized blocks, NULL if not available
+
     uint64_t (*get_cost)(struct AVMotionEstContext *me_ctx, int x_mb, int y_mb,
                          int mv_x, int mv_y);
 } AVMotionEstContext;
@@ -64,8 +67,30 @@ typedef struct AVMotionEstContext {
 void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_param,
                         int width, int height, int x_min, int x_max, int y_min, int y_max);
 
+/**
+ * Compute the SAD of two size x size blocks with the linesize of me_ctx,
+ * using the SIMD functions of pixelutils for power of 2 sizes.
+ */
+uint64_t ff_me_sad_block(AVMotionEstContext *me_ctx, const uint8_t *src1,
+                         const uint8_t *src2, int size);
+
 uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv);
 
+/**
+ * Get the macroblock rows crossing a wavefront of a b_width x b_height
+ * macroblock grid, for searches using predictors from the left, top-left,
+ * top and top-right macroblocks of the current frame.
+ * Wavefront n holds the macroblocks with mb_x + 2 * mb_y == n, so all the
+ * predictors of a macroblock are in previous wavefronts and the
+ * macroblocks of a wavefront can be searched in parallel.
+ * There are b_width + 2 * (b_height - 1) wavefronts.
+ *
+ * @param mb_y_start first row crossing the wavefront
+ * @param mb_y_end   row after the last row crossing the wavefront
+ */
+void ff_me_wavefront_rows(int wave, int b_width, int b_height,
+                          int *mb_y_start, int *mb_y_end);
+
 uint64_t ff_me_search_esa(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int *mv);
 
 uint64_t ff_me_search_tss(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int *mv);
@@ -0,0 +1,49 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PALETTEUSE_H
+#define AVFILTER_PALETTEUSE_H
+
+#include <stdint.h>
+
+/* the packed palettes are padded to a multiple of this number of entries */
+#define PALETTEUSE_PACKED_ALIGN 8
+
+/* component value of the padding entries, far from any color */
+#define PALETTEUSE_PACKED_PAD -1024
+
+typedef struct PaletteUseDSPContext {
+    /**
+     * Find the palette entry nearest to a color, by euclidean distance in RGB.
+     *
+     * The palette is packed as two planes of one dword per entry: the words
+     * r, g in rg and b, 0 in b, both 32 byte aligned.
+     *
+     * @param nb_entries number of entries, a multiple of PALETTEUSE_PACKED_ALIGN
+     *                   at most 256, padded with PALETTEUSE_PACKED_PAD entries
+     * @param color      0xXXRRGGBB color, the top byte is ignored
+     * @return index of the nearest entry, the lowest one in case of ties
+     */
+    int (*nearest_color)(const int16_t *rg, const int16_t *b, int nb_entries,
+                         uint32_t color);
+} PaletteUseDSPContext;
+
+void ff_paletteuse_init(PaletteUseDSPContext *dsp);
+void ff_paletteuse_init_x86(PaletteUseDSPContext *dsp);
+
+#endif /* AVFILTER_PALETTEUSE_H */
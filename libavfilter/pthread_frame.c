@@ -0,0 +1,325 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Frame multithreading support for filters without inter-frame state
+ *
+ * Input frames are queued until there is one per thread, then filtered
+ * together as the jobs of a single call to the graph execute function, so
+ * the graph threads are shared by all the filters. The frames the jobs
+ * output are captured and sent to the next filters from the caller thread
+ * once the call returns, in submission order, so the rest of the graph keeps
+ * running on a single thread.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+#include "avfilter.h"
+#include "internal.h"
+#include "thread.h"
+
+typedef struct FrameOutput {
+    AVFilterLink *link;
+    AVFrame *frame;
+} FrameOutput;
+
+typedef struct FrameJob {
+    AVFrame *in;
+
+    FrameOutput *out;
+    unsigned int out_size;
+    int nb_out;
+
+    pthread_t thread;           ///< thread filtering the job, if running is set
+    int running;
+} FrameJob;
+
+typedef struct FrameThreadContext {
+    AVFilterLink *link;
+    int (*filter_frame)(AVFilterLink *link, AVFrame *frame);
+    int max_jobs;
+
+    /* queued jobs, starting with the nb_filtered ones whose output was not
+     * sent yet; frames can still be queued while that output is sent */
+    FrameJob *jobs;
+    unsigned int jobs_size;
+    int *rets;
+    unsigned int rets_size;
+    int nb_queued;
+    int nb_filtered;
+
+    /* protects the running state of the jobs and serializes the buffer
+     * requests of the jobs on the output links */
+    pthread_mutex_t lock;
+
+    int sending;                ///< output is being sent
+} FrameThreadContext;
+
+static int filter_job(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FrameThreadContext *c = arg;
+    FrameJob *job         = &c->jobs[jobnr];
+    AVFrame *in           = job->in;
+    int ret;
+
+    pthread_mutex_lock(&c->lock);
+    job->thread  = pthread_self();
+    job->running = 1;
+    pthread_mutex_unlock(&c->lock);
+
+    job->in = NULL;
+    ret     = c->filter_frame(c->link, in);
+
+    pthread_mutex_lock(&c->lock);
+    job->running = 0;
+    pthread_mutex_unlock(&c->lock);
+
+    return ret;
+}
+
+static void filter_jobs(AVFilterContext *ctx)
+{
+    FrameThreadContext *c = ctx->internal->frame_thread;
+
+    if (c->sending || c->nb_filtered || !c->nb_queued)
+        return;
+    ctx->graph->internal->thread_execute(ctx, filter_job, c, c->rets,
+                                         c->nb_queued);
+    c->nb_filtered = c->nb_queued;
+}
+
+/**
+ * Send the output of the filtered jobs in submission order.
+ *
+ * @return the number of jobs sent or a negative error code
+ */
+static int send_jobs(FrameThreadContext *c)
+{
+    int i, j, ret = 0, nb_sent = 0;
+
+    /* a command sent by a later filter may flush again while sending */
+    if (c->sending || !c->nb_filtered)
+        return 0;
+    c->sending = 1;
+
+    for (i = 0; i < c->nb_filtered; i++) {
+        /* the jobs can be reallocated by frames queued while sending */
+        int nb_out = c->jobs[i].nb_out;
+
+        if (ret >= 0)
+            ret = c->rets[i];
+        for (j = 0; j < nb_out; j++) {
+            FrameOutput out = c->jobs[i].out[j];
+
+            if (ret >= 0)
+                ret = ff_filter_frame(out.link, out.frame);
+            else
+                av_frame_free(&out.frame);
+        }
+        c->jobs[i].nb_out = 0;
+        if (ret >= 0)
+            nb_sent++;
+    }
+
+    for (i = 0; i < c->nb_filtered; i++) {
+        av_freep(&c->jobs[i].out);
+        c->jobs[i].out_size = 0;
+    }
+    c->nb_queued -= c->nb_filtered;
+    memmove(c->jobs, c->jobs + c->nb_filtered, c->nb_queued * sizeof(*c->jobs));
+    memset(c->jobs + c->nb_queued, 0, c->nb_filtered * sizeof(*c->jobs));
+    c->nb_filtered = 0;
+    c->sending     = 0;
+
+    return ret < 0 ? ret : nb_sent;
+}
+
+int ff_filter_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                  int (*filter_frame)(AVFilterLink *, AVFrame *))
+{
+    AVFilterContext *ctx  = link->dst;
+    FrameThreadContext *c = ctx->internal->frame_thread;
+    FrameJob *jobs;
+    int *rets;
+    int ret;
+
+    /* output of the frames filtered by ff_filter_frame_thread_wait() */
+    ret = send_jobs(c);
+    if (ret < 0) {
+        av_frame_free(&frame);
+        return ret;
+    }
+
+    if ((c->nb_queued + 1) * sizeof(*c->jobs) > c->jobs_size) {
+        unsigned int old_size = c->jobs_size;
+
+        jobs = av_fast_realloc(c->jobs, &c->jobs_size,
+                               (c->nb_queued + 1) * sizeof(*c->jobs));
+        if (!jobs) {
+            av_frame_free(&frame);
+            return AVERROR(ENOMEM);
+        }
+        memset((uint8_t *)jobs + old_size, 0, c->jobs_size - old_size);
+        c->jobs = jobs;
+    }
+    rets = av_fast_realloc(c->rets, &c->rets_size,
+                           (c->nb_queued + 1) * sizeof(*c->rets));
+    if (!rets) {
+        av_frame_free(&frame);
+        return AVERROR(ENOMEM);
+    }
+    c->rets = rets;
+
+    c->link         = link;
+    c->filter_frame = filter_frame;
+    c->jobs[c->nb_queued++].in = frame;
+
+    if (c->sending || c->nb_queued - c->nb_filtered < c->max_jobs)
+        return 0;
+    filter_jobs(ctx);
+    ret = send_jobs(c);
+
+    return FFMIN(ret, 0);
+}
+
+int ff_filter_frame_thread_capture(AVFilterLink *link, AVFrame *frame)
+{
+    FrameThreadContext *c = link->src->internal->frame_thread;
+    pthread_t self = pthread_self();
+    FrameOutput *out;
+    FrameJob *job = NULL;
+    int i;
+
+    pthread_mutex_lock(&c->lock);
+    for (i = 0; i < c->nb_queued; i++) {
+        if (c->jobs[i].running && pthread_equal(c->jobs[i].thread, self)) {
+            job = &c->jobs[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&c->lock);
+    if (!job)
+        return 0;
+
+    out = av_fast_realloc(job->out, &job->out_size,
+                          (job->nb_out + 1) * sizeof(*job->out));
+    if (!out) {
+        av_frame_free(&frame);
+        return AVERROR(ENOMEM);
+    }
+    job->out = out;
+    job->out[job->nb_out].link  = link;
+    job->out[job->nb_out].frame = frame;
+    job->nb_out++;
+
+    return 1;
+}
+
+void ff_filter_frame_thread_lock(AVFilterContext *ctx)
+{
+    pthread_mutex_lock(&ctx->internal->frame_thread->lock);
+}
+
+void ff_filter_frame_thread_unlock(AVFilterContext *ctx)
+{
+    pthread_mutex_unlock(&ctx->internal->frame_thread->lock);
+}
+
+int ff_filter_frame_thread_flush(AVFilterContext *ctx)
+{
+    FrameThreadContext *c = ctx->internal->frame_thread;
+    int ret, nb_sent = 0;
+
+    do {
+        filter_jobs(ctx);
+        ret = send_jobs(c);
+        if (ret < 0)
+            return ret;
+        nb_sent += ret;
+    } while (ret && c->nb_queued);
+
+    return nb_sent;
+}
+
+int ff_filter_frame_thread_flush_inputs(AVFilterContext *ctx)
+{
+    int i, ret;
+
+    for (i = 0; i < ctx->nb_inputs; i++) {
+        AVFilterContext *src = ctx->inputs[i] ? ctx->inputs[i]->src : NULL;
+        FrameThreadContext *c = src ? src->internal->frame_thread : NULL;
+
+        /* the filters before one that is sending already sent their frames
+         * or are sending them */
+        if (!src || (c && c->sending))
+            continue;
+        if ((ret = ff_filter_frame_thread_flush_inputs(src)) < 0)
+            return ret;
+        if (c && (ret = ff_filter_frame_thread_flush(src)) < 0)
+            return ret;
+    }
+    return 0;
+}
+
+void ff_filter_frame_thread_wait(AVFilterContext *ctx)
+{
+    filter_jobs(ctx);
+}
+
+void ff_filter_frame_thread_free(AVFilterContext *ctx)
+{
+    FrameThreadContext *c = ctx->internal->frame_thread;
+    int i, j;
+
+    if (!c)
+        return;
+
+    for (i = 0; i < c->nb_queued; i++) {
+        FrameJob *job = &c->jobs[i];
+
+        av_frame_free(&job->in);
+        for (j = 0; j < job->nb_out; j++)
+            av_frame_free(&job->out[j].frame);
+        av_freep(&job->out);
+    }
+
+    pthread_mutex_destroy(&c->lock);
+    av_freep(&c->rets);
+    av_freep(&c->jobs);
+    av_freep(&ctx->internal->frame_thread);
+}
+
+int ff_filter_frame_thread_init(AVFilterContext *ctx)
+{
+    FrameThreadContext *c = av_mallocz(sizeof(*c));
+
+    if (!c)
+        return AVERROR(ENOMEM);
+    c->max_jobs = ff_filter_get_nb_threads(ctx);
+    pthread_mutex_init(&c->lock, NULL);
+    ctx->internal->frame_thread = c;
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Scene change detection on a downscaled luma
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "internal.h"
+#include "scene_detect.h"
+
+static const enum AVPixelFormat pix_fmts[] = {
+    AV_PIX_FMT_GRAY8,
+    AV_PIX_FMT_YUV410P, AV_PIX_FMT_YUV411P, AV_PIX_FMT_YUV420P,
+    AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV440P, AV_PIX_FMT_YUV444P,
+    AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_YUVJ422P, AV_PIX_FMT_YUVJ440P,
+    AV_PIX_FMT_YUVJ444P, AV_PIX_FMT_YUVA420P, AV_PIX_FMT_YUVA422P,
+    AV_PIX_FMT_YUVA444P, AV_PIX_FMT_NV12, AV_PIX_FMT_NV21,
+    AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24,
+    AV_PIX_FMT_RGBA, AV_PIX_FMT_BGRA, AV_PIX_FMT_ARGB, AV_PIX_FMT_ABGR,
+    AV_PIX_FMT_NONE
+};
+
+AVFilterFormats *ff_scene_detect_formats(void)
+{
+    return ff_make_format_list(pix_fmts);
+}
+
+int ff_scene_detect_init(SceneDetectContext *s, void *log_ctx, int width, int height,
+                         enum AVPixelFormat pix_fmt, int scale, int nb_threads)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    int i;
+
+    if (!desc || desc->comp[0].depth != 8 || desc->comp[0].plane ||
+        (desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM))) {
+        av_log(log_ctx, AV_LOG_ERROR, "Unsupported pixel format for scene detection\n");
+        return AVERROR(EINVAL);
+    }
+
+    s->rgb  = !!(desc->flags & AV_PIX_FMT_FLAG_RGB);
+    s->step = desc->comp[0].step;
+    if (s->rgb) {
+        if (desc->flags & AV_PIX_FMT_FLAG_PLANAR || desc->nb_components < 3) {
+            av_log(log_ctx, AV_LOG_ERROR, "Unsupported pixel format for scene detection\n");
+            return AVERROR(EINVAL);
+        }
+        for (i = 0; i < 3; i++)
+            s->offset[i] = desc->comp[i].offset;
+    }
+
+    s->scale  = av_clip(scale, 1, FFMAX(1, FFMIN(width, height)));
+    s->width  = width;
+    s->height = height;
+    s->dw     = width  / s->scale;
+    s->dh     = height / s->scale;
+    s->nb_jobs = av_clip(FFMIN(nb_threads, s->dh), 1, 64);
+
+    s->cur  = av_malloc_array(s->dw, s->dh);
+    s->prev = av_malloc_array(s->dw, s->dh);
+    s->acc  = av_malloc_array(s->nb_jobs * s->dw * s->scale, s->step * sizeof(*s->acc));
+    s->jobs = av_malloc_array(s->nb_jobs, sizeof(*s->jobs));
+    if (!s->cur || !s->prev || !s->acc || !s->jobs) {
+        ff_scene_detect_uninit(s);
+        return AVERROR(ENOMEM);
+    }
+    s->has_prev  = 0;
+    s->prev_mafd = 0;
+
+    return 0;
+}
+
+static int scene_detect_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SceneDetectContext *s = arg;
+    SceneDetectJob *job = &s->jobs[jobnr];
+    const AVFrame *frame = s->frame;
+    const int scale = s->scale, step = s->step, dw = s->dw;
+    const int row_size = dw * scale * step;
+    const int o0 = s->offset[0], o1 = s->offset[1], o2 = s->offset[2];
+    /* the RGB sums weight R, G and B as 1, 2 and 1 */
+    const int area = scale * scale << (2 * s->rgb);
+    const int shift = av_log2(area);
+    const int slice_start = (s->dh *  jobnr     ) / nb_jobs;
+    const int slice_end   = (s->dh * (jobnr + 1)) / nb_jobs;
+    uint16_t *acc = s->acc + jobnr * row_size;
+    int64_t sad = 0;
+    int x, y, i, j;
+
+    memset(job->hist, 0, sizeof(job->hist));
+
+    for (y = slice_start; y < slice_end; y++) {
+        const uint8_t *src = frame->data[0] + y * scale * frame->linesize[0];
+        uint8_t *cur = s->cur + y * dw;
+        const uint8_t *prev = s->prev + y * dw;
+
+        /* sum the rows of the blocks first, so that the loop over the
+         * full resolution pixels is a plain vertical sum */
+        memset(acc, 0, row_size * sizeof(*acc));
+        for (j = 0; j < scale; j++, src += frame->linesize[0])
+            for (x = 0; x < row_size; x++)
+                acc[x] += src[x];
+
+        for (x = 0; x < dw; x++) {
+            const uint16_t *a = acc + x * scale * step;
+            unsigned sum = 0;
+
+            if (s->rgb) {
+                for (i = 0; i < scale; i++, a += step)
+                    sum += a[o0] + 2 * a[o1] + a[o2];
+            } else {
+                for (i = 0; i < scale; i++, a += step)
+                    sum += a[0];
+            }
+            if (area == 1 << shift)
+                cur[x] = (sum + (area >> 1)) >> shift;
+            else
+                cur[x] = (sum + (area >> 1)) / area;
+            job->hist[cur[x] >> (8 - SCENE_DETECT_HIST_BITS)]++;
+        }
+        if (s->has_prev)
+            for (x = 0; x < dw; x++)
+                sad += FFABS(cur[x] - prev[x]);
+    }
+    job->sad = sad;
+
+    return 0;
+}
+
+double ff_scene_detect_frame(SceneDetectContext *s, AVFilterContext *ctx,
+                             const AVFrame *frame)
+{
+    const int nb_jobs = FFMIN(s->nb_jobs, s->dh);
+    const int nb_pixels = s->dw * s->dh;
+    int *hist = s->hist[0], *prev_hist = s->hist[1];
+    double ret = 0;
+    int64_t sad = 0;
+    int i, j;
+
+    if (frame->width != s->width || frame->height != s->height || !nb_pixels) {
+        s->has_prev = 0;
+        return 0;
+    }
+
+    s->frame = frame;
+    ctx->internal->execute(ctx, scene_detect_slice, s, NULL, nb_jobs);
+    s->frame = NULL;
+
+    memset(hist, 0, sizeof(s->hist[0]));
+    for (i = 0; i < nb_jobs; i++) {
+        sad += s->jobs[i].sad;
+        for (j = 0; j < FF_ARRAY_ELEMS(s->hist[0]); j++)
+            hist[j] += s->jobs[i].hist[j];
+    }
+
+    if (s->has_prev) {
+        double mafd, diff, sad_score, hist_score;
+        int64_t hist_diff = 0;
+
+        mafd = (double)sad / nb_pixels;
+        diff = fabs(mafd - s->prev_mafd);
+        sad_score = av_clipf(FFMIN(mafd, diff) / 100., 0, 1);
+        s->prev_mafd = mafd;
+
+        for (j = 0; j < FF_ARRAY_ELEMS(s->hist[0]); j++)
+            hist_diff += FFABS(hist[j] - prev_hist[j]);
+        hist_score = hist_diff / (2. * nb_pixels);
+
+        ret = av_clipf(sqrt(sad_score * hist_score), 0, 1);
+    }
+
+    FFSWAP(uint8_t *, s->cur, s->prev);
+    memcpy(prev_hist, hist, sizeof(s->hist[0]));
+    s->has_prev = 1;
+
+    return ret;
+}
+
+void ff_scene_detect_uninit(SceneDetectContext *s)
+{
+    av_freep(&s->cur);
+    av_freep(&s->prev);
+    av_freep(&s->acc);
+    av_freep(&s->jobs);
+}
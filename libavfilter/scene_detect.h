@@ -0,0 +1,88 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_SCENE_DETECT_H
+#define AVFILTER_SCENE_DETECT_H
+
+#include <stdint.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/pixfmt.h"
+#include "avfilter.h"
+#include "formats.h"
+
+#define SCENE_DETECT_HIST_BITS 6
+
+typedef struct SceneDetectJob {
+    int64_t sad;
+    int hist[1 << SCENE_DETECT_HIST_BITS];
+} SceneDetectJob;
+
+typedef struct SceneDetectContext {
+    int scale;                  ///< downscaling factor of the luma
+    int width, height;          ///< size of the input frames
+    int dw, dh;                 ///< size of the downscaled luma
+    int step;                   ///< distance between two pixels of the luma or RGB plane
+    int rgb;                    ///< packed RGB input, the luma is approximated from it
+    int offset[3];              ///< offsets of R, G and B in a packed RGB pixel
+
+    uint8_t *cur, *prev;        ///< downscaled luma of the current and previous frames
+    int has_prev;
+    int hist[2][1 << SCENE_DETECT_HIST_BITS];   ///< luma histograms of the current and previous frames
+    double prev_mafd;
+
+    uint16_t *acc;              ///< per job sums of the rows of a block row
+    SceneDetectJob *jobs;
+    int nb_jobs;
+
+    const AVFrame *frame;       ///< frame being analyzed
+} SceneDetectContext;
+
+/**
+ * @return the list of the pixel formats supported by the scene detection
+ */
+AVFilterFormats *ff_scene_detect_formats(void);
+
+/**
+ * Initialize the scene detection for frames of the given size and format.
+ *
+ * @param scale      downscaling factor of the luma analyzed, 1 to analyze
+ *                   it at full resolution
+ * @param nb_threads maximum number of slice jobs run on a frame
+ */
+int ff_scene_detect_init(SceneDetectContext *s, void *log_ctx, int width, int height,
+                         enum AVPixelFormat pix_fmt, int scale, int nb_threads);
+
+/**
+ * Compute the scene change score of a frame against the previous one,
+ * with slice threads of ctx.
+ *
+ * The score combines the change of the mean absolute difference of the
+ * downscaled luma since the previous frame, like the select filter does
+ * (there is no motion compensation), with the distance of the luma
+ * histograms, so that motion alone scores lower while cuts and fades to
+ * different content score high.
+ *
+ * @return the score, between 0 and 1, 0 for the first frame
+ */
+double ff_scene_detect_frame(SceneDetectContext *s, AVFilterContext *ctx,
+                             const AVFrame *frame);
+
+void ff_scene_detect_uninit(SceneDetectContext *s);
+
+#endif /* AVFILTER_SCENE_DETECT_H */
@@ -73,17 +73,28 @@ static av_cold void split_uninit(AVFilterContext *ctx)
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
     AVFilterContext *ctx = inlink->dst;
-    int i, ret = AVERROR_EOF;
+    int i, nb_left = 0, ret = AVERROR_EOF;
 
+    for (i = 0; i < ctx->nb_outputs; i++)
+        nb_left += !ctx->outputs[i]->status;
+
+    /* Hand the input reference itself to the last output, so that it gets
+     * a writable frame if it works in place and the other outputs are done
+     * with theirs. */
     for (i = 0; i < ctx->nb_outputs; i++) {
         AVFrame *buf_out;
 
         if (ctx->outputs[i]->status)
             continue;
-        buf_out = av_frame_clone(frame);
-        if (!buf_out) {
-            ret = AVERROR(ENOMEM);
-            break;
+        if (--nb_left) {
+            buf_out = av_frame_clone(frame);
+            if (!buf_out) {
+                ret = AVERROR(ENOMEM);
+                break;
+            }
+        } else {
+            buf_out = frame;
+            frame   = NULL;
         }
 
         ret = ff_filter_frame(ctx->outputs[i], buf_out);
@@ -0,0 +1,161 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Run small graphs ending in buffersinks and print the checksums of the
+ * frames of each sink, then the statistics of the graph frame pools: the
+ * buffers must be reused, and a split must hand a writable frame to an
+ * in-place filter on its last output only.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/frame.h"
+#include "libavutil/pixdesc.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+#define MAX_SINKS 2
+
+static uint32_t frame_checksum(const AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    uint32_t checksum = 0;
+    int p, y;
+
+    for (p = 0; p < 4 && frame->data[p]; p++) {
+        int w = frame->width, h = frame->height;
+
+        if (p == 1 || p == 2) {
+            w = AV_CEIL_RSHIFT(w, desc->log2_chroma_w);
+            h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
+        }
+        for (y = 0; y < h; y++)
+            checksum = av_adler32_update(checksum,
+                                         frame->data[p] + y * frame->linesize[p],
+                                         w);
+    }
+    return checksum;
+}
+
+static int run_graph(const char *desc)
+{
+    AVFilterGraph *graph;
+    AVFilterInOut *inputs = NULL, *outputs = NULL, *out;
+    AVFilterContext *sinks[MAX_SINKS];
+    const char *labels[MAX_SINKS];
+    AVFrame *frame = av_frame_alloc();
+    int nb_sinks = 0, nb_eof = 0, eof[MAX_SINKS] = { 0 };
+    int nb_requested, nb_allocated, nb_in_place;
+    int i, ret;
+
+    printf("%s\n", desc);
+
+    graph = avfilter_graph_alloc();
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = 1;
+
+    ret = avfilter_graph_parse2(graph, desc, &inputs, &outputs);
+    if (ret < 0)
+        goto end;
+    for (out = outputs; out; out = out->next) {
+        char name[16];
+
+        if (nb_sinks == MAX_SINKS) {
+            ret = AVERROR(EINVAL);
+            goto end;
+        }
+        labels[nb_sinks] = out->name ? out->name : "out";
+        snprintf(name, sizeof(name), "sink%d", nb_sinks);
+        ret = avfilter_graph_create_filter(&sinks[nb_sinks],
+                                           avfilter_get_by_name("buffersink"),
+                                           name, NULL, NULL, graph);
+        if (ret < 0)
+            goto end;
+        ret = avfilter_link(out->filter_ctx, out->pad_idx, sinks[nb_sinks], 0);
+        if (ret < 0)
+            goto end;
+        nb_sinks++;
+    }
+    ret = avfilter_graph_config(graph, NULL);
+    if (ret < 0)
+        goto end;
+
+    while (nb_eof < nb_sinks) {
+        for (i = 0; i < nb_sinks; i++) {
+            if (eof[i])
+                continue;
+            ret = av_buffersink_get_frame(sinks[i], frame);
+            if (ret == AVERROR_EOF) {
+                eof[i] = 1;
+                nb_eof++;
+                continue;
+            }
+            if (ret < 0)
+                goto end;
+            printf("%-4s pts %3"PRId64" checksum 0x%08"PRIx32"\n",
+                   labels[i], frame->pts, frame_checksum(frame));
+            av_frame_unref(frame);
+        }
+    }
+
+    avfilter_graph_get_frame_pool_stats(graph, &nb_requested, &nb_allocated,
+                                        &nb_in_place);
+    printf("requested %d allocated %d in place %d\n\n",
+           nb_requested, nb_allocated, nb_in_place);
+    ret = 0;
+
+end:
+    if (ret < 0)
+        printf("error %d\n", ret);
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    avfilter_graph_free(&graph);
+    av_frame_free(&frame);
+    return ret;
+}
+
+static const char *const graphs[] = {
+    /* the buffers of the source and of hflip come back to the pools */
+    "testsrc2=s=64x48:r=10:d=0.5,format=yuv420p,hflip",
+    /* lut is served last and finds the frame writable */
+    "testsrc2=s=64x48:r=10:d=0.5,format=yuv420p,split[a][b];"
+    "[a]hflip[out0];[b]lut=y=negval[out1]",
+    /* lut shares the frame with the second output and needs a copy */
+    "testsrc2=s=64x48:r=10:d=0.5,format=yuv420p,split[a][b];"
+    "[a]lut=y=negval[out0];[b]hflip[out1]",
+};
+
+int main(void)
+{
+    int i;
+
+    avfilter_register_all();
+
+    for (i = 0; i < FF_ARRAY_ELEMS(graphs); i++)
+        if (run_graph(graphs[i]) < 0)
+            return 1;
+
+    return 0;
+}
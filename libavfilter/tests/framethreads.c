@@ -0,0 +1,217 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that graphs of several frame threaded filters output exactly the
+ * frames of the single threaded graph, in the same order, with commands
+ * sent while frames are queued in the filters.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/common.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/log.h"
+#include "libavutil/pixdesc.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+#define MAX_FILTERS 12
+#define MAX_FRAMES  64
+
+/* the frames of the graph are pulled from the output of the last filter */
+typedef struct FilterDesc {
+    const char *name;
+    const char *args;
+    int src[2];             ///< filters linked to the inputs, -1 for none
+} FilterDesc;
+
+static const FilterDesc graph_chain[] = {
+    { "testsrc2",          "s=96x72:r=25:d=2",   { -1, -1 } },
+    { "format",            "rgb24",              {  0, -1 } },
+    { "lutrgb",            "r=negval",           {  1, -1 } },
+    { "hflip",             NULL,                 {  2, -1 } },
+    { "curves",            "preset=vintage",     {  3, -1 } },
+    { "colorlevels",       "rimin=0.1",          {  4, -1 } },
+    { "colorbalance",      "rs=0.3:bh=-0.2",     {  5, -1 } },
+    { "colorchannelmixer", "rr=0.5:rb=0.5",      {  6, -1 } },
+    { "transpose",         "clock",              {  7, -1 } },
+    { NULL },
+};
+
+static const FilterDesc graph_split[] = {
+    { "testsrc2",          "s=64x48:r=25:d=1.8", { -1, -1 } },
+    { "format",            "yuv420p",            {  0, -1 } },
+    { "split",             NULL,                 {  1, -1 } },
+    { "lut",               "y=negval",           {  2, -1 } },
+    { "hflip",             NULL,                 {  3, -1 } },
+    { "transpose",         "cclock_flip",        {  2, -1 } },
+    { "transpose",         "clock_flip",         {  5, -1 } },
+    { "hstack",            NULL,                 {  4,  6 } },
+    { NULL },
+};
+
+static const FilterDesc *const graphs[] = { graph_chain, graph_split };
+
+static const int nb_threads[] = { 2, 3, 8 };
+
+static uint32_t frame_checksum(const AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    uint32_t checksum = 0;
+    int p, y;
+
+    for (p = 0; p < 4 && frame->data[p]; p++) {
+        int w = av_image_get_linesize(frame->format, frame->width, p);
+        int h = frame->height;
+
+        if (p == 1 || p == 2)
+            h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
+        for (y = 0; y < h; y++)
+            checksum = av_adler32_update(checksum,
+                                         frame->data[p] + y * frame->linesize[p],
+                                         w);
+    }
+    return checksum;
+}
+
+/**
+ * Run a graph and store the checksums of its output frames.
+ *
+ * @return the number of frames, or a negative error code
+ */
+static int run_graph(const FilterDesc *desc, int threads,
+                     uint32_t checksums[MAX_FRAMES], int *nb_frame_threaded)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *filters[MAX_FILTERS + 1];
+    int nb_outputs[MAX_FILTERS] = { 0 };
+    AVFrame *frame = av_frame_alloc();
+    int i, j, nb_filters, nb_frames = 0, ret;
+
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads  = threads;
+    graph->thread_type = AVFILTER_THREAD_SLICE | AVFILTER_THREAD_FRAME;
+
+    for (nb_filters = 0; desc[nb_filters].name; nb_filters++) {
+        const FilterDesc *d = &desc[nb_filters];
+        AVFilterContext *ctx;
+
+        ctx = avfilter_graph_alloc_filter(graph, avfilter_get_by_name(d->name),
+                                          NULL);
+        if (!ctx) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        ctx->thread_type = AVFILTER_THREAD_SLICE | AVFILTER_THREAD_FRAME;
+        if ((ret = avfilter_init_str(ctx, d->args)) < 0)
+            goto end;
+        for (j = 0; j < FF_ARRAY_ELEMS(d->src) && d->src[j] >= 0; j++) {
+            ret = avfilter_link(filters[d->src[j]], nb_outputs[d->src[j]]++,
+                                ctx, j);
+            if (ret < 0)
+                goto end;
+        }
+        filters[nb_filters] = ctx;
+    }
+    ret = avfilter_graph_create_filter(&filters[nb_filters],
+                                       avfilter_get_by_name("buffersink"),
+                                       "sink", NULL, NULL, graph);
+    if (ret < 0 ||
+        (ret = avfilter_link(filters[nb_filters - 1], 0,
+                             filters[nb_filters], 0)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    *nb_frame_threaded = 0;
+    for (i = 0; i < graph->nb_filters; i++)
+        *nb_frame_threaded += graph->filters[i]->thread_type == AVFILTER_THREAD_FRAME;
+
+    while ((ret = av_buffersink_get_frame(filters[nb_filters], frame)) >= 0) {
+        if (nb_frames == MAX_FRAMES) {
+            ret = AVERROR(ENOSPC);
+            goto end;
+        }
+        checksums[nb_frames++] = frame_checksum(frame);
+        av_frame_unref(frame);
+
+        /* flushes the frames queued for the threads */
+        if (!(nb_frames % 7)) {
+            ret = avfilter_graph_send_command(graph, "all", "ping", "",
+                                              NULL, 0, 0);
+            if (ret < 0 && ret != AVERROR(ENOSYS))
+                goto end;
+        }
+    }
+    if (ret == AVERROR_EOF)
+        ret = nb_frames;
+
+end:
+    avfilter_graph_free(&graph);
+    av_frame_free(&frame);
+    return ret;
+}
+
+int main(void)
+{
+    uint32_t checksums_ref[MAX_FRAMES], checksums[MAX_FRAMES];
+    int i, j, nb_frame_threaded, ret = 0;
+
+    av_log_set_level(AV_LOG_ERROR);
+    avfilter_register_all();
+
+    for (i = 0; i < FF_ARRAY_ELEMS(graphs); i++) {
+        int nb_frames_ref = run_graph(graphs[i], 1, checksums_ref,
+                                      &nb_frame_threaded);
+
+        if (nb_frames_ref <= 0) {
+            fprintf(stderr, "graph %d: 1 thread failed\n", i);
+            ret = 1;
+            continue;
+        }
+
+        for (j = 0; j < FF_ARRAY_ELEMS(nb_threads); j++) {
+            int nb_frames = run_graph(graphs[i], nb_threads[j], checksums,
+                                      &nb_frame_threaded);
+
+            if (nb_frames < 0)
+                fprintf(stderr, "graph %d: %d threads failed\n",
+                        i, nb_threads[j]);
+            else if (!nb_frame_threaded)
+                fprintf(stderr, "graph %d: %d threads did not use frame threads\n",
+                        i, nb_threads[j]);
+            else if (nb_frames != nb_frames_ref ||
+                     memcmp(checksums, checksums_ref,
+                            nb_frames * sizeof(*checksums)))
+                fprintf(stderr, "graph %d: %d threads differ from 1 thread\n",
+                        i, nb_threads[j]);
+            else
+                continue;
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
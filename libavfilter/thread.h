@@ -25,4 +25,62 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Set up frame threading for a filter with AVFILTER_FLAG_FRAME_THREADS. The
+ * frames are filtered by the jobs of the graph execute function.
+ */
+int ff_filter_frame_thread_init(AVFilterContext *ctx);
+
+/**
+ * Free the frame threading state of a filter, dropping the queued frames.
+ */
+void ff_filter_frame_thread_free(AVFilterContext *ctx);
+
+/**
+ * Queue a frame to be filtered with filter_frame. Once a frame is queued for
+ * each thread, the queued frames are filtered concurrently and their output
+ * is sent on in order.
+ */
+int ff_filter_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                  int (*filter_frame)(AVFilterLink *, AVFrame *));
+
+/**
+ * Store a frame output on link by a job of its source filter, to be sent on
+ * later by the thread that submitted the input frame.
+ *
+ * @return 1 if the frame was stored, 0 if not called from a job,
+ *         a negative error code on failure
+ */
+int ff_filter_frame_thread_capture(AVFilterLink *link, AVFrame *frame);
+
+/**
+ * Lock or unlock the mutex serializing the buffer requests that the jobs of
+ * a frame threaded filter make on its output links.
+ */
+void ff_filter_frame_thread_lock(AVFilterContext *ctx);
+void ff_filter_frame_thread_unlock(AVFilterContext *ctx);
+
+/**
+ * Filter all the queued frames and send on their output.
+ *
+ * @return the number of input frames whose output was sent or a negative
+ *         error code
+ */
+int ff_filter_frame_thread_flush(AVFilterContext *ctx);
+
+/**
+ * Flush all the frame threaded filters feeding ctx, directly or not, so that
+ * the frames they still hold reach ctx before its state is changed by a
+ * command, as they would without frame threading.
+ *
+ * @return 0 on success, a negative error code on failure
+ */
+int ff_filter_frame_thread_flush_inputs(AVFilterContext *ctx);
+
+/**
+ * Filter all the queued frames, without sending their output. Must be
+ * called before changing the filter state, e.g. when processing a command.
+ */
+void ff_filter_frame_thread_wait(AVFilterContext *ctx);
+
 #endif /* AVFILTER_THREAD_H */
@@ -65,7 +65,8 @@ typedef struct UnsharpFilterParam {
     int steps_y;                             ///< vertical step count
     int scalebits;                           ///< bits to shift pixel
     int32_t halfscale;                       ///< amount to add to pixel
-    uint32_t *sc[MAX_MATRIX_SIZE - 1];       ///< finite state machine storage
+    uint32_t *sc;                            ///< finite state machine storage, 2 * steps_y rows plus a row sum line per thread
+    ptrdiff_t sc_stride;                     ///< distance between sc rows, in elements
 } UnsharpFilterParam;
 
 typedef struct UnsharpContext {
@@ -75,11 +76,30 @@ typedef struct UnsharpContext {
     UnsharpFilterParam luma;   ///< luma parameters (width, height, amount)
     UnsharpFilterParam chroma; ///< chroma parameters (width, height, amount)
     int hsub, vsub;
+    int nb_threads;
     int opencl;
 #if CONFIG_OPENCL
     UnsharpOpenclContext opencl_ctx;
 #endif
     int (* apply_unsharp)(AVFilterContext *ctx, AVFrame *in, AVFrame *out);
+
+    /**
+     * Run the vertical part of the blur on one line of horizontal sums.
+     * row is replaced by the full blur sums, sc holds the 2 * steps rows
+     * of column state. May process up to 7 elements past width.
+     */
+    void (*vblur_row)(uint32_t *sc, ptrdiff_t sc_stride, uint32_t *row,
+                      int steps, int width);
+
+    /**
+     * Sharpen or blur one line of src with the blur sums in blur.
+     * @return the number of pixels written, the caller handles the rest
+     */
+    int (*sharpen_row)(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                       int width, int amount, int scalebits, int32_t halfscale);
 } UnsharpContext;
 
+void ff_unsharp_init(UnsharpContext *s);
+void ff_unsharp_init_x86(UnsharpContext *s);
+
 #endif /* AVFILTER_UNSHARP_H */
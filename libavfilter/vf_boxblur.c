@@ -28,9 +28,11 @@
 #include "libavutil/avstring.h"
 #include "libavutil/common.h"
 #include "libavutil/eval.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "avfilter.h"
+#include "boxblur.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -70,9 +72,22 @@ typedef struct BoxBlurContext {
     int hsub, vsub;
     int radius[4];
     int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
+    int nb_jobs;      ///< number of bands each plane is split into
+    uint8_t *temp;    ///< temporary buffers of the jobs
+    int temp_size;    ///< size of the temporary buffers of a job
+    BoxBlurDSPContext dsp;
 } BoxBlurContext;
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int nb_planes;
+    int w[4], h[4];
+    int pixsize;
+} ThreadData;
+
+/* number of columns blurred together by the vertical pass */
+#define BLOCK_WIDTH 64
+
 #define Y 0
 #define U 1
 #define V 2
@@ -111,8 +126,7 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     BoxBlurContext *s = ctx->priv;
 
-    av_freep(&s->temp[0]);
-    av_freep(&s->temp[1]);
+    av_freep(&s->temp);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -143,10 +157,18 @@ static int config_input(AVFilterLink *inlink)
     char *expr;
     int ret;
 
-    if (!(s->temp[0] = av_malloc(2*FFMAX(w, h))) ||
-        !(s->temp[1] = av_malloc(2*FFMAX(w, h))))
+    /* the running sums of a block of columns, then two rows of the
+     * horizontal pass or two blocks of columns of the vertical pass */
+    s->nb_jobs   = ff_filter_get_nb_threads(ctx);
+    s->temp_size = FFALIGN(BLOCK_WIDTH * sizeof(uint32_t) +
+                           2 * FFMAX(w, h * BLOCK_WIDTH) * 2, 64);
+    av_freep(&s->temp);
+    s->temp = av_malloc_array(4 * s->nb_jobs, s->temp_size);
+    if (!s->temp)
         return AVERROR(ENOMEM);
 
+    ff_boxblur_init(&s->dsp);
+
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
 
@@ -306,17 +328,185 @@ static void hblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_li
                    w, radius, power, temp, pixsize);
 }
 
-static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
-                  int w, int h, int radius, int power, uint8_t *temp[2], int pixsize)
+static int blur_row8_c(uint32_t *sum, uint8_t *dst, const uint8_t *add,
+                       const uint8_t *sub, int inv, int width)
 {
-    int x;
+    int i;
 
-    if (radius == 0 && dst == src)
-        return;
+    for (i = 0; i < width; i++) {
+        sum[i] += (add[i] - sub[i]) * inv;
+        dst[i] = sum[i] >> 16;
+    }
+    return width;
+}
+
+static int blur_row16_c(uint32_t *sum, uint16_t *dst, const uint16_t *add,
+                        const uint16_t *sub, int inv, int width)
+{
+    int i;
+
+    for (i = 0; i < width; i++) {
+        sum[i] += (add[i] - sub[i]) * inv;
+        dst[i] = sum[i] >> 16;
+    }
+    return width;
+}
+
+av_cold void ff_boxblur_init(BoxBlurDSPContext *dsp)
+{
+    dsp->blur_row8  = blur_row8_c;
+    dsp->blur_row16 = blur_row16_c;
+
+    if (ARCH_X86)
+        ff_boxblur_init_x86(dsp);
+}
 
+/* Same as blur8() and blur16() along the columns of a block, a row at a
+ * time so that the memory is accessed sequentially. */
+static void blur_rows(const BoxBlurDSPContext *dsp, uint8_t *dst, int dst_linesize,
+                      const uint8_t *src, int src_linesize, int w, int len, int radius,
+                      uint32_t *sum, int pixsize)
+{
+    const int length = radius*2 + 1;
+    const int inv = ((1<<16) + length/2)/length;
+    int x, y, add, sub, i;
+
+    if (pixsize == 1) {
+        for (x = 0; x < w; x++)
+            sum[x] = src[radius*src_linesize + x];
+        for (y = 0; y < radius; y++)
+            for (x = 0; x < w; x++)
+                sum[x] += src[y*src_linesize + x]<<1;
+    } else {
+        for (x = 0; x < w; x++)
+            sum[x] = AV_RN16A(src + radius*src_linesize + 2*x);
+        for (y = 0; y < radius; y++)
+            for (x = 0; x < w; x++)
+                sum[x] += AV_RN16A(src + y*src_linesize + 2*x)<<1;
+    }
     for (x = 0; x < w; x++)
-        blur_power(dst + x*pixsize, dst_linesize, src + x*pixsize, src_linesize,
-                   h, radius, power, temp, pixsize);
+        sum[x] = sum[x]*inv + (1<<15);
+
+    for (y = 0; y < len; y++) {
+        if (y <= radius) {
+            add = radius + y;
+            sub = radius - y;
+        } else if (y < len - radius) {
+            add = radius + y;
+            sub = y - radius - 1;
+        } else {
+            add = 2*len - radius - y - 1;
+            sub = y - radius - 1;
+        }
+        if (pixsize == 1) {
+            uint8_t *d = dst + y*dst_linesize;
+            const uint8_t *a = src + add*src_linesize;
+            const uint8_t *b = src + sub*src_linesize;
+            i = dsp->blur_row8(sum, d, a, b, inv, w);
+            blur_row8_c(sum + i, d + i, a + i, b + i, inv, w - i);
+        } else {
+            uint16_t *d = (uint16_t *)(dst + y*dst_linesize);
+            const uint16_t *a = (const uint16_t *)(src + add*src_linesize);
+            const uint16_t *b = (const uint16_t *)(src + sub*src_linesize);
+            i = dsp->blur_row16(sum, d, a, b, inv, w);
+            blur_row16_c(sum + i, d + i, a + i, b + i, inv, w - i);
+        }
+    }
+}
+
+static void copy_rows(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
+                      int w, int h, int pixsize)
+{
+    int y;
+
+    for (y = 0; y < h; y++)
+        memcpy(dst + y*dst_linesize, src + y*src_linesize, w*pixsize);
+}
+
+/* blur_power() of a block of columns, with the passes done by blur_rows() */
+static void vblur(const BoxBlurDSPContext *dsp, uint8_t *dst, int dst_linesize,
+                  const uint8_t *src, int src_linesize, int w, int h, int radius,
+                  int power, uint8_t *temp[2], uint32_t *sum, int pixsize)
+{
+    const int linesize = BLOCK_WIDTH * pixsize;
+    uint8_t *a = temp[0], *b = temp[1];
+
+    if (radius && power) {
+        blur_rows(dsp, a, linesize, src, src_linesize, w, h, radius, sum, pixsize);
+        for (; power > 2; power--) {
+            blur_rows(dsp, b, linesize, a, linesize, w, h, radius, sum, pixsize);
+            FFSWAP(uint8_t *, a, b);
+        }
+        if (power > 1)
+            blur_rows(dsp, dst, dst_linesize, a, linesize, w, h, radius, sum, pixsize);
+        else
+            copy_rows(dst, dst_linesize, a, linesize, w, h, pixsize);
+    } else if (dst != src) {
+        copy_rows(dst, dst_linesize, src, src_linesize, w, h, pixsize);
+    }
+}
+
+static void get_temp(BoxBlurContext *s, int jobnr, uint8_t *temp[2], uint32_t **sum)
+{
+    uint8_t *buf = s->temp + jobnr * s->temp_size;
+    const int size = (s->temp_size - BLOCK_WIDTH * sizeof(uint32_t)) / 2;
+
+    *sum    = (uint32_t *)buf;
+    temp[0] = buf + BLOCK_WIDTH * sizeof(uint32_t);
+    temp[1] = temp[0] + size;
+}
+
+/* each job blurs a band of rows of a plane */
+static int hblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int plane = jobnr % td->nb_planes;
+    const int nb_bands = nb_jobs / td->nb_planes;
+    const int band = jobnr / td->nb_planes;
+    const int h = td->h[plane];
+    const int slice_start = (h *  band   ) / nb_bands;
+    const int slice_end   = (h * (band+1)) / nb_bands;
+    const int dst_linesize = td->out->linesize[plane];
+    const int src_linesize = td->in ->linesize[plane];
+    uint8_t *temp[2];
+    uint32_t *sum;
+
+    get_temp(s, jobnr, temp, &sum);
+    hblur(td->out->data[plane] + slice_start * dst_linesize, dst_linesize,
+          td->in ->data[plane] + slice_start * src_linesize, src_linesize,
+          td->w[plane], slice_end - slice_start, s->radius[plane], s->power[plane],
+          temp, td->pixsize);
+    return 0;
+}
+
+/* each job blurs a band of columns of a plane, by blocks of BLOCK_WIDTH */
+static int vblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int plane = jobnr % td->nb_planes;
+    const int nb_bands = nb_jobs / td->nb_planes;
+    const int band = jobnr / td->nb_planes;
+    const int w = td->w[plane];
+    const int slice_start = (w *  band   ) / nb_bands;
+    const int slice_end   = (w * (band+1)) / nb_bands;
+    const int pixsize = td->pixsize;
+    const int linesize = td->out->linesize[plane];
+    uint8_t *data = td->out->data[plane];
+    uint8_t *temp[2];
+    uint32_t *sum;
+    int x;
+
+    if (s->radius[plane] == 0)
+        return 0;
+
+    get_temp(s, jobnr, temp, &sum);
+    for (x = slice_start; x < slice_end; x += BLOCK_WIDTH)
+        vblur(&s->dsp, data + x * pixsize, linesize, data + x * pixsize, linesize,
+              FFMIN(BLOCK_WIDTH, slice_end - x), td->h[plane],
+              s->radius[plane], s->power[plane], temp, sum, pixsize);
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
@@ -331,7 +521,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     int h[4] = { in->height, ch, ch, in->height };
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     const int depth = desc->comp[0].depth;
-    const int pixsize = (depth+7)/8;
+    ThreadData td;
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -340,17 +530,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++)
-        hblur(out->data[plane], out->linesize[plane],
-              in ->data[plane], in ->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp, pixsize);
+    td.in      = in;
+    td.out     = out;
+    td.pixsize = (depth+7)/8;
+    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++) {
+        td.w[plane] = w[plane];
+        td.h[plane] = h[plane];
+    }
+    td.nb_planes = plane;
 
-    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++)
-        vblur(out->data[plane], out->linesize[plane],
-              out->data[plane], out->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp, pixsize);
+    ctx->internal->execute(ctx, hblur_slice, &td, NULL, td.nb_planes * s->nb_jobs);
+    ctx->internal->execute(ctx, vblur_slice, &td, NULL, td.nb_planes * s->nb_jobs);
 
     av_frame_free(&in);
 
@@ -409,5 +599,5 @@ AVFilter ff_vf_boxblur = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_boxblur_inputs,
     .outputs       = avfilter_vf_boxblur_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -84,6 +84,7 @@ static int query_formats(AVFilterContext *ctx)
     AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
     if (!fmts_list)
         return AVERROR(ENOMEM);
+    ctx->inputs[0]->in_place = 1;
     return ff_set_common_formats(ctx, fmts_list);
 }
 
@@ -358,5 +359,5 @@ AVFilter ff_vf_colorchannelmixer = {
     .query_formats = query_formats,
     .inputs        = colorchannelmixer_inputs,
     .outputs       = colorchannelmixer_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_FRAME_THREADS,
 };
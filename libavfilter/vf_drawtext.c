@@ -52,6 +52,7 @@
 #include "libavutil/random_seed.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/timecode.h"
+#include "libavutil/thread.h"
 #include "libavutil/time_internal.h"
 #include "libavutil/tree.h"
 #include "libavutil/lfg.h"
@@ -134,6 +135,8 @@ enum expansion_mode {
     EXP_STRFTIME,
 };
 
+struct GlyphCache;
+
 typedef struct DrawTextContext {
     const AVClass *class;
     int exp_mode;                   ///< expansion mode to use for the text
@@ -173,7 +176,10 @@ typedef struct DrawTextContext {
     FT_Library library;             ///< freetype font library handle
     FT_Face face;                   ///< freetype font face handle
     FT_Stroker stroker;             ///< freetype stroker handle
-    struct AVTreeNode *glyphs;      ///< rendered glyphs, stored using the UTF-32 char code
+    char *font_path;                ///< path of the loaded font file
+    int font_index;                 ///< index of the loaded face in the font file
+    struct GlyphCache *glyph_cache; ///< shared cache of the glyphs rendered with the font
+    struct AVTreeNode *glyphs;      ///< glyphs used by this instance, stored using the UTF-32 char code
     char *x_expr;                   ///< expression for x position
     char *y_expr;                   ///< expression for y position
     AVExpr *x_pexpr, *y_pexpr;      ///< parsed expressions for x and y
@@ -277,8 +283,6 @@ static const struct ft_error
 #define FT_ERRMSG(e) ft_errors[e].err_msg
 
 typedef struct Glyph {
-    FT_Glyph glyph;
-    FT_Glyph border_glyph;
     uint32_t code;
     FT_Bitmap bitmap; ///< array holding bitmaps of font
     FT_Bitmap border_bitmap; ///< array holding bitmaps of font border
@@ -288,6 +292,26 @@ typedef struct Glyph {
     int bitmap_top;
 } Glyph;
 
+/**
+ * Glyphs rendered from one face at one size, shared by all the filter
+ * instances using the same font settings in the process.
+ * Lookups and insertions are done with glyph_cache_mutex held.
+ */
+typedef struct GlyphCache {
+    char *font_path;
+    int font_index;
+    unsigned int fontsize;
+    int borderw;
+    int ft_load_flags;
+    struct AVTreeNode *glyphs;      ///< rendered glyphs, stored using the UTF-32 char code
+    int refcount;
+    struct GlyphCache *next;
+} GlyphCache;
+
+static GlyphCache *glyph_caches;
+static AVMutex glyph_cache_mutex;
+static AVOnce glyph_cache_once = AV_ONCE_INIT;
+
 static int glyph_cmp(const void *key, const void *b)
 {
     const Glyph *a = key, *bb = b;
@@ -295,12 +319,37 @@ static int glyph_cmp(const void *key, const void *b)
     return diff > 0 ? 1 : diff < 0 ? -1 : 0;
 }
 
+static int copy_bitmap(FT_Bitmap *dst, const FT_Bitmap *src)
+{
+    size_t size = (size_t)FFABS(src->pitch) * src->rows;
+
+    *dst = *src;
+    dst->buffer = NULL;
+    if (!size)
+        return 0;
+    if (!(dst->buffer = av_malloc(size)))
+        return AVERROR(ENOMEM);
+    memcpy(dst->buffer, src->buffer, size);
+    return 0;
+}
+
+static void glyph_free(Glyph *glyph)
+{
+    av_freep(&glyph->bitmap.buffer);
+    av_freep(&glyph->border_bitmap.buffer);
+    av_free(glyph);
+}
+
 /**
- * Load glyphs corresponding to the UTF-32 codepoint code.
+ * Render the glyphs corresponding to the UTF-32 codepoint code and add
+ * them to the shared glyph cache, must be called with the cache locked.
+ * Only the bitmaps are kept, so that the cache does not depend on the
+ * FreeType library of the instance.
  */
-static int load_glyph(AVFilterContext *ctx, Glyph **glyph_ptr, uint32_t code)
+static int render_glyph(AVFilterContext *ctx, Glyph **glyph_ptr, uint32_t code)
 {
     DrawTextContext *s = ctx->priv;
+    FT_Glyph ft_glyph = NULL, border_glyph = NULL;
     FT_BitmapGlyph bitmapglyph;
     Glyph *glyph;
     struct AVTreeNode *node = NULL;
@@ -317,54 +366,158 @@ static int load_glyph(AVFilterContext *ctx, Glyph **glyph_ptr, uint32_t code)
     }
     glyph->code  = code;
 
-    if (FT_Get_Glyph(s->face->glyph, &glyph->glyph)) {
+    if (FT_Get_Glyph(s->face->glyph, &ft_glyph)) {
         ret = AVERROR(EINVAL);
         goto error;
     }
     if (s->borderw) {
-        glyph->border_glyph = glyph->glyph;
-        if (FT_Glyph_StrokeBorder(&glyph->border_glyph, s->stroker, 0, 0) ||
-            FT_Glyph_To_Bitmap(&glyph->border_glyph, FT_RENDER_MODE_NORMAL, 0, 1)) {
+        border_glyph = ft_glyph;
+        if (FT_Glyph_StrokeBorder(&border_glyph, s->stroker, 0, 0) ||
+            FT_Glyph_To_Bitmap(&border_glyph, FT_RENDER_MODE_NORMAL, 0, 1)) {
             ret = AVERROR_EXTERNAL;
             goto error;
         }
-        bitmapglyph = (FT_BitmapGlyph) glyph->border_glyph;
-        glyph->border_bitmap = bitmapglyph->bitmap;
+        bitmapglyph = (FT_BitmapGlyph) border_glyph;
+        if ((ret = copy_bitmap(&glyph->border_bitmap, &bitmapglyph->bitmap)) < 0)
+            goto error;
     }
-    if (FT_Glyph_To_Bitmap(&glyph->glyph, FT_RENDER_MODE_NORMAL, 0, 1)) {
+    if (FT_Glyph_To_Bitmap(&ft_glyph, FT_RENDER_MODE_NORMAL, 0, 1)) {
         ret = AVERROR_EXTERNAL;
         goto error;
     }
-    bitmapglyph = (FT_BitmapGlyph) glyph->glyph;
+    bitmapglyph = (FT_BitmapGlyph) ft_glyph;
 
-    glyph->bitmap      = bitmapglyph->bitmap;
+    if ((ret = copy_bitmap(&glyph->bitmap, &bitmapglyph->bitmap)) < 0)
+        goto error;
     glyph->bitmap_left = bitmapglyph->left;
     glyph->bitmap_top  = bitmapglyph->top;
     glyph->advance     = s->face->glyph->advance.x >> 6;
 
     /* measure text height to calculate text_height (or the maximum text height) */
-    FT_Glyph_Get_CBox(glyph->glyph, ft_glyph_bbox_pixels, &glyph->bbox);
+    FT_Glyph_Get_CBox(ft_glyph, ft_glyph_bbox_pixels, &glyph->bbox);
 
     /* cache the newly created glyph */
     if (!(node = av_tree_node_alloc())) {
         ret = AVERROR(ENOMEM);
         goto error;
     }
-    av_tree_insert(&s->glyphs, glyph, glyph_cmp, &node);
+    av_tree_insert(&s->glyph_cache->glyphs, glyph, glyph_cmp, &node);
 
-    if (glyph_ptr)
-        *glyph_ptr = glyph;
+    FT_Done_Glyph(ft_glyph);
+    FT_Done_Glyph(border_glyph);
+    *glyph_ptr = glyph;
     return 0;
 
 error:
+    if (border_glyph != ft_glyph)
+        FT_Done_Glyph(border_glyph);
+    FT_Done_Glyph(ft_glyph);
     if (glyph)
-        av_freep(&glyph->glyph);
-
-    av_freep(&glyph);
+        glyph_free(glyph);
     av_freep(&node);
     return ret;
 }
 
+/**
+ * Load glyphs corresponding to the UTF-32 codepoint code.
+ */
+static int load_glyph(AVFilterContext *ctx, Glyph **glyph_ptr, uint32_t code)
+{
+    DrawTextContext *s = ctx->priv;
+    Glyph dummy = { 0 }, *glyph;
+    struct AVTreeNode *node;
+    int ret = 0;
+
+    ff_mutex_lock(&glyph_cache_mutex);
+    dummy.code = code;
+    glyph = av_tree_find(s->glyph_cache->glyphs, &dummy, glyph_cmp, NULL);
+    if (!glyph)
+        ret = render_glyph(ctx, &glyph, code);
+    ff_mutex_unlock(&glyph_cache_mutex);
+    if (ret < 0)
+        return ret;
+
+    /* reference it locally, so that drawing does not need the lock */
+    if (!(node = av_tree_node_alloc()))
+        return AVERROR(ENOMEM);
+    av_tree_insert(&s->glyphs, glyph, glyph_cmp, &node);
+    av_free(node);
+
+    if (glyph_ptr)
+        *glyph_ptr = glyph;
+    return 0;
+}
+
+static int glyph_enu_free(void *opaque, void *elem)
+{
+    glyph_free(elem);
+    return 0;
+}
+
+static void glyph_cache_init(void)
+{
+    ff_mutex_init(&glyph_cache_mutex, NULL);
+}
+
+/**
+ * Get the glyph cache matching the font settings, creating it if needed.
+ */
+static int glyph_cache_acquire(DrawTextContext *s)
+{
+    GlyphCache *c;
+
+    ff_thread_once(&glyph_cache_once, glyph_cache_init);
+    ff_mutex_lock(&glyph_cache_mutex);
+    for (c = glyph_caches; c; c = c->next)
+        if (!strcmp(c->font_path, s->font_path) &&
+            c->font_index    == s->font_index    &&
+            c->fontsize      == s->fontsize      &&
+            c->borderw       == s->borderw       &&
+            c->ft_load_flags == s->ft_load_flags)
+            break;
+    if (!c) {
+        c = av_mallocz(sizeof(*c));
+        if (c && !(c->font_path = av_strdup(s->font_path)))
+            av_freep(&c);
+        if (!c) {
+            ff_mutex_unlock(&glyph_cache_mutex);
+            return AVERROR(ENOMEM);
+        }
+        c->font_index    = s->font_index;
+        c->fontsize      = s->fontsize;
+        c->borderw       = s->borderw;
+        c->ft_load_flags = s->ft_load_flags;
+        c->next          = glyph_caches;
+        glyph_caches     = c;
+    }
+    c->refcount++;
+    s->glyph_cache = c;
+    ff_mutex_unlock(&glyph_cache_mutex);
+
+    return 0;
+}
+
+static void glyph_cache_release(DrawTextContext *s)
+{
+    GlyphCache *c = s->glyph_cache, **cp;
+
+    if (!c)
+        return;
+
+    ff_mutex_lock(&glyph_cache_mutex);
+    if (!--c->refcount) {
+        for (cp = &glyph_caches; *cp != c; cp = &(*cp)->next)
+            ;
+        *cp = c->next;
+        av_tree_enumerate(c->glyphs, NULL, NULL, glyph_enu_free);
+        av_tree_destroy(c->glyphs);
+        av_freep(&c->font_path);
+        av_free(c);
+    }
+    ff_mutex_unlock(&glyph_cache_mutex);
+    s->glyph_cache = NULL;
+}
+
 static int load_font_file(AVFilterContext *ctx, const char *path, int index)
 {
     DrawTextContext *s = ctx->priv;
@@ -378,6 +531,11 @@ static int load_font_file(AVFilterContext *ctx, const char *path, int index)
 #endif
         return AVERROR(EINVAL);
     }
+
+    av_freep(&s->font_path);
+    if (!(s->font_path = av_strdup(path)))
+        return AVERROR(ENOMEM);
+    s->font_index = index;
     return 0;
 }
 
@@ -666,6 +824,9 @@ static av_cold int init(AVFilterContext *ctx)
 
     s->use_kerning = FT_HAS_KERNING(s->face);
 
+    if ((err = glyph_cache_acquire(s)) < 0)
+        return err;
+
     /* load the fallback glyph with code 0 */
     load_glyph(ctx, NULL, 0);
 
@@ -691,16 +852,6 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, ff_draw_supported_pixel_formats(0));
 }
 
-static int glyph_enu_free(void *opaque, void *elem)
-{
-    Glyph *glyph = elem;
-
-    FT_Done_Glyph(glyph->glyph);
-    FT_Done_Glyph(glyph->border_glyph);
-    av_free(elem);
-    return 0;
-}
-
 static av_cold void uninit(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
@@ -711,10 +862,11 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->positions);
     s->nb_positions = 0;
 
-
-    av_tree_enumerate(s->glyphs, NULL, NULL, glyph_enu_free);
+    /* the glyphs are owned by the shared cache */
     av_tree_destroy(s->glyphs);
     s->glyphs = NULL;
+    glyph_cache_release(s);
+    av_freep(&s->font_path);
 
     FT_Done_Face(s->face);
     FT_Stroker_Done(s->stroker);
@@ -1070,10 +1222,19 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
-                       FFDrawColor *color,
-                       int x, int y, int borderw)
+typedef struct ThreadData {
+    AVFrame *frame;
+    FFDrawColor *fontcolor;
+    FFDrawColor *shadowcolor;
+    FFDrawColor *bordercolor;
+    FFDrawColor *boxcolor;
+    int box_w, box_h;
+} ThreadData;
+
+static void draw_glyphs(DrawTextContext *s, uint8_t *data[], int linesize[],
+                        int width, int height,
+                        FFDrawColor *color,
+                        int x, int y, int borderw)
 {
     char *text = s->expanded_text.str;
     uint32_t code = 0;
@@ -1095,20 +1256,58 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
 
         bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
 
-        if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
-            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
-            return AVERROR(EINVAL);
-
         x1 = s->positions[i].x+s->x+x - borderw;
         y1 = s->positions[i].y+s->y+y - borderw;
 
         ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
+                      data, linesize, width, height,
                       bitmap.buffer, bitmap.pitch,
                       bitmap.width, bitmap.rows,
                       bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
                       0, x1, y1);
     }
+}
+
+/**
+ * Draw the box and the text on a band of rows of the frame, starting on a
+ * chroma row so that the bands blend the same pixels as the whole frame.
+ */
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int width  = frame->width;
+    const int height = frame->height;
+    const int slice_start = ff_draw_round_to_sub(&s->dc, 1, -1, (height *  jobnr   ) / nb_jobs);
+    const int slice_end   = jobnr == nb_jobs - 1 ? height :
+                            ff_draw_round_to_sub(&s->dc, 1, -1, (height * (jobnr+1)) / nb_jobs);
+    const int slice_h = slice_end - slice_start;
+    uint8_t *data[4] = { NULL };
+    int i;
+
+    if (slice_h <= 0)
+        return 0;
+    for (i = 0; i < s->dc.nb_planes; i++)
+        data[i] = frame->data[i] + (slice_start >> s->dc.vsub[i]) * frame->linesize[i];
+
+    /* draw box */
+    if (s->draw_box)
+        ff_blend_rectangle(&s->dc, td->boxcolor,
+                           data, frame->linesize, width, slice_h,
+                           s->x - s->boxborderw, s->y - s->boxborderw - slice_start,
+                           td->box_w + s->boxborderw * 2, td->box_h + s->boxborderw * 2);
+
+    if (s->shadowx || s->shadowy)
+        draw_glyphs(s, data, frame->linesize, width, slice_h,
+                    td->shadowcolor, s->shadowx, s->shadowy - slice_start, 0);
+
+    if (s->borderw)
+        draw_glyphs(s, data, frame->linesize, width, slice_h,
+                    td->bordercolor, 0, -slice_start, s->borderw);
+
+    draw_glyphs(s, data, frame->linesize, width, slice_h,
+                td->fontcolor, 0, -slice_start, 0);
 
     return 0;
 }
@@ -1153,6 +1352,7 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     FT_Vector delta;
     Glyph *glyph = NULL, *prev_glyph = NULL;
     Glyph dummy = { 0 };
+    ThreadData td;
 
     time_t now = time(0);
     struct tm ltime;
@@ -1228,6 +1428,9 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
             if (ret < 0)
                 return ret;
         }
+        if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
+            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+            return AVERROR(EINVAL);
 
         y_min = FFMIN(glyph->bbox.yMin, y_min);
         y_max = FFMAX(glyph->bbox.yMax, y_max);
@@ -1299,27 +1502,16 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     box_w = FFMIN(width - 1 , max_text_line_w);
     box_h = FFMIN(height - 1, y + s->max_glyph_h);
 
-    /* draw box */
-    if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
-    }
-
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
-    }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    td.frame       = frame;
+    td.fontcolor   = &fontcolor;
+    td.shadowcolor = &shadowcolor;
+    td.bordercolor = &bordercolor;
+    td.boxcolor    = &boxcolor;
+    td.box_w       = box_w;
+    td.box_h       = box_h;
+    ctx->internal->execute(ctx, draw_text_slice, &td, NULL,
+                           FFMIN(ff_filter_get_nb_threads(ctx),
+                                 FFMAX(height >> s->dc.vsub_max, 1)));
 
     return 0;
 }
@@ -1392,5 +1584,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
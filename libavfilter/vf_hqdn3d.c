@@ -55,7 +55,34 @@ static uint32_t lowpass(int prev, int cur, int16_t *coef, int depth)
 }
 
 av_always_inline
-static void denoise_temporal(uint8_t *src, uint8_t *dst,
+static void denoise_tmp_row(uint8_t *src, uint8_t *dst, uint16_t *frame_ant,
+                            ptrdiff_t w, int16_t *temporal, int depth)
+{
+    ptrdiff_t x;
+    uint32_t tmp;
+
+    for (x = 0; x < w; x++) {
+        frame_ant[x] = tmp = lowpass(frame_ant[x], LOAD(x), temporal, depth);
+        STORE(x, tmp);
+    }
+}
+
+#define DEFINE_TMP_ROW(depth)                                                 \
+static void denoise_tmp_row_ ## depth ## _c(uint8_t *src, uint8_t *dst,      \
+                                            uint16_t *frame_ant, ptrdiff_t w, \
+                                            int16_t *temporal)                \
+{                                                                             \
+    denoise_tmp_row(src, dst, frame_ant, w, temporal, depth);                 \
+}
+
+DEFINE_TMP_ROW(8)
+DEFINE_TMP_ROW(9)
+DEFINE_TMP_ROW(10)
+DEFINE_TMP_ROW(16)
+
+av_always_inline
+static void denoise_temporal(HQDN3DContext *s,
+                             uint8_t *src, uint8_t *dst,
                              uint16_t *frame_ant,
                              int w, int h, int sstride, int dstride,
                              int16_t *temporal, int depth)
@@ -66,7 +93,10 @@ static void denoise_temporal(uint8_t *src, uint8_t *dst,
     temporal += 256 << LUT_BITS;
 
     for (y = 0; y < h; y++) {
-        for (x = 0; x < w; x++) {
+        /* the SIMD versions process multiples of 8 pixels */
+        x = w & ~7;
+        s->denoise_tmp_row[depth](src, dst, frame_ant, x, temporal);
+        for (; x < w; x++) {
             frame_ant[x] = tmp = lowpass(frame_ant[x], LOAD(x), temporal, depth);
             STORE(x, tmp);
         }
@@ -121,60 +151,102 @@ static void denoise_spatial(HQDN3DContext *s,
 }
 
 av_always_inline
-static int denoise_depth(HQDN3DContext *s,
-                         uint8_t *src, uint8_t *dst,
-                         uint16_t *line_ant, uint16_t **frame_ant_ptr,
-                         int w, int h, int sstride, int dstride,
-                         int16_t *spatial, int16_t *temporal, int depth)
+static void denoise_depth(HQDN3DContext *s,
+                          uint8_t *src, uint8_t *dst,
+                          uint16_t *line_ant, uint16_t *frame_ant,
+                          int w, int h, int sstride, int dstride,
+                          int16_t *spatial, int16_t *temporal,
+                          int init, int depth)
 {
     // FIXME: For 16-bit depth, frame_ant could be a pointer to the previous
     // filtered frame rather than a separate buffer.
     long x, y;
-    uint16_t *frame_ant = *frame_ant_ptr;
-    if (!frame_ant) {
+
+    if (init) {
         uint8_t *frame_src = src;
-        *frame_ant_ptr = frame_ant = av_malloc_array(w, h*sizeof(uint16_t));
-        if (!frame_ant)
-            return AVERROR(ENOMEM);
+        uint16_t *frame_dst = frame_ant;
         for (y = 0; y < h; y++, src += sstride, frame_ant += w)
             for (x = 0; x < w; x++)
                 frame_ant[x] = LOAD(x);
         src = frame_src;
-        frame_ant = *frame_ant_ptr;
+        frame_ant = frame_dst;
     }
 
     if (spatial[0])
         denoise_spatial(s, src, dst, line_ant, frame_ant,
                         w, h, sstride, dstride, spatial, temporal, depth);
     else
-        denoise_temporal(src, dst, frame_ant,
+        denoise_temporal(s, src, dst, frame_ant,
                          w, h, sstride, dstride, temporal, depth);
     emms_c();
-    return 0;
 }
 
 #define denoise(...)                                                          \
     do {                                                                      \
-        int ret = AVERROR_BUG;                                                \
         switch (s->depth) {                                                   \
-            case  8: ret = denoise_depth(__VA_ARGS__,  8); break;             \
-            case  9: ret = denoise_depth(__VA_ARGS__,  9); break;             \
-            case 10: ret = denoise_depth(__VA_ARGS__, 10); break;             \
-            case 16: ret = denoise_depth(__VA_ARGS__, 16); break;             \
-        }                                                                     \
-        if (ret < 0) {                                                        \
-            av_frame_free(&out);                                              \
-            if (!direct)                                                      \
-                av_frame_free(&in);                                           \
-            return ret;                                                       \
+            case  8: denoise_depth(__VA_ARGS__,  8); break;                   \
+            case  9: denoise_depth(__VA_ARGS__,  9); break;                   \
+            case 10: denoise_depth(__VA_ARGS__, 10); break;                   \
+            case 16: denoise_depth(__VA_ARGS__, 16); break;                   \
         }                                                                     \
     } while (0)
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int init;                   ///< frame_prev has to be seeded from in
+} ThreadData;
+
+/**
+ * Denoise one row band of one plane. Jobs are ordered plane by plane,
+ * with nb_bands consecutive jobs per plane. Every band restarts the
+ * vertical recursion as if it were the top of the picture.
+ */
+static int denoise_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HQDN3DContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    const int nb_bands = nb_jobs / 3;
+    const int c    = jobnr / nb_bands;
+    const int band = jobnr % nb_bands;
+    const int w = AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub));
+    const int h = AV_CEIL_RSHIFT(in->height, (!!c * s->vsub));
+    const int slice_start = (h *  band     ) / nb_bands;
+    const int slice_end   = (h * (band + 1)) / nb_bands;
+
+    if (slice_start >= slice_end)
+        return 0;
+
+    denoise(s, in->data[c]  + slice_start * in->linesize[c],
+            out->data[c] + slice_start * out->linesize[c],
+            s->line + jobnr * s->line_stride,
+            s->frame_prev[c] + slice_start * w,
+            w, slice_end - slice_start,
+            in->linesize[c], out->linesize[c],
+            s->coefs[c ? CHROMA_SPATIAL : LUMA_SPATIAL],
+            s->coefs[c ? CHROMA_TMP     : LUMA_TMP],
+            td->init);
+    return 0;
+}
+
+av_cold void ff_hqdn3d_init(HQDN3DContext *hqdn3d)
+{
+    hqdn3d->denoise_tmp_row[8]  = denoise_tmp_row_8_c;
+    hqdn3d->denoise_tmp_row[9]  = denoise_tmp_row_9_c;
+    hqdn3d->denoise_tmp_row[10] = denoise_tmp_row_10_c;
+    hqdn3d->denoise_tmp_row[16] = denoise_tmp_row_16_c;
+
+    if (ARCH_X86)
+        ff_hqdn3d_init_x86(hqdn3d);
+}
+
 static int16_t *precalc_coefs(double dist25, int depth)
 {
     int i;
     double gamma, simil, C;
-    int16_t *ct = av_malloc((512<<LUT_BITS)*sizeof(int16_t));
+    /* one spare entry, SIMD may read a whole dword at the last index */
+    int16_t *ct = av_mallocz(((512<<LUT_BITS) + 1)*sizeof(int16_t));
     if (!ct)
         return NULL;
 
@@ -256,33 +328,48 @@ static int query_formats(AVFilterContext *ctx)
     AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
     if (!fmts_list)
         return AVERROR(ENOMEM);
+    ctx->inputs[0]->in_place = 1;
     return ff_set_common_formats(ctx, fmts_list);
 }
 
 static int config_input(AVFilterLink *inlink)
 {
-    HQDN3DContext *s = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    HQDN3DContext *s = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     int i;
 
-    uninit(inlink->dst);
+    uninit(ctx);
 
     s->hsub  = desc->log2_chroma_w;
     s->vsub  = desc->log2_chroma_h;
     s->depth = desc->comp[0].depth;
 
-    s->line = av_malloc_array(inlink->w, sizeof(*s->line));
+    s->nb_bands = s->bands ? s->bands : ff_filter_get_nb_threads(ctx);
+    s->nb_bands = av_clip(s->nb_bands, 1, AV_CEIL_RSHIFT(inlink->h, s->vsub));
+
+    s->line_stride = FFALIGN(inlink->w, 16);
+    s->line = av_malloc_array(3 * s->nb_bands * s->line_stride, sizeof(*s->line));
     if (!s->line)
         return AVERROR(ENOMEM);
 
+    for (i = 0; i < 3; i++) {
+        int w = AV_CEIL_RSHIFT(inlink->w, (!!i * s->hsub));
+        int h = AV_CEIL_RSHIFT(inlink->h, (!!i * s->vsub));
+
+        s->frame_prev[i] = av_malloc_array(w, h * sizeof(*s->frame_prev[i]));
+        if (!s->frame_prev[i])
+            return AVERROR(ENOMEM);
+    }
+    s->frame_init = 1;
+
     for (i = 0; i < 4; i++) {
         s->coefs[i] = precalc_coefs(s->strength[i], s->depth);
         if (!s->coefs[i])
             return AVERROR(ENOMEM);
     }
 
-    if (ARCH_X86)
-        ff_hqdn3d_init_x86(s);
+    ff_hqdn3d_init(s);
 
     return 0;
 }
@@ -294,7 +381,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     AVFilterLink *outlink = ctx->outputs[0];
 
     AVFrame *out;
-    int c, direct = av_frame_is_writable(in) && !ctx->is_disabled;
+    ThreadData td;
+    int direct = av_frame_is_writable(in) && !ctx->is_disabled;
 
     if (direct) {
         out = in;
@@ -308,15 +396,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         av_frame_copy_props(out, in);
     }
 
-    for (c = 0; c < 3; c++) {
-        denoise(s, in->data[c], out->data[c],
-                s->line, &s->frame_prev[c],
-                AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub)),
-                AV_CEIL_RSHIFT(in->height, (!!c * s->vsub)),
-                in->linesize[c], out->linesize[c],
-                s->coefs[c ? CHROMA_SPATIAL : LUMA_SPATIAL],
-                s->coefs[c ? CHROMA_TMP     : LUMA_TMP]);
-    }
+    td.in   = in;
+    td.out  = out;
+    td.init = s->frame_init;
+    ctx->internal->execute(ctx, denoise_slice, &td, NULL, 3 * s->nb_bands);
+    s->frame_init = 0;
 
     if (ctx->is_disabled) {
         av_frame_free(&out);
@@ -336,6 +420,7 @@ static const AVOption hqdn3d_options[] = {
     { "chroma_spatial", "spatial chroma strength",  OFFSET(strength[CHROMA_SPATIAL]), AV_OPT_TYPE_DOUBLE, { .dbl = 0.0 }, 0, DBL_MAX, FLAGS },
     { "luma_tmp",       "temporal luma strength",   OFFSET(strength[LUMA_TMP]),       AV_OPT_TYPE_DOUBLE, { .dbl = 0.0 }, 0, DBL_MAX, FLAGS },
     { "chroma_tmp",     "temporal chroma strength", OFFSET(strength[CHROMA_TMP]),     AV_OPT_TYPE_DOUBLE, { .dbl = 0.0 }, 0, DBL_MAX, FLAGS },
+    { "bands",          "set number of row bands per plane, 0 for one per thread", OFFSET(bands), AV_OPT_TYPE_INT, { .i64 = 1 }, 0, INT_MAX, FLAGS },
     { NULL }
 };
 
@@ -370,5 +455,5 @@ AVFilter ff_vf_hqdn3d = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_hqdn3d_inputs,
     .outputs       = avfilter_vf_hqdn3d_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -31,12 +31,19 @@
 typedef struct HQDN3DContext {
     const AVClass *class;
     int16_t *coefs[4];
-    uint16_t *line;
+    uint16_t *line;             ///< one line buffer per job, line_stride apart
+    int line_stride;
     uint16_t *frame_prev[3];
+    int frame_init;             ///< frame_prev has not been seeded yet
     double strength[4];
     int hsub, vsub;
     int depth;
+    int bands;                  ///< requested number of row bands per plane
+    int nb_bands;               ///< number of row bands per plane in use
     void (*denoise_row[17])(uint8_t *src, uint8_t *dst, uint16_t *line_ant, uint16_t *frame_ant, ptrdiff_t w, int16_t *spatial, int16_t *temporal);
+    /* the spatial filter is a recursion along the row, only the temporal
+     * only row filter has SIMD versions */
+    void (*denoise_tmp_row[17])(uint8_t *src, uint8_t *dst, uint16_t *frame_ant, ptrdiff_t w, int16_t *temporal);
 } HQDN3DContext;
 
 #define LUMA_SPATIAL   0
@@ -44,6 +51,7 @@ typedef struct HQDN3DContext {
 #define CHROMA_SPATIAL 2
 #define CHROMA_TMP     3
 
+void ff_hqdn3d_init(HQDN3DContext *hqdn3d);
 void ff_hqdn3d_init_x86(HQDN3DContext *hqdn3d);
 
 #endif /* AVFILTER_HQDN3D_H */
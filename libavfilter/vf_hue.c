@@ -236,6 +236,7 @@ static int query_formats(AVFilterContext *ctx)
     AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
     if (!fmts_list)
         return AVERROR(ENOMEM);
+    ctx->inputs[0]->in_place = 1;
     return ff_set_common_formats(ctx, fmts_list);
 }
 
@@ -34,6 +34,7 @@
 #include "drawutils.h"
 #include "formats.h"
 #include "internal.h"
+#include "lut.h"
 #include "video.h"
 
 static const char *const var_names[] = {
@@ -70,6 +71,7 @@ typedef struct LutContext {
     int is_16bit;
     int step;
     int negate_alpha; /* only used by negate */
+    LutDSPContext dsp;
 } LutContext;
 
 #define Y 0
@@ -148,6 +150,7 @@ static int query_formats(AVFilterContext *ctx)
     AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
     if (!fmts_list)
         return AVERROR(ENOMEM);
+    ctx->inputs[0]->in_place = 1;
     return ff_set_common_formats(ctx, fmts_list);
 }
 
@@ -192,6 +195,33 @@ static double compute_gammaval709(void *opaque, double gamma)
     return level * (maxval - minval) + minval;
 }
 
+static int lut_row8_c(uint8_t *dst, const uint8_t *src, const uint16_t *lut, int width)
+{
+    int i;
+
+    for (i = 0; i < width; i++)
+        dst[i] = lut[src[i]];
+    return width;
+}
+
+static int lut_row16_c(uint16_t *dst, const uint16_t *src, const uint16_t *lut, int width)
+{
+    int i;
+
+    for (i = 0; i < width; i++)
+        dst[i] = lut[src[i]];
+    return width;
+}
+
+av_cold void ff_lut_init(LutDSPContext *dsp)
+{
+    dsp->lut_row8  = lut_row8_c;
+    dsp->lut_row16 = lut_row16_c;
+
+    if (ARCH_X86)
+        ff_lut_init_x86(dsp);
+}
+
 static double (* const funcs1[])(void *, double) = {
     clip,
     compute_gammaval,
@@ -222,6 +252,8 @@ static int config_props(AVFilterLink *inlink)
     s->var_values[VAR_H] = inlink->h;
     s->is_16bit = desc->comp[0].depth > 8;
 
+    ff_lut_init(&s->dsp);
+
     switch (inlink->format) {
     case AV_PIX_FMT_YUV410P:
     case AV_PIX_FMT_YUV411P:
@@ -435,13 +467,14 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             outrow = (uint16_t *)out->data[plane];
 
             for (i = 0; i < h; i++) {
-                for (j = 0; j < w; j++) {
 #if HAVE_BIGENDIAN
+                for (j = 0; j < w; j++)
                     outrow[j] = av_bswap16(tab[av_bswap16(inrow[j])]);
 #else
+                j = s->dsp.lut_row16(outrow, inrow, tab, w);
+                for (; j < w; j++)
                     outrow[j] = tab[inrow[j]];
 #endif
-                }
                 inrow  += in_linesize;
                 outrow += out_linesize;
             }
@@ -463,7 +496,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             outrow = out->data[plane];
 
             for (i = 0; i < h; i++) {
-                for (j = 0; j < w; j++)
+                j = s->dsp.lut_row8(outrow, inrow, tab, w);
+                for (; j < w; j++)
                     outrow[j] = tab[inrow[j]];
                 inrow  += in_linesize;
                 outrow += out_linesize;
@@ -503,7 +537,8 @@ static const AVFilterPad outputs[] = {
         .query_formats = query_formats,                                 \
         .inputs        = inputs,                                        \
         .outputs       = outputs,                                       \
-        .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,        \
+        .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |       \
+                         AVFILTER_FLAG_FRAME_THREADS,                   \
     }
 
 #if CONFIG_LUT_FILTER
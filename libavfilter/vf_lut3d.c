@@ -34,6 +34,7 @@
 #include "dualinput.h"
 #include "formats.h"
 #include "internal.h"
+#include "lut3d.h"
 #include "video.h"
 
 #define R 0
@@ -65,6 +66,11 @@ typedef struct LUT3DContext {
     avfilter_action_func *interp;
     struct rgbvec lut[MAX_LEVEL][MAX_LEVEL][MAX_LEVEL];
     int lutsize;
+    int fixed;                  ///< the fixed point tables below are used
+    int16_t lut_fixed[MAX_LEVEL * MAX_LEVEL * MAX_LEVEL][4];
+    uint32_t coord[3][256];
+    uint32_t params[LUT3D_NB_PARAMS];
+    LUT3DDSPContext dsp;
 #if CONFIG_HALDCLUT_FILTER
     uint8_t clut_rgba_map[4];
     int clut_step;
@@ -246,6 +252,149 @@ DEFINE_INTERP_FUNC(nearest,     16)
 DEFINE_INTERP_FUNC(trilinear,   16)
 DEFINE_INTERP_FUNC(tetrahedral, 16)
 
+/**
+ * Tetrahedral interpolation of 8-bit values with the fixed point tables,
+ * the vertices are selected by sorting the weights instead of branching.
+ */
+static av_always_inline void interp_tetrahedral_fixed(const int16_t *lut, const uint32_t *coord,
+                                                      const uint32_t *params,
+                                                      int r, int g, int b, int *dst)
+{
+    const uint32_t cr = coord[r], cg = coord[256 + g], cb = coord[512 + b];
+    const int dr = cr & (LUT3D_COORD_NEXT - 1);
+    const int dg = cg & (LUT3D_COORD_NEXT - 1);
+    const int db = cb & (LUT3D_COORD_NEXT - 1);
+    const int sr = cr & LUT3D_COORD_NEXT ? params[LUT3D_STRIDE_R] : 0;
+    const int sg = cg & LUT3D_COORD_NEXT ? params[LUT3D_STRIDE_G] : 0;
+    const int sb = cb & LUT3D_COORD_NEXT ? params[LUT3D_STRIDE_B] : 0;
+    const int o000 = (cr >> LUT3D_COORD_SHIFT) + (cg >> LUT3D_COORD_SHIFT) + (cb >> LUT3D_COORD_SHIFT);
+    const int o111 = o000 + sr + sg + sb;
+    const int d1 = FFMAX3(dr, dg, db);
+    const int d3 = FFMIN3(dr, dg, db);
+    const int d2 = dr + dg + db - d1 - d3;
+    /* on ties, the vertex picked gets a weight of 0 */
+    const int o1 = o000 + (dr == d1 ? sr : dg == d1 ? sg : sb);
+    const int o2 = o111 - (dr == d3 ? sr : dg == d3 ? sg : sb);
+    const int16_t *c000 = lut + 4 * o000;
+    const int16_t *c1   = lut + 4 * o1;
+    const int16_t *c2   = lut + 4 * o2;
+    const int16_t *c111 = lut + 4 * o111;
+    const int w0 = LUT3D_COORD_NEXT - d1, w1 = d1 - d2, w2 = d2 - d3, w3 = d3;
+    int i;
+
+    for (i = 0; i < 3; i++)
+        dst[i] = av_clip_uint8((w0 * c000[i] + w1 * c1[i] + w2 * c2[i] + w3 * c111[i] +
+                                (1 << (LUT3D_FRAC_BITS + LUT3D_LUT_BITS - 1))) >>
+                               (LUT3D_FRAC_BITS + LUT3D_LUT_BITS));
+}
+
+static int interp_tetrahedral_row_c(uint8_t *dst, const uint8_t *src, int width,
+                                    const int16_t *lut, const uint32_t *coord,
+                                    const uint32_t *params)
+{
+    int x, rgb[3];
+
+    for (x = 0; x < width; x++) {
+        const uint32_t p = AV_RL32(src + 4 * x);
+
+        interp_tetrahedral_fixed(lut, coord, params,
+                                 p >> params[LUT3D_SHIFT_R] & 0xff,
+                                 p >> params[LUT3D_SHIFT_G] & 0xff,
+                                 p >> params[LUT3D_SHIFT_B] & 0xff, rgb);
+        AV_WL32(dst + 4 * x, (p & params[LUT3D_ALPHA_MASK])  |
+                             rgb[0] << params[LUT3D_SHIFT_R] |
+                             rgb[1] << params[LUT3D_SHIFT_G] |
+                             rgb[2] << params[LUT3D_SHIFT_B]);
+    }
+    return width;
+}
+
+av_cold void ff_lut3d_init(LUT3DDSPContext *dsp)
+{
+    dsp->interp_tetrahedral_row = interp_tetrahedral_row_c;
+
+    if (ARCH_X86)
+        ff_lut3d_init_x86(dsp);
+}
+
+static int interp_8_tetrahedral_fixed(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    int x, y, rgb[3];
+    const LUT3DContext *lut3d = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *in  = td->in;
+    const AVFrame *out = td->out;
+    const int direct = out == in;
+    const int step = lut3d->step;
+    const uint8_t r = lut3d->rgba_map[R];
+    const uint8_t g = lut3d->rgba_map[G];
+    const uint8_t b = lut3d->rgba_map[B];
+    const int slice_start = (in->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (in->height * (jobnr+1)) / nb_jobs;
+    uint8_t       *dstrow = out->data[0] + slice_start * out->linesize[0];
+    const uint8_t *srcrow = in ->data[0] + slice_start * in ->linesize[0];
+
+    for (y = slice_start; y < slice_end; y++) {
+        x = 0;
+        if (step == 4)
+            x = lut3d->dsp.interp_tetrahedral_row(dstrow, srcrow, in->width,
+                                                  lut3d->lut_fixed[0], lut3d->coord[0],
+                                                  lut3d->params);
+        for (x *= step; x < in->width * step; x += step) {
+            interp_tetrahedral_fixed(lut3d->lut_fixed[0], lut3d->coord[0], lut3d->params,
+                                     srcrow[x + r], srcrow[x + g], srcrow[x + b], rgb);
+            dstrow[x + r] = rgb[0];
+            dstrow[x + g] = rgb[1];
+            dstrow[x + b] = rgb[2];
+            if (!direct && step == 4)
+                dstrow[x + lut3d->rgba_map[A]] = srcrow[x + lut3d->rgba_map[A]];
+        }
+        dstrow += out->linesize[0];
+        srcrow += in ->linesize[0];
+    }
+    return 0;
+}
+
+/**
+ * Fill the fixed point tables from the current 3D LUT.
+ */
+static void update_fixed_lut(LUT3DContext *lut3d)
+{
+    const int size = lut3d->lutsize;
+    const float scale = 255 << LUT3D_LUT_BITS;
+    int i, j, k, v;
+
+    if (!lut3d->fixed || !size)
+        return;
+
+    lut3d->params[LUT3D_STRIDE_R] = size * size;
+    lut3d->params[LUT3D_STRIDE_G] = size;
+    lut3d->params[LUT3D_STRIDE_B] = 1;
+
+    for (i = 0; i < size; i++) {
+        for (j = 0; j < size; j++) {
+            for (k = 0; k < size; k++) {
+                const struct rgbvec *vec = &lut3d->lut[i][j][k];
+                int16_t *dst = lut3d->lut_fixed[(i * size + j) * size + k];
+                dst[0] = lrintf(av_clipf(vec->r * scale, INT16_MIN, INT16_MAX));
+                dst[1] = lrintf(av_clipf(vec->g * scale, INT16_MIN, INT16_MAX));
+                dst[2] = lrintf(av_clipf(vec->b * scale, INT16_MIN, INT16_MAX));
+                dst[3] = 0;
+            }
+        }
+    }
+
+    for (i = 0; i < 3; i++) {
+        for (v = 0; v < 256; v++) {
+            const int num  = v * (size - 1);
+            const int prev = num / 255;
+            const int frac = ((num - prev * 255) * LUT3D_COORD_NEXT + 127) / 255;
+            lut3d->coord[i][v] = frac | (prev < size - 1 ? LUT3D_COORD_NEXT : 0) |
+                                 (uint32_t)prev * lut3d->params[LUT3D_STRIDE_R + i] << LUT3D_COORD_SHIFT;
+        }
+    }
+}
+
 #define MAX_LINE_SIZE 512
 
 static int skip_line(const char *p)
@@ -474,6 +623,7 @@ static int query_formats(AVFilterContext *ctx)
     AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
     if (!fmts_list)
         return AVERROR(ENOMEM);
+    ctx->inputs[0]->in_place = 1;
     return ff_set_common_formats(ctx, fmts_list);
 }
 
@@ -507,6 +657,20 @@ static int config_input(AVFilterLink *inlink)
         av_assert0(0);
     }
 
+    lut3d->fixed = !is16bit && lut3d->interpolation == INTERPOLATE_TETRAHEDRAL;
+    if (lut3d->fixed) {
+        lut3d->interp = interp_8_tetrahedral_fixed;
+        lut3d->params[LUT3D_SHIFT_R]    = 8 * lut3d->rgba_map[R];
+        lut3d->params[LUT3D_SHIFT_G]    = 8 * lut3d->rgba_map[G];
+        lut3d->params[LUT3D_SHIFT_B]    = 8 * lut3d->rgba_map[B];
+        lut3d->params[LUT3D_ALPHA_MASK] = ~(0xffU << lut3d->params[LUT3D_SHIFT_R] |
+                                            0xffU << lut3d->params[LUT3D_SHIFT_G] |
+                                            0xffU << lut3d->params[LUT3D_SHIFT_B]);
+        ff_lut3d_init(&lut3d->dsp);
+        /* the Hald CLUT fills the tables when it is received */
+        update_fixed_lut(lut3d);
+    }
+
     return 0;
 }
 
@@ -671,6 +835,8 @@ static void update_clut(LUT3DContext *lut3d, const AVFrame *frame)
 
     if (!lut3d->clut_is16bit) LOAD_CLUT(8);
     else                      LOAD_CLUT(16);
+
+    update_fixed_lut(lut3d);
 }
 
 
@@ -254,20 +254,17 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     int linesize = me_ctx->linesize;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, me_ctx->x_min, me_ctx->x_max);
     y = av_clip(y, me_ctx->y_min, me_ctx->y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - me_ctx->x_min, me_ctx->x_max - x), FFMIN(x - me_ctx->x_min, me_ctx->x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - me_ctx->y_min, me_ctx->y_max - y), FFMIN(y - me_ctx->y_min, me_ctx->y_max - y));
 
-    data_cur += (y + mv_y) * linesize;
-    data_next += (y - mv_y) * linesize;
-
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + j * linesize] - data_next[x - mv_x + i + j * linesize]);
+    sbad = ff_me_sad_block(me_ctx, data_cur  + x + mv_x + (y + mv_y) * linesize,
+                                   data_next + x - mv_x + (y - mv_y) * linesize,
+                           me_ctx->mb_size);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -283,17 +280,20 @@ static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv,
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    /* the block overlapped by half a block on each side */
+    x -= me_ctx->mb_size / 2;
+    y -= me_ctx->mb_size / 2;
+    sbad = ff_me_sad_block(me_ctx, data_cur  + x + mv_x + (y + mv_y) * linesize,
+                                   data_next + x - mv_x + (y - mv_y) * linesize,
+                           me_ctx->mb_size * 2);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -309,17 +309,16 @@ static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, i
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    uint64_t sad;
 
-    x = av_clip(x, x_min, x_max);
-    y = av_clip(y, y_min, y_max);
-    x_mv = av_clip(x_mv, x_min, x_max);
-    y_mv = av_clip(y_mv, y_min, y_max);
+    x = av_clip(x, x_min, x_max) - me_ctx->mb_size / 2;
+    y = av_clip(y, y_min, y_max) - me_ctx->mb_size / 2;
+    x_mv = av_clip(x_mv, x_min, x_max) - me_ctx->mb_size / 2;
+    y_mv = av_clip(y_mv, y_min, y_max) - me_ctx->mb_size / 2;
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    sad = ff_me_sad_block(me_ctx, data_ref + x_mv + y_mv * linesize,
+                                  data_cur + x + y * linesize,
+                          me_ctx->mb_size * 2);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -402,9 +401,9 @@ static int config_output(AVFilterLink *outlink)
         preds.nb++;\
     } while(0)
 
-static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int dir)
+static void search_mv(MIContext *mi_ctx, AVMotionEstContext *me_ctx, Block *blocks,
+                      int mb_x, int mb_y, int dir)
 {
-    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     AVMotionEstPredictor *preds = me_ctx->preds;
     Block *block = &blocks[mb_x + mb_y * mi_ctx->b_width];
 
@@ -544,8 +543,86 @@ static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int
     block->mvs[dir][1] = mv[1] - y_mb;
 }
 
-static void bilateral_me(MIContext *mi_ctx)
+typedef struct ThreadData {
+    Block *blocks;
+    int dir;
+    int wave;                   ///< wavefront to search, -1 to search all the rows
+    int pred_x, pred_y;         ///< predictors left by the search of the last block
+    AVMotionEstPredictor preds[2];
+} ThreadData;
+
+static int search_mv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    /* the searches update the predictors of the context */
+    AVMotionEstContext me_ctx = mi_ctx->me_ctx;
+    int mb_x, mb_y, mb_y_start = 0, mb_y_end = mi_ctx->b_height;
+    int slice_start, slice_end;
+
+    if (td->wave >= 0)
+        ff_me_wavefront_rows(td->wave, mi_ctx->b_width, mi_ctx->b_height, &mb_y_start, &mb_y_end);
+    slice_start = mb_y_start + ((mb_y_end - mb_y_start) *  jobnr   ) / nb_jobs;
+    slice_end   = mb_y_start + ((mb_y_end - mb_y_start) * (jobnr+1)) / nb_jobs;
+
+    for (mb_y = slice_start; mb_y < slice_end; mb_y++) {
+        if (td->wave >= 0) {
+            search_mv(mi_ctx, &me_ctx, td->blocks, td->wave - 2 * mb_y, mb_y, td->dir);
+            continue;
+        }
+        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
+            search_mv(mi_ctx, &me_ctx, td->blocks, mb_x, mb_y, td->dir);
+    }
+
+    /* the block costs computed after the search use the predictors of the
+     * last block, as when searching in raster order */
+    if (slice_end == mi_ctx->b_height && (td->wave < 0 || td->wave - 2 * (slice_end - 1) == mi_ctx->b_width - 1)) {
+        td->pred_x = me_ctx.pred_x;
+        td->pred_y = me_ctx.pred_y;
+        memcpy(td->preds, me_ctx.preds, sizeof(td->preds));
+    }
+
+    return 0;
+}
+
+/**
+ * Search the motion vectors of all the blocks, in wavefronts for the
+ * methods using the vectors of the previous blocks as predictors.
+ */
+static void search_mvs(AVFilterContext *ctx, Block *blocks, int dir)
 {
+    MIContext *mi_ctx = ctx->priv;
+    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    int mb_y_start, mb_y_end;
+    ThreadData td;
+
+    td.blocks = blocks;
+    td.dir    = dir;
+    td.pred_x = me_ctx->pred_x;
+    td.pred_y = me_ctx->pred_y;
+    memcpy(td.preds, me_ctx->preds, sizeof(td.preds));
+
+    if (mi_ctx->me_method == AV_ME_METHOD_EPZS || mi_ctx->me_method == AV_ME_METHOD_UMH) {
+        for (td.wave = 0; td.wave < mi_ctx->b_width + 2 * (mi_ctx->b_height - 1); td.wave++) {
+            ff_me_wavefront_rows(td.wave, mi_ctx->b_width, mi_ctx->b_height, &mb_y_start, &mb_y_end);
+            ctx->internal->execute(ctx, search_mv_slice, &td, NULL,
+                                   FFMIN(mb_y_end - mb_y_start, nb_threads));
+        }
+    } else {
+        td.wave = -1;
+        ctx->internal->execute(ctx, search_mv_slice, &td, NULL,
+                               FFMIN(mi_ctx->b_height, nb_threads));
+    }
+
+    me_ctx->pred_x = td.pred_x;
+    me_ctx->pred_y = td.pred_y;
+    memcpy(me_ctx->preds, td.preds, sizeof(td.preds));
+}
+
+static void bilateral_me(AVFilterContext *ctx)
+{
+    MIContext *mi_ctx = ctx->priv;
     Block *block;
     int mb_x, mb_y;
 
@@ -560,9 +637,7 @@ static void bilateral_me(MIContext *mi_ctx)
             block->mvs[0][1] = 0;
         }
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-            search_mv(mi_ctx, mi_ctx->int_blocks, mb_x, mb_y, 0);
+    search_mvs(ctx, mi_ctx->int_blocks, 0);
 }
 
 static int var_size_bme(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n)
@@ -746,9 +821,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
                     mi_ctx->me_ctx.data_cur = mi_ctx->frames[2].avf->data[0];
                     mi_ctx->me_ctx.data_ref = mi_ctx->frames[dir ? 3 : 1].avf->data[0];
 
-                    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-                            search_mv(mi_ctx, mi_ctx->frames[2].blocks, mb_x, mb_y, dir);
+                    search_mvs(ctx, mi_ctx->frames[2].blocks, dir);
                 }
             }
 
@@ -763,7 +836,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
             mi_ctx->me_ctx.data_cur = mi_ctx->frames[1].avf->data[0];
             mi_ctx->me_ctx.data_ref = mi_ctx->frames[2].avf->data[0];
 
-            bilateral_me(mi_ctx);
+            bilateral_me(ctx);
 
             if (mi_ctx->mc_mode == MC_MODE_AOBMC) {
 
@@ -1240,4 +1313,5 @@ AVFilter ff_vf_minterpolate = {
     .query_formats = query_formats,
     .inputs        = minterpolate_inputs,
     .outputs       = minterpolate_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
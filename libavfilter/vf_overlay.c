@@ -39,6 +39,7 @@
 #include "dualinput.h"
 #include "drawutils.h"
 #include "video.h"
+#include "vf_overlay.h"
 
 static const char *const var_names[] = {
     "main_w",    "W", ///< width  of the main    video
@@ -55,21 +56,6 @@ static const char *const var_names[] = {
     NULL
 };
 
-enum var_name {
-    VAR_MAIN_W,    VAR_MW,
-    VAR_MAIN_H,    VAR_MH,
-    VAR_OVERLAY_W, VAR_OW,
-    VAR_OVERLAY_H, VAR_OH,
-    VAR_HSUB,
-    VAR_VSUB,
-    VAR_X,
-    VAR_Y,
-    VAR_N,
-    VAR_POS,
-    VAR_T,
-    VAR_VARS_NB
-};
-
 enum EOFAction {
     EOF_ACTION_REPEAT,
     EOF_ACTION_ENDALL,
@@ -92,49 +78,10 @@ static const char * const eof_action_str[] = {
 #define U 1
 #define V 2
 
-enum EvalMode {
-    EVAL_MODE_INIT,
-    EVAL_MODE_FRAME,
-    EVAL_MODE_NB
-};
-
-enum OverlayFormat {
-    OVERLAY_FORMAT_YUV420,
-    OVERLAY_FORMAT_YUV422,
-    OVERLAY_FORMAT_YUV444,
-    OVERLAY_FORMAT_RGB,
-    OVERLAY_FORMAT_NB
-};
-
-typedef struct OverlayContext {
-    const AVClass *class;
-    int x, y;                   ///< position of overlaid picture
-
-    int allow_packed_rgb;
-    uint8_t main_is_packed_rgb;
-    uint8_t main_rgba_map[4];
-    uint8_t main_has_alpha;
-    uint8_t overlay_is_packed_rgb;
-    uint8_t overlay_rgba_map[4];
-    uint8_t overlay_has_alpha;
-    int format;                 ///< OverlayFormat
-    int eval_mode;              ///< EvalMode
-
-    FFDualInputContext dinput;
-
-    int main_pix_step[4];       ///< steps per pixel for each plane of the main output
-    int overlay_pix_step[4];    ///< steps per pixel for each plane of the overlay
-    int hsub, vsub;             ///< chroma subsampling values
-
-    double var_values[VAR_VARS_NB];
-    char *x_expr, *y_expr;
-
-    int eof_action;             ///< action to take on EOF from source
-
-    AVExpr *x_pexpr, *y_pexpr;
-
-    void (*blend_image)(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y);
-} OverlayContext;
+typedef struct ThreadData {
+    AVFrame *dst;
+    const AVFrame *src;
+} ThreadData;
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
@@ -380,16 +327,74 @@ static int config_output(AVFilterLink *outlink)
 // ((((x) + (y)) << 8) - ((x) + (y)) - (y) * (x)) is a faster version of: 255 * (x + y)
 #define UNPREMULTIPLY_ALPHA(x, y) ((((x) << 16) - ((x) << 9) + (x)) / ((((x) + (y)) << 8) - ((x) + (y)) - (y) * (x)))
 
+static int blend_row_44_c(uint8_t *d, const uint8_t *s, const uint8_t *a,
+                          int w, ptrdiff_t alinesize)
+{
+    int k;
+
+    for (k = 0; k < w; k++)
+        d[k] = FAST_DIV255(d[k] * (255 - a[k]) + s[k] * a[k]);
+    return w;
+}
+
+static int blend_row_20_c(uint8_t *d, const uint8_t *s, const uint8_t *a,
+                          int w, ptrdiff_t alinesize)
+{
+    int k;
+
+    for (k = 0; k < w; k++) {
+        // average alpha for color components, improve quality
+        int alpha = (a[2*k] + a[2*k + alinesize] +
+                     a[2*k + 1] + a[2*k + alinesize + 1]) >> 2;
+        d[k] = FAST_DIV255(d[k] * (255 - alpha) + s[k] * alpha);
+    }
+    return w;
+}
+
+av_cold void ff_overlay_init(OverlayContext *s, int format, int main_has_alpha)
+{
+    memset(s->blend_row, 0, sizeof(s->blend_row));
+
+    /* the straight alpha conversion needs the main alpha, keep it scalar */
+    if (main_has_alpha)
+        return;
+
+    switch (format) {
+    case OVERLAY_FORMAT_YUV420:
+        s->blend_row[0] = blend_row_44_c;
+        s->blend_row[1] = blend_row_20_c;
+        s->blend_row[2] = blend_row_20_c;
+        break;
+    case OVERLAY_FORMAT_YUV422:
+        s->blend_row[0] = blend_row_44_c;
+        break;
+    case OVERLAY_FORMAT_YUV444:
+        s->blend_row[0] = blend_row_44_c;
+        s->blend_row[1] = blend_row_44_c;
+        s->blend_row[2] = blend_row_44_c;
+        break;
+    }
+
+    if (ARCH_X86)
+        ff_overlay_init_x86(s, format, main_has_alpha);
+}
+
 /**
  * Blend image in src to destination buffer dst at position (x, y).
+ * Only the rows of the overlapping area assigned to slice jobnr
+ * are blended.
  */
 
-static void blend_image_packed_rgb(AVFilterContext *ctx,
-                                   AVFrame *dst, const AVFrame *src,
-                                   int x, int y)
+static int blend_slice_packed_rgb(AVFilterContext *ctx, void *arg,
+                                  int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
-    int i, imax, j, jmax;
+    ThreadData *td = arg;
+    AVFrame *dst = td->dst;
+    const AVFrame *src = td->src;
+    const int x = s->x;
+    const int y = s->y;
+    int i, imin, imax, j, jmax;
     const int src_w = src->width;
     const int src_h = src->height;
     const int dst_w = dst->width;
@@ -408,11 +413,14 @@ static void blend_image_packed_rgb(AVFilterContext *ctx,
     const int main_has_alpha = s->main_has_alpha;
     uint8_t *S, *sp, *d, *dp;
 
-    i = FFMAX(-y, 0);
+    imin = FFMAX(-y, 0);
+    imax = FFMIN(-y + dst_h, src_h);
+    i    = imin + (imax - imin) *  jobnr      / nb_jobs;
+    imax = imin + (imax - imin) * (jobnr + 1) / nb_jobs;
     sp = src->data[0] + i     * src->linesize[0];
     dp = dst->data[0] + (y+i) * dst->linesize[0];
 
-    for (imax = FFMIN(-y + dst_h, src_h); i < imax; i++) {
+    for (; i < imax; i++) {
         j = FFMAX(-x, 0);
         S = sp + j     * sstep;
         d = dp + (x+j) * dstep;
@@ -460,6 +468,7 @@ static void blend_image_packed_rgb(AVFilterContext *ctx,
         dp += dst->linesize[0];
         sp += src->linesize[0];
     }
+    return 0;
 }
 
 static av_always_inline void blend_plane(AVFilterContext *ctx,
@@ -468,8 +477,10 @@ static av_always_inline void blend_plane(AVFilterContext *ctx,
                                          int dst_w, int dst_h,
                                          int i, int hsub, int vsub,
                                          int x, int y,
-                                         int main_has_alpha)
+                                         int main_has_alpha,
+                                         int jobnr, int nb_jobs)
 {
+    OverlayContext *octx = ctx->priv;
     int src_wp = AV_CEIL_RSHIFT(src_w, hsub);
     int src_hp = AV_CEIL_RSHIFT(src_h, vsub);
     int dst_wp = AV_CEIL_RSHIFT(dst_w, hsub);
@@ -477,20 +488,35 @@ static av_always_inline void blend_plane(AVFilterContext *ctx,
     int yp = y>>vsub;
     int xp = x>>hsub;
     uint8_t *s, *sp, *d, *dp, *a, *ap;
-    int jmax, j, k, kmax;
+    int jmin, jmax, j, k, kmax;
 
-    j = FFMAX(-yp, 0);
+    jmin = FFMAX(-yp, 0);
+    jmax = FFMIN(-yp + dst_hp, src_hp);
+    j    = jmin + (jmax - jmin) *  jobnr      / nb_jobs;
+    jmax = jmin + (jmax - jmin) * (jobnr + 1) / nb_jobs;
     sp = src->data[i] + j         * src->linesize[i];
     dp = dst->data[i] + (yp+j)    * dst->linesize[i];
     ap = src->data[3] + (j<<vsub) * src->linesize[3];
 
-    for (jmax = FFMIN(-yp + dst_hp, src_hp); j < jmax; j++) {
+    for (; j < jmax; j++) {
         k = FFMAX(-xp, 0);
         d = dp + xp+k;
         s = sp + k;
         a = ap + (k<<hsub);
+        kmax = FFMIN(-xp + dst_wp, src_wp);
+
+        if (octx->blend_row[i] && (!vsub || j+1 < src_hp) &&
+            FFMIN(kmax, src_wp - hsub) > k) {
+            int c = octx->blend_row[i](d, s, a, FFMIN(kmax, src_wp - hsub) - k,
+                                       src->linesize[3]);
+
+            d += c;
+            s += c;
+            a += c << hsub;
+            k += c;
+        }
 
-        for (kmax = FFMIN(-xp + dst_wp, src_wp); k < kmax; k++) {
+        for (; k < kmax; k++) {
             int alpha_v, alpha_h, alpha;
 
             // average alpha for color components, improve quality
@@ -537,17 +563,21 @@ static av_always_inline void blend_plane(AVFilterContext *ctx,
 static inline void alpha_composite(const AVFrame *src, const AVFrame *dst,
                                    int src_w, int src_h,
                                    int dst_w, int dst_h,
-                                   int x, int y)
+                                   int x, int y,
+                                   int jobnr, int nb_jobs)
 {
     uint8_t alpha;          ///< the amount of overlay to blend on to main
     uint8_t *s, *sa, *d, *da;
-    int i, imax, j, jmax;
+    int i, imin, imax, j, jmax;
 
-    i = FFMAX(-y, 0);
+    imin = FFMAX(-y, 0);
+    imax = FFMIN(-y + dst_h, src_h);
+    i    = imin + (imax - imin) *  jobnr      / nb_jobs;
+    imax = imin + (imax - imin) * (jobnr + 1) / nb_jobs;
     sa = src->data[3] + i     * src->linesize[3];
     da = dst->data[3] + (y+i) * dst->linesize[3];
 
-    for (imax = FFMIN(-y + dst_h, src_h); i < imax; i++) {
+    for (; i < imax; i++) {
         j = FFMAX(-x, 0);
         s = sa + j;
         d = da + x+j;
@@ -576,11 +606,12 @@ static inline void alpha_composite(const AVFrame *src, const AVFrame *dst,
     }
 }
 
-static av_always_inline void blend_image_yuv(AVFilterContext *ctx,
+static av_always_inline void blend_slice_yuv(AVFilterContext *ctx,
                                              AVFrame *dst, const AVFrame *src,
                                              int hsub, int vsub,
                                              int main_has_alpha,
-                                             int x, int y)
+                                             int x, int y,
+                                             int jobnr, int nb_jobs)
 {
     const int src_w = src->width;
     const int src_h = src->height;
@@ -588,32 +619,38 @@ static av_always_inline void blend_image_yuv(AVFilterContext *ctx,
     const int dst_h = dst->height;
 
     if (main_has_alpha)
-        alpha_composite(src, dst, src_w, src_h, dst_w, dst_h, x, y);
+        alpha_composite(src, dst, src_w, src_h, dst_w, dst_h, x, y, jobnr, nb_jobs);
 
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 0, 0,       0, x, y, main_has_alpha);
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 1, hsub, vsub, x, y, main_has_alpha);
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 2, hsub, vsub, x, y, main_has_alpha);
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 0, 0,       0, x, y, main_has_alpha, jobnr, nb_jobs);
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 1, hsub, vsub, x, y, main_has_alpha, jobnr, nb_jobs);
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 2, hsub, vsub, x, y, main_has_alpha, jobnr, nb_jobs);
 }
 
-static void blend_image_yuv420(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
+static int blend_slice_yuv420(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
+    ThreadData *td = arg;
 
-    blend_image_yuv(ctx, dst, src, 1, 1, s->main_has_alpha, x, y);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, s->main_has_alpha, s->x, s->y, jobnr, nb_jobs);
+    return 0;
 }
 
-static void blend_image_yuv422(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
+static int blend_slice_yuv422(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
+    ThreadData *td = arg;
 
-    blend_image_yuv(ctx, dst, src, 1, 0, s->main_has_alpha, x, y);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, s->main_has_alpha, s->x, s->y, jobnr, nb_jobs);
+    return 0;
 }
 
-static void blend_image_yuv444(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
+static int blend_slice_yuv444(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
+    ThreadData *td = arg;
 
-    blend_image_yuv(ctx, dst, src, 0, 0, s->main_has_alpha, x, y);
+    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, s->main_has_alpha, s->x, s->y, jobnr, nb_jobs);
+    return 0;
 }
 
 static int config_input_main(AVFilterLink *inlink)
@@ -631,18 +668,20 @@ static int config_input_main(AVFilterLink *inlink)
     s->main_has_alpha = ff_fmt_is_in(inlink->format, alpha_pix_fmts);
     switch (s->format) {
     case OVERLAY_FORMAT_YUV420:
-        s->blend_image = blend_image_yuv420;
+        s->blend_slice = blend_slice_yuv420;
         break;
     case OVERLAY_FORMAT_YUV422:
-        s->blend_image = blend_image_yuv422;
+        s->blend_slice = blend_slice_yuv422;
         break;
     case OVERLAY_FORMAT_YUV444:
-        s->blend_image = blend_image_yuv444;
+        s->blend_slice = blend_slice_yuv444;
         break;
     case OVERLAY_FORMAT_RGB:
-        s->blend_image = blend_image_packed_rgb;
+        s->blend_slice = blend_slice_packed_rgb;
         break;
     }
+
+    ff_overlay_init(s, s->format, s->main_has_alpha);
     return 0;
 }
 
@@ -673,8 +712,15 @@ static AVFrame *do_blend(AVFilterContext *ctx, AVFrame *mainpic,
     }
 
     if (s->x < mainpic->width  && s->x + second->width  >= 0 ||
-        s->y < mainpic->height && s->y + second->height >= 0)
-        s->blend_image(ctx, mainpic, second, s->x, s->y);
+        s->y < mainpic->height && s->y + second->height >= 0) {
+        ThreadData td;
+
+        td.dst = mainpic;
+        td.src = second;
+        ctx->internal->execute(ctx, s->blend_slice, &td, NULL,
+                               FFMIN(FFMAX(1, FFMIN(second->height, mainpic->height)),
+                                     ff_filter_get_nb_threads(ctx)));
+    }
     return mainpic;
 }
 
@@ -779,5 +825,6 @@ AVFilter ff_vf_overlay = {
     .process_command = process_command,
     .inputs        = avfilter_vf_overlay_inputs,
     .outputs       = avfilter_vf_overlay_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
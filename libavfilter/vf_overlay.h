@@ -0,0 +1,102 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_OVERLAY_H
+#define AVFILTER_OVERLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/eval.h"
+#include "avfilter.h"
+#include "dualinput.h"
+
+enum var_name {
+    VAR_MAIN_W,    VAR_MW,
+    VAR_MAIN_H,    VAR_MH,
+    VAR_OVERLAY_W, VAR_OW,
+    VAR_OVERLAY_H, VAR_OH,
+    VAR_HSUB,
+    VAR_VSUB,
+    VAR_X,
+    VAR_Y,
+    VAR_N,
+    VAR_POS,
+    VAR_T,
+    VAR_VARS_NB
+};
+
+enum EvalMode {
+    EVAL_MODE_INIT,
+    EVAL_MODE_FRAME,
+    EVAL_MODE_NB
+};
+
+enum OverlayFormat {
+    OVERLAY_FORMAT_YUV420,
+    OVERLAY_FORMAT_YUV422,
+    OVERLAY_FORMAT_YUV444,
+    OVERLAY_FORMAT_RGB,
+    OVERLAY_FORMAT_NB
+};
+
+typedef struct OverlayContext {
+    const AVClass *class;
+    int x, y;                   ///< position of overlaid picture
+
+    int allow_packed_rgb;
+    uint8_t main_is_packed_rgb;
+    uint8_t main_rgba_map[4];
+    uint8_t main_has_alpha;
+    uint8_t overlay_is_packed_rgb;
+    uint8_t overlay_rgba_map[4];
+    uint8_t overlay_has_alpha;
+    int format;                 ///< OverlayFormat
+    int eval_mode;              ///< EvalMode
+
+    FFDualInputContext dinput;
+
+    int main_pix_step[4];       ///< steps per pixel for each plane of the main output
+    int overlay_pix_step[4];    ///< steps per pixel for each plane of the overlay
+    int hsub, vsub;             ///< chroma subsampling values
+
+    double var_values[VAR_VARS_NB];
+    char *x_expr, *y_expr;
+
+    int eof_action;             ///< action to take on EOF from source
+
+    AVExpr *x_pexpr, *y_pexpr;
+
+    int (*blend_slice)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
+
+    /**
+     * Blend w pixels of one row of plane i onto a main picture without
+     * alpha. a points to the overlay alpha row matching the row of s,
+     * subsampled planes average the 2x2 alpha block at a and a + alinesize.
+     * Only called on pixels that have a full alpha block available.
+     *
+     * @return the number of pixels blended, the caller blends the rest
+     */
+    int (*blend_row[3])(uint8_t *d, const uint8_t *s, const uint8_t *a,
+                        int w, ptrdiff_t alinesize);
+} OverlayContext;
+
+void ff_overlay_init(OverlayContext *s, int format, int main_has_alpha);
+void ff_overlay_init_x86(OverlayContext *s, int format, int main_has_alpha);
+
+#endif /* AVFILTER_OVERLAY_H */
@@ -29,6 +29,8 @@
 #include "libavutil/qsort.h"
 #include "dualinput.h"
 #include "avfilter.h"
+#include "internal.h"
+#include "paletteuse.h"
 
 enum dithering_mode {
     DITHERING_NONE,
@@ -47,6 +49,11 @@ enum color_search_method {
     NB_COLOR_SEARCHES
 };
 
+/* lookup in the precomputed 3D LUT, selected with the lut_bits option */
+#define COLOR_SEARCH_LUT NB_COLOR_SEARCHES
+
+#define MAX_JOBS 64
+
 enum diff_mode {
     DIFF_MODE_NONE,
     DIFF_MODE_RECTANGLE,
@@ -75,15 +82,24 @@ struct cache_node {
 
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              AVFrame *out, AVFrame *in,
                               int x_start, int y_start, int width, int height);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFDualInputContext dinput;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node *cache;               /* lookup cache of each job, CACHE_SIZE nodes each */
+    int nb_jobs;
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
+    DECLARE_ALIGNED(32, int16_t, pal_rg)[2*AVPALETTE_COUNT]; /* opaque palette colors packed for the brute-force search */
+    DECLARE_ALIGNED(32, int16_t, pal_b)[2*AVPALETTE_COUNT];
+    uint8_t pal_ids[AVPALETTE_COUNT];       /* palette index of each packed color */
+    int nb_pal_entries;
+    PaletteUseDSPContext dsp;
+    int lut_bits;
+    uint8_t *lut;                           /* nearest color of each cell of the RGB cube, lut_bits per component */
     int palette_loaded;
     int dither;
     int new;
@@ -114,6 +130,7 @@ static const AVOption paletteuse_options[] = {
     { "bayer_scale", "set scale for bayer dithering", OFFSET(bayer_scale), AV_OPT_TYPE_INT, {.i64=2}, 0, 5, FLAGS },
     { "diff_mode",   "set frame difference mode",     OFFSET(diff_mode),   AV_OPT_TYPE_INT, {.i64=DIFF_MODE_NONE}, 0, NB_DIFF_MODE-1, FLAGS, "diff_mode" },
         { "rectangle", "process smallest different rectangle", 0, AV_OPT_TYPE_CONST, {.i64=DIFF_MODE_RECTANGLE}, INT_MIN, INT_MAX, FLAGS, "diff_mode" },
+    { "lut_bits",    "set bits per component of the precomputed color lookup table, 0 to disable it", OFFSET(lut_bits), AV_OPT_TYPE_INT, {.i64=0}, 0, 7, FLAGS },
 
     /* following are the debug options, not part of the official API */
     { "debug_kdtree", "save Graphviz graph of the kdtree in specified file", OFFSET(dot_filename), AV_OPT_TYPE_STRING, {.str=NULL}, CHAR_MIN, CHAR_MAX, FLAGS },
@@ -190,6 +207,43 @@ static av_always_inline uint8_t colormap_nearest_bruteforce(const uint32_t *pale
     return pal_id;
 }
 
+static int nearest_color_c(const int16_t *rg, const int16_t *b, int nb_entries,
+                           uint32_t color)
+{
+    const int r0 = color >> 16 & 0xff;
+    const int g0 = color >>  8 & 0xff;
+    const int b0 = color       & 0xff;
+    int i, pal_id = 0, min_dist = INT_MAX;
+
+    for (i = 0; i < nb_entries; i++) {
+        const int dr = rg[2*i    ] - r0;
+        const int dg = rg[2*i + 1] - g0;
+        const int db = b [2*i    ] - b0;
+        const int d = dr*dr + dg*dg + db*db;
+        if (d < min_dist) {
+            pal_id = i;
+            min_dist = d;
+        }
+    }
+    return pal_id;
+}
+
+av_cold void ff_paletteuse_init(PaletteUseDSPContext *dsp)
+{
+    dsp->nearest_color = nearest_color_c;
+
+    if (ARCH_X86)
+        ff_paletteuse_init_x86(dsp);
+}
+
+/* Brute-force search into the packed opaque colors, same result as
+ * colormap_nearest_bruteforce() */
+static av_always_inline uint8_t colormap_nearest_packed(const PaletteUseContext *s, const uint8_t *rgb)
+{
+    const uint32_t c = rgb[0] << 16 | rgb[1] << 8 | rgb[2];
+    return s->pal_ids[s->dsp.nearest_color(s->pal_rg, s->pal_b, s->nb_pal_entries, c)];
+}
+
 /* Recursive form, simpler but a bit slower. Kept for reference. */
 struct nearest_color {
     int node_pos;
@@ -310,22 +364,21 @@ end:
     return root[best_node_id].palette_id;
 }
 
-#define COLORMAP_NEAREST(search, palette, root, target)                                    \
-    search == COLOR_SEARCH_NNS_ITERATIVE ? colormap_nearest_iterative(root, target) :      \
-    search == COLOR_SEARCH_NNS_RECURSIVE ? colormap_nearest_recursive(root, target) :      \
-                                           colormap_nearest_bruteforce(palette, target)
+#define COLORMAP_NEAREST(s, search, target)                                                 \
+    search == COLOR_SEARCH_NNS_ITERATIVE ? colormap_nearest_iterative((s)->map, target) :  \
+    search == COLOR_SEARCH_NNS_RECURSIVE ? colormap_nearest_recursive((s)->map, target) :  \
+                                           colormap_nearest_packed(s, target)
 
 /**
  * Check if the requested color is in the cache already. If not, find it in the
  * color tree and cache it.
  * Note: r, g, and b are the component of c but are passed as well to avoid
  * recomputing them (they are generally computed by the caller for other uses).
+ * With the precomputed LUT, the color is looked up directly instead.
  */
-static av_always_inline int color_get(struct cache_node *cache, uint32_t color,
-                                      uint8_t r, uint8_t g, uint8_t b,
-                                      const struct color_node *map,
-                                      const uint32_t *palette,
-                                      const enum color_search_method search_method)
+static av_always_inline int color_get(const PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color, uint8_t r, uint8_t g, uint8_t b,
+                                      const int search_method)
 {
     int i;
     const uint8_t rgb[] = {r, g, b};
@@ -336,6 +389,11 @@ static av_always_inline int color_get(struct cache_node *cache, uint32_t color,
     struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
+    if (search_method == COLOR_SEARCH_LUT) {
+        const int bits = s->lut_bits, shift = 8 - bits;
+        return s->lut[(r >> shift) << (2*bits) | (g >> shift) << bits | b >> shift];
+    }
+
     for (i = 0; i < node->nb_entries; i++) {
         e = &node->entries[i];
         if (e->color == color)
@@ -347,36 +405,33 @@ static av_always_inline int color_get(struct cache_node *cache, uint32_t color,
     if (!e)
         return AVERROR(ENOMEM);
     e->color = color;
-    e->pal_entry = COLORMAP_NEAREST(search_method, palette, map, rgb);
+    e->pal_entry = COLORMAP_NEAREST(s, search_method, rgb);
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(struct cache_node *cache,
-                                              uint32_t c, const struct color_node *map,
-                                              const uint32_t *palette,
+static av_always_inline int get_dst_color_err(const PaletteUseContext *s,
+                                              struct cache_node *cache, uint32_t c,
                                               int *er, int *eg, int *eb,
-                                              const enum color_search_method search_method)
+                                              const int search_method)
 {
     const uint8_t r = c >> 16 & 0xff;
     const uint8_t g = c >>  8 & 0xff;
     const uint8_t b = c       & 0xff;
-    const int dstx = color_get(cache, c, r, g, b, map, palette, search_method);
-    const uint32_t dstc = palette[dstx];
+    const int dstx = color_get(s, cache, c, r, g, b, search_method);
+    const uint32_t dstc = s->palette[dstx];
     *er = r - (dstc >> 16 & 0xff);
     *eg = g - (dstc >>  8 & 0xff);
     *eb = b - (dstc       & 0xff);
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
                                       enum dithering_mode dither,
-                                      const enum color_search_method search_method)
+                                      const int search_method)
 {
     int x, y;
-    const struct color_node *map = s->map;
-    struct cache_node *cache = s->cache;
-    const uint32_t *palette = s->palette;
     const int src_linesize = in ->linesize[0] >> 2;
     const int dst_linesize = out->linesize[0];
     uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
@@ -398,7 +453,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
                 const uint32_t c = r<<16 | g<<8 | b;
-                const int color = color_get(cache, c, r, g, b, map, palette, search_method);
+                const int color = color_get(s, cache, c, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -406,7 +461,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(cache, src[x], map, palette, &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -418,7 +473,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(cache, src[x], map, palette, &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -432,7 +487,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(cache, src[x], map, palette, &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -451,7 +506,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(cache, src[x], map, palette, &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -465,7 +520,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = src[x] >> 16 & 0xff;
                 const uint8_t g = src[x] >>  8 & 0xff;
                 const uint8_t b = src[x]       & 0xff;
-                const int color = color_get(cache, src[x] & 0xffffff, r, g, b, map, palette, search_method);
+                const int color = color_get(s, cache, src[x] & 0xffffff, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -478,6 +533,43 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
     return 0;
 }
 
+#define DEFINE_SET_FRAME(color_search, name, value)                                     \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,             \
+                            AVFrame *out, AVFrame *in,                                  \
+                            int x_start, int y_start, int w, int h)                     \
+{                                                                                       \
+    return set_frame(s, cache, out, in, x_start, y_start, w, h, value, color_search);   \
+}
+
+#define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
+    DEFINE_SET_FRAME(color_search_macro, color_search##_##none,            DITHERING_NONE)              \
+    DEFINE_SET_FRAME(color_search_macro, color_search##_##bayer,           DITHERING_BAYER)             \
+    DEFINE_SET_FRAME(color_search_macro, color_search##_##heckbert,        DITHERING_HECKBERT)          \
+    DEFINE_SET_FRAME(color_search_macro, color_search##_##floyd_steinberg, DITHERING_FLOYD_STEINBERG)   \
+    DEFINE_SET_FRAME(color_search_macro, color_search##_##sierra2,         DITHERING_SIERRA2)           \
+    DEFINE_SET_FRAME(color_search_macro, color_search##_##sierra2_4a,      DITHERING_SIERRA2_4A)        \
+
+DEFINE_SET_FRAME_COLOR_SEARCH(nns_iterative, COLOR_SEARCH_NNS_ITERATIVE)
+DEFINE_SET_FRAME_COLOR_SEARCH(nns_recursive, COLOR_SEARCH_NNS_RECURSIVE)
+DEFINE_SET_FRAME_COLOR_SEARCH(bruteforce,    COLOR_SEARCH_BRUTEFORCE)
+DEFINE_SET_FRAME_COLOR_SEARCH(lut,           COLOR_SEARCH_LUT)
+
+#define DITHERING_ENTRIES(color_search) {       \
+    set_frame_##color_search##_none,            \
+    set_frame_##color_search##_bayer,           \
+    set_frame_##color_search##_heckbert,        \
+    set_frame_##color_search##_floyd_steinberg, \
+    set_frame_##color_search##_sierra2,         \
+    set_frame_##color_search##_sierra2_4a,      \
+}
+
+static const set_frame_func set_frame_lut[NB_COLOR_SEARCHES + 1][NB_DITHERING] = {
+    DITHERING_ENTRIES(nns_iterative),
+    DITHERING_ENTRIES(nns_recursive),
+    DITHERING_ENTRIES(bruteforce),
+    DITHERING_ENTRIES(lut),
+};
+
 #define INDENT 4
 static void disp_node(AVBPrint *buf,
                       const struct color_node *map,
@@ -532,16 +624,16 @@ static int disp_tree(const struct color_node *node, const char *fname)
     return 0;
 }
 
-static int debug_accuracy(const struct color_node *node, const uint32_t *palette,
-                          const enum color_search_method search_method)
+static int debug_accuracy(const PaletteUseContext *s, const int search_method)
 {
+    const uint32_t *palette = s->palette;
     int r, g, b, ret = 0;
 
     for (r = 0; r < 256; r++) {
         for (g = 0; g < 256; g++) {
             for (b = 0; b < 256; b++) {
                 const uint8_t rgb[] = {r, g, b};
-                const int r1 = COLORMAP_NEAREST(search_method, palette, node, rgb);
+                const int r1 = COLORMAP_NEAREST(s, search_method, rgb);
                 const int r2 = colormap_nearest_bruteforce(palette, rgb);
                 if (r1 != r2) {
                     const uint32_t c1 = palette[r1];
@@ -698,6 +790,40 @@ static int cmp_pal_entry(const void *a, const void *b)
     return c1 - c2;
 }
 
+/**
+ * Pack the distinct opaque colors of the palette for the brute-force search.
+ * The palette must be sorted, so that the duplicates are contiguous; only
+ * the first one is kept, as it is the one colormap_nearest_bruteforce()
+ * would return.
+ */
+static void pack_palette(PaletteUseContext *s)
+{
+    int i, nb_colors, n = 0;
+
+    for (i = 0; i < AVPALETTE_COUNT; i++) {
+        const uint32_t c = s->palette[i];
+
+        if ((c & 0xff000000) != 0xff000000)
+            continue;
+        if (n && c == s->palette[s->pal_ids[n - 1]])
+            continue;
+        s->pal_rg[2*n    ] = c >> 16 & 0xff;
+        s->pal_rg[2*n + 1] = c >>  8 & 0xff;
+        s->pal_b [2*n    ] = c       & 0xff;
+        s->pal_b [2*n + 1] = 0;
+        s->pal_ids[n++] = i;
+    }
+    nb_colors = n;
+
+    for (; n < FFALIGN(FFMAX(nb_colors, 1), PALETTEUSE_PACKED_ALIGN); n++) {
+        s->pal_rg[2*n] = s->pal_rg[2*n + 1] = PALETTEUSE_PACKED_PAD;
+        s->pal_b [2*n] = PALETTEUSE_PACKED_PAD;
+        s->pal_b [2*n + 1] = 0;
+        s->pal_ids[n] = 0;
+    }
+    s->nb_pal_entries = n;
+}
+
 static void load_colormap(PaletteUseContext *s)
 {
     int i, nb_used = 0;
@@ -725,11 +851,13 @@ static void load_colormap(PaletteUseContext *s)
 
     colormap_insert(s->map, color_used, &nb_used, s->palette, &box);
 
+    pack_palette(s);
+
     if (s->dot_filename)
         disp_tree(s->map, s->dot_filename);
 
     if (s->debug_accuracy) {
-        if (!debug_accuracy(s->map, s->palette, s->color_search_method))
+        if (!debug_accuracy(s, s->color_search_method))
             av_log(NULL, AV_LOG_INFO, "Accuracy check passed\n");
     }
 }
@@ -853,12 +981,30 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+} ThreadData;
+
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const int slice_start = td->y + (td->h *  jobnr     ) / nb_jobs;
+    const int slice_end   = td->y + (td->h * (jobnr + 1)) / nb_jobs;
+
+    return s->set_frame(s, s->cache + jobnr * CACHE_SIZE, td->out, td->in,
+                        td->x, slice_start, td->w, slice_end - slice_start);
+}
+
 static AVFrame *apply_palette(AVFilterLink *inlink, AVFrame *in)
 {
-    int x, y, w, h;
+    int x, y, w, h, i, nb_jobs;
     AVFilterContext *ctx = inlink->dst;
     PaletteUseContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
+    int rets[MAX_JOBS];
+    ThreadData td;
 
     AVFrame *out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -883,9 +1029,22 @@ static AVFrame *apply_palette(AVFilterLink *inlink, AVFrame *in)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    if (s->set_frame(s, out, in, x, y, w, h) < 0) {
-        av_frame_free(&out);
-        return NULL;
+    /* the error diffusion needs the rows to be processed in order, the
+     * ordered and no dithering have no dependency between the pixels */
+    nb_jobs = s->dither == DITHERING_NONE || s->dither == DITHERING_BAYER ?
+              FFMIN(s->nb_jobs, h) : 1;
+    td.in  = in;
+    td.out = out;
+    td.x   = x;
+    td.y   = y;
+    td.w   = w;
+    td.h   = h;
+    ctx->internal->execute(ctx, set_frame_slice, &td, rets, nb_jobs);
+    for (i = 0; i < nb_jobs; i++) {
+        if (rets[i] < 0) {
+            av_frame_free(&out);
+            return NULL;
+        }
     }
     memcpy(out->data[1], s->palette, AVPALETTE_SIZE);
     if (s->calc_mean_err)
@@ -894,6 +1053,16 @@ static AVFrame *apply_palette(AVFilterLink *inlink, AVFrame *in)
     return out;
 }
 
+static void reset_caches(PaletteUseContext *s)
+{
+    int i;
+
+    for (i = 0; i < s->nb_jobs * CACHE_SIZE; i++) {
+        av_freep(&s->cache[i].entries);
+        s->cache[i].nb_entries = 0;
+    }
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     int ret;
@@ -903,6 +1072,15 @@ static int config_output(AVFilterLink *outlink)
     outlink->w = ctx->inputs[0]->w;
     outlink->h = ctx->inputs[0]->h;
 
+    reset_caches(s);
+    av_freep(&s->cache);
+    s->nb_jobs = FFMIN(ff_filter_get_nb_threads(ctx), MAX_JOBS);
+    s->cache = av_mallocz_array(s->nb_jobs * CACHE_SIZE, sizeof(*s->cache));
+    if (!s->cache) {
+        s->nb_jobs = 0;
+        return AVERROR(ENOMEM);
+    }
+
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_dualinput_init(ctx, &s->dinput)) < 0)
         return ret;
@@ -924,8 +1102,33 @@ static int config_input_palette(AVFilterLink *inlink)
     return 0;
 }
 
-static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
+static int build_lut_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const int bits  = s->lut_bits;
+    const int shift = 8 - bits;
+    const int half  = 1 << shift >> 1;
+    const int size  = 1 << bits;
+    const int slice_start = (size *  jobnr     ) / nb_jobs;
+    const int slice_end   = (size * (jobnr + 1)) / nb_jobs;
+    uint8_t *lut = s->lut + (slice_start << 2*bits);
+    int r, g, b;
+
+    /* each cell maps to the color nearest to its center */
+    for (r = slice_start; r < slice_end; r++) {
+        for (g = 0; g < size; g++) {
+            for (b = 0; b < size; b++) {
+                const uint8_t rgb[] = { r << shift | half, g << shift | half, b << shift | half };
+                *lut++ = COLORMAP_NEAREST(s, s->color_search_method, rgb);
+            }
+        }
+    }
+    return 0;
+}
+
+static int load_palette(AVFilterContext *ctx, const AVFrame *palette_frame)
 {
+    PaletteUseContext *s = ctx->priv;
     int i, x, y;
     const uint32_t *p = (const uint32_t *)palette_frame->data[0];
     const int p_linesize = palette_frame->linesize[0] >> 2;
@@ -933,9 +1136,7 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        reset_caches(s);
     }
 
     i = 0;
@@ -947,8 +1148,20 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
 
     load_colormap(s);
 
+    if (s->lut_bits) {
+        if (!s->lut) {
+            s->lut = av_malloc(1 << 3*s->lut_bits);
+            if (!s->lut)
+                return AVERROR(ENOMEM);
+        }
+        ctx->internal->execute(ctx, build_lut_slice, NULL, NULL,
+                               FFMIN(s->nb_jobs, 1 << s->lut_bits));
+    }
+    s->set_frame = set_frame_lut[s->lut_bits ? COLOR_SEARCH_LUT : s->color_search_method][s->dither];
+
     if (!s->new)
         s->palette_loaded = 1;
+    return 0;
 }
 
 static AVFrame *load_apply_palette(AVFilterContext *ctx, AVFrame *main,
@@ -957,7 +1170,10 @@ static AVFrame *load_apply_palette(AVFilterContext *ctx, AVFrame *main,
     AVFilterLink *inlink = ctx->inputs[0];
     PaletteUseContext *s = ctx->priv;
     if (!s->palette_loaded) {
-        load_palette(s, second);
+        if (load_palette(ctx, second) < 0) {
+            av_frame_free(&main);
+            return NULL;
+        }
     }
     return apply_palette(inlink, main);
 }
@@ -968,40 +1184,6 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     return ff_dualinput_filter_frame(&s->dinput, inlink, in);
 }
 
-#define DEFINE_SET_FRAME(color_search, name, value)                             \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
-{                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
-}
-
-#define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
-    DEFINE_SET_FRAME(color_search_macro, color_search##_##none,            DITHERING_NONE)              \
-    DEFINE_SET_FRAME(color_search_macro, color_search##_##bayer,           DITHERING_BAYER)             \
-    DEFINE_SET_FRAME(color_search_macro, color_search##_##heckbert,        DITHERING_HECKBERT)          \
-    DEFINE_SET_FRAME(color_search_macro, color_search##_##floyd_steinberg, DITHERING_FLOYD_STEINBERG)   \
-    DEFINE_SET_FRAME(color_search_macro, color_search##_##sierra2,         DITHERING_SIERRA2)           \
-    DEFINE_SET_FRAME(color_search_macro, color_search##_##sierra2_4a,      DITHERING_SIERRA2_4A)        \
-
-DEFINE_SET_FRAME_COLOR_SEARCH(nns_iterative, COLOR_SEARCH_NNS_ITERATIVE)
-DEFINE_SET_FRAME_COLOR_SEARCH(nns_recursive, COLOR_SEARCH_NNS_RECURSIVE)
-DEFINE_SET_FRAME_COLOR_SEARCH(bruteforce,    COLOR_SEARCH_BRUTEFORCE)
-
-#define DITHERING_ENTRIES(color_search) {       \
-    set_frame_##color_search##_none,            \
-    set_frame_##color_search##_bayer,           \
-    set_frame_##color_search##_heckbert,        \
-    set_frame_##color_search##_floyd_steinberg, \
-    set_frame_##color_search##_sierra2,         \
-    set_frame_##color_search##_sierra2_4a,      \
-}
-
-static const set_frame_func set_frame_lut[NB_COLOR_SEARCHES][NB_DITHERING] = {
-    DITHERING_ENTRIES(nns_iterative),
-    DITHERING_ENTRIES(nns_recursive),
-    DITHERING_ENTRIES(bruteforce),
-};
-
 static int dither_value(int p)
 {
     const int q = p ^ (p >> 3);
@@ -1017,7 +1199,7 @@ static av_cold int init(AVFilterContext *ctx)
     s->dinput.skip_initial_unpaired = 1;
     s->dinput.process    = load_apply_palette;
 
-    s->set_frame = set_frame_lut[s->color_search_method][s->dither];
+    ff_paletteuse_init(&s->dsp);
 
     if (s->dither == DITHERING_BAYER) {
         int i;
@@ -1038,12 +1220,12 @@ static int request_frame(AVFilterLink *outlink)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
     PaletteUseContext *s = ctx->priv;
 
     ff_dualinput_uninit(&s->dinput);
-    for (i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    reset_caches(s);
+    av_freep(&s->cache);
+    av_freep(&s->lut);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1083,4 +1265,5 @@ AVFilter ff_vf_paletteuse = {
     .inputs        = paletteuse_inputs,
     .outputs       = paletteuse_outputs,
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
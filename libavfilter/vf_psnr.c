@@ -54,6 +54,8 @@ typedef struct PSNRContext {
     int planewidth[4];
     int planeheight[4];
     double planeweight[4];
+    uint64_t (*score)[4];       ///< sum of squared errors of each slice and plane
+    int nb_threads;
     PSNRDSPContext dsp;
 } PSNRContext;
 
@@ -104,29 +106,40 @@ static uint64_t sse_line_16bit(const uint8_t *_main_line, const uint8_t *_ref_li
     return m2;
 }
 
-static inline
-void compute_images_mse(PSNRContext *s,
-                        const uint8_t *main_data[4], const int main_linesizes[4],
-                        const uint8_t *ref_data[4], const int ref_linesizes[4],
-                        int w, int h, double mse[4])
+typedef struct ThreadData {
+    const uint8_t *main_data[4];
+    const uint8_t *ref_data[4];
+    int main_linesize[4];
+    int ref_linesize[4];
+} ThreadData;
+
+static int compute_images_mse(AVFilterContext *ctx, void *arg,
+                              int jobnr, int nb_jobs)
 {
+    PSNRContext *s = ctx->priv;
+    ThreadData *td = arg;
+    uint64_t *score = s->score[jobnr];
     int i, c;
 
     for (c = 0; c < s->nb_components; c++) {
         const int outw = s->planewidth[c];
         const int outh = s->planeheight[c];
-        const uint8_t *main_line = main_data[c];
-        const uint8_t *ref_line = ref_data[c];
-        const int ref_linesize = ref_linesizes[c];
-        const int main_linesize = main_linesizes[c];
+        const int slice_start = (outh * jobnr) / nb_jobs;
+        const int slice_end   = (outh * (jobnr + 1)) / nb_jobs;
+        const int ref_linesize = td->ref_linesize[c];
+        const int main_linesize = td->main_linesize[c];
+        const uint8_t *main_line = td->main_data[c] + main_linesize * slice_start;
+        const uint8_t *ref_line = td->ref_data[c] + ref_linesize * slice_start;
         uint64_t m = 0;
-        for (i = 0; i < outh; i++) {
+        for (i = slice_start; i < slice_end; i++) {
             m += s->dsp.sse_line(main_line, ref_line, outw);
             ref_line += ref_linesize;
             main_line += main_linesize;
         }
-        mse[c] = m / (double)(outw * outh);
+        score[c] = m;
     }
+
+    return 0;
 }
 
 static void set_meta(AVDictionary **metadata, const char *key, char comp, float d)
@@ -147,12 +160,27 @@ static AVFrame *do_psnr(AVFilterContext *ctx, AVFrame *main,
 {
     PSNRContext *s = ctx->priv;
     double comp_mse[4], mse = 0;
-    int j, c;
+    int i, j, c, nb_jobs;
     AVDictionary **metadata = avpriv_frame_get_metadatap(main);
+    ThreadData td;
 
-    compute_images_mse(s, (const uint8_t **)main->data, main->linesize,
-                          (const uint8_t **)ref->data, ref->linesize,
-                          main->width, main->height, comp_mse);
+    for (c = 0; c < s->nb_components; c++) {
+        td.main_data[c]     = main->data[c];
+        td.ref_data[c]      = ref->data[c];
+        td.main_linesize[c] = main->linesize[c];
+        td.ref_linesize[c]  = ref->linesize[c];
+    }
+    nb_jobs = FFMIN(s->nb_threads, s->planeheight[1]);
+    ctx->internal->execute(ctx, compute_images_mse, &td, NULL, nb_jobs);
+
+    /* the partial sums are integers, so the result does not depend on the
+     * number of jobs */
+    for (c = 0; c < s->nb_components; c++) {
+        uint64_t m = 0;
+        for (i = 0; i < nb_jobs; i++)
+            m += s->score[i][c];
+        comp_mse[c] = m / (double)(s->planewidth[c] * s->planeheight[c]);
+    }
 
     for (j = 0; j < s->nb_components; j++)
         mse += comp_mse[j] * s->planeweight[j];
@@ -317,6 +345,11 @@ static int config_input_ref(AVFilterLink *inlink)
     }
     s->average_max = lrint(average_max);
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->score = av_calloc(s->nb_threads, sizeof(*s->score));
+    if (!s->score)
+        return AVERROR(ENOMEM);
+
     s->dsp.sse_line = desc->comp[0].depth > 8 ? sse_line_16bit : sse_line_8bit;
     if (ARCH_X86)
         ff_psnr_init_x86(&s->dsp, desc->comp[0].depth);
@@ -379,6 +412,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     if (s->stats_file && s->stats_file != stdout)
         fclose(s->stats_file);
+
+    av_freep(&s->score);
 }
 
 static const AVFilterPad psnr_inputs[] = {
@@ -415,4 +450,5 @@ AVFilter ff_vf_psnr = {
     .priv_class    = &psnr_class,
     .inputs        = psnr_inputs,
     .outputs       = psnr_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
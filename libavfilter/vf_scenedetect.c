@@ -0,0 +1,124 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * scene change detection filter, exporting the score as frame metadata
+ */
+
+#include "libavutil/internal.h"
+#include "libavutil/opt.h"
+#include "libavutil/timestamp.h"
+
+#include "avfilter.h"
+#include "formats.h"
+#include "internal.h"
+#include "scene_detect.h"
+#include "video.h"
+
+typedef struct SceneDetectFilterContext {
+    const AVClass *class;
+    int scale;
+    double threshold;
+    SceneDetectContext sd;
+} SceneDetectFilterContext;
+
+static int query_formats(AVFilterContext *ctx)
+{
+    AVFilterFormats *fmts_list = ff_scene_detect_formats();
+    if (!fmts_list)
+        return AVERROR(ENOMEM);
+    return ff_set_common_formats(ctx, fmts_list);
+}
+
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    SceneDetectFilterContext *s = ctx->priv;
+
+    ff_scene_detect_uninit(&s->sd);
+    return ff_scene_detect_init(&s->sd, ctx, inlink->w, inlink->h, inlink->format,
+                                s->scale, ff_filter_get_nb_threads(ctx));
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    SceneDetectFilterContext *s = ctx->priv;
+    AVDictionary **metadata = avpriv_frame_get_metadatap(frame);
+    double score = ff_scene_detect_frame(&s->sd, ctx, frame);
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%f", score);
+    av_dict_set(metadata, "lavfi.scene_score", buf, 0);
+    if (s->threshold > 0 && score >= s->threshold)
+        av_dict_set(metadata, "lavfi.scene_change", "1", 0);
+
+    av_log(ctx, AV_LOG_DEBUG, "n:%"PRId64" pts:%s scene:%f\n",
+           inlink->frame_count, av_ts2str(frame->pts), score);
+
+    return ff_filter_frame(ctx->outputs[0], frame);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    SceneDetectFilterContext *s = ctx->priv;
+
+    ff_scene_detect_uninit(&s->sd);
+}
+
+#define OFFSET(x) offsetof(SceneDetectFilterContext, x)
+#define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
+
+static const AVOption scenedetect_options[] = {
+    { "scale",     "set the downscaling factor of the analyzed luma", OFFSET(scale),     AV_OPT_TYPE_INT,    { .i64 = 4 }, 1, 16, FLAGS },
+    { "threshold", "set the score from which a scene change is flagged", OFFSET(threshold), AV_OPT_TYPE_DOUBLE, { .dbl = 0 }, 0, 1,  FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(scenedetect);
+
+static const AVFilterPad scenedetect_inputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
+        .filter_frame = filter_frame,
+    },
+    { NULL }
+};
+
+static const AVFilterPad scenedetect_outputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_scenedetect = {
+    .name          = "scenedetect",
+    .description   = NULL_IF_CONFIG_SMALL("Detect scene changes and export their score as metadata."),
+    .priv_size     = sizeof(SceneDetectFilterContext),
+    .priv_class    = &scenedetect_class,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .inputs        = scenedetect_inputs,
+    .outputs       = scenedetect_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
+};
@@ -59,8 +59,15 @@ typedef struct SSIMContext {
     int planewidth[4];
     int planeheight[4];
     int *temp;
+    int temp_size;              ///< size of the temp buffer of each job
+    float *row_ssim[4];         ///< SSIM of each row of 4x4 blocks of each plane
     int is_rgb;
+    int nb_threads;
     SSIMDSPContext dsp;
+
+    int psnr;                   ///< also compute the PSNR from the block sums
+    uint64_t (*sse)[4];         ///< sum of squared errors of each job and plane
+    double mse, min_mse, max_mse, mse_comp[4];
 } SSIMContext;
 
 #define OFFSET(x) offsetof(SSIMContext, x)
@@ -69,6 +76,7 @@ typedef struct SSIMContext {
 static const AVOption ssim_options[] = {
     {"stats_file", "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
     {"f",          "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    {"psnr",       "Also compute the PSNR in the same pass",                    OFFSET(psnr),           AV_OPT_TYPE_BOOL,   {.i64=0},    0, 1, FLAGS },
     { NULL }
 };
 
@@ -147,31 +155,92 @@ static float ssim_endn(const int (*sum0)[4], const int (*sum1)[4], int width)
     return ssim;
 }
 
-static float ssim_plane(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp)
+typedef struct ThreadData {
+    const uint8_t *main_data[4];
+    const uint8_t *ref_data[4];
+    int main_linesize[4];
+    int ref_linesize[4];
+} ThreadData;
+
+/* squared errors of the pixels right and below the 4x4 blocks, band of
+ * pixel rows y0..y1 */
+static uint64_t sse_edges(const uint8_t *main, int main_stride,
+                          const uint8_t *ref, int ref_stride,
+                          int width, int height, int y0, int y1)
 {
-    int z = 0, y;
-    float ssim = 0.0;
-    int (*sum0)[4] = temp;
-    int (*sum1)[4] = sum0 + (width >> 2) + 3;
+    uint64_t sse = 0;
+    int x, y;
+
+    for (y = y0; y < y1; y++) {
+        x = y < (height & ~3) ? width & ~3 : 0;
+        for (; x < width; x++) {
+            int d = main[y * main_stride + x] - ref[y * ref_stride + x];
+            sse += d * d;
+        }
+    }
+    return sse;
+}
 
-    width >>= 2;
-    height >>= 2;
+/* computes the SSIM of the rows of 4x4 blocks of a band of each plane, the
+ * rows are summed in order afterwards so the result does not depend on the
+ * number of jobs */
+static int ssim_plane(AVFilterContext *ctx, void *arg,
+                      int jobnr, int nb_jobs)
+{
+    SSIMContext *s = ctx->priv;
+    ThreadData *td = arg;
+    SSIMDSPContext *dsp = &s->dsp;
+    void *temp = s->temp + jobnr * s->temp_size;
+    int c, z;
+
+    for (c = 0; c < s->nb_components; c++) {
+        const uint8_t *main = td->main_data[c];
+        const uint8_t *ref  = td->ref_data[c];
+        const int main_stride = td->main_linesize[c];
+        const int ref_stride  = td->ref_linesize[c];
+        const int width  = s->planewidth[c]  >> 2;
+        const int height = s->planeheight[c] >> 2;
+        const int slice_start = (height * jobnr) / nb_jobs;
+        const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+        int (*sum0)[4] = temp;
+        int (*sum1)[4] = sum0 + width + 3;
+        uint64_t sse = 0;
+
+        /* the first row of the band also needs the sums of the row above */
+        if (slice_start > 0)
+            dsp->ssim_4x4_line(&main[4 * (slice_start - 1) * main_stride], main_stride,
+                               &ref[4 * (slice_start - 1) * ref_stride], ref_stride,
+                               sum0, width);
 
-    for (y = 1; y < height; y++) {
-        for (; z <= y; z++) {
+        for (z = slice_start; z < slice_end; z++) {
             FFSWAP(void*, sum0, sum1);
             dsp->ssim_4x4_line(&main[4 * z * main_stride], main_stride,
                                &ref[4 * z * ref_stride], ref_stride,
                                sum0, width);
+            if (s->psnr) {
+                int x;
+                for (x = 0; x < width; x++)
+                    sse += sum0[x][2] - 2 * sum0[x][3];
+            }
+            if (z > 0)
+                s->row_ssim[c][z] = dsp->ssim_end_line((const int (*)[4])sum0,
+                                                       (const int (*)[4])sum1, width - 1);
         }
 
-        ssim += dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
+        if (s->psnr) {
+            int y1 = jobnr == nb_jobs - 1 ? s->planeheight[c] : 4 * slice_end;
+            sse += sse_edges(main, main_stride, ref, ref_stride,
+                             s->planewidth[c], s->planeheight[c], 4 * slice_start, y1);
+            s->sse[jobnr][c] = sse;
+        }
     }
 
-    return ssim / ((height - 1) * (width - 1));
+    return 0;
+}
+
+static inline double get_psnr(double mse, uint64_t nb_frames, int max)
+{
+    return 10.0 * log10(max * max / (mse / nb_frames));
 }
 
 static double ssim_db(double ssim, double weight)
@@ -185,14 +254,29 @@ static AVFrame *do_ssim(AVFilterContext *ctx, AVFrame *main,
     AVDictionary **metadata = avpriv_frame_get_metadatap(main);
     SSIMContext *s = ctx->priv;
     float c[4], ssimv = 0.0;
-    int i;
+    double comp_mse[4], mse = 0;
+    ThreadData td;
+    int i, j, nb_jobs;
 
     s->nb_frames++;
 
     for (i = 0; i < s->nb_components; i++) {
-        c[i] = ssim_plane(&s->dsp, main->data[i], main->linesize[i],
-                          ref->data[i], ref->linesize[i],
-                          s->planewidth[i], s->planeheight[i], s->temp);
+        td.main_data[i]     = main->data[i];
+        td.ref_data[i]      = ref->data[i];
+        td.main_linesize[i] = main->linesize[i];
+        td.ref_linesize[i]  = ref->linesize[i];
+    }
+    nb_jobs = av_clip(s->planeheight[1] >> 2, 1, s->nb_threads);
+    ctx->internal->execute(ctx, ssim_plane, &td, NULL, nb_jobs);
+
+    for (i = 0; i < s->nb_components; i++) {
+        const int width  = s->planewidth[i]  >> 2;
+        const int height = s->planeheight[i] >> 2;
+        float ssim = 0.0;
+
+        for (j = 1; j < height; j++)
+            ssim += s->row_ssim[i][j];
+        c[i] = ssim / ((height - 1) * (width - 1));
         ssimv += s->coefs[i] * c[i];
         s->ssim[i] += c[i];
     }
@@ -205,6 +289,28 @@ static AVFrame *do_ssim(AVFilterContext *ctx, AVFrame *main,
     set_meta(metadata, "lavfi.ssim.All", 0, ssimv);
     set_meta(metadata, "lavfi.ssim.dB", 0, ssim_db(ssimv, 1.0));
 
+    if (s->psnr) {
+        for (i = 0; i < s->nb_components; i++) {
+            uint64_t sse = 0;
+            for (j = 0; j < nb_jobs; j++)
+                sse += s->sse[j][i];
+            comp_mse[i] = sse / (double)(s->planewidth[i] * s->planeheight[i]);
+            mse += comp_mse[i] * s->coefs[i];
+            s->mse_comp[i] += comp_mse[i];
+        }
+        s->min_mse = FFMIN(s->min_mse, mse);
+        s->max_mse = FFMAX(s->max_mse, mse);
+        s->mse += mse;
+
+        for (i = 0; i < s->nb_components; i++) {
+            int cidx = s->is_rgb ? s->rgba_map[i] : i;
+            set_meta(metadata, "lavfi.psnr.mse.", av_tolower(s->comps[i]), comp_mse[cidx]);
+            set_meta(metadata, "lavfi.psnr.psnr.", av_tolower(s->comps[i]), get_psnr(comp_mse[cidx], 1, 255));
+        }
+        set_meta(metadata, "lavfi.psnr.mse_avg", 0, mse);
+        set_meta(metadata, "lavfi.psnr.psnr_avg", 0, get_psnr(mse, 1, 255));
+    }
+
     if (s->stats_file) {
         fprintf(s->stats_file, "n:%"PRId64" ", s->nb_frames);
 
@@ -213,7 +319,17 @@ static AVFrame *do_ssim(AVFilterContext *ctx, AVFrame *main,
             fprintf(s->stats_file, "%c:%f ", s->comps[i], c[cidx]);
         }
 
-        fprintf(s->stats_file, "All:%f (%f)\n", ssimv, ssim_db(ssimv, 1.0));
+        fprintf(s->stats_file, "All:%f (%f)", ssimv, ssim_db(ssimv, 1.0));
+
+        if (s->psnr) {
+            for (i = 0; i < s->nb_components; i++) {
+                int cidx = s->is_rgb ? s->rgba_map[i] : i;
+                fprintf(s->stats_file, " psnr_%c:%0.2f", av_tolower(s->comps[i]),
+                        get_psnr(comp_mse[cidx], 1, 255));
+            }
+            fprintf(s->stats_file, " psnr_avg:%0.2f", get_psnr(mse, 1, 255));
+        }
+        fprintf(s->stats_file, "\n");
     }
 
     return main;
@@ -223,6 +339,9 @@ static av_cold int init(AVFilterContext *ctx)
 {
     SSIMContext *s = ctx->priv;
 
+    s->min_mse = +INFINITY;
+    s->max_mse = -INFINITY;
+
     if (s->stats_file_str) {
         if (!strcmp(s->stats_file_str, "-")) {
             s->stats_file = stdout;
@@ -297,9 +416,22 @@ static int config_input_ref(AVFilterLink *inlink)
     for (i = 0; i < s->nb_components; i++)
         s->coefs[i] = (double) s->planeheight[i] * s->planewidth[i] / sum;
 
-    s->temp = av_malloc((2 * inlink->w + 12) * sizeof(*s->temp));
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->temp_size  = FFALIGN(2 * inlink->w + 12, 16);
+    s->temp = av_malloc_array(s->nb_threads, s->temp_size * sizeof(*s->temp));
     if (!s->temp)
         return AVERROR(ENOMEM);
+    s->row_ssim[0] = av_malloc_array(s->nb_components * ((inlink->h >> 2) + 1),
+                                      sizeof(*s->row_ssim[0]));
+    if (!s->row_ssim[0])
+        return AVERROR(ENOMEM);
+    for (i = 1; i < s->nb_components; i++)
+        s->row_ssim[i] = s->row_ssim[i - 1] + (s->planeheight[i - 1] >> 2) + 1;
+    if (s->psnr) {
+        s->sse = av_calloc(s->nb_threads, sizeof(*s->sse));
+        if (!s->sse)
+            return AVERROR(ENOMEM);
+    }
 
     s->dsp.ssim_4x4_line = ssim_4x4xn;
     s->dsp.ssim_end_line = ssim_endn;
@@ -355,6 +487,19 @@ static av_cold void uninit(AVFilterContext *ctx)
         }
         av_log(ctx, AV_LOG_INFO, "SSIM%s All:%f (%f)\n", buf,
                s->ssim_total / s->nb_frames, ssim_db(s->ssim_total, s->nb_frames));
+
+        if (s->psnr) {
+            buf[0] = 0;
+            for (i = 0; i < s->nb_components; i++) {
+                int c = s->is_rgb ? s->rgba_map[i] : i;
+                av_strlcatf(buf, sizeof(buf), " %c:%f", av_tolower(s->comps[i]),
+                            get_psnr(s->mse_comp[c], s->nb_frames, 255));
+            }
+            av_log(ctx, AV_LOG_INFO, "PSNR%s average:%f min:%f max:%f\n", buf,
+                   get_psnr(s->mse, s->nb_frames, 255),
+                   get_psnr(s->max_mse, 1, 255),
+                   get_psnr(s->min_mse, 1, 255));
+        }
     }
 
     ff_dualinput_uninit(&s->dinput);
@@ -363,6 +508,8 @@ static av_cold void uninit(AVFilterContext *ctx)
         fclose(s->stats_file);
 
     av_freep(&s->temp);
+    av_freep(&s->row_ssim[0]);
+    av_freep(&s->sse);
 }
 
 static const AVFilterPad ssim_inputs[] = {
@@ -399,4 +546,5 @@ AVFilter ff_vf_ssim = {
     .priv_class    = &ssim_class,
     .inputs        = ssim_inputs,
     .outputs       = ssim_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 
+#include "libavutil/display.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
@@ -58,6 +59,8 @@ typedef struct TransContext {
 
     int passthrough;    ///< PassthroughType, landscape passthrough mode enabled
     int dir;            ///< TransposeDir
+    int displaymatrix;  ///< export the transposition instead of applying it
+    int32_t matrix[9];  ///< display matrix of the transposition
 } TransContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -104,6 +107,17 @@ static int config_props_output(AVFilterLink *outlink)
         s->passthrough = TRANSPOSE_PT_TYPE_NONE;
     }
 
+    if (s->displaymatrix) {
+        av_display_rotation_set(s->matrix, s->dir == TRANSPOSE_CLOCK ||
+                                           s->dir == TRANSPOSE_CLOCK_FLIP ? -90 : 90);
+        av_display_matrix_flip(s->matrix, 0, s->dir == TRANSPOSE_CCLOCK_FLIP ||
+                                             s->dir == TRANSPOSE_CLOCK_FLIP);
+        av_log(ctx, AV_LOG_VERBOSE,
+               "w:%d h:%d dir:%d -> exported as display matrix\n",
+               inlink->w, inlink->h, s->dir);
+        return 0;
+    }
+
     s->hsub = desc_in->log2_chroma_w;
     s->vsub = desc_in->log2_chroma_h;
 
@@ -130,7 +144,7 @@ static AVFrame *get_video_buffer(AVFilterLink *inlink, int w, int h)
 {
     TransContext *s = inlink->dst->priv;
 
-    return s->passthrough ?
+    return s->passthrough || s->displaymatrix ?
         ff_null_get_video_buffer   (inlink, w, h) :
         ff_default_get_video_buffer(inlink, w, h);
 }
@@ -224,6 +238,48 @@ static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr,
     return 0;
 }
 
+/**
+ * Attach the transposition to the frame display matrix, so that the pixels
+ * are rotated by whoever displays or encodes the frame.
+ */
+static int export_display_matrix(TransContext *s, AVFrame *frame)
+{
+    AVFrameSideData *sd = av_frame_get_side_data(frame, AV_FRAME_DATA_DISPLAYMATRIX);
+    int32_t *matrix;
+    int i, j, ret;
+
+    if (!sd) {
+        sd = av_frame_new_side_data(frame, AV_FRAME_DATA_DISPLAYMATRIX,
+                                    sizeof(s->matrix));
+        if (!sd)
+            return AVERROR(ENOMEM);
+        memcpy(sd->data, s->matrix, sizeof(s->matrix));
+        return 0;
+    }
+    if (sd->size < sizeof(s->matrix))
+        return AVERROR_INVALIDDATA;
+
+    /* the side data buffer may be shared with other frames */
+    ret = av_buffer_make_writable(&sd->buf);
+    if (ret < 0)
+        return ret;
+    sd->data = sd->buf->data;
+
+    /* apply the transposition after the existing transformation, the
+     * 2x2 part is in 16.16 fixed point and the transposition has no
+     * translation */
+    matrix = (int32_t *)sd->data;
+    for (i = 0; i < 3; i++) {
+        int64_t row[2];
+        for (j = 0; j < 2; j++)
+            row[j] = ((int64_t)matrix[3 * i]     * s->matrix[j] +
+                      (int64_t)matrix[3 * i + 1] * s->matrix[3 + j]) >> 16;
+        matrix[3 * i]     = row[0];
+        matrix[3 * i + 1] = row[1];
+    }
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -235,6 +291,15 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     if (s->passthrough)
         return ff_filter_frame(outlink, in);
 
+    if (s->displaymatrix) {
+        int ret = export_display_matrix(s, in);
+        if (ret < 0) {
+            av_frame_free(&in);
+            return ret;
+        }
+        return ff_filter_frame(outlink, in);
+    }
+
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
         av_frame_free(&in);
@@ -271,6 +336,9 @@ static const AVOption transpose_options[] = {
         { "portrait",  "preserve portrait geometry",   0, AV_OPT_TYPE_CONST, {.i64=TRANSPOSE_PT_TYPE_PORTRAIT},  INT_MIN, INT_MAX, FLAGS, "passthrough" },
         { "landscape", "preserve landscape geometry",  0, AV_OPT_TYPE_CONST, {.i64=TRANSPOSE_PT_TYPE_LANDSCAPE}, INT_MIN, INT_MAX, FLAGS, "passthrough" },
 
+    { "displaymatrix", "export the transposition as display matrix instead of applying it",
+      OFFSET(displaymatrix), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
+
     { NULL }
 };
 
@@ -303,5 +371,5 @@ AVFilter ff_vf_transpose = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_transpose_inputs,
     .outputs       = avfilter_vf_transpose_outputs,
-    .flags         = AVFILTER_FLAG_SLICE_THREADS,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_FRAME_THREADS,
 };
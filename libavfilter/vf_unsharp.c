@@ -48,64 +48,123 @@
 #include "unsharp.h"
 #include "unsharp_opencl.h"
 
-static void apply_unsharp(      uint8_t *dst, int dst_stride,
+static void vblur_row_c(uint32_t *sc, ptrdiff_t sc_stride, uint32_t *row,
+                        int steps, int width)
+{
+    uint32_t tmp1, tmp2;
+    int x, z;
+
+    for (x = 0; x < width; x++) {
+        uint32_t *scx = sc + x;
+
+        tmp1 = row[x];
+        for (z = 0; z < steps; z++) {
+            tmp2 = scx[0]         + tmp1; scx[0]         = tmp1;
+            tmp1 = scx[sc_stride] + tmp2; scx[sc_stride] = tmp2;
+            scx += 2 * sc_stride;
+        }
+        row[x] = tmp1;
+    }
+}
+
+static int sharpen_row_c(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                         int width, int amount, int scalebits, int32_t halfscale)
+{
+    int32_t res;
+    int x;
+
+    for (x = 0; x < width; x++) {
+        res = (int32_t)src[x] + ((((int32_t)src[x] - (int32_t)((blur[x] + halfscale) >> scalebits)) * amount) >> 16);
+        dst[x] = av_clip_uint8(res);
+    }
+    return width;
+}
+
+av_cold void ff_unsharp_init(UnsharpContext *s)
+{
+    s->vblur_row   = vblur_row_c;
+    s->sharpen_row = sharpen_row_c;
+
+    if (ARCH_X86)
+        ff_unsharp_init_x86(s);
+}
+
+/**
+ * Filter the output rows of one slice. The blur is a cascade of two tap
+ * box filters, so its state only depends on the last 2 * steps_y input
+ * rows and each slice can start from a clean state 2 * steps_y rows
+ * above its first output row while staying bit-exact.
+ */
+static void apply_unsharp(UnsharpContext *s,
+                                uint8_t *dst, int dst_stride,
                           const uint8_t *src, int src_stride,
-                          int width, int height, UnsharpFilterParam *fp)
+                          int width, int height, UnsharpFilterParam *fp,
+                          int jobnr, int nb_jobs)
 {
-    uint32_t **sc = fp->sc;
+    const ptrdiff_t sc_stride = fp->sc_stride;
+    uint32_t *sc  = fp->sc + jobnr * (2 * fp->steps_y + 1) * sc_stride;
+    uint32_t *row = sc + 2 * fp->steps_y * sc_stride;
     uint32_t sr[MAX_MATRIX_SIZE - 1], tmp1, tmp2;
 
-    int32_t res;
-    int x, y, z;
-    const uint8_t *src2 = NULL;  //silence a warning
+    int x, y, z, n;
     const int amount = fp->amount;
     const int steps_x = fp->steps_x;
     const int steps_y = fp->steps_y;
     const int scalebits = fp->scalebits;
     const int32_t halfscale = fp->halfscale;
+    const int slice_start = (height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+
+    if (slice_start >= slice_end)
+        return;
 
     if (!amount) {
-        av_image_copy_plane(dst, dst_stride, src, src_stride, width, height);
+        av_image_copy_plane(dst + slice_start * dst_stride, dst_stride,
+                            src + slice_start * src_stride, src_stride,
+                            width, slice_end - slice_start);
         return;
     }
 
-    for (y = 0; y < 2 * steps_y; y++)
-        memset(sc[y], 0, sizeof(sc[y][0]) * (width + 2 * steps_x));
+    memset(sc, 0, sizeof(sc[0]) * 2 * steps_y * sc_stride);
 
-    for (y = -steps_y; y < height + steps_y; y++) {
-        if (y < height)
-            src2 = src;
+    for (y = slice_start - steps_y; y < slice_end + steps_y; y++) {
+        const uint8_t *src2 = src + av_clip(y, 0, height - 1) * src_stride;
 
-        memset(sr, 0, sizeof(sr[0]) * (2 * steps_x - 1));
+        memset(sr, 0, sizeof(sr[0]) * 2 * steps_x);
         for (x = -steps_x; x < width + steps_x; x++) {
             tmp1 = x <= 0 ? src2[0] : x >= width ? src2[width-1] : src2[x];
             for (z = 0; z < steps_x * 2; z += 2) {
                 tmp2 = sr[z + 0] + tmp1; sr[z + 0] = tmp1;
                 tmp1 = sr[z + 1] + tmp2; sr[z + 1] = tmp2;
             }
-            for (z = 0; z < steps_y * 2; z += 2) {
-                tmp2 = sc[z + 0][x + steps_x] + tmp1; sc[z + 0][x + steps_x] = tmp1;
-                tmp1 = sc[z + 1][x + steps_x] + tmp2; sc[z + 1][x + steps_x] = tmp2;
-            }
-            if (x >= steps_x && y >= steps_y) {
-                const uint8_t *srx = src - steps_y * src_stride + x - steps_x;
-                uint8_t *dsx       = dst - steps_y * dst_stride + x - steps_x;
-
-                res = (int32_t)*srx + ((((int32_t) * srx - (int32_t)((tmp1 + halfscale) >> scalebits)) * amount) >> 16);
-                *dsx = av_clip_uint8(res);
-            }
+            row[x + steps_x] = tmp1;
         }
-        if (y >= 0) {
-            dst += dst_stride;
-            src += src_stride;
+        s->vblur_row(sc, sc_stride, row, steps_y, width + 2 * steps_x);
+
+        if (y >= slice_start + steps_y) {
+            const uint8_t *srx = src + (y - steps_y) * src_stride;
+            uint8_t *dsx       = dst + (y - steps_y) * dst_stride;
+            const uint32_t *blur = row + 2 * steps_x;
+
+            n = s->sharpen_row(dsx, srx, blur, width, amount, scalebits, halfscale);
+            if (n < width)
+                sharpen_row_c(dsx + n, srx + n, blur + n, width - n,
+                              amount, scalebits, halfscale);
         }
     }
 }
 
-static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int unsharp_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     AVFilterLink *inlink = ctx->inputs[0];
     UnsharpContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
     int i, plane_w[3], plane_h[3];
     UnsharpFilterParam *fp[3];
     plane_w[0] = inlink->w;
@@ -115,11 +174,25 @@ static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
     fp[0] = &s->luma;
     fp[1] = fp[2] = &s->chroma;
     for (i = 0; i < 3; i++) {
-        apply_unsharp(out->data[i], out->linesize[i], in->data[i], in->linesize[i], plane_w[i], plane_h[i], fp[i]);
+        apply_unsharp(s, out->data[i], out->linesize[i], in->data[i], in->linesize[i],
+                      plane_w[i], plane_h[i], fp[i], jobnr, nb_jobs);
     }
     return 0;
 }
 
+static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
+{
+    UnsharpContext *s = ctx->priv;
+    ThreadData td;
+
+    td.in  = in;
+    td.out = out;
+    ctx->internal->execute(ctx, unsharp_slice, &td, NULL,
+                           FFMIN(AV_CEIL_RSHIFT(ctx->inputs[0]->h, s->vsub),
+                                 s->nb_threads));
+    return 0;
+}
+
 static void set_filter_param(UnsharpFilterParam *fp, int msize_x, int msize_y, float amount)
 {
     fp->msize_x = msize_x;
@@ -146,6 +219,7 @@ static av_cold int init(AVFilterContext *ctx)
         return AVERROR(EINVAL);
     }
     s->apply_unsharp = apply_unsharp_c;
+    ff_unsharp_init(s);
     if (!CONFIG_OPENCL && s->opencl) {
         av_log(ctx, AV_LOG_ERROR, "OpenCL support was not enabled in this build, cannot be selected\n");
         return AVERROR(EINVAL);
@@ -175,7 +249,7 @@ static int query_formats(AVFilterContext *ctx)
 
 static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const char *effect_type, int width)
 {
-    int z;
+    UnsharpContext *s = ctx->priv;
     const char *effect = fp->amount == 0 ? "none" : fp->amount < 0 ? "blur" : "sharpen";
 
     if  (!(fp->msize_x & fp->msize_y & 1)) {
@@ -188,10 +262,12 @@ static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const
     av_log(ctx, AV_LOG_VERBOSE, "effect:%s type:%s msize_x:%d msize_y:%d amount:%0.2f\n",
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        if (!(fp->sc[z] = av_malloc_array(width + 2 * fp->steps_x,
-                                          sizeof(*(fp->sc[z])))))
-            return AVERROR(ENOMEM);
+    /* padded so that SIMD can run past the end of a row */
+    fp->sc_stride = FFALIGN(width + 2 * fp->steps_x, 8);
+    fp->sc = av_malloc_array((2 * fp->steps_y + 1) * fp->sc_stride,
+                             s->nb_threads * sizeof(*fp->sc));
+    if (!fp->sc)
+        return AVERROR(ENOMEM);
 
     return 0;
 }
@@ -204,6 +280,7 @@ static int config_props(AVFilterLink *link)
 
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
+    s->nb_threads = ff_filter_get_nb_threads(link->dst);
 
     ret = init_filter_param(link->dst, &s->luma,   "luma",   link->w);
     if (ret < 0)
@@ -217,10 +294,7 @@ static int config_props(AVFilterLink *link)
 
 static void free_filter_param(UnsharpFilterParam *fp)
 {
-    int z;
-
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        av_freep(&fp->sc[z]);
+    av_freep(&fp->sc);
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -314,5 +388,5 @@ AVFilter ff_vf_unsharp = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_unsharp_inputs,
     .outputs       = avfilter_vf_unsharp_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -42,6 +42,8 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/avassert.h"
 
+#define MAX_THREADS 64
+
 static const char *const var_names[] = {
     "in_w",   "iw",
     "in_h",   "ih",
@@ -106,13 +108,16 @@ typedef struct ZScaleContext {
 
     int force_original_aspect_ratio;
 
-    void *tmp;
-    size_t tmp_size;
+    int nb_threads;
+    int out_slice_start[MAX_THREADS];   ///< first output row of each band
+    int out_slice_end[MAX_THREADS];     ///< row after the last output row of each band
+    void *tmp[MAX_THREADS];             ///< zimg temporary buffer of each band
+    size_t tmp_size[MAX_THREADS];
 
     zimg_image_format src_format, dst_format;
     zimg_image_format alpha_src_format, alpha_dst_format;
     zimg_graph_builder_params alpha_params, params;
-    zimg_filter_graph *alpha_graph, *graph;
+    zimg_filter_graph *alpha_graph[MAX_THREADS], *graph[MAX_THREADS];
 
     enum AVColorSpace in_colorspace, out_colorspace;
     enum AVColorTransferCharacteristic in_trc, out_trc;
@@ -410,17 +415,132 @@ static int convert_range(enum AVColorRange color_range)
     return ZIMG_RANGE_LIMITED;
 }
 
+/**
+ * Split the output in bands of rows for the slice threads, aligned on the
+ * chroma subsampling so that each band is a valid image for zimg.
+ */
+static void slice_params(ZScaleContext *s, int out_h, int nb_threads, int align)
+{
+    int i;
+
+    s->nb_threads = av_clip(FFMIN(nb_threads, out_h / align), 1, MAX_THREADS);
+
+    s->out_slice_start[0] = 0;
+    for (i = 1; i < s->nb_threads; i++) {
+        s->out_slice_start[i]   = (out_h * i / s->nb_threads) & ~(align - 1);
+        s->out_slice_end[i - 1] = s->out_slice_start[i];
+    }
+    s->out_slice_end[s->nb_threads - 1] = out_h;
+}
+
+/**
+ * Build the graph of each band, converting the matching region of the
+ * source image so that the bands sample it like a single graph would.
+ */
+static int graphs_build(AVFilterContext *ctx, const zimg_image_format *src_format,
+                        const zimg_image_format *dst_format,
+                        const zimg_graph_builder_params *params,
+                        zimg_filter_graph **graph)
+{
+    ZScaleContext *s = ctx->priv;
+    const double scale_h = (double)src_format->height / dst_format->height;
+    int i;
+
+    for (i = 0; i < s->nb_threads; i++) {
+        zimg_image_format src = *src_format, dst = *dst_format;
+        size_t tmp_size;
+
+        src.active_region.left   = 0;
+        src.active_region.top    = s->out_slice_start[i] * scale_h;
+        src.active_region.width  = src.width;
+        src.active_region.height = (s->out_slice_end[i] - s->out_slice_start[i]) * scale_h;
+        dst.height = s->out_slice_end[i] - s->out_slice_start[i];
+
+        zimg_filter_graph_free(graph[i]);
+        graph[i] = zimg_filter_graph_build(&src, &dst, params);
+        if (!graph[i])
+            return print_zimg_error(ctx);
+
+        if (zimg_filter_graph_get_tmp_size(graph[i], &tmp_size))
+            return print_zimg_error(ctx);
+
+        if (tmp_size > s->tmp_size[i]) {
+            av_freep(&s->tmp[i]);
+            s->tmp[i] = av_malloc(tmp_size);
+            if (!s->tmp[i])
+                return AVERROR(ENOMEM);
+            s->tmp_size[i] = tmp_size;
+        }
+    }
+
+    return 0;
+}
+
+typedef struct ThreadData {
+    const AVPixFmtDescriptor *desc, *odesc;
+    AVFrame *in, *out;
+} ThreadData;
+
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ZScaleContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const AVPixFmtDescriptor *desc = td->desc, *odesc = td->odesc;
+    const int slice_start = s->out_slice_start[jobnr];
+    const int slice_end   = s->out_slice_end[jobnr];
+    zimg_image_buffer_const src_buf = { ZIMG_API_VERSION };
+    zimg_image_buffer dst_buf = { ZIMG_API_VERSION };
+    AVFrame *in = td->in, *out = td->out;
+    int plane;
+
+    for (plane = 0; plane < 3; plane++) {
+        const int vsub = plane ? odesc->log2_chroma_h : 0;
+        int p = desc->comp[plane].plane;
+
+        src_buf.plane[plane].data   = in->data[p];
+        src_buf.plane[plane].stride = in->linesize[p];
+        src_buf.plane[plane].mask   = -1;
+
+        p = odesc->comp[plane].plane;
+        dst_buf.plane[plane].data   = out->data[p] + (slice_start >> vsub) * out->linesize[p];
+        dst_buf.plane[plane].stride = out->linesize[p];
+        dst_buf.plane[plane].mask   = -1;
+    }
+
+    if (zimg_filter_graph_process(s->graph[jobnr], &src_buf, &dst_buf, s->tmp[jobnr], 0, 0, 0, 0))
+        return print_zimg_error(ctx);
+
+    if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        src_buf.plane[0].data   = in->data[3];
+        src_buf.plane[0].stride = in->linesize[3];
+        src_buf.plane[0].mask   = -1;
+
+        dst_buf.plane[0].data   = out->data[3] + slice_start * out->linesize[3];
+        dst_buf.plane[0].stride = out->linesize[3];
+        dst_buf.plane[0].mask   = -1;
+
+        if (zimg_filter_graph_process(s->alpha_graph[jobnr], &src_buf, &dst_buf, s->tmp[jobnr], 0, 0, 0, 0))
+            return print_zimg_error(ctx);
+    } else if (odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        int y;
+
+        for (y = slice_start; y < slice_end; y++)
+            memset(out->data[3] + y * out->linesize[3], 0xff, out->width);
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     ZScaleContext *s = link->dst->priv;
     AVFilterLink *outlink = link->dst->outputs[0];
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(outlink->format);
-    zimg_image_buffer_const src_buf = { ZIMG_API_VERSION };
-    zimg_image_buffer dst_buf = { ZIMG_API_VERSION };
+    int rets[MAX_THREADS];
+    ThreadData td;
     char buf[32];
-    size_t tmp_size;
-    int ret = 0, plane;
+    int ret = 0, i;
     AVFrame *out;
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
@@ -511,27 +631,12 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         if (s->chromal != -1)
             out->chroma_location = (int)s->dst_format.chroma_location - 1;
 
-        zimg_filter_graph_free(s->graph);
-        s->graph = zimg_filter_graph_build(&s->src_format, &s->dst_format, &s->params);
-        if (!s->graph) {
-            ret = print_zimg_error(link->dst);
-            goto fail;
-        }
+        slice_params(s, out->height, ff_filter_get_nb_threads(link->dst),
+                     1 << FFMAX(desc->log2_chroma_h, odesc->log2_chroma_h));
 
-        if ((ret = zimg_filter_graph_get_tmp_size(s->graph, &tmp_size))) {
-            ret = print_zimg_error(link->dst);
+        if ((ret = graphs_build(link->dst, &s->src_format, &s->dst_format,
+                                &s->params, s->graph)) < 0)
             goto fail;
-        }
-
-        if (tmp_size > s->tmp_size) {
-            av_freep(&s->tmp);
-            s->tmp = av_malloc(tmp_size);
-            if (!s->tmp) {
-                ret = AVERROR(ENOMEM);
-                goto fail;
-            }
-            s->tmp_size = tmp_size;
-        }
 
         s->in_colorspace  = in->colorspace;
         s->in_trc         = in->color_trc;
@@ -563,12 +668,9 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
             s->alpha_dst_format.pixel_type = odesc->comp[0].depth > 8 ? ZIMG_PIXEL_WORD : ZIMG_PIXEL_BYTE;
             s->alpha_dst_format.color_family = ZIMG_COLOR_GREY;
 
-            zimg_filter_graph_free(s->alpha_graph);
-            s->alpha_graph = zimg_filter_graph_build(&s->alpha_src_format, &s->alpha_dst_format, &s->alpha_params);
-            if (!s->alpha_graph) {
-                ret = print_zimg_error(link->dst);
+            if ((ret = graphs_build(link->dst, &s->alpha_src_format, &s->alpha_dst_format,
+                                    &s->alpha_params, s->alpha_graph)) < 0)
                 goto fail;
-            }
         }
     }
 
@@ -589,43 +691,16 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
               (int64_t)in->sample_aspect_ratio.den * outlink->w * link->h,
               INT_MAX);
 
-    for (plane = 0; plane < 3; plane++) {
-        int p = desc->comp[plane].plane;
-        src_buf.plane[plane].data   = in->data[p];
-        src_buf.plane[plane].stride = in->linesize[p];
-        src_buf.plane[plane].mask   = -1;
-
-        p = odesc->comp[plane].plane;
-        dst_buf.plane[plane].data   = out->data[p];
-        dst_buf.plane[plane].stride = out->linesize[p];
-        dst_buf.plane[plane].mask   = -1;
-    }
-
-    ret = zimg_filter_graph_process(s->graph, &src_buf, &dst_buf, s->tmp, 0, 0, 0, 0);
-    if (ret) {
-        print_zimg_error(link->dst);
-        goto fail;
-    }
-
-    if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
-        src_buf.plane[0].data   = in->data[3];
-        src_buf.plane[0].stride = in->linesize[3];
-        src_buf.plane[0].mask   = -1;
-
-        dst_buf.plane[0].data   = out->data[3];
-        dst_buf.plane[0].stride = out->linesize[3];
-        dst_buf.plane[0].mask   = -1;
-
-        ret = zimg_filter_graph_process(s->alpha_graph, &src_buf, &dst_buf, s->tmp, 0, 0, 0, 0);
-        if (ret) {
-            print_zimg_error(link->dst);
-            goto fail;
+    td.desc  = desc;
+    td.odesc = odesc;
+    td.in    = in;
+    td.out   = out;
+    link->dst->internal->execute(link->dst, filter_slice, &td, rets, s->nb_threads);
+    for (i = 0; i < s->nb_threads; i++) {
+        if (rets[i]) {
+            ret = rets[i];
+            break;
         }
-    } else if (odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
-        int y;
-
-        for (y = 0; y < outlink->h; y++)
-            memset(out->data[3] + y * out->linesize[3], 0xff, outlink->w);
     }
 
 fail:
@@ -641,10 +716,14 @@ fail:
 static void uninit(AVFilterContext *ctx)
 {
     ZScaleContext *s = ctx->priv;
+    int i;
 
-    zimg_filter_graph_free(s->graph);
-    av_freep(&s->tmp);
-    s->tmp_size = 0;
+    for (i = 0; i < MAX_THREADS; i++) {
+        zimg_filter_graph_free(s->graph[i]);
+        zimg_filter_graph_free(s->alpha_graph[i]);
+        av_freep(&s->tmp[i]);
+        s->tmp_size[i] = 0;
+    }
 }
 
 static int process_command(AVFilterContext *ctx, const char *cmd, const char *args,
@@ -786,4 +865,5 @@ AVFilter ff_vf_zscale = {
     .inputs          = avfilter_vf_zscale_inputs,
     .outputs         = avfilter_vf_zscale_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
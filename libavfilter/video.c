@@ -30,6 +30,7 @@
 
 #include "avfilter.h"
 #include "internal.h"
+#include "thread.h"
 #include "video.h"
 
 #define BUFFER_ALIGN 32
@@ -47,6 +48,10 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
     int pool_align = 0;
     enum AVPixelFormat pool_format = AV_PIX_FMT_NONE;
 
+    if (link->graph)
+        return ff_filter_graph_get_video_buffer(link->graph, w, h,
+                                                link->format, BUFFER_ALIGN);
+
     if (!link->video_frame_pool) {
         link->video_frame_pool = ff_video_frame_pool_init(av_buffer_allocz, w, h,
                                                           link->format, BUFFER_ALIGN);
@@ -79,11 +84,19 @@ AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h)
 
     FF_TPRINTF_START(NULL, get_video_buffer); ff_tlog_link(NULL, link, 0);
 
+    /* the jobs of a frame threaded source filter request buffers
+     * concurrently */
+    if (link->src->internal->frame_thread)
+        ff_filter_frame_thread_lock(link->src);
+
     if (link->dstpad->get_video_buffer)
         ret = link->dstpad->get_video_buffer(link, w, h);
 
     if (!ret)
         ret = ff_default_get_video_buffer(link, w, h);
 
+    if (link->src->internal->frame_thread)
+        ff_filter_frame_thread_unlock(link->src);
+
     return ret;
 }
@@ -0,0 +1,82 @@
+;*****************************************************************************
+;* x86-optimized functions for amix filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; int ff_amix_mix(float *dst, const float **src, const float *scale,
+;                 int nb_src, int len)
+;------------------------------------------------------------------------------
+
+; the sums of two registers of samples are kept in m0 and m1 while the
+; inputs are walked, so that dst is written once whatever their number
+%macro AMIX_MIX 0
+cglobal amix_mix, 5, 8, 6, dst, src, scale, nb_src, len, x, j, ptr
+    and        lend, -(mmsize / 2)
+    shl        lend, 2
+    xor          xq, xq
+    test       lend, lend
+    jz .end
+.loop:
+    mov        ptrq, [srcq]
+    VBROADCASTSS m2, [scaleq]
+    movu         m0, [ptrq + xq]
+    movu         m1, [ptrq + xq + mmsize]
+    mulps        m0, m2
+    mulps        m1, m2
+    mov          jd, 1
+    cmp          jd, nb_srcd
+    jge .store
+.src_loop:
+    mov        ptrq, [srcq + jq * gprsize]
+    VBROADCASTSS m2, [scaleq + jq * 4]
+    movu         m3, [ptrq + xq]
+    movu         m4, [ptrq + xq + mmsize]
+    FMULADD_PS   m0, m3, m2, m0, m5
+    FMULADD_PS   m1, m4, m2, m1, m5
+    inc          jd
+    cmp          jd, nb_srcd
+    jl .src_loop
+.store:
+    movu [dstq + xq], m0
+    movu [dstq + xq + mmsize], m1
+    add          xq, 2 * mmsize
+    cmp          xd, lend
+    jl .loop
+.end:
+    mov         eax, xd
+    shr         eax, 2
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse
+AMIX_MIX
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+AMIX_MIX
+%endif
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+AMIX_MIX
+%endif
+%endif
@@ -0,0 +1,166 @@
+;*****************************************************************************
+;* x86-optimized functions for the biquad filters
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; byte offsets of the coefficients, see biquads.h
+%define B0  0 * 32
+%define B1  1 * 32
+%define B2  2 * 32
+%define A1  3 * 32
+%define A2  4 * 32
+
+; 4x4 transpose of the floats of xmm registers %1-%4 into %5-%8
+%macro TRANSPOSE4PS 10 ; in0-3, out0-3, tmp0-1
+    unpcklps       xm%9, xm%1, xm%2
+    unpckhps      xm%10, xm%1, xm%2
+    unpcklps       xm%1, xm%3, xm%4
+    unpckhps       xm%2, xm%3, xm%4
+    movlhps        xm%5, xm%9, xm%1
+    movhlps        xm%6, xm%1, xm%9
+    movlhps        xm%7, xm%10, xm%2
+    movhlps        xm%8, xm%2, xm%10
+%endmacro
+
+; 4x4 transpose of the doubles of ymm registers %1-%4 into %5-%8
+%macro TRANSPOSE4PD 10 ; in0-3, out0-3, tmp0-1
+    unpcklpd        m%9, m%1, m%2
+    unpckhpd       m%10, m%1, m%2
+    unpcklpd        m%1, m%3, m%4
+    unpckhpd        m%2, m%3, m%4
+    vperm2f128      m%5, m%9, m%1, 0x20
+    vperm2f128      m%7, m%9, m%1, 0x31
+    vperm2f128      m%6, m%10, m%2, 0x20
+    vperm2f128      m%8, m%10, m%2, 0x31
+%endmacro
+
+; one sample of the 4 channels, in the order of operations of the C version
+; m4 = i1, m5 = i2, m6 = o1, m7 = o2, %1 = input replaced by the output
+%macro BIQUAD_STEP 1
+    mulpd          m12, m5, [coeffsq + B2]
+    mulpd          m13, m4, [coeffsq + B1]
+    addpd          m12, m13
+    mulpd          m13, m%1, [coeffsq + B0]
+    addpd          m12, m13
+    mulpd          m13, m7, [coeffsq + A2]
+    addpd          m12, m13
+    mulpd          m13, m6, [coeffsq + A1]
+    addpd          m12, m13
+    mova            m5, m4
+    mova            m4, m%1
+    mova            m7, m6
+    mova            m6, m12
+    mova           m%1, m12
+%endmacro
+
+;------------------------------------------------------------------------------
+; int ff_biquads_filter4_<fmt>(uint8_t *const *dst, const uint8_t *const *src,
+;                              int len, double *state, const double *coeffs)
+;------------------------------------------------------------------------------
+
+; 4 samples of the 4 channels per iteration, transposed to one vector of
+; doubles per sample
+%macro BIQUAD4 1 ; fmt
+cglobal biquads_filter4_%1, 5, 13, 14, dst, src, len, state, coeffs, s0, s1, s2, s3, d0, d1, d2, d3
+    movsxdifnidn  lenq, lend
+    and           lenq, ~3
+    jz .end
+    mov            s0q, [srcq + 0 * gprsize]
+    mov            s1q, [srcq + 1 * gprsize]
+    mov            s2q, [srcq + 2 * gprsize]
+    mov            s3q, [srcq + 3 * gprsize]
+    mov            d0q, [dstq + 0 * gprsize]
+    mov            d1q, [dstq + 1 * gprsize]
+    mov            d2q, [dstq + 2 * gprsize]
+    mov            d3q, [dstq + 3 * gprsize]
+    movu            m4, [stateq + 0 * 32]
+    movu            m5, [stateq + 1 * 32]
+    movu            m6, [stateq + 2 * 32]
+    movu            m7, [stateq + 3 * 32]
+%ifidn %1, flt
+    shl           lenq, 2
+%else
+    shl           lenq, 3
+%endif
+    xor           srcq, srcq
+.loop:
+%ifidn %1, flt
+    movu           xm8, [s0q + srcq]
+    movu           xm9, [s1q + srcq]
+    movu          xm10, [s2q + srcq]
+    movu          xm11, [s3q + srcq]
+    TRANSPOSE4PS     8, 9, 10, 11, 0, 1, 2, 3, 12, 13
+    cvtps2pd        m0, xm0
+    cvtps2pd        m1, xm1
+    cvtps2pd        m2, xm2
+    cvtps2pd        m3, xm3
+%else
+    movu            m8, [s0q + srcq]
+    movu            m9, [s1q + srcq]
+    movu           m10, [s2q + srcq]
+    movu           m11, [s3q + srcq]
+    TRANSPOSE4PD     8, 9, 10, 11, 0, 1, 2, 3, 12, 13
+%endif
+    BIQUAD_STEP      0
+    BIQUAD_STEP      1
+    BIQUAD_STEP      2
+    BIQUAD_STEP      3
+%ifidn %1, flt
+    cvtpd2ps       xm8, m0
+    cvtpd2ps       xm9, m1
+    cvtpd2ps      xm10, m2
+    cvtpd2ps      xm11, m3
+    TRANSPOSE4PS     8, 9, 10, 11, 0, 1, 2, 3, 12, 13
+    movu   [d0q + srcq], xm0
+    movu   [d1q + srcq], xm1
+    movu   [d2q + srcq], xm2
+    movu   [d3q + srcq], xm3
+    add           srcq, 16
+%else
+    TRANSPOSE4PD     0, 1, 2, 3, 8, 9, 10, 11, 12, 13
+    movu   [d0q + srcq], m8
+    movu   [d1q + srcq], m9
+    movu   [d2q + srcq], m10
+    movu   [d3q + srcq], m11
+    add           srcq, 32
+%endif
+    cmp           srcq, lenq
+    jl .loop
+    movu [stateq + 0 * 32], m4
+    movu [stateq + 1 * 32], m5
+    movu [stateq + 2 * 32], m6
+    movu [stateq + 3 * 32], m7
+%ifidn %1, flt
+    shr           lenq, 2
+%else
+    shr           lenq, 3
+%endif
+.end:
+    mov            eax, lend
+    RET
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX_EXTERNAL
+INIT_YMM avx
+BIQUAD4 flt
+BIQUAD4 dbl
+%endif
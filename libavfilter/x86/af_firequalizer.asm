@@ -0,0 +1,67 @@
+;*****************************************************************************
+;* x86-optimized functions for the firequalizer filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; int ff_firequalizer_fcmul_add(float *sum, const float *t, const float *c,
+;                               int len)
+;------------------------------------------------------------------------------
+
+; mmsize / 8 complex numbers per iteration, without fma so that the results
+; are the same as the C version
+%macro FCMUL_ADD 0
+cglobal firequalizer_fcmul_add, 4, 5, 4, sum, t, c, len, x
+    movsxdifnidn  lenq, lend
+    and           lenq, ~(mmsize / 8 - 1)
+    jz .end
+    lea             xq, [lenq * 8]
+    add           sumq, xq
+    add             tq, xq
+    add             cq, xq
+    neg             xq
+.loop:
+    ; the complex numbers of the spectra are not 16 byte aligned
+    movups          m1, [tq + xq]
+    movsldup        m0, m1                  ; re(t) re(t)
+    movshdup        m1, m1                  ; im(t) im(t)
+    movups          m2, [cq + xq]           ; re(c) im(c)
+    shufps          m3, m2, m2, q2301       ; im(c) re(c)
+    mulps           m0, m2
+    mulps           m1, m3
+    addsubps        m0, m1
+    movups          m1, [sumq + xq]
+    addps           m0, m1
+    movups [sumq + xq], m0
+    add             xq, mmsize
+    jl .loop
+.end:
+    mov            eax, lend
+    RET
+%endmacro
+
+INIT_XMM sse3
+FCMUL_ADD
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+FCMUL_ADD
+%endif
@@ -0,0 +1,163 @@
+;*****************************************************************************
+;* x86-optimized functions for drawing utilities
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_0x1010101: times 8 dd 0x1010101
+pb_1:         times 32 db 1
+
+SECTION .text
+
+; broadcast the low dword of %1
+%macro SPLATD_ALL 1
+%if cpuflag(avx2)
+    vpbroadcastd m%1, xm%1
+%else
+    pshufd       m%1, m%1, 0
+%endif
+%endmacro
+
+; blend the dwords of d (m1) with the color (m5), weighted by mask (m0)
+; times alpha (m4), result in m1
+; d = (d * 0x1010101 + mask * alpha * (s - d)) >> 24
+%macro BLEND_DWORDS 0
+    pmulld        m0, m4
+    psubd         m2, m5, m1
+    pmulld        m2, m0
+    pmulld        m1, m6
+    paddd         m1, m2
+    psrld         m1, 24
+%endmacro
+
+; pack the mmsize/4 dwords of m1 to bytes and store them at %1
+%macro STORE_DWORDS 1
+    packusdw      m1, m1
+    packuswb      m1, m1
+%if mmsize == 32
+    vextracti128 xm2, m1, 1
+    punpckldq    xm1, xm2
+    movq          %1, xm1
+%else
+    movd          %1, m1
+%endif
+%endmacro
+
+; load %2 bytes of two mask rows and average the 2x2 blocks to words in
+; xm%1, the second row pointer is in mask_linesizeq
+%macro LOAD_MASK_2x2 2
+%if %2 == 16
+    movu        xm%1, [maskq + 2*xq]
+    movu        xm3,  [mask_linesizeq + 2*xq]
+%elif %2 == 8
+    movq        xm%1, [maskq + 2*xq]
+    movq        xm3,  [mask_linesizeq + 2*xq]
+%else
+    movd        xm%1, [maskq + 2*xq]
+    movd        xm3,  [mask_linesizeq + 2*xq]
+%endif
+    pmaddubsw   xm%1, [pb_1]
+    pmaddubsw   xm3,  [pb_1]
+    paddw       xm%1, xm3
+    psrlw       xm%1, 2
+%endmacro
+
+; int blend_mask_row_XXX(uint8_t *dst, const uint8_t *mask,
+;                        ptrdiff_t mask_linesize, const uint8_t *color,
+;                        unsigned alpha, int w)
+; XXX is 1x1 for a full resolution plane, 2x2 for a plane subsampled in both
+; directions and 2x2_uv for a subsampled plane of two interleaved components
+%macro BLEND_MASK_ROW 1
+cglobal blend_mask_row_%1, 6, 7, 7, dst, mask, mask_linesize, color, alpha, w, x
+    movsxdifnidn  wq, wd
+%ifidn %1, 2x2_uv
+    and           wq, -(mmsize/8)
+%else
+    and           wq, -(mmsize/4)
+%endif
+    jz .end
+%ifnidn %1, 1x1
+    add mask_linesizeq, maskq
+%endif
+%ifidn %1, 2x2_uv
+    movzx         xd, byte [colorq + 1]
+    movd         xm2, xd
+    movzx         xd, byte [colorq]
+    movd         xm5, xd
+    punpckldq    xm5, xm2
+%if cpuflag(avx2)
+    vpbroadcastq  m5, xm5
+%else
+    punpcklqdq    m5, m5
+%endif
+%else
+    movzx         xd, byte [colorq]
+    movd         xm5, xd
+    SPLATD_ALL    5
+%endif
+    movd         xm4, alphad
+    SPLATD_ALL    4
+    mova          m6, [pd_0x1010101]
+    xor           xq, xq
+
+.loop:
+%ifidn %1, 1x1
+    pmovzxbd      m0, [maskq + xq]
+    pmovzxbd      m1, [dstq + xq]
+    BLEND_DWORDS
+    STORE_DWORDS  [dstq + xq]
+    add           xq, mmsize/4
+%elifidn %1, 2x2
+    LOAD_MASK_2x2 0, mmsize/2
+    pmovzxwd      m0, xm0
+    pmovzxbd      m1, [dstq + xq]
+    BLEND_DWORDS
+    STORE_DWORDS  [dstq + xq]
+    add           xq, mmsize/4
+%else
+    LOAD_MASK_2x2 0, mmsize/4
+    punpcklwd    xm0, xm0
+    pmovzxwd      m0, xm0
+    pmovzxbd      m1, [dstq + 2*xq]
+    BLEND_DWORDS
+    STORE_DWORDS  [dstq + 2*xq]
+    add           xq, mmsize/8
+%endif
+    cmp           xq, wq
+    jl .loop
+
+.end:
+    mov          eax, wd
+    RET
+%endmacro
+
+INIT_XMM sse4
+BLEND_MASK_ROW 1x1
+BLEND_MASK_ROW 2x2
+BLEND_MASK_ROW 2x2_uv
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+BLEND_MASK_ROW 1x1
+BLEND_MASK_ROW 2x2
+BLEND_MASK_ROW 2x2_uv
+%endif
@@ -0,0 +1,64 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/drawutils.h"
+
+#define BLEND_MASK_ROW_FUNC(name, opt)                                       \
+int ff_blend_mask_row_##name##_##opt(uint8_t *dst, const uint8_t *mask,     \
+                                     ptrdiff_t mask_linesize,               \
+                                     const uint8_t *color, unsigned alpha,  \
+                                     int w);
+
+BLEND_MASK_ROW_FUNC(1x1,    sse4)
+BLEND_MASK_ROW_FUNC(1x1,    avx2)
+BLEND_MASK_ROW_FUNC(2x2,    sse4)
+BLEND_MASK_ROW_FUNC(2x2,    avx2)
+BLEND_MASK_ROW_FUNC(2x2_uv, sse4)
+BLEND_MASK_ROW_FUNC(2x2_uv, avx2)
+
+av_cold void ff_draw_init_x86(FFDrawContext *draw)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int i;
+
+    for (i = 0; i < MAX_PLANES; i++) {
+        if (!draw->blend_mask_row[i])
+            continue;
+
+        if (EXTERNAL_SSE4(cpu_flags)) {
+            if (draw->pixelstep[i] == 2)
+                draw->blend_mask_row[i] = ff_blend_mask_row_2x2_uv_sse4;
+            else if (draw->hsub[i])
+                draw->blend_mask_row[i] = ff_blend_mask_row_2x2_sse4;
+            else
+                draw->blend_mask_row[i] = ff_blend_mask_row_1x1_sse4;
+        }
+
+        if (EXTERNAL_AVX2(cpu_flags)) {
+            if (draw->pixelstep[i] == 2)
+                draw->blend_mask_row[i] = ff_blend_mask_row_2x2_uv_avx2;
+            else if (draw->hsub[i])
+                draw->blend_mask_row[i] = ff_blend_mask_row_2x2_avx2;
+            else
+                draw->blend_mask_row[i] = ff_blend_mask_row_1x1_avx2;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+;*****************************************************************************
+;* x86-optimized functions for the EBU R128 loudness measurement
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_ebur128_kweight2(const double *src, ptrdiff_t stride, int nb_samples,
+;                          double *state, double *energy, const double *coeffs)
+;------------------------------------------------------------------------------
+
+; each register holds the samples of the two channels, the operations are
+; done in the order of the C version so that the results are bit-exact
+%if ARCH_X86_64
+INIT_XMM sse2
+cglobal ebur128_kweight2, 6, 6, 10, src, stride, len, state, energy, coeffs
+    shl     strideq, 3
+    movu         m0, [stateq + 0 * 16]      ; x[-1]
+    movu         m1, [stateq + 1 * 16]      ; x[-2]
+    movu         m2, [stateq + 2 * 16]      ; y[-1]
+    movu         m3, [stateq + 3 * 16]      ; y[-2]
+    movu         m4, [stateq + 4 * 16]      ; z[-1]
+    movu         m5, [stateq + 5 * 16]      ; z[-2]
+    xorpd        m9, m9
+    test       lend, lend
+    jle .end
+.loop:
+    movu         m6, [srcq]                 ; x[0]
+    mulpd        m7, m6, [coeffsq + 0 * 16]
+    mulpd        m8, m0, [coeffsq + 1 * 16]
+    addpd        m7, m8
+    mulpd        m8, m1, [coeffsq + 2 * 16]
+    addpd        m7, m8
+    mulpd        m8, m2, [coeffsq + 3 * 16]
+    subpd        m7, m8
+    mulpd        m8, m3, [coeffsq + 4 * 16]
+    subpd        m7, m8                     ; y[0]
+    mova         m1, m0
+    mova         m0, m6
+    mulpd        m8, m2, [coeffsq + 5 * 16]
+    addpd        m8, m7, m8
+    addpd        m8, m3
+    mulpd        m6, m4, [coeffsq + 6 * 16]
+    subpd        m8, m6
+    mulpd        m6, m5, [coeffsq + 7 * 16]
+    subpd        m8, m6                     ; z[0]
+    mova         m3, m2
+    mova         m2, m7
+    mova         m5, m4
+    mova         m4, m8
+    mulpd        m8, m8
+    addpd        m9, m8
+    add        srcq, strideq
+    dec        lend
+    jg .loop
+.end:
+    movu [stateq + 0 * 16], m0
+    movu [stateq + 1 * 16], m1
+    movu [stateq + 2 * 16], m2
+    movu [stateq + 3 * 16], m3
+    movu [stateq + 4 * 16], m4
+    movu [stateq + 5 * 16], m5
+    movu         m6, [energyq]
+    addpd        m6, m9
+    movu  [energyq], m6
+    RET
+%endif
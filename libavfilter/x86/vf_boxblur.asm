@@ -0,0 +1,106 @@
+;*****************************************************************************
+;* x86-optimized functions for boxblur filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or modify
+;* it under the terms of the GNU General Public License as published by
+;* the Free Software Foundation; either version 2 of the License, or
+;* (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;* GNU General Public License for more details.
+;*
+;* You should have received a copy of the GNU General Public License along
+;* with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+;* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_255: times 8 dd 255
+
+SECTION .text
+
+; int blur_row8 (uint32_t *sum, uint8_t  *dst, const uint8_t  *add,
+;                const uint8_t  *sub, int inv, int width)
+; int blur_row16(uint32_t *sum, uint16_t *dst, const uint16_t *add,
+;                const uint16_t *sub, int inv, int width)
+;
+; The sums wrap like the C code does, so only the low bits of sum >> 16
+; are stored.
+%macro BLUR_ROW 1 ; bits
+%if %1 == 8
+    %define bps 1
+    %define PMOVZX pmovzxbd
+%else
+    %define bps 2
+    %define PMOVZX pmovzxwd
+%endif
+cglobal boxblur_blur_row%1, 6, 7, 5, sum, dst, add, sub, inv, w, x
+    movd             xm4, invd
+%if cpuflag(avx2)
+    vpbroadcastd      m4, xm4
+%else
+    pshufd            m4, m4, q0000
+%endif
+    movsxdifnidn      wq, wd
+    and               wq, ~(mmsize/4 - 1)
+    jz .end
+    lea             sumq, [sumq+wq*4]
+    lea             dstq, [dstq+wq*bps]
+    lea             addq, [addq+wq*bps]
+    lea             subq, [subq+wq*bps]
+    mov               xq, wq
+    neg               xq
+.loop:
+    PMOVZX            m0, [addq+xq*bps]
+    PMOVZX            m1, [subq+xq*bps]
+    psubd             m0, m1
+    pmulld            m0, m4
+    paddd             m0, [sumq+xq*4]
+    mova  [sumq+xq*4], m0
+    psrld             m0, 16
+%if %1 == 8
+    pand              m0, [pd_255]
+%endif
+%if cpuflag(avx2)
+    vextracti128     xm1, m0, 1
+    packusdw         xm0, xm1
+%else
+    packusdw          m0, m0
+%endif
+%if %1 == 8
+    packuswb         xm0, xm0
+%if cpuflag(avx2)
+    movq  [dstq+xq], xm0
+%else
+    movd  [dstq+xq], xm0
+%endif
+%elif cpuflag(avx2)
+    movu  [dstq+xq*2], xm0
+%else
+    movh  [dstq+xq*2], m0
+%endif
+    add               xq, mmsize/4
+    jl .loop
+.end:
+    mov              eax, wd
+    RET
+%undef bps
+%undef PMOVZX
+%endmacro
+
+INIT_XMM sse4
+BLUR_ROW 8
+BLUR_ROW 16
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+BLUR_ROW 8
+BLUR_ROW 16
+%endif
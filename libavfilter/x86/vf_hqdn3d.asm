@@ -20,6 +20,12 @@
 
 %include "libavutil/x86/x86util.asm"
 
+SECTION_RODATA 32
+
+pd_31:  times 8 dd 31
+pd_63:  times 8 dd 63
+pd_127: times 8 dd 127
+
 SECTION .text
 
 %macro LOWPASS 3 ; prevsample, cursample, lut
@@ -104,3 +110,65 @@ HQDN3D_ROW 8
 HQDN3D_ROW 9
 HQDN3D_ROW 10
 HQDN3D_ROW 16
+
+; void hqdn3d_tmp_row(uint8_t *src, uint8_t *dst, uint16_t *frameant,
+;                     ptrdiff_t width, int16_t *temporal)
+; temporal-only denoising, width must be a multiple of 8
+%macro HQDN3D_TMP_ROW 1 ; bitdepth
+cglobal hqdn3d_tmp_row_%1, 5, 6, 4, src, dst, frameant, width, temporal, x
+    %assign lut_bits 4+4*(%1/16)
+    test        widthq, widthq
+    jle .end
+    xor             xq, xq
+.loop:
+%if %1 == 8
+    pmovzxbd        m0, [srcq+xq]
+%else
+    pmovzxwd        m0, [srcq+xq*2]
+%endif
+%if %1 != 16
+    pslld           m0, 16-%1
+%if %1 == 8
+    paddd           m0, [pd_127]
+%elif %1 == 9
+    paddd           m0, [pd_63]
+%else
+    paddd           m0, [pd_31]
+%endif
+%endif
+    pmovzxwd        m1, [frameantq+xq*2]
+    psubd           m1, m0
+%if lut_bits != 8
+    psrad           m1, 8-lut_bits
+%endif
+    pcmpeqd         m2, m2
+    vpgatherdd      m3, [temporalq+m1*2], m2
+    pslld           m3, 16
+    psrad           m3, 16
+    paddd           m0, m3
+    packusdw        m0, m0
+    vpermq          m0, m0, q3120
+    movu [frameantq+xq*2], xm0
+%if %1 != 16
+    psrlw          xm0, 16-%1
+%endif
+%if %1 == 8
+    packuswb       xm0, xm0
+    movq      [dstq+xq], xm0
+%else
+    movu    [dstq+xq*2], xm0
+%endif
+    add             xq, 8
+    cmp             xq, widthq
+    jl .loop
+.end:
+    RET
+%endmacro ; HQDN3D_TMP_ROW
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+HQDN3D_TMP_ROW 8
+HQDN3D_TMP_ROW 9
+HQDN3D_TMP_ROW 10
+HQDN3D_TMP_ROW 16
+%endif
@@ -22,6 +22,8 @@
 #include <stdint.h>
 
 #include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
 #include "libavfilter/vf_hqdn3d.h"
 #include "config.h"
 
@@ -38,12 +40,30 @@ void ff_hqdn3d_row_16_x86(uint8_t *src, uint8_t *dst, uint16_t *line_ant,
                           uint16_t *frame_ant, ptrdiff_t w, int16_t *spatial,
                           int16_t *temporal);
 
+void ff_hqdn3d_tmp_row_8_avx2(uint8_t *src, uint8_t *dst, uint16_t *frame_ant,
+                              ptrdiff_t w, int16_t *temporal);
+void ff_hqdn3d_tmp_row_9_avx2(uint8_t *src, uint8_t *dst, uint16_t *frame_ant,
+                              ptrdiff_t w, int16_t *temporal);
+void ff_hqdn3d_tmp_row_10_avx2(uint8_t *src, uint8_t *dst, uint16_t *frame_ant,
+                               ptrdiff_t w, int16_t *temporal);
+void ff_hqdn3d_tmp_row_16_avx2(uint8_t *src, uint8_t *dst, uint16_t *frame_ant,
+                               ptrdiff_t w, int16_t *temporal);
+
 av_cold void ff_hqdn3d_init_x86(HQDN3DContext *hqdn3d)
 {
+    int cpu_flags = av_get_cpu_flags();
+
 #if HAVE_YASM
     hqdn3d->denoise_row[8]  = ff_hqdn3d_row_8_x86;
     hqdn3d->denoise_row[9]  = ff_hqdn3d_row_9_x86;
     hqdn3d->denoise_row[10] = ff_hqdn3d_row_10_x86;
     hqdn3d->denoise_row[16] = ff_hqdn3d_row_16_x86;
 #endif /* HAVE_YASM */
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        hqdn3d->denoise_tmp_row[8]  = ff_hqdn3d_tmp_row_8_avx2;
+        hqdn3d->denoise_tmp_row[9]  = ff_hqdn3d_tmp_row_9_avx2;
+        hqdn3d->denoise_tmp_row[10] = ff_hqdn3d_tmp_row_10_avx2;
+        hqdn3d->denoise_tmp_row[16] = ff_hqdn3d_tmp_row_16_avx2;
+    }
 }
@@ -0,0 +1,82 @@
+;*****************************************************************************
+;* x86-optimized functions for lut filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_ffff: times 8 dd 0xffff
+
+SECTION .text
+
+; int lut_row8 (uint8_t  *dst, const uint8_t  *src, const uint16_t *lut, int width)
+; int lut_row16(uint16_t *dst, const uint16_t *src, const uint16_t *lut, int width)
+;
+; 16 samples per iteration, the table entries are fetched as dwords by two
+; gathers and their upper word, the next entry, is masked out.
+%macro LUT_ROW 1 ; bits
+%if %1 == 8
+    %define bps 1
+    %define PMOVZX     pmovzxbd
+%else
+    %define bps 2
+    %define PMOVZX     pmovzxwd
+%endif
+cglobal lut_row%1, 4, 5, 6, dst, src, lut, w, x
+    movsxdifnidn     wq, wd
+    and              wq, ~15
+    jz .end
+    lea            srcq, [srcq+wq*bps]
+    lea            dstq, [dstq+wq*bps]
+    mov              xq, wq
+    neg              xq
+    mova             m5, [pd_ffff]
+.loop:
+    PMOVZX           m0, [srcq+xq*bps]
+    PMOVZX           m1, [srcq+xq*bps+8*bps]
+    pcmpeqd          m2, m2
+    pcmpeqd          m3, m3
+    vpgatherdd       m4, [lutq+m0*2], m2
+    vpgatherdd       m0, [lutq+m1*2], m3
+    pand             m4, m5
+    pand             m0, m5
+    packusdw         m4, m0
+    vpermq           m4, m4, q3120
+%if %1 == 8
+    vextracti128    xm0, m4, 1
+    packuswb        xm4, xm0
+    movu [dstq+xq], xm4
+%else
+    movu [dstq+xq*2], m4
+%endif
+    add              xq, 16
+    jl .loop
+.end:
+    mov             eax, wd
+    RET
+%undef bps
+%undef PMOVZX
+%endmacro
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+LUT_ROW 8
+LUT_ROW 16
+%endif
@@ -0,0 +1,208 @@
+;*****************************************************************************
+;* x86-optimized functions for lut3d filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_255:   times 8 dd 255
+pd_1023:  times 8 dd 1023
+pd_1024:  times 8 dd 1024
+pd_32768: times 8 dd 32768
+
+SECTION .text
+
+; byte offsets of the entries of the params array, see lut3d.h
+%define STRIDE_R   0
+%define STRIDE_G   4
+%define STRIDE_B   8
+%define SHIFT_R   12
+%define SHIFT_G   16
+%define SHIFT_B   20
+%define ALPHA_MASK 24
+
+; Pair the words of the components of two vertices for pmaddwd
+; in:  %1 = r0 | g0 << 16, %2 = r1 | g1 << 16, %3 = b0, %4 = b1
+; out: %1 = r0 | r1 << 16, %2 = g0 | g1 << 16, %3 = b0 | b1 << 16
+%macro PAIR_VERTICES 5 ; rg0, rg1, b0, b1, tmp
+    pslld           m%5, m%2, 16
+    pslld           m%4, 16
+    pblendw         m%3, m%3, m%4, 0xAA
+    psrld           m%4, m%1, 16
+    pblendw         m%1, m%1, m%5, 0xAA
+    pblendw         m%2, m%4, m%2, 0xAA
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+
+; int lut3d_interp_tetrahedral_row(uint8_t *dst, const uint8_t *src, int width,
+;                                  const int16_t *lut, const uint32_t *coord,
+;                                  const uint32_t *params)
+;
+; 8 pixels per iteration. The 3 weights are sorted to select the vertices
+; of the tetrahedron, then the 2 x 4 words of each of its 4 vertices are
+; gathered and the weighted sums computed with pmaddwd.
+cglobal lut3d_interp_tetrahedral_row, 6, 7, 16, dst, src, w, lut, coord, params, x
+    movsxdifnidn      wq, wd
+    and               wq, ~7
+    jz .end
+    lea             srcq, [srcq+wq*4]
+    lea             dstq, [dstq+wq*4]
+    lea               xq, [wq*4]
+    neg               xq
+    vpbroadcastd     m13, [paramsq+SHIFT_R]
+    vpbroadcastd     m14, [paramsq+SHIFT_G]
+    vpbroadcastd     m15, [paramsq+SHIFT_B]
+.loop:
+    movu             m12, [srcq+xq]
+    mova              m3, [pd_255]
+    vpsrlvd           m0, m12, m13
+    vpsrlvd           m1, m12, m14
+    vpsrlvd           m2, m12, m15
+    pand              m0, m3
+    pand              m1, m3
+    pand              m2, m3
+
+    ; coordinates of the 3 components
+    pcmpeqd           m3, m3
+    vpgatherdd        m4, [coordq+m0*4], m3
+    pcmpeqd           m3, m3
+    vpgatherdd        m5, [coordq+m1*4+1024], m3
+    pcmpeqd           m3, m3
+    vpgatherdd        m6, [coordq+m2*4+2048], m3
+
+    ; offsets to the next level of each component, 0 on the last one
+    pslld             m0, m4, 31 - 10
+    pslld             m1, m5, 31 - 10
+    pslld             m2, m6, 31 - 10
+    psrad             m0, 31
+    psrad             m1, 31
+    psrad             m2, 31
+    vpbroadcastd      m3, [paramsq+STRIDE_R]
+    pand              m0, m3
+    vpbroadcastd      m3, [paramsq+STRIDE_G]
+    pand              m1, m3
+    vpbroadcastd      m3, [paramsq+STRIDE_B]
+    pand              m2, m3
+
+    ; m7 = offset of the first vertex
+    psrld             m7, m4, 11
+    psrld             m3, m5, 11
+    paddd             m7, m3
+    psrld             m3, m6, 11
+    paddd             m7, m3
+
+    ; m4, m5, m6 = weights of the components, m8 = max, m9 = min
+    mova              m3, [pd_1023]
+    pand              m4, m3
+    pand              m5, m3
+    pand              m6, m3
+    pmaxsd            m8, m4, m5
+    pminsd            m9, m4, m5
+    pmaxsd            m8, m6
+    pminsd            m9, m6
+
+    ; m3 = offset of the component of the max weight, m11 of the min one
+    pcmpeqd          m10, m5, m8
+    vpblendvb         m3, m2, m1, m10
+    pcmpeqd          m10, m4, m8
+    vpblendvb         m3, m3, m0, m10
+    pcmpeqd          m10, m5, m9
+    vpblendvb        m11, m2, m1, m10
+    pcmpeqd          m10, m4, m9
+    vpblendvb        m11, m11, m0, m10
+
+    ; m7, m3, m11, m10 = offsets of the 4 vertices
+    paddd            m10, m0, m1
+    paddd            m10, m2
+    paddd            m10, m7
+    paddd             m3, m7
+    psubd            m11, m10, m11
+
+    ; m4 = w0 | w1 << 16, m9 = w2 | w3 << 16
+    paddd             m0, m4, m5
+    paddd             m0, m6
+    psubd             m0, m8
+    psubd             m0, m9
+    psubd             m1, m8, m0
+    psubd             m2, m0, m9
+    mova              m4, [pd_1024]
+    psubd             m4, m8
+    pslld             m1, 16
+    por               m4, m1
+    pslld             m9, 16
+    por               m9, m2
+
+    pcmpeqd           m0, m0
+    vpgatherdd        m1, [lutq+m7*8], m0
+    pcmpeqd           m0, m0
+    vpgatherdd        m2, [lutq+m7*8+4], m0
+    pcmpeqd           m0, m0
+    vpgatherdd        m5, [lutq+m3*8], m0
+    pcmpeqd           m0, m0
+    vpgatherdd        m6, [lutq+m3*8+4], m0
+    PAIR_VERTICES      1, 5, 2, 6, 0
+    pmaddwd           m0, m1, m4
+    pmaddwd           m1, m5, m4
+    pmaddwd           m2, m4
+
+    pcmpeqd           m3, m3
+    vpgatherdd        m4, [lutq+m11*8], m3
+    pcmpeqd           m3, m3
+    vpgatherdd        m5, [lutq+m11*8+4], m3
+    pcmpeqd           m3, m3
+    vpgatherdd        m6, [lutq+m10*8], m3
+    pcmpeqd           m3, m3
+    vpgatherdd        m7, [lutq+m10*8+4], m3
+    PAIR_VERTICES      4, 6, 5, 7, 3
+    pmaddwd           m4, m9
+    pmaddwd           m6, m9
+    pmaddwd           m5, m9
+    paddd             m0, m4
+    paddd             m1, m6
+    paddd             m2, m5
+
+    mova              m3, [pd_32768]
+    pxor              m4, m4
+    mova              m5, [pd_255]
+%assign i 0
+%rep 3
+    paddd          m %+ i, m3
+    psrad          m %+ i, 16
+    pmaxsd         m %+ i, m4
+    pminsd         m %+ i, m5
+%assign i i+1
+%endrep
+    vpsllvd           m0, m0, m13
+    vpsllvd           m1, m1, m14
+    vpsllvd           m2, m2, m15
+    vpbroadcastd      m3, [paramsq+ALPHA_MASK]
+    pand              m3, m12
+    por               m0, m1
+    por               m2, m3
+    por               m0, m2
+    movu       [dstq+xq], m0
+    add               xq, mmsize
+    jl .loop
+.end:
+    mov              eax, wd
+    RET
+%endif
@@ -0,0 +1,110 @@
+;*****************************************************************************
+;* x86-optimized functions for overlay filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pb_1:   times 32 db 1
+pw_128: times 16 dw 128
+pw_255: times 16 dw 255
+pw_257: times 16 dw 257
+
+SECTION .text
+
+; blend mmsize/2 words of d (%1) and s (%2) with alpha (%3), result in %1
+; d = ((d * (255 - a) + s * a + 128) * 257) >> 16
+%macro BLEND_WORDS 3
+    pmullw     %2, %3
+    pxor       %3, m3
+    pmullw     %1, %3
+    paddw      %1, %2
+    paddw      %1, [pw_128]
+    pmulhuw    %1, [pw_257]
+%endmacro
+
+; int overlay_row_XX(uint8_t *d, const uint8_t *s, const uint8_t *a,
+;                    int w, ptrdiff_t alinesize)
+; XX is 44 for a full resolution alpha, 20 for an alpha averaged over 2x2
+%macro OVERLAY_ROW 1
+cglobal overlay_row_%1, 5, 7, 8, d, s, a, w, alinesize, x, r
+    movsxdifnidn  wq, wd
+    mov           rq, wq
+    and           rq, -mmsize
+    jz .end
+%if %1 == 20
+    add   alinesizeq, aq
+%endif
+    mova          m3, [pw_255]
+    pxor          m7, m7
+    xor           xq, xq
+
+.loop:
+%if %1 == 20
+    movu          m0, [aq + 2*xq]
+    movu          m1, [aq + 2*xq + mmsize]
+    movu          m2, [alinesizeq + 2*xq]
+    movu          m4, [alinesizeq + 2*xq + mmsize]
+    pmaddubsw     m0, [pb_1]
+    pmaddubsw     m1, [pb_1]
+    pmaddubsw     m2, [pb_1]
+    pmaddubsw     m4, [pb_1]
+    paddw         m0, m2
+    paddw         m1, m4
+    psrlw         m0, 2
+    psrlw         m1, 2
+    packuswb      m0, m1
+%if mmsize == 32
+    vpermq        m0, m0, q3120
+%endif
+%else
+    movu          m0, [aq + xq]
+%endif
+    movu          m1, [sq + xq]
+    movu          m2, [dq + xq]
+    punpckhbw     m4, m0, m7
+    punpcklbw     m0, m7
+    punpckhbw     m5, m2, m7
+    punpckhbw     m6, m1, m7
+    punpcklbw     m2, m7
+    punpcklbw     m1, m7
+    BLEND_WORDS   m5, m6, m4
+    BLEND_WORDS   m2, m1, m0
+    packuswb      m2, m5
+    movu   [dq + xq], m2
+    add           xq, mmsize
+    cmp           xq, rq
+    jl .loop
+
+.end:
+    mov          eax, rd
+    RET
+%endmacro
+
+INIT_XMM sse2
+OVERLAY_ROW 44
+INIT_XMM ssse3
+OVERLAY_ROW 20
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+OVERLAY_ROW 44
+OVERLAY_ROW 20
+%endif
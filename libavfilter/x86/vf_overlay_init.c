@@ -0,0 +1,73 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/vf_overlay.h"
+
+#define OVERLAY_ROW_FUNC(name, opt)                                          \
+int ff_overlay_row_##name##_##opt(uint8_t *d, const uint8_t *s,             \
+                                  const uint8_t *a, int w,                  \
+                                  ptrdiff_t alinesize);
+
+OVERLAY_ROW_FUNC(44, sse2)
+OVERLAY_ROW_FUNC(44, avx2)
+OVERLAY_ROW_FUNC(20, ssse3)
+OVERLAY_ROW_FUNC(20, avx2)
+
+av_cold void ff_overlay_init_x86(OverlayContext *s, int format, int main_has_alpha)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (main_has_alpha)
+        return;
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        switch (format) {
+        case OVERLAY_FORMAT_YUV444:
+            s->blend_row[1] = ff_overlay_row_44_sse2;
+            s->blend_row[2] = ff_overlay_row_44_sse2;
+        case OVERLAY_FORMAT_YUV420:
+        case OVERLAY_FORMAT_YUV422:
+            s->blend_row[0] = ff_overlay_row_44_sse2;
+            break;
+        }
+    }
+
+    if (EXTERNAL_SSSE3(cpu_flags) && format == OVERLAY_FORMAT_YUV420) {
+        s->blend_row[1] = ff_overlay_row_20_ssse3;
+        s->blend_row[2] = ff_overlay_row_20_ssse3;
+    }
+
+    if (EXTERNAL_AVX2(cpu_flags)) {
+        switch (format) {
+        case OVERLAY_FORMAT_YUV420:
+            s->blend_row[1] = ff_overlay_row_20_avx2;
+            s->blend_row[2] = ff_overlay_row_20_avx2;
+            s->blend_row[0] = ff_overlay_row_44_avx2;
+            break;
+        case OVERLAY_FORMAT_YUV444:
+            s->blend_row[1] = ff_overlay_row_44_avx2;
+            s->blend_row[2] = ff_overlay_row_44_avx2;
+        case OVERLAY_FORMAT_YUV422:
+            s->blend_row[0] = ff_overlay_row_44_avx2;
+            break;
+        }
+    }
+}
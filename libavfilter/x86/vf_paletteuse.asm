@@ -0,0 +1,97 @@
+;*****************************************************************************
+;* x86-optimized functions for paletteuse filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_index: dd 0, 1, 2, 3, 4, 5, 6, 7
+pd_max:   times 8 dd 0x7fffffff
+pd_8:     times 8 dd 8
+pd_4:     times 4 dd 4
+
+SECTION .text
+
+; int paletteuse_nearest_color(const int16_t *rg, const int16_t *b,
+;                              int nb_entries, uint32_t color)
+;
+; The distances of 4 or 8 entries are computed at once with pmaddwd on the
+; r,g and b,0 word pairs. Each distance is shifted left by 8 and or'ed with
+; the index of its entry, so that the minimum of these keys gives both the
+; nearest entry and the lowest index among equally near ones.
+%macro NEAREST_COLOR 0
+cglobal paletteuse_nearest_color, 4, 4, 7, rg, b, n, color
+    and          colord, 0xffffff
+    movd             xm1, colord
+    pxor             xm2, xm2
+    punpcklbw        xm1, xm2               ; b, g, r, 0
+    pshuflw          xm0, xm1, q1212        ; r, g
+    pshuflw          xm1, xm1, q3030        ; b, 0
+%if cpuflag(avx2)
+    vpbroadcastd      m0, xm0
+    vpbroadcastd      m1, xm1
+    mova              m4, [pd_8]
+%else
+    pshufd            m0, m0, q0000
+    pshufd            m1, m1, q0000
+    mova              m4, [pd_4]
+%endif
+    mova              m5, [pd_index]
+    mova              m6, [pd_max]
+
+    movsxdifnidn      nq, nd
+    lea              rgq, [rgq+nq*4]
+    lea               bq, [bq+nq*4]
+    neg               nq
+.loop:
+    mova              m2, [rgq+nq*4]
+    mova              m3, [bq+nq*4]
+    psubw             m2, m0
+    psubw             m3, m1
+    pmaddwd           m2, m2
+    pmaddwd           m3, m3
+    paddd             m2, m3
+    pslld             m2, 8
+    por               m2, m5
+    pminsd            m6, m2
+    paddd             m5, m4
+    add               nq, mmsize/4
+    jl .loop
+
+%if cpuflag(avx2)
+    vextracti128     xm2, m6, 1
+    pminsd           xm6, xm2
+%endif
+    pshufd           xm2, xm6, q1032
+    pminsd           xm6, xm2
+    pshufd           xm2, xm6, q2301
+    pminsd           xm6, xm2
+    movd             eax, xm6
+    and              eax, 0xff
+    RET
+%endmacro
+
+INIT_XMM sse4
+NEAREST_COLOR
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+NEAREST_COLOR
+%endif
@@ -0,0 +1,139 @@
+;*****************************************************************************
+;* x86-optimized functions for unsharp filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; void unsharp_vblur_row(uint32_t *sc, ptrdiff_t sc_stride, uint32_t *row,
+;                        int steps, int width)
+%macro VBLUR_ROW 0
+cglobal unsharp_vblur_row, 5, 7, 3, sc, stride, row, steps, w, p, z
+    movsxdifnidn     wq, wd
+    test             wq, wq
+    jle .end
+    shl         strideq, 2
+    lea            rowq, [rowq+wq*4]
+    lea             scq, [scq+wq*4]
+    neg              wq
+
+.loop:
+    movu             m0, [rowq+wq*4]
+    lea              pq, [scq+wq*4]
+    mov              zd, stepsd
+.steps:
+    movu             m1, [pq]
+    movu           [pq], m0
+    paddd            m1, m0
+    movu             m2, [pq+strideq]
+    movu   [pq+strideq], m1
+    paddd            m0, m2, m1
+    lea              pq, [pq+strideq*2]
+    dec              zd
+    jg .steps
+    movu    [rowq+wq*4], m0
+    add              wq, mmsize/4
+    jl .loop
+.end:
+    RET
+%endmacro
+
+; int unsharp_sharpen_row(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+;                         int width, int amount, int scalebits, int halfscale)
+;
+; (diff * amount) >> 16 is evaluated on words as
+; diff * ((amount + 0x8000) >> 16) + pmulhw(diff, amount & 0xffff)
+%macro SHARPEN_ROW 0
+cglobal unsharp_sharpen_row, 7, 7, 8, dst, src, blur, w, amount, scalebits, half
+    movd            xm7, halfd
+    movd            xm6, scalebitsd
+%if mmsize == 32
+    vpbroadcastd     m7, xm7
+%else
+    SPLATD           m7
+%endif
+    movd            xm5, amountd
+    add         amountd, 0x8000
+    sar         amountd, 16
+    movd            xm4, amountd
+    pshuflw         xm5, xm5, q0000
+    pshuflw         xm4, xm4, q0000
+%if mmsize == 32
+    vpbroadcastq     m5, xm5
+    vpbroadcastq     m4, xm4
+%else
+    punpcklqdq       m5, m5
+    punpcklqdq       m4, m4
+%endif
+    pxor             m3, m3
+
+    movsxdifnidn     wq, wd
+    and              wq, -mmsize/2
+    mov           halfq, wq
+    jz .end
+    add            dstq, wq
+    add            srcq, wq
+    lea           blurq, [blurq+wq*4]
+    neg              wq
+
+.loop:
+    movu             m0, [blurq+wq*4]
+    movu             m1, [blurq+wq*4+mmsize]
+    paddd            m0, m7
+    paddd            m1, m7
+    psrld            m0, xm6
+    psrld            m1, xm6
+    packssdw         m0, m1
+%if mmsize == 32
+    vpermq           m0, m0, q3120
+    pmovzxbw         m1, [srcq+wq]
+%else
+    movh             m1, [srcq+wq]
+    punpcklbw        m1, m3
+%endif
+    psubw            m2, m1, m0
+    pmullw           m0, m2, m4
+    pmulhw           m2, m5
+    paddw            m0, m2
+    paddw            m0, m1
+    packuswb         m0, m0
+%if mmsize == 32
+    vpermq           m0, m0, q3120
+    movu      [dstq+wq], xm0
+%else
+    movh      [dstq+wq], m0
+%endif
+    add              wq, mmsize/2
+    jl .loop
+
+.end:
+    mov             eax, halfd
+    RET
+%endmacro
+
+INIT_XMM sse2
+VBLUR_ROW
+SHARPEN_ROW
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+VBLUR_ROW
+SHARPEN_ROW
+%endif
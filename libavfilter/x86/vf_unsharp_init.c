@@ -0,0 +1,45 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/unsharp.h"
+
+void ff_unsharp_vblur_row_sse2(uint32_t *sc, ptrdiff_t sc_stride, uint32_t *row,
+                               int steps, int width);
+void ff_unsharp_vblur_row_avx2(uint32_t *sc, ptrdiff_t sc_stride, uint32_t *row,
+                               int steps, int width);
+int ff_unsharp_sharpen_row_sse2(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                                int width, int amount, int scalebits, int32_t halfscale);
+int ff_unsharp_sharpen_row_avx2(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                                int width, int amount, int scalebits, int32_t halfscale);
+
+av_cold void ff_unsharp_init_x86(UnsharpContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        s->vblur_row   = ff_unsharp_vblur_row_sse2;
+        s->sharpen_row = ff_unsharp_sharpen_row_sse2;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        s->vblur_row   = ff_unsharp_vblur_row_avx2;
+        s->sharpen_row = ff_unsharp_sharpen_row_avx2;
+    }
+}
@@ -0,0 +1,282 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Cache of scaling contexts sharing their filter coefficients
+ */
+
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/mem.h"
+
+#include "swscale.h"
+#include "swscale_internal.h"
+
+typedef struct SwsPooledFilter {
+    SwsFilterKey key;
+    AVBufferRef *filter;
+    AVBufferRef *filter_pos;
+    int filter_size;
+} SwsPooledFilter;
+
+struct SwsFilterPool {
+    SwsPooledFilter *filters;
+    int nb_filters;
+    int64_t hits;                 ///< Number of filters taken from the pool.
+};
+
+SwsFilterPool *ff_sws_filter_pool_alloc(void)
+{
+    return av_mallocz(sizeof(SwsFilterPool));
+}
+
+void ff_sws_filter_pool_free(SwsFilterPool **ppool)
+{
+    SwsFilterPool *pool = *ppool;
+    int i;
+
+    if (!pool)
+        return;
+
+    for (i = 0; i < pool->nb_filters; i++) {
+        av_buffer_unref(&pool->filters[i].filter);
+        av_buffer_unref(&pool->filters[i].filter_pos);
+    }
+    av_freep(&pool->filters);
+    av_freep(ppool);
+}
+
+int ff_sws_filter_pool_get(SwsFilterPool *pool, const SwsFilterKey *key,
+                           AVBufferRef **filter, AVBufferRef **filter_pos,
+                           int *filter_size)
+{
+    int i;
+
+    for (i = 0; i < pool->nb_filters; i++) {
+        const SwsPooledFilter *f = &pool->filters[i];
+
+        if (memcmp(&f->key, key, sizeof(*key)))
+            continue;
+
+        *filter     = av_buffer_ref(f->filter);
+        *filter_pos = av_buffer_ref(f->filter_pos);
+        if (!*filter || !*filter_pos) {
+            av_buffer_unref(filter);
+            av_buffer_unref(filter_pos);
+            return 0;
+        }
+        *filter_size = f->filter_size;
+        pool->hits++;
+        return 1;
+    }
+    return 0;
+}
+
+int ff_sws_filter_pool_add(SwsFilterPool *pool, const SwsFilterKey *key,
+                           AVBufferRef *filter, AVBufferRef *filter_pos,
+                           int filter_size)
+{
+    SwsPooledFilter *filters, *f;
+
+    filters = av_realloc_array(pool->filters, pool->nb_filters + 1,
+                               sizeof(*pool->filters));
+    if (!filters)
+        return AVERROR(ENOMEM);
+    pool->filters = filters;
+
+    f = &filters[pool->nb_filters];
+    f->key         = *key;
+    f->filter_size = filter_size;
+    f->filter      = av_buffer_ref(filter);
+    f->filter_pos  = av_buffer_ref(filter_pos);
+    if (!f->filter || !f->filter_pos) {
+        av_buffer_unref(&f->filter);
+        av_buffer_unref(&f->filter_pos);
+        return AVERROR(ENOMEM);
+    }
+    pool->nb_filters++;
+    return 0;
+}
+
+void ff_sws_filter_pool_prune(SwsFilterPool *pool)
+{
+    int i, j;
+
+    for (i = j = 0; i < pool->nb_filters; i++) {
+        SwsPooledFilter *f = &pool->filters[i];
+
+        if (av_buffer_get_ref_count(f->filter)     == 1 &&
+            av_buffer_get_ref_count(f->filter_pos) == 1) {
+            av_buffer_unref(&f->filter);
+            av_buffer_unref(&f->filter_pos);
+        } else {
+            pool->filters[j++] = *f;
+        }
+    }
+    pool->nb_filters = j;
+}
+
+typedef struct SwsCacheEntry {
+    SwsContext *ctx;
+    uint64_t last_use;
+    /* The requested parameters, sws_init_context() changes some of them
+     * in the context (e.g. flags and the deprecated JPEG formats). */
+    int srcW, srcH;
+    enum AVPixelFormat srcFormat;
+    int dstW, dstH;
+    enum AVPixelFormat dstFormat;
+    int flags;
+    double param[2];
+} SwsCacheEntry;
+
+struct SwsContextCache {
+    SwsCacheEntry *entries;
+    int nb_entries;
+    int max_entries;
+    uint64_t clock;
+    SwsFilterPool *filter_pool;
+    int64_t hits;
+    int64_t misses;
+};
+
+SwsContextCache *sws_context_cache_alloc(int max_contexts)
+{
+    SwsContextCache *cache;
+
+    if (max_contexts <= 0)
+        return NULL;
+
+    cache = av_mallocz(sizeof(*cache));
+    if (!cache)
+        return NULL;
+
+    cache->entries     = av_mallocz_array(max_contexts, sizeof(*cache->entries));
+    cache->filter_pool = ff_sws_filter_pool_alloc();
+    if (!cache->entries || !cache->filter_pool) {
+        sws_context_cache_free(&cache);
+        return NULL;
+    }
+    cache->max_entries = max_contexts;
+
+    return cache;
+}
+
+void sws_context_cache_free(SwsContextCache **pcache)
+{
+    SwsContextCache *cache = *pcache;
+    int i;
+
+    if (!cache)
+        return;
+
+    for (i = 0; i < cache->nb_entries; i++)
+        sws_freeContext(cache->entries[i].ctx);
+    av_freep(&cache->entries);
+    ff_sws_filter_pool_free(&cache->filter_pool);
+    av_freep(pcache);
+}
+
+struct SwsContext *sws_context_cache_get(SwsContextCache *cache,
+                                         int srcW, int srcH, enum AVPixelFormat srcFormat,
+                                         int dstW, int dstH, enum AVPixelFormat dstFormat,
+                                         int flags, const double *param)
+{
+    static const double default_param[2] = { SWS_PARAM_DEFAULT,
+                                             SWS_PARAM_DEFAULT };
+    SwsCacheEntry *entry;
+    SwsContext *c;
+    int i;
+
+    if (!param)
+        param = default_param;
+
+    for (i = 0; i < cache->nb_entries; i++) {
+        entry = &cache->entries[i];
+        if (entry->srcW      == srcW      &&
+            entry->srcH      == srcH      &&
+            entry->srcFormat == srcFormat &&
+            entry->dstW      == dstW      &&
+            entry->dstH      == dstH      &&
+            entry->dstFormat == dstFormat &&
+            entry->flags     == flags     &&
+            entry->param[0]  == param[0]  &&
+            entry->param[1]  == param[1]) {
+            entry->last_use = ++cache->clock;
+            cache->hits++;
+            return entry->ctx;
+        }
+    }
+
+    cache->misses++;
+
+    if (!(c = sws_alloc_context()))
+        return NULL;
+    c->srcW        = srcW;
+    c->srcH        = srcH;
+    c->srcFormat   = srcFormat;
+    c->dstW        = dstW;
+    c->dstH        = dstH;
+    c->dstFormat   = dstFormat;
+    c->flags       = flags;
+    c->param[0]    = param[0];
+    c->param[1]    = param[1];
+    c->filter_pool = cache->filter_pool;
+
+    if (sws_init_context(c, NULL, NULL) < 0) {
+        sws_freeContext(c);
+        ff_sws_filter_pool_prune(cache->filter_pool);
+        return NULL;
+    }
+
+    if (cache->nb_entries < cache->max_entries) {
+        entry = &cache->entries[cache->nb_entries++];
+    } else {
+        entry = &cache->entries[0];
+        for (i = 1; i < cache->nb_entries; i++)
+            if (cache->entries[i].last_use < entry->last_use)
+                entry = &cache->entries[i];
+        sws_freeContext(entry->ctx);
+        ff_sws_filter_pool_prune(cache->filter_pool);
+    }
+    entry->ctx       = c;
+    entry->last_use  = ++cache->clock;
+    entry->srcW      = srcW;
+    entry->srcH      = srcH;
+    entry->srcFormat = srcFormat;
+    entry->dstW      = dstW;
+    entry->dstH      = dstH;
+    entry->dstFormat = dstFormat;
+    entry->flags     = flags;
+    entry->param[0]  = param[0];
+    entry->param[1]  = param[1];
+
+    return c;
+}
+
+void sws_context_cache_stats(const SwsContextCache *cache, int64_t *hits,
+                             int64_t *misses, int64_t *shared_filters)
+{
+    if (hits)
+        *hits = cache->hits;
+    if (misses)
+        *misses = cache->misses;
+    if (shared_filters)
+        *shared_filters = cache->filter_pool->hits;
+}
@@ -139,6 +139,49 @@ extern void (*deinterleaveBytes)(const uint8_t *src, uint8_t *dst1, uint8_t *dst
                                  int width, int height, int srcStride,
                                  int dst1Stride, int dst2Stride);
 
+/**
+ * Shift the native endian 16 bit samples left by shift bits.
+ * The strides are in bytes.
+ */
+extern void (*shiftWords)(const uint16_t *src, uint16_t *dst,
+                          int width, int height, int srcStride,
+                          int dstStride, int shift);
+
+/**
+ * Shift the native endian 16 bit samples right by shift bits.
+ * The strides are in bytes.
+ */
+extern void (*shiftWordsRight)(const uint16_t *src, uint16_t *dst,
+                               int width, int height, int srcStride,
+                               int dstStride, int shift);
+
+/**
+ * Interleave the native endian 16 bit samples of src1 and src2, shifted
+ * left by shift bits. The strides are in bytes.
+ */
+extern void (*interleaveWords)(const uint16_t *src1, const uint16_t *src2,
+                               uint16_t *dst, int width, int height,
+                               int src1Stride, int src2Stride, int dstStride,
+                               int shift);
+
+/**
+ * Deinterleave the native endian 16 bit samples of src into dst1 and dst2,
+ * shifted right by shift bits. The strides are in bytes.
+ */
+extern void (*deinterleaveWords)(const uint16_t *src, uint16_t *dst1,
+                                 uint16_t *dst2, int width, int height,
+                                 int srcStride, int dst1Stride,
+                                 int dst2Stride, int shift);
+
+/**
+ * Interleave the bytes of src1 and src2, each byte x being stored as the
+ * little endian 16 bit sample x * 257.
+ */
+extern void (*interleaveBytesToWords)(const uint8_t *src1, const uint8_t *src2,
+                                      uint8_t *dst, int width, int height,
+                                      int src1Stride, int src2Stride,
+                                      int dstStride);
+
 extern void (*vu9_to_vu12)(const uint8_t *src1, const uint8_t *src2,
                            uint8_t *dst1, uint8_t *dst2,
                            int width, int height,
@@ -725,6 +725,93 @@ static void deinterleaveBytes_c(const uint8_t *src, uint8_t *dst1, uint8_t *dst2
     }
 }
 
+static void shiftWords_c(const uint16_t *src, uint16_t *dst,
+                         int width, int height, int srcStride,
+                         int dstStride, int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        int w;
+        for (w = 0; w < width; w++)
+            dst[w] = src[w] << shift;
+        src = (const uint16_t *)((const uint8_t *)src + srcStride);
+        dst = (uint16_t *)((uint8_t *)dst + dstStride);
+    }
+}
+
+static void shiftWordsRight_c(const uint16_t *src, uint16_t *dst,
+                              int width, int height, int srcStride,
+                              int dstStride, int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        int w;
+        for (w = 0; w < width; w++)
+            dst[w] = src[w] >> shift;
+        src = (const uint16_t *)((const uint8_t *)src + srcStride);
+        dst = (uint16_t *)((uint8_t *)dst + dstStride);
+    }
+}
+
+static void interleaveWords_c(const uint16_t *src1, const uint16_t *src2,
+                              uint16_t *dst, int width, int height,
+                              int src1Stride, int src2Stride, int dstStride,
+                              int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        int w;
+        for (w = 0; w < width; w++) {
+            dst[2 * w + 0] = src1[w] << shift;
+            dst[2 * w + 1] = src2[w] << shift;
+        }
+        src1 = (const uint16_t *)((const uint8_t *)src1 + src1Stride);
+        src2 = (const uint16_t *)((const uint8_t *)src2 + src2Stride);
+        dst  = (uint16_t *)((uint8_t *)dst + dstStride);
+    }
+}
+
+static void deinterleaveWords_c(const uint16_t *src, uint16_t *dst1,
+                                uint16_t *dst2, int width, int height,
+                                int srcStride, int dst1Stride, int dst2Stride,
+                                int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        int w;
+        for (w = 0; w < width; w++) {
+            dst1[w] = src[2 * w + 0] >> shift;
+            dst2[w] = src[2 * w + 1] >> shift;
+        }
+        src  = (const uint16_t *)((const uint8_t *)src + srcStride);
+        dst1 = (uint16_t *)((uint8_t *)dst1 + dst1Stride);
+        dst2 = (uint16_t *)((uint8_t *)dst2 + dst2Stride);
+    }
+}
+
+static void interleaveBytesToWords_c(const uint8_t *src1, const uint8_t *src2,
+                                     uint8_t *dst, int width, int height,
+                                     int src1Stride, int src2Stride,
+                                     int dstStride)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        int w;
+        for (w = 0; w < width; w++) {
+            dst[4 * w + 0] = dst[4 * w + 1] = src1[w];
+            dst[4 * w + 2] = dst[4 * w + 3] = src2[w];
+        }
+        src1 += src1Stride;
+        src2 += src2Stride;
+        dst  += dstStride;
+    }
+}
+
 static inline void vu9_to_vu12_c(const uint8_t *src1, const uint8_t *src2,
                                  uint8_t *dst1, uint8_t *dst2,
                                  int width, int height,
@@ -961,6 +1048,11 @@ static av_cold void rgb2rgb_init_c(void)
     ff_rgb24toyv12     = ff_rgb24toyv12_c;
     interleaveBytes    = interleaveBytes_c;
     deinterleaveBytes  = deinterleaveBytes_c;
+    shiftWords         = shiftWords_c;
+    shiftWordsRight    = shiftWordsRight_c;
+    interleaveWords    = interleaveWords_c;
+    deinterleaveWords  = deinterleaveWords_c;
+    interleaveBytesToWords = interleaveBytesToWords_c;
     vu9_to_vu12        = vu9_to_vu12_c;
     yvu9_to_yuy2       = yvu9_to_yuy2_c;
 
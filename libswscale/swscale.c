@@ -132,6 +132,38 @@ static void hScale8To15_c(SwsContext *c, int16_t *dst, int dstW,
     }
 }
 
+static void hScale8To15_lowp_c(int16_t *dst, int dstW, const uint8_t *src,
+                               const int8_t *filter, const int32_t *filterPos,
+                               int filterSize)
+{
+    const int blocks = (filterSize + 3) >> 2;
+    int i;
+    for (i = 0; i < dstW; i++) {
+        const int8_t *f = filter + ((i >> 3) * blocks * 8 + (i & 7)) * 4;
+        int j;
+        int srcPos = filterPos[i];
+        int val    = 0;
+        for (j = 0; j < filterSize; j++)
+            val += src[srcPos + j] * f[(j >> 2) * 32 + (j & 3)];
+        // filter=6 bit, input=8 bit, the sum is doubled to make 15 bit
+        dst[i] = av_clip_int16(val * 2);
+    }
+}
+
+static void hyScale_lowp(SwsContext *c, int16_t *dst, int dstW,
+                         const uint8_t *src, const int16_t *filter,
+                         const int32_t *filterPos, int filterSize)
+{
+    c->hScale8To15_lowp(dst, dstW, src, c->hLumFilter8, filterPos, filterSize);
+}
+
+static void hcScale_lowp(SwsContext *c, int16_t *dst, int dstW,
+                         const uint8_t *src, const int16_t *filter,
+                         const int32_t *filterPos, int filterSize)
+{
+    c->hScale8To15_lowp(dst, dstW, src, c->hChrFilter8, filterPos, filterSize);
+}
+
 static void hScale8To19_c(SwsContext *c, int16_t *_dst, int dstW,
                           const uint8_t *src, const int16_t *filter,
                           const int32_t *filterPos, int filterSize)
@@ -228,6 +260,42 @@ static void lumRangeFromJpeg16_c(int16_t *_dst, int width)
     if (DEBUG_SWSCALE_BUFFERS)                  \
         av_log(c, AV_LOG_DEBUG, __VA_ARGS__)
 
+/**
+ * The SIMD output functions may write a few pixels past the end of a line.
+ * In the threaded scaling, this must not reach the first lines of the next
+ * band, so the last lines of a band are scaled to padded buffers and copied.
+ * Point the lines of vout written at dstY which are the last of their plane
+ * in the band to these buffers.
+ *
+ * @return the number of lines redirected, whose slots in the line arrays of
+ *         vout and destination are stored in slot and dst
+ */
+static int redirect_band_end(SwsContext *c, SwsSlice *vout, int dstY,
+                             uint8_t ***slot, uint8_t **dst, int *plane)
+{
+    const int chrSkipMask = (1 << c->chrDstVSubSample) - 1;
+    const int chrDstY     = dstY >> c->chrDstVSubSample;
+    const int chrEnd      = c->dst_slice_end >> c->chrDstVSubSample;
+    int i, n = 0;
+
+    for (i = 0; i < 4; i++) {
+        const int y = i == 1 || i == 2 ? chrDstY : dstY;
+
+        if (!c->dst_slice_tmp[i])
+            continue;
+        if (i == 1 || i == 2 ? chrDstY != chrEnd - 1 || dstY & chrSkipMask
+                             : dstY != c->dst_slice_end - 1)
+            continue;
+        slot[n]  = &vout->plane[i].line[y - vout->plane[i].sliceY];
+        dst[n]   = *slot[n];
+        plane[n] = i;
+        *slot[n] = c->dst_slice_tmp[i];
+        n++;
+    }
+
+    return n;
+}
+
 static int swscale(SwsContext *c, const uint8_t *src[],
                    int srcStride[], int srcSliceY,
                    int srcSliceH, uint8_t *dst[], int dstStride[])
@@ -236,6 +304,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
      * and faster */
     const int dstW                   = c->dstW;
     const int dstH                   = c->dstH;
+    const int dstSliceEnd            = c->dst_slice_end;
 
     const enum AVPixelFormat dstFormat = c->dstFormat;
     const int flags                  = c->flags;
@@ -337,7 +406,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = c->dst_slice_start;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -369,7 +438,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstSliceEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -497,7 +566,18 @@ static int swscale(SwsContext *c, const uint8_t *src[],
                            yuv2packed1, yuv2packed2, yuv2packedX, yuv2anyX, use_mmx_vfilter);
         }
 
-        {
+        if (dstSliceEnd < dstH) {
+            uint8_t **slot[4], *line[4];
+            int plane[4];
+            int n = redirect_band_end(c, vout_slice, dstY, slot, line, plane);
+
+            for (i = vStart; i < vEnd; ++i)
+                desc[i].process(c, &desc[i], dstY, 1);
+            for (i = 0; i < n; i++) {
+                memcpy(line[i], *slot[i], c->dst_slice_linesize[plane[i]]);
+                *slot[i] = line[i];
+            }
+        } else {
             for (i = vStart; i < vEnd; ++i)
                 desc[i].process(c, &desc[i], dstY, 1);
         }
@@ -570,6 +650,7 @@ static av_cold void sws_init_swscale(SwsContext *c)
     if (c->srcBpc == 8) {
         if (c->dstBpc <= 14) {
             c->hyScale = c->hcScale = hScale8To15_c;
+            c->hScale8To15_lowp = hScale8To15_lowp_c;
             if (c->flags & SWS_FAST_BILINEAR) {
                 c->hyscale_fast = ff_hyscale_fast_c;
                 c->hcscale_fast = ff_hcscale_fast_c;
@@ -602,6 +683,13 @@ SwsFunc ff_getSwsFunc(SwsContext *c)
     if (ARCH_ARM)
         ff_sws_init_swscale_arm(c);
 
+    /* the C version is only a reference for the SIMD ones, hScale8To15_c
+     * is faster and more accurate */
+    if (c->hLumFilter8 && c->hScale8To15_lowp != hScale8To15_lowp_c) {
+        c->hyScale = hyScale_lowp;
+        c->hcScale = hcScale_lowp;
+    }
+
     return swscale;
 }
 
@@ -746,6 +834,35 @@ static void rgb48Toxyz12(struct SwsContext *c, uint16_t *dst,
     }
 }
 
+typedef struct ScaleBandArgs {
+    const uint8_t **src;
+    const int *srcStride;
+    uint8_t **dst;
+    const int *dstStride;
+} ScaleBandArgs;
+
+static int scale_band(SwsContext *c, void *arg, int jobnr, int nb_jobs)
+{
+    const ScaleBandArgs *args = arg;
+    SwsContext *band = c->slice_ctx[jobnr];
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int srcStride[4], dstStride[4];
+
+    // swscale() may modify these, each band needs its own copy
+    memcpy(src,       args->src,       sizeof(src));
+    memcpy(srcStride, args->srcStride, sizeof(srcStride));
+    memcpy(dst,       args->dst,       sizeof(dst));
+    memcpy(dstStride, args->dstStride, sizeof(dstStride));
+
+    if (usePal(c->srcFormat)) {
+        memcpy(band->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+        memcpy(band->pal_rgb, c->pal_rgb, sizeof(c->pal_rgb));
+    }
+
+    return band->swscale(band, src, srcStride, 0, c->srcH, dst, dstStride);
+}
+
 /**
  * swscale wrapper, so we don't need to export the SwsContext.
  * Assumes planar YUV to be in YUV order instead of YVU.
@@ -974,7 +1091,13 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     /* reset slice direction at end of frame */
     if (srcSliceY_internal + srcSliceH == c->srcH)
         c->sliceDir = 0;
-    ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
+    if (c->slice_ctx && srcSliceY_internal == 0 && srcSliceH == c->srcH) {
+        ScaleBandArgs args = { src2, srcStride2, dst2, dstStride2 };
+
+        ff_sws_thread_execute(c, scale_band, &args, c->nb_slice_ctx);
+        c->dstY = ret = c->dstH;
+    } else
+        ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
 
 
     if (c->dstXYZ && !(c->srcXYZ && c->srcW==c->dstW && c->srcH==c->dstH)) {
@@ -82,6 +82,14 @@ const char *swscale_license(void);
 #define SWS_DIRECT_BGR        0x8000
 #define SWS_ACCURATE_RND      0x40000
 #define SWS_BITEXACT          0x80000
+/**
+ * Trade quality for speed with SWS_BILINEAR and SWS_BICUBIC of 8 bit YUV
+ * input: the horizontal filter coefficients are reduced to 6 bits and
+ * accumulated in 16 bits. Ignored with SWS_ACCURATE_RND or SWS_BITEXACT.
+ * Only implemented for x86-64 with SSSE3, it has no effect on 32-bit x86
+ * and the other architectures.
+ */
+#define SWS_LOW_PRECISION    0x100000
 #define SWS_ERROR_DIFFUSION  0x800000
 
 #define SWS_MAX_REDUCE_CUTOFF 0.002
@@ -297,6 +305,60 @@ struct SwsContext *sws_getCachedContext(struct SwsContext *context,
                                         int flags, SwsFilter *srcFilter,
                                         SwsFilter *dstFilter, const double *param);
 
+/**
+ * A cache of scaling contexts, for callers switching between several
+ * conversions, see sws_context_cache_alloc().
+ */
+typedef struct SwsContextCache SwsContextCache;
+
+/**
+ * Allocate a cache of at most max_contexts scaling contexts, the least
+ * recently used one being freed when a new one is needed.
+ *
+ * The contexts of a cache share the filter coefficients computed with the
+ * same sizes, flags and parameters, so that for example contexts which
+ * only differ in their pixel formats compute them once.
+ *
+ * A cache and its contexts must not be used from several threads at once.
+ *
+ * @return the cache, or NULL if max_contexts is not positive or on
+ *         allocation failure
+ */
+SwsContextCache *sws_context_cache_alloc(int max_contexts);
+
+/**
+ * Free the cache and all its contexts, and set *cache to NULL.
+ */
+void sws_context_cache_free(SwsContextCache **cache);
+
+/**
+ * Get a context of the cache for the given parameters, which are those of
+ * sws_getContext() without the filters. The context is created (evicting
+ * the least recently used one if the cache is full) if the cache does not
+ * hold one yet.
+ *
+ * The context belongs to the cache and must not be freed by the caller.
+ * It stays valid until it is evicted, which does not happen before
+ * max_contexts - 1 other contexts have been requested.
+ *
+ * @return the context, or NULL on error
+ */
+struct SwsContext *sws_context_cache_get(SwsContextCache *cache,
+                                         int srcW, int srcH, enum AVPixelFormat srcFormat,
+                                         int dstW, int dstH, enum AVPixelFormat dstFormat,
+                                         int flags, const double *param);
+
+/**
+ * Get the statistics of the cache. Any of the pointers may be NULL.
+ *
+ * @param hits           number of requests answered with a cached context
+ * @param misses         number of requests which needed a new context
+ * @param shared_filters number of filters shared by a new context instead
+ *                       of being computed
+ */
+void sws_context_cache_stats(const SwsContextCache *cache, int64_t *hits,
+                             int64_t *misses, int64_t *shared_filters);
+
 /**
  * Convert an 8-bit paletted frame into a frame with a color depth of 32 bits.
  *
@@ -31,6 +31,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
+#include "libavutil/buffer.h"
 #include "libavutil/common.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
@@ -325,6 +326,27 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* The slice_* fields allow splitting a frame scaled in one call into
+     * bands of destination lines, each scaled by its own context in a
+     * worker thread from the full source frame.
+     */
+    int nb_threads;               ///< Number of worker threads, 0 for one per CPU.
+    struct SwsContext **slice_ctx;
+    int nb_slice_ctx;
+    struct SwsThreadContext *thread;
+    int dst_slice_start;          ///< First destination line scaled by this context.
+    int dst_slice_end;            ///< Last destination line scaled by this context + 1.
+    uint8_t *dst_slice_tmp[4];    ///< Padded buffers for the last lines of a band.
+    int dst_slice_linesize[4];    ///< Size in bytes of the lines of the destination planes.
+
+    /* Contexts created by an SwsContextCache share the filters computed
+     * with the same parameters through the filter pool of the cache. The
+     * filters of such a context are then references to pooled buffers.
+     */
+    struct SwsFilterPool *filter_pool;
+    AVBufferRef *filter_buf[4];   ///< hLum, hChr, vLum and vChr filters, if pooled.
+    AVBufferRef *filter_pos_buf[4]; ///< Matching filter positions.
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -387,6 +409,15 @@ typedef struct SwsContext {
     int vChrFilterSize;           ///< Vertical   filter size for chroma     pixels.
     //@}
 
+    /**
+     * Horizontal filters quantized to 6 bits for SWS_LOW_PRECISION, NULL
+     * when the mode is not used. The coefficients of each group of 8 output
+     * pixels are interleaved by blocks of 4 taps: tap j of pixel i is at
+     * ((i / 8 * ceil(filterSize / 4) + j / 4) * 8 + i % 8) * 4 + j % 4.
+     */
+    int8_t *hLumFilter8;
+    int8_t *hChrFilter8;
+
     int lumMmxextFilterCodeSize;  ///< Runtime-generated MMXEXT horizontal fast bilinear scaler code size for luma/alpha planes.
     int chrMmxextFilterCodeSize;  ///< Runtime-generated MMXEXT horizontal fast bilinear scaler code size for chroma planes.
     uint8_t *lumMmxextFilterCode; ///< Runtime-generated MMXEXT horizontal fast bilinear scaler code for luma/alpha planes.
@@ -617,6 +648,16 @@ typedef struct SwsContext {
                     const int32_t *filterPos, int filterSize);
     /** @} */
 
+    /**
+     * Scale one horizontal line of 8 bit input to 15 bit with a filter of
+     * hLumFilter8/hChrFilter8, accumulating in 16 bits with saturation.
+     * Used for hyScale and hcScale with SWS_LOW_PRECISION. Up to 7 pixels
+     * past dstW may be written.
+     */
+    void (*hScale8To15_lowp)(int16_t *dst, int dstW, const uint8_t *src,
+                             const int8_t *filter, const int32_t *filterPos,
+                             int filterSize);
+
     /// Color range conversion function for luma plane if needed.
     void (*lumConvertRange)(int16_t *dst, int width);
     /// Color range conversion function for chroma planes if needed.
@@ -998,6 +1039,64 @@ int ff_init_filters(SwsContext *c);
 // Free all filter data
 int ff_free_filters(SwsContext *c);
 
+typedef int (sws_thread_func)(SwsContext *c, void *arg, int jobnr, int nb_jobs);
+
+/**
+ * Start nb_threads worker threads for the slice contexts of c.
+ *
+ * @return the number of threads started, 1 if none, or a negative error code
+ */
+int ff_sws_thread_init(SwsContext *c, int nb_threads);
+
+void ff_sws_thread_free(SwsContext *c);
+
+/**
+ * Run func for the jobs 0 to nb_jobs - 1 in the worker threads of c and
+ * wait for all of them to finish.
+ */
+void ff_sws_thread_execute(SwsContext *c, sws_thread_func *func, void *arg,
+                           int nb_jobs);
+
+/**
+ * Parameters of one call to the filter initialization, all of which the
+ * computed filter depends on.
+ */
+typedef struct SwsFilterKey {
+    int xInc, srcW, dstW;
+    int filterAlign, one, flags, cpu_flags;
+    int srcPos, dstPos;
+    double param[2];
+} SwsFilterKey;
+
+typedef struct SwsFilterPool SwsFilterPool;
+
+SwsFilterPool *ff_sws_filter_pool_alloc(void);
+
+void ff_sws_filter_pool_free(SwsFilterPool **pool);
+
+/**
+ * Look up the filter computed for key.
+ *
+ * @return 1 and new references to the filter coefficients and positions
+ *         if found, 0 otherwise
+ */
+int ff_sws_filter_pool_get(SwsFilterPool *pool, const SwsFilterKey *key,
+                           AVBufferRef **filter, AVBufferRef **filter_pos,
+                           int *filter_size);
+
+/**
+ * Add the filter computed for key to the pool, which takes new references
+ * to filter and filter_pos.
+ */
+int ff_sws_filter_pool_add(SwsFilterPool *pool, const SwsFilterKey *key,
+                           AVBufferRef *filter, AVBufferRef *filter_pos,
+                           int filter_size);
+
+/**
+ * Free the filters of the pool not used by any context anymore.
+ */
+void ff_sws_filter_pool_prune(SwsFilterPool *pool);
+
 /*
  function for applying ring buffer logic into slice s
  It checks if the slice can hold more @lum lines, if yes
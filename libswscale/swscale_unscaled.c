@@ -206,88 +206,58 @@ static int planarToP010Wrapper(SwsContext *c, const uint8_t *src8[],
     const uint16_t **src = (const uint16_t**)src8;
     uint16_t *dstY = (uint16_t*)(dstParam8[0] + dstStride[0] * srcSliceY);
     uint16_t *dstUV = (uint16_t*)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
-    int x, y;
 
     av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 || srcStride[2] % 2 ||
                  dstStride[0] % 2 || dstStride[1] % 2));
 
-    for (y = 0; y < srcSliceH; y++) {
-        uint16_t *tdstY = dstY;
-        const uint16_t *tsrc0 = src[0];
-        for (x = c->srcW; x > 0; x--) {
-            *tdstY++ = *tsrc0++ << 6;
-        }
-        src[0] += srcStride[0] / 2;
-        dstY += dstStride[0] / 2;
-
-        if (!(y & 1)) {
-            uint16_t *tdstUV = dstUV;
-            const uint16_t *tsrc1 = src[1];
-            const uint16_t *tsrc2 = src[2];
-            for (x = c->srcW / 2; x > 0; x--) {
-                *tdstUV++ = *tsrc1++ << 6;
-                *tdstUV++ = *tsrc2++ << 6;
-            }
-            src[1] += srcStride[1] / 2;
-            src[2] += srcStride[2] / 2;
-            dstUV += dstStride[1] / 2;
-        }
-    }
+    shiftWords(src[0], dstY, c->srcW, srcSliceH, srcStride[0], dstStride[0], 6);
+    interleaveWords(src[1], src[2], dstUV, c->srcW / 2, (srcSliceH + 1) / 2,
+                    srcStride[1], srcStride[2], dstStride[1], 6);
 
     return srcSliceH;
 }
 
-#if AV_HAVE_BIGENDIAN
-#define output_pixel(p, v) do { \
-        uint16_t *pp = (p); \
-        AV_WL16(pp, (v)); \
-    } while(0)
-#else
-#define output_pixel(p, v) (*p) = (v)
-#endif
+static int p010ToPlanarWrapper(SwsContext *c, const uint8_t *src8[],
+                               int srcStride[], int srcSliceY,
+                               int srcSliceH, uint8_t *dstParam8[],
+                               int dstStride[])
+{
+    const uint16_t **src = (const uint16_t**)src8;
+    uint16_t *dstY = (uint16_t*)(dstParam8[0] + dstStride[0] * srcSliceY);
+    uint16_t *dstU = (uint16_t*)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
+    uint16_t *dstV = (uint16_t*)(dstParam8[2] + dstStride[2] * srcSliceY / 2);
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2 || dstStride[2] % 2));
+
+    shiftWordsRight(src[0], dstY, c->srcW, srcSliceH, srcStride[0],
+                    dstStride[0], 6);
+    deinterleaveWords(src[1], dstU, dstV, c->srcW / 2, (srcSliceH + 1) / 2,
+                      srcStride[1], dstStride[1], dstStride[2], 6);
+
+    return srcSliceH;
+}
 
 static int planar8ToP01xleWrapper(SwsContext *c, const uint8_t *src[],
                                   int srcStride[], int srcSliceY,
                                   int srcSliceH, uint8_t *dstParam8[],
                                   int dstStride[])
 {
-    uint16_t *dstY = (uint16_t*)(dstParam8[0] + dstStride[0] * srcSliceY);
-    uint16_t *dstUV = (uint16_t*)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
-    int x, y, t;
+    uint8_t *dstY  = dstParam8[0] + dstStride[0] * srcSliceY;
+    uint8_t *dstUV = dstParam8[1] + dstStride[1] * srcSliceY / 2;
 
     av_assert0(!(dstStride[0] % 2 || dstStride[1] % 2));
 
-    for (y = 0; y < srcSliceH; y++) {
-        uint16_t *tdstY = dstY;
-        const uint8_t *tsrc0 = src[0];
-        for (x = c->srcW; x > 0; x--) {
-            t = *tsrc0++;
-            output_pixel(tdstY++, t | (t << 8));
-        }
-        src[0] += srcStride[0];
-        dstY += dstStride[0] / 2;
-
-        if (!(y & 1)) {
-            uint16_t *tdstUV = dstUV;
-            const uint8_t *tsrc1 = src[1];
-            const uint8_t *tsrc2 = src[2];
-            for (x = c->srcW / 2; x > 0; x--) {
-                t = *tsrc1++;
-                output_pixel(tdstUV++, t | (t << 8));
-                t = *tsrc2++;
-                output_pixel(tdstUV++, t | (t << 8));
-            }
-            src[1] += srcStride[1];
-            src[2] += srcStride[2];
-            dstUV += dstStride[1] / 2;
-        }
-    }
+    /* t | t << 8 in little endian is the byte t twice */
+    interleaveBytes(src[0], src[0], dstY, c->srcW, srcSliceH,
+                    srcStride[0], srcStride[0], dstStride[0]);
+    interleaveBytesToWords(src[1], src[2], dstUV, c->srcW / 2,
+                           (srcSliceH + 1) / 2, srcStride[1], srcStride[2],
+                           dstStride[1]);
 
     return srcSliceH;
 }
 
-#undef output_pixel
-
 static int planarToYuy2Wrapper(SwsContext *c, const uint8_t *src[],
                                int srcStride[], int srcSliceY, int srcSliceH,
                                uint8_t *dstParam[], int dstStride[])
@@ -1696,7 +1666,8 @@ void ff_get_unscaled_swscale(SwsContext *c)
     }
     /* yuv2bgr */
     if ((srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUV422P ||
-         srcFormat == AV_PIX_FMT_YUVA420P) && isAnyRGB(dstFormat) &&
+         srcFormat == AV_PIX_FMT_YUVA420P || srcFormat == AV_PIX_FMT_NV12 ||
+         srcFormat == AV_PIX_FMT_NV21) && isAnyRGB(dstFormat) &&
         !(flags & SWS_ACCURATE_RND) && (c->dither == SWS_DITHER_BAYER || c->dither == SWS_DITHER_AUTO) && !(dstH & 1)) {
         c->swscale = ff_yuv2rgb_get_func_ptr(c);
     }
@@ -1705,6 +1676,10 @@ void ff_get_unscaled_swscale(SwsContext *c)
         dstFormat == AV_PIX_FMT_P010) {
         c->swscale = planarToP010Wrapper;
     }
+    /* p010_to_yuv420p10 */
+    if (srcFormat == AV_PIX_FMT_P010 && dstFormat == AV_PIX_FMT_YUV420P10) {
+        c->swscale = p010ToPlanarWrapper;
+    }
     /* yuv420p_to_p010le */
     if ((srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVA420P) &&
         dstFormat == AV_PIX_FMT_P010LE) {
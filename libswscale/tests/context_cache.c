@@ -0,0 +1,244 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check the hits and the least recently used eviction of SwsContextCache,
+ * also for parameters sws_init_context() changes in the context, and that
+ * its contexts, sharing their filters, scale exactly like the contexts of
+ * sws_getContext(), also after the context which computed the shared
+ * filters was freed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "libswscale/swscale.h"
+
+#define SRC_W 96
+#define SRC_H 64
+#define DST_W 56
+#define DST_H 40
+
+static uint8_t *src_data[4];
+static int src_linesize[4];
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                \
+                    __FILE__, __LINE__, #cond);                         \
+            return 1;                                                   \
+        }                                                               \
+    } while (0)
+
+static int check_stats(const SwsContextCache *cache, int64_t hits,
+                       int64_t misses)
+{
+    int64_t h, m;
+
+    sws_context_cache_stats(cache, &h, &m, NULL);
+    if (h != hits || m != misses) {
+        fprintf(stderr, "%"PRId64" hits and %"PRId64" misses, expected "
+                "%"PRId64" and %"PRId64"\n", h, m, hits, misses);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Scale the source picture with c and with a new context of sws_getContext()
+ * for the same parameters, and compare the outputs.
+ *
+ * @return 0 if they are identical, 1 otherwise
+ */
+static int check_output(struct SwsContext *c, enum AVPixelFormat dst_format,
+                        int flags)
+{
+    struct SwsContext *ref;
+    uint8_t *dst[2][4] = { { NULL } }, *buf[2] = { NULL };
+    int linesize[2][4], i, size, ret = 1;
+
+    ref = sws_getContext(SRC_W, SRC_H, AV_PIX_FMT_YUV420P,
+                         DST_W, DST_H, dst_format, flags, NULL, NULL, NULL);
+    size = av_image_get_buffer_size(dst_format, DST_W, DST_H, 1);
+    if (!ref || size < 0)
+        goto end;
+
+    for (i = 0; i < 2; i++) {
+        buf[i] = av_malloc(size);
+        if (!buf[i] ||
+            av_image_alloc(dst[i], linesize[i], DST_W, DST_H, dst_format, 32) < 0)
+            goto end;
+        sws_scale(i ? ref : c, (const uint8_t * const *)src_data, src_linesize,
+                  0, SRC_H, dst[i], linesize[i]);
+        av_image_copy_to_buffer(buf[i], size, (const uint8_t * const *)dst[i],
+                                linesize[i], dst_format, DST_W, DST_H, 1);
+    }
+    ret = !!memcmp(buf[0], buf[1], size);
+    if (ret)
+        fprintf(stderr, "cached context output differs from sws_getContext()\n");
+
+end:
+    for (i = 0; i < 2; i++) {
+        av_freep(&dst[i][0]);
+        av_freep(&buf[i]);
+    }
+    sws_freeContext(ref);
+    return ret;
+}
+
+static int test_lru(void)
+{
+    SwsContextCache *cache = sws_context_cache_alloc(2);
+    struct SwsContext *a, *b;
+
+#define GET(w) sws_context_cache_get(cache, SRC_W, SRC_H, AV_PIX_FMT_YUV420P, \
+                                     w, DST_H, AV_PIX_FMT_YUV420P,            \
+                                     SWS_BILINEAR, NULL)
+    CHECK(cache);
+
+    a = GET(DST_W);
+    CHECK(a);
+    CHECK(GET(DST_W) == a);
+    CHECK(!check_stats(cache, 1, 1));
+
+    b = GET(DST_W / 2);
+    CHECK(b && b != a);
+    CHECK(!check_stats(cache, 1, 2));
+
+    /* a becomes the most recently used, so the third context evicts b */
+    CHECK(GET(DST_W) == a);
+    CHECK(GET(DST_W / 4));
+    CHECK(!check_stats(cache, 2, 3));
+    CHECK(GET(DST_W) == a);
+    CHECK(!check_stats(cache, 3, 3));
+    CHECK(GET(DST_W / 2));
+    CHECK(!check_stats(cache, 3, 4));
+#undef GET
+
+    sws_context_cache_free(&cache);
+    CHECK(!cache);
+    return 0;
+}
+
+/* sws_init_context() changes the flags of these contexts, which must still
+ * be found with the requested ones */
+static int test_requested_params(void)
+{
+    static const struct {
+        int dst_w;
+        enum AVPixelFormat dst_format;
+        int flags;
+    } params[] = {
+        { DST_W,     AV_PIX_FMT_YUV420P, 0                  },
+        { DST_W - 1, AV_PIX_FMT_RGB24,   SWS_BILINEAR       },
+        { DST_W,     AV_PIX_FMT_GBRP,    SWS_BICUBIC        },
+        { 6,         AV_PIX_FMT_YUV420P, SWS_FAST_BILINEAR  },
+    };
+    SwsContextCache *cache = sws_context_cache_alloc(FF_ARRAY_ELEMS(params));
+    struct SwsContext *c;
+    int i;
+
+    CHECK(cache);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(params); i++) {
+        c = sws_context_cache_get(cache, SRC_W, SRC_H, AV_PIX_FMT_YUV420P,
+                                  params[i].dst_w, DST_H, params[i].dst_format,
+                                  params[i].flags, NULL);
+        CHECK(c);
+        CHECK(sws_context_cache_get(cache, SRC_W, SRC_H, AV_PIX_FMT_YUV420P,
+                                    params[i].dst_w, DST_H,
+                                    params[i].dst_format, params[i].flags,
+                                    NULL) == c);
+        CHECK(!check_stats(cache, i + 1, i + 1));
+    }
+
+    sws_context_cache_free(&cache);
+    CHECK(!cache);
+    return 0;
+}
+
+static int test_shared_filters(int flags)
+{
+    SwsContextCache *cache = sws_context_cache_alloc(2);
+    struct SwsContext *a, *b;
+    int64_t shared;
+
+    CHECK(cache);
+
+    /* the contexts only differ in their output format */
+    a = sws_context_cache_get(cache, SRC_W, SRC_H, AV_PIX_FMT_YUV420P,
+                              DST_W, DST_H, AV_PIX_FMT_YUV420P, flags, NULL);
+    CHECK(a);
+    sws_context_cache_stats(cache, NULL, NULL, &shared);
+    CHECK(shared == 0);
+
+    b = sws_context_cache_get(cache, SRC_W, SRC_H, AV_PIX_FMT_YUV420P,
+                              DST_W, DST_H, AV_PIX_FMT_NV12, flags, NULL);
+    CHECK(b && b != a);
+    sws_context_cache_stats(cache, NULL, NULL, &shared);
+    CHECK(shared > 0);
+
+    CHECK(!check_output(a, AV_PIX_FMT_YUV420P, flags));
+    CHECK(!check_output(b, AV_PIX_FMT_NV12,    flags));
+
+    /* evict a, which computed the filters b still uses */
+    CHECK(sws_context_cache_get(cache, SRC_W, SRC_H, AV_PIX_FMT_YUV420P,
+                                DST_W / 2, DST_H / 2, AV_PIX_FMT_YUV420P,
+                                flags, NULL));
+    CHECK(sws_context_cache_get(cache, SRC_W, SRC_H, AV_PIX_FMT_YUV420P,
+                                DST_W, DST_H, AV_PIX_FMT_NV12,
+                                flags, NULL) == b);
+    CHECK(!check_output(b, AV_PIX_FMT_NV12, flags));
+
+    sws_context_cache_free(&cache);
+    CHECK(!cache);
+    return 0;
+}
+
+int main(void)
+{
+    static const int flags[] = { SWS_BILINEAR, SWS_BICUBIC, SWS_LANCZOS };
+    AVLFG lfg;
+    int i, x, y, ret = 0;
+
+    if (av_image_alloc(src_data, src_linesize, SRC_W, SRC_H,
+                       AV_PIX_FMT_YUV420P, 32) < 0)
+        return 1;
+    av_lfg_init(&lfg, 1);
+    for (i = 0; i < 3; i++) {
+        const int w = i ? SRC_W / 2 : SRC_W;
+        const int h = i ? SRC_H / 2 : SRC_H;
+        for (y = 0; y < h; y++)
+            for (x = 0; x < w; x++)
+                src_data[i][y * src_linesize[i] + x] = av_lfg_get(&lfg);
+    }
+
+    ret |= test_lru();
+    ret |= test_requested_params();
+    for (i = 0; i < FF_ARRAY_ELEMS(flags); i++)
+        ret |= test_shared_filters(flags[i]);
+
+    av_freep(&src_data[0]);
+    return ret;
+}
@@ -0,0 +1,205 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Compare the speed and quality of SWS_LOW_PRECISION with the default path.
+ * Both are measured against the accurate rounding output of the same
+ * algorithm, on a synthetic picture downscaled to a few preview sizes.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/cpu.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+
+#include "libswscale/swscale.h"
+
+typedef struct Picture {
+    uint8_t *data[4];
+    int linesize[4];
+    int w, h;
+} Picture;
+
+static int alloc_picture(Picture *p, int w, int h)
+{
+    p->w = w;
+    p->h = h;
+    return av_image_alloc(p->data, p->linesize, w, h, AV_PIX_FMT_YUV420P, 32);
+}
+
+/* gradients, sharp edges and noise */
+static void fill_picture(Picture *p)
+{
+    AVLFG lfg;
+    int x, y;
+
+    av_lfg_init(&lfg, 1);
+    for (y = 0; y < p->h; y++)
+        for (x = 0; x < p->w; x++) {
+            int v = x * 160 / p->w + ((x / 64 + y / 64) & 1) * 64 +
+                    (av_lfg_get(&lfg) & 31);
+            p->data[0][y * p->linesize[0] + x] = v;
+        }
+    for (y = 0; y < p->h / 2; y++)
+        for (x = 0; x < p->w / 2; x++) {
+            p->data[1][y * p->linesize[1] + x] = 64 + y * 128 / p->h +
+                                                 (av_lfg_get(&lfg) & 15);
+            p->data[2][y * p->linesize[2] + x] = 192 - x * 128 / p->w +
+                                                 (av_lfg_get(&lfg) & 15);
+        }
+}
+
+static double psnr(const Picture *a, const Picture *b)
+{
+    uint64_t ssd = 0, count = 0;
+    int plane, x, y;
+
+    for (plane = 0; plane < 3; plane++) {
+        int w = plane ? a->w / 2 : a->w;
+        int h = plane ? a->h / 2 : a->h;
+        for (y = 0; y < h; y++)
+            for (x = 0; x < w; x++) {
+                int d = a->data[plane][y * a->linesize[plane] + x] -
+                        b->data[plane][y * b->linesize[plane] + x];
+                ssd += d * d;
+            }
+        count += w * h;
+    }
+    if (!ssd)
+        return INFINITY;
+    return 10 * log10(255.0 * 255 * count / ssd);
+}
+
+/* Scale src to dst nb_frames times, returning the time of the fastest frame
+ * in us, which is less disturbed by other processes than the mean. */
+static double scale(const Picture *src, Picture *dst, int flags, int nb_frames)
+{
+    struct SwsContext *sws;
+    int64_t t, t_min = INT64_MAX;
+    int i;
+
+    sws = sws_getContext(src->w, src->h, AV_PIX_FMT_YUV420P,
+                         dst->w, dst->h, AV_PIX_FMT_YUV420P,
+                         flags, NULL, NULL, NULL);
+    if (!sws)
+        return -1;
+
+    for (i = 0; i < nb_frames; i++) {
+        t = av_gettime_relative();
+        sws_scale(sws, (const uint8_t * const *)src->data, src->linesize,
+                  0, src->h, dst->data, dst->linesize);
+        t_min = FFMIN(t_min, av_gettime_relative() - t);
+    }
+
+    sws_freeContext(sws);
+    return t_min;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct {
+        int flags;
+        const char *name;
+    } algorithms[] = {
+        { SWS_BILINEAR, "bilinear" },
+        { SWS_BICUBIC,  "bicubic"  },
+    };
+    static const int scales[] = { 2, 3, 4, 8 };
+    Picture src = { { 0 } };
+    int src_w = 1920, src_h = 1080, nb_frames = 50;
+    int a, s, i;
+
+    for (i = 1; i < argc; i += 2) {
+        if (argv[i][0] != '-' || i + 1 == argc)
+            goto bad_option;
+        if (!strcmp(argv[i], "-cpuflags")) {
+            unsigned flags = av_get_cpu_flags();
+            if (av_parse_cpu_caps(&flags, argv[i + 1]) < 0) {
+                fprintf(stderr, "invalid cpu flags %s\n", argv[i + 1]);
+                return 1;
+            }
+            av_force_cpu_flags(flags);
+        } else if (!strcmp(argv[i], "-size")) {
+            if (sscanf(argv[i + 1], "%dx%d", &src_w, &src_h) != 2 ||
+                src_w < 16 || src_h < 16 || src_w > 8192 || src_h > 8192) {
+                fprintf(stderr, "invalid size %s\n", argv[i + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "-frames")) {
+            nb_frames = atoi(argv[i + 1]);
+            if (nb_frames <= 0) {
+                fprintf(stderr, "invalid number of frames %s\n", argv[i + 1]);
+                return 1;
+            }
+        } else {
+bad_option:
+            fprintf(stderr, "bad option or argument missing (%s)\n", argv[i]);
+            fprintf(stderr, "usage: %s [-cpuflags flags] [-size WxH] "
+                    "[-frames n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (alloc_picture(&src, src_w, src_h) < 0)
+        return 1;
+    fill_picture(&src);
+
+    printf("%-9s %-11s %12s %12s %8s %12s %12s\n", "algorithm", "size",
+           "default us", "low us", "speedup", "default dB", "low dB");
+
+    for (a = 0; a < FF_ARRAY_ELEMS(algorithms); a++) {
+        for (s = 0; s < FF_ARRAY_ELEMS(scales); s++) {
+            const int flags = algorithms[a].flags;
+            Picture ref = { { 0 } }, def = { { 0 } }, low = { { 0 } };
+            int dst_w = FFALIGN(src_w / scales[s], 2);
+            int dst_h = FFALIGN(src_h / scales[s], 2);
+            double t_def, t_low;
+
+            if (alloc_picture(&ref, dst_w, dst_h) < 0 ||
+                alloc_picture(&def, dst_w, dst_h) < 0 ||
+                alloc_picture(&low, dst_w, dst_h) < 0)
+                goto next;
+
+            if (scale(&src, &ref, flags | SWS_ACCURATE_RND, 1) < 0 ||
+                (t_def = scale(&src, &def, flags, nb_frames)) < 0 ||
+                (t_low = scale(&src, &low, flags | SWS_LOW_PRECISION,
+                               nb_frames)) < 0) {
+                fprintf(stderr, "failed to scale to %dx%d\n", dst_w, dst_h);
+                goto next;
+            }
+
+            printf("%-9s %4dx%-6d %12.1f %12.1f %8.2f %12.2f %12.2f\n",
+                   algorithms[a].name, dst_w, dst_h, t_def, t_low,
+                   t_def / t_low, psnr(&ref, &def), psnr(&ref, &low));
+next:
+            av_freep(&ref.data[0]);
+            av_freep(&def.data[0]);
+            av_freep(&low.data[0]);
+        }
+    }
+
+    av_freep(&src.data[0]);
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that the contexts scaling whole frames with several threads give
+ * exactly the output of a single threaded context, for scaled format pairs
+ * with odd heights, 4:2:0 outputs whose bands start on chroma lines, and
+ * packed RGB outputs written with unpadded strides.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+
+/* room for the SIMD functions writing past the end of the last line */
+#define DST_PADDING 64
+
+static const struct {
+    enum AVPixelFormat src_format;
+    int src_w, src_h;
+    enum AVPixelFormat dst_format;
+    int dst_w, dst_h;
+    int flags;
+} tests[] = {
+    { AV_PIX_FMT_YUV420P,    96,  64, AV_PIX_FMT_YUV420P,   160, 121, SWS_BICUBIC       },
+    { AV_PIX_FMT_YUV420P,   352, 287, AV_PIX_FMT_YUV420P,   177,  99, SWS_BILINEAR      },
+    { AV_PIX_FMT_YUV420P,    97,  63, AV_PIX_FMT_RGB24,     173, 111, SWS_BILINEAR      },
+    { AV_PIX_FMT_YUV420P,    97,  63, AV_PIX_FMT_BGR24,     174, 111, SWS_BILINEAR      },
+    { AV_PIX_FMT_YUV420P,    80,  60, AV_PIX_FMT_RGB565,    102,  97, SWS_BICUBIC       },
+    { AV_PIX_FMT_NV12,       64,  48, AV_PIX_FMT_BGRA,      150, 113, SWS_FAST_BILINEAR },
+    { AV_PIX_FMT_YUV422P10, 128,  96, AV_PIX_FMT_YUV420P,   200, 147, SWS_LANCZOS       },
+    { AV_PIX_FMT_RGB24,     131,  77, AV_PIX_FMT_YUV420P,   262, 155, SWS_BICUBIC       },
+    { AV_PIX_FMT_YUV420P,    64,  48, AV_PIX_FMT_YUV420P10, 128,  95, SWS_BICUBIC       },
+    { AV_PIX_FMT_GRAY8,      50,  40, AV_PIX_FMT_YUV444P,    99,  75, SWS_AREA          },
+};
+
+static const int nb_threads[] = { 2, 3, 8 };
+
+static struct SwsContext *get_context(int i, int threads)
+{
+    struct SwsContext *c = sws_alloc_context();
+
+    if (!c)
+        return NULL;
+    av_opt_set_int(c, "srcw",       tests[i].src_w,      0);
+    av_opt_set_int(c, "srch",       tests[i].src_h,      0);
+    av_opt_set_int(c, "src_format", tests[i].src_format, 0);
+    av_opt_set_int(c, "dstw",       tests[i].dst_w,      0);
+    av_opt_set_int(c, "dsth",       tests[i].dst_h,      0);
+    av_opt_set_int(c, "dst_format", tests[i].dst_format, 0);
+    av_opt_set_int(c, "sws_flags",  tests[i].flags,      0);
+    av_opt_set_int(c, "threads",    threads,             0);
+    if (sws_init_context(c, NULL, NULL) < 0) {
+        sws_freeContext(c);
+        return NULL;
+    }
+    return c;
+}
+
+/**
+ * Scale src with c into a buffer holding the picture with unpadded
+ * strides, filled with 0xAA beforehand so that stray writes show up.
+ *
+ * @return the buffer, or NULL on error
+ */
+static uint8_t *scale(struct SwsContext *c, int i, uint8_t *src[4],
+                      int src_linesize[4], int size)
+{
+    uint8_t *dst[4], *buf = av_malloc(size + DST_PADDING);
+    int linesize[4];
+
+    if (!buf)
+        return NULL;
+    memset(buf, 0xAA, size + DST_PADDING);
+    if (av_image_fill_arrays(dst, linesize, buf, tests[i].dst_format,
+                             tests[i].dst_w, tests[i].dst_h, 1) < 0 ||
+        sws_scale(c, (const uint8_t * const *)src, src_linesize, 0,
+                  tests[i].src_h, dst, linesize) != tests[i].dst_h) {
+        av_free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+static int run_test(int i, AVLFG *lfg)
+{
+    struct SwsContext *ref = NULL;
+    uint8_t *src[4] = { NULL }, *buf_ref = NULL;
+    int src_linesize[4], size, j, ret = 1;
+
+    size = av_image_alloc(src, src_linesize, tests[i].src_w, tests[i].src_h,
+                          tests[i].src_format, 32);
+    if (size < 0)
+        goto end;
+    for (j = 0; j < size; j++)
+        src[0][j] = av_lfg_get(lfg);
+
+    size = av_image_get_buffer_size(tests[i].dst_format, tests[i].dst_w,
+                                    tests[i].dst_h, 1);
+    ref  = get_context(i, 1);
+    if (size < 0 || !ref || !(buf_ref = scale(ref, i, src, src_linesize, size)))
+        goto end;
+
+    for (j = 0; j < FF_ARRAY_ELEMS(nb_threads); j++) {
+        struct SwsContext *c = get_context(i, nb_threads[j]);
+        uint8_t *buf = c ? scale(c, i, src, src_linesize, size) : NULL;
+        int diff = !buf || memcmp(buf, buf_ref, size);
+
+        if (diff)
+            fprintf(stderr, "%s %dx%d -> %s %dx%d flags 0x%x: %d threads %s\n",
+                    av_get_pix_fmt_name(tests[i].src_format),
+                    tests[i].src_w, tests[i].src_h,
+                    av_get_pix_fmt_name(tests[i].dst_format),
+                    tests[i].dst_w, tests[i].dst_h, tests[i].flags,
+                    nb_threads[j], buf ? "differ from 1 thread" : "failed");
+        av_free(buf);
+        sws_freeContext(c);
+        if (diff)
+            goto end;
+    }
+    ret = 0;
+
+end:
+    av_freep(&src[0]);
+    av_free(buf_ref);
+    sws_freeContext(ref);
+    return ret;
+}
+
+int main(void)
+{
+    AVLFG lfg;
+    int i, ret = 0;
+
+    av_lfg_init(&lfg, 0x5453);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(tests); i++) {
+        if (run_test(i, &lfg)) {
+            fprintf(stderr, "test %d failed\n", i);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
@@ -328,8 +328,8 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
 
     emms_c(); // FIXME should not be required but IS (even for non-MMX versions)
 
-    // NOTE: the +3 is for the MMX(+1) / SSE(+3) scaler which reads over the end
-    FF_ALLOC_ARRAY_OR_GOTO(NULL, *filterPos, (dstW + 3), sizeof(**filterPos), fail);
+    // NOTE: the +7 is for the MMX(+1) / SSE(+3) / AVX2(+7) scaler which reads over the end
+    FF_ALLOC_ARRAY_OR_GOTO(NULL, *filterPos, (dstW + 7), sizeof(**filterPos), fail);
 
     if (FFABS(xInc - 0x10000) < 10 && srcPos == dstPos) { // unscaled
         int i;
@@ -670,7 +670,7 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
     // Note the +1 is for the MMX scaler which reads over the end
     /* align at 16 for AltiVec (needed by hScale_altivec_real) */
     FF_ALLOCZ_ARRAY_OR_GOTO(NULL, *outFilter,
-                            (dstW + 3), *outFilterSize * sizeof(int16_t), fail);
+                            (dstW + 7), *outFilterSize * sizeof(int16_t), fail);
 
     /* normalize & store in outFilter */
     for (i = 0; i < dstW; i++) {
@@ -694,16 +694,13 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
         }
     }
 
-    (*filterPos)[dstW + 0] =
-    (*filterPos)[dstW + 1] =
-    (*filterPos)[dstW + 2] = (*filterPos)[dstW - 1]; /* the MMX/SSE scaler will
-                                                      * read over the end */
-    for (i = 0; i < *outFilterSize; i++) {
-        int k = (dstW - 1) * (*outFilterSize) + i;
-        (*outFilter)[k + 1 * (*outFilterSize)] =
-        (*outFilter)[k + 2 * (*outFilterSize)] =
-        (*outFilter)[k + 3 * (*outFilterSize)] = (*outFilter)[k];
-    }
+    /* the MMX/SSE/AVX2 scaler will read over the end */
+    for (i = dstW; i < dstW + 7; i++)
+        (*filterPos)[i] = (*filterPos)[dstW - 1];
+    for (i = dstW; i < dstW + 7; i++)
+        memcpy(*outFilter + i * (*outFilterSize),
+               *outFilter + (dstW - 1) * (*outFilterSize),
+               *outFilterSize * sizeof(**outFilter));
 
     ret = 0;
 
@@ -715,6 +712,113 @@ fail:
     return ret;
 }
 
+/**
+ * initFilter() for the filter idx (hLum, hChr, vLum, vChr) of c, taking it
+ * from the filter pool of c if it was already computed with the same
+ * parameters, and adding it to the pool otherwise.
+ */
+static av_cold int init_pooled_filter(SwsContext *c, int idx,
+                                      int16_t **outFilter, int32_t **filterPos,
+                                      int *outFilterSize, int xInc, int srcW,
+                                      int dstW, int filterAlign, int one,
+                                      int flags, int cpu_flags,
+                                      SwsVector *srcFilter, SwsVector *dstFilter,
+                                      double param[2], int srcPos, int dstPos)
+{
+    SwsFilterKey key;
+    int ret;
+
+    if (!c->filter_pool || srcFilter || dstFilter)
+        return initFilter(outFilter, filterPos, outFilterSize, xInc, srcW,
+                          dstW, filterAlign, one, flags, cpu_flags,
+                          srcFilter, dstFilter, param, srcPos, dstPos);
+
+    // the keys are compared with memcmp(), padding included
+    memset(&key, 0, sizeof(key));
+    key.xInc        = xInc;
+    key.srcW        = srcW;
+    key.dstW        = dstW;
+    key.filterAlign = filterAlign;
+    key.one         = one;
+    key.flags       = flags;
+    key.cpu_flags   = cpu_flags;
+    key.srcPos      = srcPos;
+    key.dstPos      = dstPos;
+    key.param[0]    = param[0];
+    key.param[1]    = param[1];
+
+    if (ff_sws_filter_pool_get(c->filter_pool, &key, &c->filter_buf[idx],
+                               &c->filter_pos_buf[idx], outFilterSize)) {
+        *outFilter = (int16_t *)c->filter_buf[idx]->data;
+        *filterPos = (int32_t *)c->filter_pos_buf[idx]->data;
+        return 0;
+    }
+
+    ret = initFilter(outFilter, filterPos, outFilterSize, xInc, srcW, dstW,
+                     filterAlign, one, flags, cpu_flags, srcFilter, dstFilter,
+                     param, srcPos, dstPos);
+    if (ret < 0)
+        return ret;
+
+    c->filter_buf[idx] = av_buffer_create((uint8_t *)*outFilter,
+                                          (dstW + 7) * *outFilterSize * sizeof(**outFilter),
+                                          av_buffer_default_free, NULL, 0);
+    if (!c->filter_buf[idx])
+        return AVERROR(ENOMEM);
+    c->filter_pos_buf[idx] = av_buffer_create((uint8_t *)*filterPos,
+                                              (dstW + 7) * sizeof(**filterPos),
+                                              av_buffer_default_free, NULL, 0);
+    if (!c->filter_pos_buf[idx])
+        return AVERROR(ENOMEM);
+
+    return ff_sws_filter_pool_add(c->filter_pool, &key, c->filter_buf[idx],
+                                  c->filter_pos_buf[idx], *outFilterSize);
+}
+
+/**
+ * Quantize the 14 bit horizontal filter to the 6 bit layout of
+ * hLumFilter8/hChrFilter8 for SWS_LOW_PRECISION. The coefficients are rounded
+ * by their running sums so that each pixel still sums to 64.
+ *
+ * @return 0 on success, AVERROR(ERANGE) if the 16 bit accumulation could
+ *         overflow with this filter
+ */
+static av_cold int init_lowp_filter(int8_t **outFilter, const int16_t *filter,
+                                    int filterSize, int dstW)
+{
+    const int blocks = (filterSize + 3) >> 2;
+    const int w8     = FFALIGN(dstW, 8); // the filter is padded to dstW + 7
+    int8_t *f;
+    int i, j;
+
+    f = av_mallocz(w8 * blocks * 4);
+    if (!f)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < w8; i++) {
+        int8_t *dst = f + ((i >> 3) * blocks * 8 + (i & 7)) * 4;
+        int sum = 0, prev = 0, abs_sum = 0;
+
+        for (j = 0; j < filterSize; j++) {
+            int q;
+
+            sum  += filter[i * filterSize + j];
+            q     = ((sum + 128) >> 8) - prev;
+            prev += q;
+            abs_sum += FFABS(q);
+            dst[(j >> 2) * 32 + (j & 3)] = q;
+        }
+        // pixel * sum(|coeff|) bounds every partial sum of the SIMD code
+        if (abs_sum * 255 > INT16_MAX) {
+            av_free(f);
+            return AVERROR(ERANGE);
+        }
+    }
+
+    *outFilter = f;
+    return 0;
+}
+
 static void fill_rgb2yuv_table(SwsContext *c, const int table[4], int dstRange)
 {
     int64_t W, V, Z, Cy, Cu, Cv;
@@ -852,6 +956,7 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
     int need_reinit = 0;
+    int i;
 
     handle_formats(c);
     desc_dst = av_pix_fmt_desc_get(c->dstFormat);
@@ -891,6 +996,10 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     c->dstFormatBpp = av_get_bits_per_pixel(desc_dst);
     c->srcFormatBpp = av_get_bits_per_pixel(desc_src);
 
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange, table,
+                                 dstRange, brightness, contrast, saturation);
+
     if (c->cascaded_context[c->cascaded_mainindex])
         return sws_setColorspaceDetails(c->cascaded_context[c->cascaded_mainindex],inv_table, srcRange,table, dstRange, brightness,  contrast, saturation);
 
@@ -1144,6 +1253,95 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
+#if !HAVE_THREADS
+int ff_sws_thread_init(SwsContext *c, int nb_threads)
+{
+    return 1;
+}
+
+void ff_sws_thread_free(SwsContext *c)
+{
+}
+
+void ff_sws_thread_execute(SwsContext *c, sws_thread_func *func, void *arg,
+                           int nb_jobs)
+{
+}
+#endif
+
+/**
+ * Set up the threaded scaling of c, in bands of destination lines each
+ * scaled by a copy of c from the full source frame. The bands start on
+ * chroma lines so that no destination line is written by two threads.
+ */
+static av_cold int init_slice_contexts(SwsContext *c, SwsFilter *srcFilter,
+                                       SwsFilter *dstFilter)
+{
+    const int mask = (1 << c->chrDstVSubSample) - 1;
+    int nb_threads = c->nb_threads;
+    int i, j, ret;
+
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+    // the bands overlap by the vertical filter size, keep them large enough
+    nb_threads = FFMIN(nb_threads, c->dstH / 16);
+
+    // error diffusion carries its state from one line to the next
+    if (nb_threads <= 1 || c->dither == SWS_DITHER_ED)
+        return 0;
+
+    ret = ff_sws_thread_init(c, nb_threads);
+    if (ret <= 1)
+        return FFMIN(ret, 0);
+
+    c->slice_ctx = av_mallocz_array(nb_threads, sizeof(*c->slice_ctx));
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+    c->nb_slice_ctx = nb_threads;
+
+    for (i = 0; i < nb_threads; i++) {
+        SwsContext *s = c->slice_ctx[i] = sws_alloc_context();
+        if (!s)
+            return AVERROR(ENOMEM);
+
+        ret = av_opt_copy(s, c);
+        if (ret < 0)
+            return ret;
+        s->nb_threads  = 1;
+        s->flags      &= ~SWS_PRINT_INFO;
+        s->filter_pool = c->filter_pool;
+
+        ret = sws_init_context(s, srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
+        sws_setColorspaceDetails(s, c->srcColorspaceTable, c->srcRange,
+                                 c->dstColorspaceTable, c->dstRange,
+                                 c->brightness, c->contrast, c->saturation);
+
+        s->dst_slice_start = (c->dstH *  i      / nb_threads) & ~mask;
+        s->dst_slice_end   = (c->dstH * (i + 1) / nb_threads) & ~mask;
+        if (i == nb_threads - 1) {
+            s->dst_slice_end = c->dstH;
+            break;
+        }
+
+        ret = av_image_fill_linesizes(s->dst_slice_linesize, s->dstFormat,
+                                      s->dstW);
+        if (ret < 0)
+            return ret;
+        for (j = 0; j < 4; j++) {
+            if (!s->dst_slice_linesize[j])
+                continue;
+            // the SIMD functions write less than 64 bytes past the end
+            s->dst_slice_tmp[j] = av_malloc(FFALIGN(s->dst_slice_linesize[j], 64) + 64);
+            if (!s->dst_slice_tmp[j])
+                return AVERROR(ENOMEM);
+        }
+    }
+
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -1637,7 +1835,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                                     PPC_ALTIVEC(cpu_flags) ? 8 :
                                     have_neon(cpu_flags)   ? 8 : 1;
 
-            if ((ret = initFilter(&c->hLumFilter, &c->hLumFilterPos,
+            if ((ret = init_pooled_filter(c, 0, &c->hLumFilter, &c->hLumFilterPos,
                            &c->hLumFilterSize, c->lumXInc,
                            srcW, dstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
@@ -1646,7 +1844,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                            get_local_pos(c, 0, 0, 0),
                            get_local_pos(c, 0, 0, 0))) < 0)
                 goto fail;
-            if ((ret = initFilter(&c->hChrFilter, &c->hChrFilterPos,
+            if ((ret = init_pooled_filter(c, 1, &c->hChrFilter, &c->hChrFilterPos,
                            &c->hChrFilterSize, c->chrXInc,
                            c->chrSrcW, c->chrDstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
@@ -1664,7 +1862,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                                 PPC_ALTIVEC(cpu_flags) ? 8 :
                                 have_neon(cpu_flags)   ? 2 : 1;
 
-        if ((ret = initFilter(&c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
+        if ((ret = init_pooled_filter(c, 2, &c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
                        c->lumYInc, srcH, dstH, filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                        cpu_flags, srcFilter->lumV, dstFilter->lumV,
@@ -1672,7 +1870,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                        get_local_pos(c, 0, 0, 1),
                        get_local_pos(c, 0, 0, 1))) < 0)
             goto fail;
-        if ((ret = initFilter(&c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
+        if ((ret = init_pooled_filter(c, 3, &c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
                        c->chrYInc, c->chrSrcH, c->chrDstH,
                        filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
@@ -1703,6 +1901,27 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
 #endif
     }
 
+    if ((flags & SWS_LOW_PRECISION) &&
+        (flags & (SWS_BILINEAR | SWS_BICUBIC | SWS_BICUBLIN)) &&
+        !(flags & (SWS_FAST_BILINEAR | SWS_ACCURATE_RND | SWS_BITEXACT)) &&
+        c->srcBpc == 8 && c->dstBpc <= 14) {
+        ret = init_lowp_filter(&c->hLumFilter8, c->hLumFilter,
+                               c->hLumFilterSize, dstW);
+        if (!ret)
+            ret = init_lowp_filter(&c->hChrFilter8, c->hChrFilter,
+                                   c->hChrFilterSize, c->chrDstW);
+        if (ret == AVERROR(ENOMEM))
+            goto fail;
+        if (ret < 0) {
+            av_log(c, AV_LOG_VERBOSE,
+                   "filter out of range for low precision scaling\n");
+            av_freep(&c->hLumFilter8);
+            ret = 0;
+        } else if (flags & SWS_PRINT_INFO) {
+            av_log(c, AV_LOG_INFO, "using low precision horizontal scaler\n");
+        }
+    }
+
     for (i = 0; i < 4; i++)
         FF_ALLOCZ_OR_GOTO(c, c->dither_error[i], (c->dstW+2) * sizeof(int), fail);
 
@@ -1791,8 +2010,13 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
         }
     }
 
+    c->dst_slice_start = 0;
+    c->dst_slice_end   = dstH;
     c->swscale = ff_getSwsFunc(c);
-    return ff_init_filters(c);
+    ret = ff_init_filters(c);
+    if (ret < 0 || c->nb_threads == 1)
+        return ret;
+    return init_slice_contexts(c, srcFilter, dstFilter);
 fail: // FIXME replace things by appropriate error codes
     if (ret == RETCODE_USE_CASCADE)  {
         int tmpW = sqrt(srcW * (int64_t)dstW);
@@ -2277,13 +2501,33 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
-    for (i = 0; i < 4; i++)
+    for (i = 0; i < 4; i++) {
         av_freep(&c->dither_error[i]);
+        av_freep(&c->dst_slice_tmp[i]);
+    }
+
+    /* the pooled filters are freed with their last reference */
+    {
+        int16_t **filter[4]    = { &c->hLumFilter,    &c->hChrFilter,
+                                   &c->vLumFilter,    &c->vChrFilter    };
+        int32_t **filterPos[4] = { &c->hLumFilterPos, &c->hChrFilterPos,
+                                   &c->vLumFilterPos, &c->vChrFilterPos };
+        for (i = 0; i < 4; i++) {
+            if (c->filter_buf[i])
+                *filter[i] = NULL;
+            if (c->filter_pos_buf[i])
+                *filterPos[i] = NULL;
+            av_buffer_unref(&c->filter_buf[i]);
+            av_buffer_unref(&c->filter_pos_buf[i]);
+        }
+    }
 
     av_freep(&c->vLumFilter);
     av_freep(&c->vChrFilter);
     av_freep(&c->hLumFilter);
     av_freep(&c->hChrFilter);
+    av_freep(&c->hLumFilter8);
+    av_freep(&c->hChrFilter8);
 #if HAVE_ALTIVEC
     av_freep(&c->vYCoeffsBank);
     av_freep(&c->vCCoeffsBank);
@@ -2316,6 +2560,14 @@ void sws_freeContext(SwsContext *c)
     av_freep(&c->yuvTable);
     av_freep(&c->formatConvBuffer);
 
+    ff_sws_thread_free(c);
+    if (c->slice_ctx) {
+        for (i = 0; i < c->nb_slice_ctx; i++)
+            sws_freeContext(c->slice_ctx[i]);
+        av_freep(&c->slice_ctx);
+    }
+    c->nb_slice_ctx = 0;
+
     sws_freeContext(c->cascaded_context[0]);
     sws_freeContext(c->cascaded_context[1]);
     sws_freeContext(c->cascaded_context[2]);
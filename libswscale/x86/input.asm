@@ -23,7 +23,7 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
 
 %define RY 0x20DE
 %define GY 0x4087
@@ -35,8 +35,8 @@ SECTION_RODATA
 %define GV 0xD0E3
 %define BV 0xF6E4
 
-rgb_Yrnd:        times 4 dd 0x80100        ;  16.5 << 15
-rgb_UVrnd:       times 4 dd 0x400100       ; 128.5 << 15
+rgb_Yrnd:        times 8 dd 0x80100        ;  16.5 << 15
+rgb_UVrnd:       times 8 dd 0x400100       ; 128.5 << 15
 %define bgr_Ycoeff_12x4 16*4 + 16* 0 + tableq
 %define bgr_Ycoeff_3x56 16*4 + 16* 1 + tableq
 %define rgb_Ycoeff_12x4 16*4 + 16* 2 + tableq
@@ -96,6 +96,25 @@ shuf_rgb_3x56:   db 2, 0x80, 3, 0x80,  4, 0x80,  5, 0x80, \
 
 SECTION .text
 
+; The coefficient tables and the shuffles are 16 bytes wide, the ymm versions
+; use them in both lanes.
+%macro LOAD_LANES 2
+%if mmsize == 32
+    vbroadcasti128 %1, %2
+%else
+    mova           %1, %2
+%endif
+%endmacro
+
+; The output lines are only 16 byte aligned.
+%macro STORE_LINE 2
+%if mmsize == 32
+    movu           %1, %2
+%else
+    mova           %1, %2
+%endif
+%endmacro
+
 ;-----------------------------------------------------------------------------
 ; RGB to Y/UV.
 ;
@@ -115,8 +134,8 @@ cglobal %2 %+ 24ToY, 6, 6, %1, dst, src, u1, u2, w, table
 %define coeff1 m5
 %define coeff2 m6
 %elif ARCH_X86_64
-    mova           m8, [%2_Ycoeff_12x4]
-    mova           m9, [%2_Ycoeff_3x56]
+    LOAD_LANES     m8, [%2_Ycoeff_12x4]
+    LOAD_LANES     m9, [%2_Ycoeff_3x56]
 %define coeff1 m8
 %define coeff2 m9
 %else ; x86-32 && mmsize == 16
@@ -128,10 +147,10 @@ cglobal %2 %+ 24ToY, 6, 6, %1, dst, src, u1, u2, w, table
 %else ; (ARCH_X86_64 && %0 == 3) || mmsize == 8
 .body:
 %if cpuflag(ssse3)
-    mova           m7, [shuf_rgb_12x4]
+    LOAD_LANES     m7, [shuf_rgb_12x4]
 %define shuf_rgb1 m7
 %if ARCH_X86_64
-    mova          m10, [shuf_rgb_3x56]
+    LOAD_LANES    m10, [shuf_rgb_3x56]
 %define shuf_rgb2 m10
 %else ; x86-32
 %define shuf_rgb2 [shuf_rgb_3x56]
@@ -149,8 +168,15 @@ cglobal %2 %+ 24ToY, 6, 6, %1, dst, src, u1, u2, w, table
     mova           m4, [rgb_Yrnd]
 .loop:
 %if cpuflag(ssse3)
+%if mmsize == 32
+    movu          xm0, [srcq+0]           ; (byte) { Bx, Gx, Rx }[0-3]
+    movu          xm2, [srcq+12]          ; (byte) { Bx, Gx, Rx }[4-7]
+    vinserti128    m0, m0, [srcq+24], 1   ; (byte) { Bx, Gx, Rx }[8-11]
+    vinserti128    m2, m2, [srcq+36], 1   ; (byte) { Bx, Gx, Rx }[12-15]
+%else
     movu           m0, [srcq+0]           ; (byte) { Bx, Gx, Rx }[0-3]
     movu           m2, [srcq+12]          ; (byte) { Bx, Gx, Rx }[4-7]
+%endif
     pshufb         m1, m0, shuf_rgb2      ; (word) { R0, B1, G1, R1, R2, B3, G3, R3 }
     pshufb         m0, shuf_rgb1          ; (word) { B0, G0, R0, B1, B2, G2, R2, B3 }
     pshufb         m3, m2, shuf_rgb2      ; (word) { R4, B5, G5, R5, R6, B7, G7, R7 }
@@ -187,7 +213,7 @@ cglobal %2 %+ 24ToY, 6, 6, %1, dst, src, u1, u2, w, table
     psrad          m0, 9
     psrad          m2, 9
     packssdw       m0, m2                 ; (word) { Y[0-7] }
-    mova    [dstq+wq], m0
+    STORE_LINE [dstq+wq], m0
     add            wq, mmsize
     jl .loop
     REP_RET
@@ -199,10 +225,10 @@ cglobal %2 %+ 24ToY, 6, 6, %1, dst, src, u1, u2, w, table
 %macro RGB24_TO_UV_FN 2-3
 cglobal %2 %+ 24ToUV, 7, 7, %1, dstU, dstV, u1, src, u2, w, table
 %if ARCH_X86_64
-    mova           m8, [%2_Ucoeff_12x4]
-    mova           m9, [%2_Ucoeff_3x56]
-    mova          m10, [%2_Vcoeff_12x4]
-    mova          m11, [%2_Vcoeff_3x56]
+    LOAD_LANES     m8, [%2_Ucoeff_12x4]
+    LOAD_LANES     m9, [%2_Ucoeff_3x56]
+    LOAD_LANES    m10, [%2_Vcoeff_12x4]
+    LOAD_LANES    m11, [%2_Vcoeff_3x56]
 %define coeffU1 m8
 %define coeffU2 m9
 %define coeffV1 m10
@@ -218,10 +244,10 @@ cglobal %2 %+ 24ToUV, 7, 7, %1, dstU, dstV, u1, src, u2, w, table
 %else ; ARCH_X86_64 && %0 == 3
 .body:
 %if cpuflag(ssse3)
-    mova           m7, [shuf_rgb_12x4]
+    LOAD_LANES     m7, [shuf_rgb_12x4]
 %define shuf_rgb1 m7
 %if ARCH_X86_64
-    mova          m12, [shuf_rgb_3x56]
+    LOAD_LANES    m12, [shuf_rgb_3x56]
 %define shuf_rgb2 m12
 %else ; x86-32
 %define shuf_rgb2 [shuf_rgb_3x56]
@@ -242,8 +268,15 @@ cglobal %2 %+ 24ToUV, 7, 7, %1, dstU, dstV, u1, src, u2, w, table
 %endif
 .loop:
 %if cpuflag(ssse3)
+%if mmsize == 32
+    movu          xm0, [srcq+0]           ; (byte) { Bx, Gx, Rx }[0-3]
+    movu          xm4, [srcq+12]          ; (byte) { Bx, Gx, Rx }[4-7]
+    vinserti128    m0, m0, [srcq+24], 1   ; (byte) { Bx, Gx, Rx }[8-11]
+    vinserti128    m4, m4, [srcq+36], 1   ; (byte) { Bx, Gx, Rx }[12-15]
+%else
     movu           m0, [srcq+0]           ; (byte) { Bx, Gx, Rx }[0-3]
     movu           m4, [srcq+12]          ; (byte) { Bx, Gx, Rx }[4-7]
+%endif
     pshufb         m1, m0, shuf_rgb2      ; (word) { R0, B1, G1, R1, R2, B3, G3, R3 }
     pshufb         m0, shuf_rgb1          ; (word) { B0, G0, R0, B1, B2, G2, R2, B3 }
 %else ; !cpuflag(ssse3)
@@ -296,13 +329,8 @@ cglobal %2 %+ 24ToUV, 7, 7, %1, dstU, dstV, u1, src, u2, w, table
     psrad          m4, 9
     packssdw       m0, m1                 ; (word) { U[0-7] }
     packssdw       m2, m4                 ; (word) { V[0-7] }
-%if mmsize == 8
-    mova   [dstUq+wq], m0
-    mova   [dstVq+wq], m2
-%else ; mmsize == 16
-    mova   [dstUq+wq], m0
-    mova   [dstVq+wq], m2
-%endif ; mmsize == 8/16
+    STORE_LINE [dstUq+wq], m0
+    STORE_LINE [dstVq+wq], m2
     add            wq, mmsize
     jl .loop
     REP_RET
@@ -334,12 +362,17 @@ INIT_XMM avx
 RGB24_FUNCS 11, 13
 %endif
 
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+RGB24_FUNCS 11, 13
+%endif
+
 ; %1 = nr. of XMM registers
 ; %2-5 = rgba, bgra, argb or abgr (in individual characters)
 %macro RGB32_TO_Y_FN 5-6
 cglobal %2%3%4%5 %+ ToY, 6, 6, %1, dst, src, u1, u2, w, table
-    mova           m5, [rgba_Ycoeff_%2%4]
-    mova           m6, [rgba_Ycoeff_%3%5]
+    LOAD_LANES     m5, [rgba_Ycoeff_%2%4]
+    LOAD_LANES     m6, [rgba_Ycoeff_%3%5]
 %if %0 == 6
     jmp mangle(private_prefix %+ _ %+ %6 %+ ToY %+ SUFFIX).body
 %else ; %0 == 6
@@ -371,7 +404,10 @@ cglobal %2%3%4%5 %+ ToY, 6, 6, %1, dst, src, u1, u2, w, table
     psrad          m0, 9
     psrad          m2, 9
     packssdw       m0, m2                 ; (word) { Y[0-7] }
-    mova    [dstq+wq], m0
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+%endif
+    STORE_LINE [dstq+wq], m0
     add            wq, mmsize
     jl .loop
     sub            wq, mmsize - 1
@@ -379,7 +415,7 @@ cglobal %2%3%4%5 %+ ToY, 6, 6, %1, dst, src, u1, u2, w, table
     add            srcq, 2*mmsize - 2
     add            dstq, mmsize - 1
 .loop2:
-    movd           m0, [srcq+wq*2+0]      ; (byte) { Bx, Gx, Rx, xx }[0-3]
+    movd          xm0, [srcq+wq*2+0]      ; (byte) { Bx, Gx, Rx, xx }[0-3]
     DEINTB          1,  0,  3,  2,  7     ; (word) { Gx, xx (m0/m2) or Bx, Rx (m1/m3) }[0-3]/[4-7]
     pmaddwd        m1, m5                 ; (dword) { Bx*BY + Rx*RY }[0-3]
     pmaddwd        m0, m6                 ; (dword) { Gx*GY }[0-3]
@@ -387,7 +423,7 @@ cglobal %2%3%4%5 %+ ToY, 6, 6, %1, dst, src, u1, u2, w, table
     paddd          m0, m1                 ; (dword) { Y[0-3] }
     psrad          m0, 9
     packssdw       m0, m0                 ; (word) { Y[0-7] }
-    movd    [dstq+wq], m0
+    movd    [dstq+wq], xm0
     add            wq, 2
     jl .loop2
 .end:
@@ -400,10 +436,10 @@ cglobal %2%3%4%5 %+ ToY, 6, 6, %1, dst, src, u1, u2, w, table
 %macro RGB32_TO_UV_FN 5-6
 cglobal %2%3%4%5 %+ ToUV, 7, 7, %1, dstU, dstV, u1, src, u2, w, table
 %if ARCH_X86_64
-    mova           m8, [rgba_Ucoeff_%2%4]
-    mova           m9, [rgba_Ucoeff_%3%5]
-    mova          m10, [rgba_Vcoeff_%2%4]
-    mova          m11, [rgba_Vcoeff_%3%5]
+    LOAD_LANES     m8, [rgba_Ucoeff_%2%4]
+    LOAD_LANES     m9, [rgba_Ucoeff_%3%5]
+    LOAD_LANES    m10, [rgba_Vcoeff_%2%4]
+    LOAD_LANES    m11, [rgba_Vcoeff_%3%5]
 %define coeffU1 m8
 %define coeffU2 m9
 %define coeffV1 m10
@@ -459,13 +495,12 @@ cglobal %2%3%4%5 %+ ToUV, 7, 7, %1, dstU, dstV, u1, src, u2, w, table
     psrad          m1, 9
     packssdw       m0, m4                 ; (word) { U[0-7] }
     packssdw       m2, m1                 ; (word) { V[0-7] }
-%if mmsize == 8
-    mova   [dstUq+wq], m0
-    mova   [dstVq+wq], m2
-%else ; mmsize == 16
-    mova   [dstUq+wq], m0
-    mova   [dstVq+wq], m2
-%endif ; mmsize == 8/16
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+    vpermq         m2, m2, q3120
+%endif
+    STORE_LINE [dstUq+wq], m0
+    STORE_LINE [dstVq+wq], m2
     add            wq, mmsize
     jl .loop
     sub            wq, mmsize - 1
@@ -474,7 +509,7 @@ cglobal %2%3%4%5 %+ ToUV, 7, 7, %1, dstU, dstV, u1, src, u2, w, table
     add            dstUq, mmsize - 1
     add            dstVq, mmsize - 1
 .loop2:
-    movd           m0, [srcq+wq*2]        ; (byte) { Bx, Gx, Rx, xx }[0-3]
+    movd          xm0, [srcq+wq*2]        ; (byte) { Bx, Gx, Rx, xx }[0-3]
     DEINTB          1,  0,  5,  4,  7     ; (word) { Gx, xx (m0/m4) or Bx, Rx (m1/m5) }[0-3]/[4-7]
     pmaddwd        m3, m1, coeffV1        ; (dword) { Bx*BV + Rx*RV }[0-3]
     pmaddwd        m2, m0, coeffV2        ; (dword) { Gx*GV }[0-3]
@@ -488,8 +523,8 @@ cglobal %2%3%4%5 %+ ToUV, 7, 7, %1, dstU, dstV, u1, src, u2, w, table
     psrad          m2, 9
     packssdw       m0, m0                 ; (word) { U[0-7] }
     packssdw       m2, m2                 ; (word) { V[0-7] }
-    movd   [dstUq+wq], m0
-    movd   [dstVq+wq], m2
+    movd   [dstUq+wq], xm0
+    movd   [dstVq+wq], xm2
     add            wq, 2
     jl .loop2
 .end:
@@ -524,6 +559,11 @@ INIT_XMM avx
 RGB32_FUNCS 8, 12
 %endif
 
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+RGB32_FUNCS 8, 12
+%endif
+
 ;-----------------------------------------------------------------------------
 ; YUYV/UYVY/NV12/NV21 packed pixel shuffling.
 ;
@@ -547,7 +587,10 @@ RGB32_FUNCS 8, 12
     psrlw          m1, 8                  ; (word) { Y8, Y9, ..., Y15 }
 %endif ; yuyv/uyvy
     packuswb       m0, m1                 ; (byte) { Y0, ..., Y15 }
-    mova    [dstq+wq], m0
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+%endif
+    STORE_LINE [dstq+wq], m0
     add            wq, mmsize
     jl .loop_%1
     REP_RET
@@ -579,6 +622,9 @@ cglobal %2ToY, 5, 5, %1, dst, unused0, unused1, src, w
 .loop_u_start:
     neg            wq
     LOOP_YUYV_TO_Y  u, %2
+%elif mmsize == 32
+    neg            wq
+    LOOP_YUYV_TO_Y  u, %2
 %else ; mmsize == 8
     neg            wq
     LOOP_YUYV_TO_Y  a, %2
@@ -606,9 +652,17 @@ cglobal %2ToY, 5, 5, %1, dst, unused0, unused1, src, w
 %endif
 %endif ; yuyv/uyvy
     packuswb       m0, m1                 ; (byte) { U0, V0, ..., U7, V7 }
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+%endif
     pand           m1, m0, m2             ; (word) { U0, U1, ..., U7 }
     psrlw          m0, 8                  ; (word) { V0, V1, ..., V7 }
-%if mmsize == 16
+%if mmsize == 32
+    packuswb       m1, m0                 ; (byte) { U0, ... U7, V0, ... V7, U8, ... }
+    vpermq         m1, m1, q3120
+    movu   [dstUq+wq], xm1
+    vextracti128 [dstVq+wq], m1, 1
+%elif mmsize == 16
     packuswb       m1, m0                 ; (byte) { U0, ... U7, V1, ... V7 }
     movh   [dstUq+wq], m1
     movhps [dstVq+wq], m1
@@ -651,6 +705,9 @@ cglobal %2ToUV, 4, 5, %1, dstU, dstV, unused, src, w
 .loop_u_start:
     neg            wq
     LOOP_YUYV_TO_UV u, %2
+%elif mmsize == 32
+    neg            wq
+    LOOP_YUYV_TO_UV u, %2
 %else ; mmsize == 8
     neg            wq
     LOOP_YUYV_TO_UV a, %2
@@ -669,12 +726,16 @@ cglobal %2ToUV, 4, 5, %1, dstU, dstV, unused, src, w
     psrlw          m1, 8                  ; (word) { V8, V9, ..., V15 }
     packuswb       m2, m3                 ; (byte) { U0, ..., U15 }
     packuswb       m0, m1                 ; (byte) { V0, ..., V15 }
+%if mmsize == 32
+    vpermq         m2, m2, q3120
+    vpermq         m0, m0, q3120
+%endif
 %ifidn %2, nv12
-    mova   [dstUq+wq], m2
-    mova   [dstVq+wq], m0
+    STORE_LINE [dstUq+wq], m2
+    STORE_LINE [dstVq+wq], m0
 %else ; nv21
-    mova   [dstVq+wq], m2
-    mova   [dstUq+wq], m0
+    STORE_LINE [dstVq+wq], m2
+    STORE_LINE [dstUq+wq], m0
 %endif ; nv12/21
     add            wq, mmsize
     jl .loop_%1
@@ -705,6 +766,9 @@ cglobal %2ToUV, 4, 5, %1, dstU, dstV, unused, src, w
 .loop_u_start:
     neg            wq
     LOOP_NVXX_TO_UV u, %2
+%elif mmsize == 32
+    neg            wq
+    LOOP_NVXX_TO_UV u, %2
 %else ; mmsize == 8
     neg            wq
     LOOP_NVXX_TO_UV a, %2
@@ -738,3 +802,13 @@ YUYV_TO_UV_FN 3, uyvy, 1
 NVXX_TO_UV_FN 5, nv12
 NVXX_TO_UV_FN 5, nv21
 %endif
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+YUYV_TO_Y_FN  3, yuyv
+YUYV_TO_Y_FN  2, uyvy
+YUYV_TO_UV_FN 3, yuyv
+YUYV_TO_UV_FN 3, uyvy, 1
+NVXX_TO_UV_FN 5, nv12
+NVXX_TO_UV_FN 5, nv21
+%endif
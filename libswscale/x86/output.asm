@@ -22,20 +22,20 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
-
-minshort:      times 8 dw 0x8000
-yuv2yuvX_16_start:  times 4 dd 0x4000 - 0x40000000
-yuv2yuvX_10_start:  times 4 dd 0x10000
-yuv2yuvX_9_start:   times 4 dd 0x20000
-yuv2yuvX_10_upper:  times 8 dw 0x3ff
-yuv2yuvX_9_upper:   times 8 dw 0x1ff
-pd_4:          times 4 dd 4
-pd_4min0x40000:times 4 dd 4 - (0x40000)
-pw_16:         times 8 dw 16
-pw_32:         times 8 dw 32
-pw_512:        times 8 dw 512
-pw_1024:       times 8 dw 1024
+SECTION_RODATA 32
+
+minshort:      times 16 dw 0x8000
+yuv2yuvX_16_start:  times 8 dd 0x4000 - 0x40000000
+yuv2yuvX_10_start:  times 8 dd 0x10000
+yuv2yuvX_9_start:   times 8 dd 0x20000
+yuv2yuvX_10_upper:  times 16 dw 0x3ff
+yuv2yuvX_9_upper:   times 16 dw 0x1ff
+pd_4:          times 8 dd 4
+pd_4min0x40000:times 8 dd 4 - (0x40000)
+pw_16:         times 16 dw 16
+pw_32:         times 16 dw 32
+pw_512:        times 16 dw 512
+pw_1024:       times 16 dw 1024
 
 SECTION .text
 
@@ -53,6 +53,10 @@ SECTION .text
 ; data. The input is 15 bits in int16_t if $output_size is [8,10] and 19 bits in
 ; int32_t if $output_size is 16. $filter is 12 bits. $filterSize is a multiple
 ; of 2. $offset is either 0 or 3. $dither holds 8 values.
+;
+; The ymm versions process 16 pixels per iteration, the dither values are
+; then repeated in both lanes. The lines of the intermediate buffers are only
+; 16 byte aligned, so they are read with unaligned loads.
 ;-----------------------------------------------------------------------------
 %macro yuv2planeX_mainloop 2
 .pixelloop_%2:
@@ -61,11 +65,16 @@ SECTION .text
     ; 8 pixels but we can only handle 2 pixels per register, and thus 4
     ; pixels per iteration. In order to not have to keep track of where
     ; we are w.r.t. dithering, we unroll the MMX/8-bit loop x2.
-%if %1 == 8
-%assign %%repcnt 16/mmsize
+%if %1 == 8 && mmsize == 8
+%assign %%repcnt 2
 %else
 %assign %%repcnt 1
 %endif
+%if mmsize == 32
+%define movsrc movu
+%else
+%define movsrc mova
+%endif
 
 %rep %%repcnt
 
@@ -86,27 +95,40 @@ SECTION .text
     ; input pixels
     mov             r6, [srcq+gprsize*cntr_reg-2*gprsize]
 %if %1 == 16
-    mova            m3, [r6+r5*4]
-    mova            m5, [r6+r5*4+mmsize]
+    movsrc          m3, [r6+r5*4]
+    movsrc          m5, [r6+r5*4+mmsize]
 %else ; %1 == 8/9/10
-    mova            m3, [r6+r5*2]
+    movsrc          m3, [r6+r5*2]
 %endif ; %1 == 8/9/10/16
     mov             r6, [srcq+gprsize*cntr_reg-gprsize]
 %if %1 == 16
-    mova            m4, [r6+r5*4]
-    mova            m6, [r6+r5*4+mmsize]
+    movsrc          m4, [r6+r5*4]
+    movsrc          m6, [r6+r5*4+mmsize]
 %else ; %1 == 8/9/10
-    mova            m4, [r6+r5*2]
+    movsrc          m4, [r6+r5*2]
 %endif ; %1 == 8/9/10/16
 
     ; coefficients
+%if mmsize == 32
+%if %1 == 16
+    vpbroadcastw    m7, [filterq+2*cntr_reg-4] ; coeff[0]
+    vpbroadcastw    m0, [filterq+2*cntr_reg-2] ; coeff[1]
+    pmovsxwd        m7, xm7              ; word -> dword
+    pmovsxwd        m0, xm0              ; word -> dword
+%else ; %1 == 10/9/8
+    vpbroadcastd    m0, [filterq+2*cntr_reg-4] ; coeff[0], coeff[1]
+%endif ; %1 == 8/9/10/16
+%else ; mmsize == 8/16
     movd            m0, [filterq+2*cntr_reg-4] ; coeff[0], coeff[1]
 %if %1 == 16
     pshuflw         m7,  m0,  0          ; coeff[0]
     pshuflw         m0,  m0,  0x55       ; coeff[1]
     pmovsxwd        m7,  m7              ; word -> dword
     pmovsxwd        m0,  m0              ; word -> dword
+%endif ; %1 == 16
+%endif ; mmsize == 8/16
 
+%if %1 == 16
     pmulld          m3,  m7
     pmulld          m5,  m7
     pmulld          m4,  m0
@@ -119,7 +141,9 @@ SECTION .text
 %else ; %1 == 10/9/8
     punpcklwd       m5,  m3,  m4
     punpckhwd       m3,  m4
+%if mmsize != 32
     SPLATD          m0
+%endif
 
     pmaddwd         m5,  m0
     pmaddwd         m3,  m0
@@ -142,10 +166,18 @@ SECTION .text
 %if %1 == 8
     packssdw        m2,  m1
     packuswb        m2,  m2
+%if mmsize == 32
+    vpermq          m2,  m2, q3120
+    movu   [dstq+r5*1], xm2
+%else
     movh   [dstq+r5*1],  m2
+%endif
 %else ; %1 == 9/10/16
 %if %1 == 16
     packssdw        m2,  m1
+%if mmsize == 32
+    vpermq          m2,  m2, q3120
+%endif
     paddw           m2, [minshort]
 %else ; %1 == 9/10
 %if cpuflag(sse4)
@@ -192,7 +224,11 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 %endif ; x86-32
 
     ; create registers holding dither
+%if mmsize == 32
+    vpbroadcastq m_dith, [ditherq]       ; dither
+%else
     movq        m_dith, [ditherq]        ; dither
+%endif
     test        offsetd, offsetd
     jz              .no_rot
 %if mmsize == 16
@@ -200,7 +236,7 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 %endif ; mmsize == 16
     PALIGNR     m_dith,  m_dith,  3,  m0
 .no_rot:
-%if mmsize == 16
+%if mmsize >= 16
     punpcklbw   m_dith,  m6
 %if ARCH_X86_64
     punpcklwd       m8,  m_dith,  m6
@@ -237,8 +273,8 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 
 %if mmsize == 8 || %1 == 8
     yuv2planeX_mainloop %1, a
-%else ; mmsize == 16
-    test          dstq, 15
+%else ; mmsize == 16/32
+    test          dstq, mmsize - 1
     jnz .unaligned
     yuv2planeX_mainloop %1, a
     REP_RET
@@ -283,6 +319,14 @@ yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
 %endif
 
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2planeX_fn  8, 10, 7
+yuv2planeX_fn  9,  7, 5
+yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 16,  8, 5
+%endif
+
 ; %1=outout-bpc, %2=alignment (u/a)
 %macro yuv2plane1_mainloop 2
 .loop_%2:
@@ -292,6 +336,9 @@ yuv2planeX_fn 10,  7, 5
     psraw           m0, 7
     psraw           m1, 7
     packuswb        m0, m1
+%if mmsize == 32
+    vpermq          m0, m0, q3120
+%endif
     mov%2    [dstq+wq], m0
 %elif %1 == 16
     paddd           m0, m4, [srcq+wq*4+mmsize*0]
@@ -305,6 +352,10 @@ yuv2planeX_fn 10,  7, 5
 %if cpuflag(sse4) ; avx/sse4
     packusdw        m0, m1
     packusdw        m2, m3
+%if mmsize == 32
+    vpermq          m0, m0, q3120
+    vpermq          m2, m2, q3120
+%endif
 %else ; mmx/sse2
     packssdw        m0, m1
     packssdw        m2, m3
@@ -350,7 +401,11 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     pxor            m4, m4               ; zero
 
     ; create registers holding dither
+%if mmsize == 32
+    vpbroadcastq    m3, [ditherq]        ; dither
+%else
     movq            m3, [ditherq]        ; dither
+%endif
     test       offsetd, offsetd
     jz              .no_rot
 %if mmsize == 16
@@ -386,8 +441,8 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     ; actual pixel scaling
 %if mmsize == 8
     yuv2plane1_mainloop %1, a
-%else ; mmsize == 16
-    test          dstq, 15
+%else ; mmsize == 16/32
+    test          dstq, mmsize - 1
     jnz .unaligned
     yuv2plane1_mainloop %1, a
     REP_RET
@@ -423,3 +478,11 @@ yuv2plane1_fn  9, 5, 3
 yuv2plane1_fn 10, 5, 3
 yuv2plane1_fn 16, 5, 3
 %endif
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2plane1_fn  8, 5, 5
+yuv2plane1_fn  9, 5, 3
+yuv2plane1_fn 10, 5, 3
+yuv2plane1_fn 16, 5, 3
+%endif
@@ -144,11 +144,282 @@ DECLARE_ALIGNED(8, extern const uint64_t, ff_bgr2UVOffset);
 
 #endif /* HAVE_INLINE_ASM */
 
+void ff_bgr24toy_ssse3(uint8_t *dst, const uint8_t *src,
+                       const int16_t *coeffs, int width);
+void ff_bgr24toy_avx2(uint8_t *dst, const uint8_t *src,
+                      const int16_t *coeffs, int width);
+void ff_bgr24touv_ssse3(uint8_t *dstU, uint8_t *dstV, const uint8_t *src0,
+                        const uint8_t *src1, const int16_t *coeffs, int width);
+void ff_bgr24touv_avx2(uint8_t *dstU, uint8_t *dstV, const uint8_t *src0,
+                       const uint8_t *src1, const int16_t *coeffs, int width);
+
+/**
+ * Like ff_rgb24toyv12_c(), but the chroma is taken from the average of each
+ * 2x2 block, the way the MMX version does. The SIMD lines need an even width
+ * of at least step pixels, the rest of the lines is done here.
+ */
+static av_always_inline void rgb24toyv12_simd(const uint8_t *src, uint8_t *ydst,
+                                              uint8_t *udst, uint8_t *vdst,
+                                              int width, int height,
+                                              int lumStride, int chromStride,
+                                              int srcStride, int32_t *rgb2yuv,
+                                              void (*toy)(uint8_t *, const uint8_t *,
+                                                          const int16_t *, int),
+                                              void (*touv)(uint8_t *, uint8_t *,
+                                                           const uint8_t *, const uint8_t *,
+                                                           const int16_t *, int),
+                                              int step)
+{
+    DECLARE_ALIGNED(16, int16_t, coeffs)[3][8];
+    const int32_t ry = rgb2yuv[RY_IDX], gy = rgb2yuv[GY_IDX], by = rgb2yuv[BY_IDX];
+    const int32_t ru = rgb2yuv[RU_IDX], gu = rgb2yuv[GU_IDX], bu = rgb2yuv[BU_IDX];
+    const int32_t rv = rgb2yuv[RV_IDX], gv = rgb2yuv[GV_IDX], bv = rgb2yuv[BV_IDX];
+    const int w    = width & ~1;
+    const int simd = w >= step ? w : 0;
+    int x, y;
+
+    for (x = 0; x < 8; x += 4) {
+        coeffs[0][x] = by; coeffs[0][x + 1] = gy; coeffs[0][x + 2] = ry; coeffs[0][x + 3] = 0;
+        coeffs[1][x] = bu; coeffs[1][x + 1] = gu; coeffs[1][x + 2] = ru; coeffs[1][x + 3] = 0;
+        coeffs[2][x] = bv; coeffs[2][x + 1] = gv; coeffs[2][x + 2] = rv; coeffs[2][x + 3] = 0;
+    }
+
+    for (y = 0; y < height; y++) {
+        if (simd)
+            toy(ydst, src, coeffs[0], simd);
+        for (x = simd; x < w; x++) {
+            const uint8_t *p = src + 3 * x;
+            ydst[x] = av_clip_uint8(((by * p[0] + gy * p[1] + ry * p[2]) >> RGB2YUV_SHIFT) + 16);
+        }
+
+        if (!(y & 1)) {
+            const uint8_t *src1 = y + 1 < height ? src + srcStride : src;
+
+            if (simd)
+                touv(udst, vdst, src, src1, coeffs[0], simd);
+            for (x = simd; x < w; x += 2) {
+                int b, g, r;
+#define AVG2X2(c) ((((src[3 * x + c]     + src1[3 * x + c]     + 1) >> 1) + \
+                    ((src[3 * x + c + 3] + src1[3 * x + c + 3] + 1) >> 1) + 1) >> 1)
+                b = AVG2X2(0);
+                g = AVG2X2(1);
+                r = AVG2X2(2);
+#undef AVG2X2
+                udst[x >> 1] = av_clip_uint8(((bu * b + gu * g + ru * r) >> RGB2YUV_SHIFT) + 128);
+                vdst[x >> 1] = av_clip_uint8(((bv * b + gv * g + rv * r) >> RGB2YUV_SHIFT) + 128);
+            }
+        } else {
+            udst += chromStride;
+            vdst += chromStride;
+        }
+        ydst += lumStride;
+        src  += srcStride;
+    }
+}
+
+#define RGB24TOYV12_FUNC(opt, step)                                           \
+static void rgb24toyv12_ ## opt(const uint8_t *src, uint8_t *ydst,           \
+                                uint8_t *udst, uint8_t *vdst,                \
+                                int width, int height,                       \
+                                int lumStride, int chromStride,              \
+                                int srcStride, int32_t *rgb2yuv)             \
+{                                                                            \
+    rgb24toyv12_simd(src, ydst, udst, vdst, width, height, lumStride,        \
+                     chromStride, srcStride, rgb2yuv,                        \
+                     ff_bgr24toy_ ## opt, ff_bgr24touv_ ## opt, step);       \
+}
+
+RGB24TOYV12_FUNC(ssse3, 16)
+RGB24TOYV12_FUNC(avx2,  32)
+
+#define INTERLEAVE_PROTOTYPES(opt)                                            \
+void ff_interleave_bytes_ ## opt(uint8_t *dst, const uint8_t *src1,          \
+                                 const uint8_t *src2, int width);            \
+void ff_deinterleave_bytes_ ## opt(uint8_t *dst1, uint8_t *dst2,             \
+                                   const uint8_t *src, int width);           \
+void ff_shift_words_ ## opt(uint16_t *dst, const uint16_t *src, int width,   \
+                            int shift);                                      \
+void ff_shift_words_right_ ## opt(uint16_t *dst, const uint16_t *src,        \
+                                  int width, int shift);                     \
+void ff_interleave_words_ ## opt(uint16_t *dst, const uint16_t *src1,        \
+                                 const uint16_t *src2, int width, int shift); \
+void ff_deinterleave_words_ ## opt(uint16_t *dst1, uint16_t *dst2,           \
+                                   const uint16_t *src, int width,           \
+                                   int shift);                               \
+void ff_interleave_bytes_to_words_ ## opt(uint8_t *dst, const uint8_t *src1, \
+                                          const uint8_t *src2, int width);
+
+INTERLEAVE_PROTOTYPES(sse2)
+INTERLEAVE_PROTOTYPES(avx2)
+
+/* The SIMD lines need at least step samples (step / 2 for interleave_words
+ * and deinterleave_words), shorter lines are done here. */
+#define INTERLEAVE_FUNCS(opt, step)                                           \
+static void interleave_bytes_ ## opt(const uint8_t *src1, const uint8_t *src2, \
+                                     uint8_t *dst, int width, int height,    \
+                                     int src1Stride, int src2Stride,         \
+                                     int dstStride)                          \
+{                                                                            \
+    int h, w;                                                                \
+                                                                             \
+    for (h = 0; h < height; h++) {                                           \
+        if (width >= step) {                                                 \
+            ff_interleave_bytes_ ## opt(dst, src1, src2, width);             \
+        } else {                                                             \
+            for (w = 0; w < width; w++) {                                    \
+                dst[2 * w + 0] = src1[w];                                    \
+                dst[2 * w + 1] = src2[w];                                    \
+            }                                                                \
+        }                                                                    \
+        src1 += src1Stride;                                                  \
+        src2 += src2Stride;                                                  \
+        dst  += dstStride;                                                   \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static void deinterleave_bytes_ ## opt(const uint8_t *src, uint8_t *dst1,    \
+                                       uint8_t *dst2, int width, int height, \
+                                       int srcStride, int dst1Stride,        \
+                                       int dst2Stride)                       \
+{                                                                            \
+    int h, w;                                                                \
+                                                                             \
+    for (h = 0; h < height; h++) {                                           \
+        if (width >= step) {                                                 \
+            ff_deinterleave_bytes_ ## opt(dst1, dst2, src, width);           \
+        } else {                                                             \
+            for (w = 0; w < width; w++) {                                    \
+                dst1[w] = src[2 * w + 0];                                    \
+                dst2[w] = src[2 * w + 1];                                    \
+            }                                                                \
+        }                                                                    \
+        src  += srcStride;                                                   \
+        dst1 += dst1Stride;                                                  \
+        dst2 += dst2Stride;                                                  \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static void shift_words_ ## opt(const uint16_t *src, uint16_t *dst,          \
+                                int width, int height, int srcStride,        \
+                                int dstStride, int shift)                    \
+{                                                                            \
+    int h, w;                                                                \
+                                                                             \
+    for (h = 0; h < height; h++) {                                           \
+        if (width >= step) {                                                 \
+            ff_shift_words_ ## opt(dst, src, width, shift);                  \
+        } else {                                                             \
+            for (w = 0; w < width; w++)                                      \
+                dst[w] = src[w] << shift;                                    \
+        }                                                                    \
+        src = (const uint16_t *)((const uint8_t *)src + srcStride);          \
+        dst = (uint16_t *)((uint8_t *)dst + dstStride);                      \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static void shift_words_right_ ## opt(const uint16_t *src, uint16_t *dst,    \
+                                      int width, int height, int srcStride,  \
+                                      int dstStride, int shift)              \
+{                                                                            \
+    int h, w;                                                                \
+                                                                             \
+    for (h = 0; h < height; h++) {                                           \
+        if (width >= step) {                                                 \
+            ff_shift_words_right_ ## opt(dst, src, width, shift);            \
+        } else {                                                             \
+            for (w = 0; w < width; w++)                                      \
+                dst[w] = src[w] >> shift;                                    \
+        }                                                                    \
+        src = (const uint16_t *)((const uint8_t *)src + srcStride);          \
+        dst = (uint16_t *)((uint8_t *)dst + dstStride);                      \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static void interleave_words_ ## opt(const uint16_t *src1,                   \
+                                     const uint16_t *src2, uint16_t *dst,    \
+                                     int width, int height, int src1Stride,  \
+                                     int src2Stride, int dstStride,          \
+                                     int shift)                              \
+{                                                                            \
+    int h, w;                                                                \
+                                                                             \
+    for (h = 0; h < height; h++) {                                           \
+        if (width >= step / 2) {                                             \
+            ff_interleave_words_ ## opt(dst, src1, src2, width, shift);      \
+        } else {                                                             \
+            for (w = 0; w < width; w++) {                                    \
+                dst[2 * w + 0] = src1[w] << shift;                           \
+                dst[2 * w + 1] = src2[w] << shift;                           \
+            }                                                                \
+        }                                                                    \
+        src1 = (const uint16_t *)((const uint8_t *)src1 + src1Stride);       \
+        src2 = (const uint16_t *)((const uint8_t *)src2 + src2Stride);       \
+        dst  = (uint16_t *)((uint8_t *)dst + dstStride);                     \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static void deinterleave_words_ ## opt(const uint16_t *src, uint16_t *dst1,   \
+                                       uint16_t *dst2, int width, int height, \
+                                       int srcStride, int dst1Stride,        \
+                                       int dst2Stride, int shift)            \
+{                                                                            \
+    int h, w;                                                                \
+                                                                             \
+    for (h = 0; h < height; h++) {                                           \
+        if (width >= step / 2) {                                             \
+            ff_deinterleave_words_ ## opt(dst1, dst2, src, width, shift);    \
+        } else {                                                             \
+            for (w = 0; w < width; w++) {                                    \
+                dst1[w] = src[2 * w + 0] >> shift;                           \
+                dst2[w] = src[2 * w + 1] >> shift;                           \
+            }                                                                \
+        }                                                                    \
+        src  = (const uint16_t *)((const uint8_t *)src + srcStride);         \
+        dst1 = (uint16_t *)((uint8_t *)dst1 + dst1Stride);                   \
+        dst2 = (uint16_t *)((uint8_t *)dst2 + dst2Stride);                   \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static void interleave_bytes_to_words_ ## opt(const uint8_t *src1,           \
+                                              const uint8_t *src2,           \
+                                              uint8_t *dst, int width,       \
+                                              int height, int src1Stride,    \
+                                              int src2Stride, int dstStride) \
+{                                                                            \
+    int h, w;                                                                \
+                                                                             \
+    for (h = 0; h < height; h++) {                                           \
+        if (width >= step) {                                                 \
+            ff_interleave_bytes_to_words_ ## opt(dst, src1, src2, width);    \
+        } else {                                                             \
+            for (w = 0; w < width; w++) {                                    \
+                dst[4 * w + 0] = dst[4 * w + 1] = src1[w];                   \
+                dst[4 * w + 2] = dst[4 * w + 3] = src2[w];                   \
+            }                                                                \
+        }                                                                    \
+        src1 += src1Stride;                                                  \
+        src2 += src2Stride;                                                  \
+        dst  += dstStride;                                                   \
+    }                                                                        \
+}
+
+INTERLEAVE_FUNCS(sse2, 16)
+INTERLEAVE_FUNCS(avx2, 32)
+
+#define INIT_INTERLEAVE_FUNCS(opt)                                            \
+    interleaveBytes        = interleave_bytes_ ## opt;                       \
+    deinterleaveBytes      = deinterleave_bytes_ ## opt;                     \
+    shiftWords             = shift_words_ ## opt;                            \
+    shiftWordsRight        = shift_words_right_ ## opt;                      \
+    interleaveWords        = interleave_words_ ## opt;                       \
+    deinterleaveWords      = deinterleave_words_ ## opt;                     \
+    interleaveBytesToWords = interleave_bytes_to_words_ ## opt
+
 av_cold void rgb2rgb_init_x86(void)
 {
-#if HAVE_INLINE_ASM
     int cpu_flags = av_get_cpu_flags();
 
+#if HAVE_INLINE_ASM
     if (INLINE_MMX(cpu_flags))
         rgb2rgb_init_mmx();
     if (INLINE_AMD3DNOW(cpu_flags))
@@ -160,4 +431,15 @@ av_cold void rgb2rgb_init_x86(void)
     if (INLINE_AVX(cpu_flags))
         rgb2rgb_init_avx();
 #endif /* HAVE_INLINE_ASM */
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        INIT_INTERLEAVE_FUNCS(sse2);
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        INIT_INTERLEAVE_FUNCS(avx2);
+    }
+    if (ARCH_X86_64 && EXTERNAL_SSSE3(cpu_flags))
+        ff_rgb24toyv12 = rgb24toyv12_ssse3;
+    if (ARCH_X86_64 && EXTERNAL_AVX2_FAST(cpu_flags))
+        ff_rgb24toyv12 = rgb24toyv12_avx2;
 }
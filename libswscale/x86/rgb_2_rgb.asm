@@ -0,0 +1,397 @@
+;******************************************************************************
+;* SIMD-optimized packed RGB to planar YUV conversion
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+; Expand pixels 0 and 1 (2 and 3) of 4 bgr24 pixels to the words b g r 0.
+; The second lane (and the last block of the xmm versions) is loaded 4 bytes
+; early so that no load reads past the 12 bytes of its 4 pixels.
+shuf_y01:   db 0, -1, 1, -1, 2, -1, -1, -1,  3, -1,  4, -1,  5, -1, -1, -1
+            db 4, -1, 5, -1, 6, -1, -1, -1,  7, -1,  8, -1,  9, -1, -1, -1
+shuf_y23:   db 6, -1, 7, -1, 8, -1, -1, -1,  9, -1, 10, -1, 11, -1, -1, -1
+            db 10, -1, 11, -1, 12, -1, -1, -1, 13, -1, 14, -1, 15, -1, -1, -1
+; Expand the even (odd) pixels of 4 bgr24 pixels to the words b g r 0.
+shuf_uv02:  db 0, -1, 1, -1, 2, -1, -1, -1,  6, -1,  7, -1,  8, -1, -1, -1
+            db 4, -1, 5, -1, 6, -1, -1, -1, 10, -1, 11, -1, 12, -1, -1, -1
+shuf_uv13:  db 3, -1, 4, -1, 5, -1, -1, -1,  9, -1, 10, -1, 11, -1, -1, -1
+            db 7, -1, 8, -1, 9, -1, -1, -1, 13, -1, 14, -1, 15, -1, -1, -1
+
+pw_16:      times 16 dw 16
+pw_128:     times 16 dw 128
+pw_00ff:    times 16 dw 0x00ff
+
+SECTION .text
+
+; Advance xq by %1 and jump back to .loop until the line of wq elements is
+; done. The last block is moved back to end at wq, overlapping the previous
+; one, so nothing is read or written past the line; wq must be at least %1.
+%macro NEXT_BLOCK 1
+    add            xq, %1
+    cmp            xq, wq
+    jge .end
+    lea          tmpq, [xq + %1]
+    cmp          tmpq, wq
+    jle .loop
+    lea            xq, [wq - %1]
+    jmp .loop
+.end:
+%endmacro
+
+; Load the mmsize pixels at pixel xq of line %5 in 4 blocks of 4 pixels
+; into m%1-m%4: pixels 0-3, 4-7, 8-11 and 12-15 in the xmm versions,
+; pixels 0-3 and 16-19, 4-7 and 20-23 and so on in the ymm versions.
+%macro LOAD_BLOCKS 5
+%if mmsize == 32
+    movu          xm%1, [%5 + tmpq +  0]
+    movu          xm%2, [%5 + tmpq + 12]
+    movu          xm%3, [%5 + tmpq + 24]
+    movu          xm%4, [%5 + tmpq + 36]
+    vinserti128    m%1, m%1, [%5 + tmpq + 44], 1
+    vinserti128    m%2, m%2, [%5 + tmpq + 56], 1
+    vinserti128    m%3, m%3, [%5 + tmpq + 68], 1
+    vinserti128    m%4, m%4, [%5 + tmpq + 80], 1
+%else
+    movu           m%1, [%5 + tmpq +  0]
+    movu           m%2, [%5 + tmpq + 12]
+    movu           m%3, [%5 + tmpq + 24]
+    movu           m%4, [%5 + tmpq + 32]
+%endif
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_bgr24toy_<opt>(uint8_t *dst, const uint8_t *src,
+;                        const int16_t *coeffs, int width)
+;
+; Y = ((ry * r + gy * g + by * b) >> 15) + 16, bit-exact with ff_rgb24toyv12_c.
+; coeffs holds by gy ry 0 repeated twice. width is even and at least mmsize.
+;-----------------------------------------------------------------------------
+
+; %1 = block register, %2 = temporary, %3 = block index (0-3)
+%macro BGR24_TO_Y_BLOCK 3
+%if mmsize == 32 || %3 < 3
+    pshufb         m%2, m%1, [shuf_y23]
+    pshufb         m%1, [shuf_y01]
+%else
+    pshufb         m%2, m%1, [shuf_y23 + 16]
+    pshufb         m%1, [shuf_y01 + 16]
+%endif
+    pmaddwd        m%1, m6
+    pmaddwd        m%2, m6
+    phaddd         m%1, m%2
+    psrad          m%1, 15
+%endmacro
+
+%macro BGR24_TO_Y 0
+cglobal bgr24toy, 4, 6, 7, dst, src, coeffs, w, x, tmp
+    movsxdifnidn   wq, wd
+%if mmsize == 32
+    vbroadcasti128 m6, [coeffsq]
+%else
+    mova           m6, [coeffsq]
+%endif
+    xor            xq, xq
+.loop:
+    lea          tmpq, [xq * 3]
+    LOAD_BLOCKS    0, 1, 2, 3, srcq
+    BGR24_TO_Y_BLOCK 0, 4, 0
+    BGR24_TO_Y_BLOCK 1, 5, 1
+    BGR24_TO_Y_BLOCK 2, 4, 2
+    BGR24_TO_Y_BLOCK 3, 5, 3
+    packssdw       m0, m1
+    packssdw       m2, m3
+    paddw          m0, [pw_16]
+    paddw          m2, [pw_16]
+    packuswb       m0, m2
+    movu   [dstq + xq], m0
+    NEXT_BLOCK     mmsize
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_bgr24touv_<opt>(uint8_t *dstU, uint8_t *dstV, const uint8_t *src0,
+;                         const uint8_t *src1, const int16_t *coeffs,
+;                         int width)
+;
+; U and V of the 2x2 blocks of lines src0 and src1, from the average of the
+; 4 pixels (rounded vertically, then horizontally):
+; U = ((ru * r + gu * g + bu * b) >> 15) + 128, V likewise.
+; coeffs holds bu gu ru 0 and bv gv rv 0, each repeated twice, after the
+; luma coefficients. width is even and at least mmsize.
+;-----------------------------------------------------------------------------
+
+; %1 = block register, %2 = temporary, %3 = block index (0-3)
+; Returns the U (V) products of the 2 chroma samples in %1 (%2).
+%macro BGR24_TO_UV_BLOCK 3
+%if mmsize == 32 || %3 < 3
+    pshufb         m%2, m%1, [shuf_uv13]
+    pshufb         m%1, [shuf_uv02]
+%else
+    pshufb         m%2, m%1, [shuf_uv13 + 16]
+    pshufb         m%1, [shuf_uv02 + 16]
+%endif
+    pavgw          m%1, m%2
+    pmaddwd        m%2, m%1, m9
+    pmaddwd        m%1, m8
+%endmacro
+
+%macro BGR24_TO_UV 0
+cglobal bgr24touv, 6, 8, 10, dstU, dstV, src0, src1, coeffs, w, x, tmp
+    movsxdifnidn   wq, wd
+%if mmsize == 32
+    vbroadcasti128 m8, [coeffsq + 16]
+    vbroadcasti128 m9, [coeffsq + 32]
+%else
+    mova           m8, [coeffsq + 16]
+    mova           m9, [coeffsq + 32]
+%endif
+    xor            xq, xq
+.loop:
+    lea          tmpq, [xq * 3]
+    LOAD_BLOCKS    0, 1, 2, 3, src0q
+    LOAD_BLOCKS    4, 5, 6, 7, src1q
+    pavgb          m0, m4
+    pavgb          m1, m5
+    pavgb          m2, m6
+    pavgb          m3, m7
+    BGR24_TO_UV_BLOCK 0, 4, 0
+    BGR24_TO_UV_BLOCK 1, 5, 1
+    BGR24_TO_UV_BLOCK 2, 6, 2
+    BGR24_TO_UV_BLOCK 3, 7, 3
+    phaddd         m0, m1           ; U 0-3
+    phaddd         m2, m3           ; U 4-7
+    phaddd         m4, m5           ; V 0-3
+    phaddd         m6, m7           ; V 4-7
+    psrad          m0, 15
+    psrad          m2, 15
+    psrad          m4, 15
+    psrad          m6, 15
+    packssdw       m0, m2
+    packssdw       m4, m6
+    paddw          m0, [pw_128]
+    paddw          m4, [pw_128]
+    packuswb       m0, m4
+    mov          tmpq, xq
+    shr          tmpq, 1
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+    movu   [dstUq + tmpq], xm0
+    vextracti128   [dstVq + tmpq], m0, 1
+%else
+    movq   [dstUq + tmpq], m0
+    movhps [dstVq + tmpq], m0
+%endif
+    NEXT_BLOCK     mmsize
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM ssse3
+BGR24_TO_Y
+BGR24_TO_UV
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+BGR24_TO_Y
+BGR24_TO_UV
+%endif
+%endif
+
+;-----------------------------------------------------------------------------
+; void ff_interleave_bytes_<opt>(uint8_t *dst, const uint8_t *src1,
+;                                const uint8_t *src2, int width)
+; void ff_deinterleave_bytes_<opt>(uint8_t *dst1, uint8_t *dst2,
+;                                  const uint8_t *src, int width)
+; void ff_shift_words_<opt>(uint16_t *dst, const uint16_t *src, int width,
+;                           int shift)
+; void ff_shift_words_right_<opt>(uint16_t *dst, const uint16_t *src,
+;                                 int width, int shift)
+; void ff_interleave_words_<opt>(uint16_t *dst, const uint16_t *src1,
+;                                const uint16_t *src2, int width, int shift)
+; void ff_deinterleave_words_<opt>(uint16_t *dst1, uint16_t *dst2,
+;                                  const uint16_t *src, int width, int shift)
+; void ff_interleave_bytes_to_words_<opt>(uint8_t *dst, const uint8_t *src1,
+;                                         const uint8_t *src2, int width)
+;
+; One line of the rgb2rgb functions of the same names, width is in samples
+; of each source (destination for deinterleave) plane and at least mmsize
+; (mmsize / 2 for interleave_words and deinterleave_words).
+;-----------------------------------------------------------------------------
+
+%macro INTERLEAVE_BYTES 0
+cglobal interleave_bytes, 4, 6, 3, dst, src1, src2, w, x, tmp
+    movsxdifnidn   wq, wd
+    xor            xq, xq
+.loop:
+    movu           m0, [src1q + xq]
+    movu           m1, [src2q + xq]
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+    vpermq         m1, m1, q3120
+%endif
+    punpckhbw      m2, m0, m1
+    punpcklbw      m0, m1
+    movu [dstq + xq * 2         ], m0
+    movu [dstq + xq * 2 + mmsize], m2
+    NEXT_BLOCK     mmsize
+    RET
+%endmacro
+
+%macro DEINTERLEAVE_BYTES 0
+cglobal deinterleave_bytes, 4, 6, 5, dst1, dst2, src, w, x, tmp
+    movsxdifnidn   wq, wd
+    mova           m4, [pw_00ff]
+    xor            xq, xq
+.loop:
+    movu           m0, [srcq + xq * 2         ]
+    movu           m1, [srcq + xq * 2 + mmsize]
+    psrlw          m2, m0, 8
+    psrlw          m3, m1, 8
+    pand           m0, m4
+    pand           m1, m4
+    packuswb       m0, m1
+    packuswb       m2, m3
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+    vpermq         m2, m2, q3120
+%endif
+    movu  [dst1q + xq], m0
+    movu  [dst2q + xq], m2
+    NEXT_BLOCK     mmsize
+    RET
+%endmacro
+
+; %1 = function name, %2 = shift instruction
+%macro SHIFT_WORDS 2
+cglobal %1, 4, 6, 3, dst, src, w, shift, x, tmp
+    movsxdifnidn   wq, wd
+    movd          xm2, shiftd
+    xor            xq, xq
+.loop:
+    movu           m0, [srcq + xq * 2         ]
+    movu           m1, [srcq + xq * 2 + mmsize]
+    %2             m0, xm2
+    %2             m1, xm2
+    movu [dstq + xq * 2         ], m0
+    movu [dstq + xq * 2 + mmsize], m1
+    NEXT_BLOCK     mmsize
+    RET
+%endmacro
+
+%macro INTERLEAVE_WORDS 0
+cglobal interleave_words, 5, 7, 4, dst, src1, src2, w, shift, x, tmp
+    movsxdifnidn   wq, wd
+    movd          xm3, shiftd
+    xor            xq, xq
+.loop:
+    movu           m0, [src1q + xq * 2]
+    movu           m1, [src2q + xq * 2]
+    psllw          m0, xm3
+    psllw          m1, xm3
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+    vpermq         m1, m1, q3120
+%endif
+    punpckhwd      m2, m0, m1
+    punpcklwd      m0, m1
+    movu [dstq + xq * 4         ], m0
+    movu [dstq + xq * 4 + mmsize], m2
+    NEXT_BLOCK     mmsize / 2
+    RET
+%endmacro
+
+; the even and odd words are sign extended to dwords, so that packssdw
+; returns them unchanged
+%macro DEINTERLEAVE_WORDS 0
+cglobal deinterleave_words, 5, 7, 5, dst1, dst2, src, w, shift, x, tmp
+    movsxdifnidn   wq, wd
+    movd          xm4, shiftd
+    xor            xq, xq
+.loop:
+    movu           m0, [srcq + xq * 4         ]
+    movu           m1, [srcq + xq * 4 + mmsize]
+    psrlw          m0, xm4
+    psrlw          m1, xm4
+    pslld          m2, m0, 16
+    pslld          m3, m1, 16
+    psrad          m2, 16
+    psrad          m3, 16
+    psrad          m0, 16
+    psrad          m1, 16
+    packssdw       m2, m3
+    packssdw       m0, m1
+%if mmsize == 32
+    vpermq         m2, m2, q3120
+    vpermq         m0, m0, q3120
+%endif
+    movu [dst1q + xq * 2], m2
+    movu [dst2q + xq * 2], m0
+    NEXT_BLOCK     mmsize / 2
+    RET
+%endmacro
+
+; each byte x of the sources is stored as the little-endian word x * 257
+%macro INTERLEAVE_BYTES_TO_WORDS 0
+cglobal interleave_bytes_to_words, 4, 6, 4, dst, src1, src2, w, x, tmp
+    movsxdifnidn   wq, wd
+    xor            xq, xq
+.loop:
+    movu           m0, [src1q + xq]
+    movu           m1, [src2q + xq]
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+    vpermq         m1, m1, q3120
+%endif
+    punpckhbw      m2, m0, m1       ; pixels mmsize / 2 and up
+    punpcklbw      m0, m1
+%if mmsize == 32
+    vpermq         m0, m0, q3120
+    vpermq         m2, m2, q3120
+%endif
+    punpckhbw      m1, m0, m0
+    punpcklbw      m0, m0
+    punpckhbw      m3, m2, m2
+    punpcklbw      m2, m2
+    movu [dstq + xq * 4             ], m0
+    movu [dstq + xq * 4 +     mmsize], m1
+    movu [dstq + xq * 4 + 2 * mmsize], m2
+    movu [dstq + xq * 4 + 3 * mmsize], m3
+    NEXT_BLOCK     mmsize
+    RET
+%endmacro
+
+%macro INTERLEAVE_FUNCS 0
+INTERLEAVE_BYTES
+DEINTERLEAVE_BYTES
+SHIFT_WORDS shift_words, psllw
+SHIFT_WORDS shift_words_right, psrlw
+INTERLEAVE_WORDS
+DEINTERLEAVE_WORDS
+INTERLEAVE_BYTES_TO_WORDS
+%endmacro
+
+INIT_XMM sse2
+INTERLEAVE_FUNCS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+INTERLEAVE_FUNCS
+%endif
@@ -21,12 +21,13 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
 
-max_19bit_int: times 4 dd 0x7ffff
+max_19bit_int: times 8 dd 0x7ffff
+minshort:      times 16 dw 0x8000
+unicoeff:      times 8 dd 0x20000000
+perm_hscale8:  dd 0, 4, 1, 5, 2, 6, 3, 7
 max_19bit_flt: times 4 dd 524287.0
-minshort:      times 8 dw 0x8000
-unicoeff:      times 4 dd 0x20000000
 
 SECTION .text
 
@@ -429,3 +430,372 @@ INIT_XMM ssse3
 SCALE_FUNCS2 6, 6, 8
 INIT_XMM sse4
 SCALE_FUNCS2 6, 6, 8
+
+;-----------------------------------------------------------------------------
+; AVX2 horizontal line scaling, same prototype as above.
+;
+; The 4- and 8-tap versions produce 8 output pixels per iteration, reading
+; filterPos[] and filter[] up to 7 entries past dstW. The generic versions
+; produce 4 output pixels per iteration, each ymm register holding the taps
+; of two of them, one per lane.
+;-----------------------------------------------------------------------------
+
+; SCALE_FUNC_AVX2 source_width, intermediate_nbits, filtersize, filtersuffix, n_args, n_xmm
+%macro SCALE_FUNC_AVX2 6
+%ifnidn %3, X
+cglobal hscale%1to%2_%4, %5, 7, %6, pos0, dst, w, src, filter, fltpos, pos1
+%else
+cglobal hscale%1to%2_%4, %5, 13, %6, pos0, dst, w, srcmem, filter, fltpos, fltsize, \
+                                     pos1, src, srcend, pos2, pos3, fs6
+%endif
+    movsxd        wq, wd
+%if %2 == 19
+    mova          m2, [max_19bit_int]
+%endif ; %2 == 19
+%if %1 == 16
+    mova          m6, [minshort]
+    mova          m7, [unicoeff]
+%endif ; %1 == 16
+
+%if %1 == 8
+%define srcmul 1
+%else ; %1 == 9-16
+%define srcmul 2
+%endif ; %1 == 8/9-16
+
+%ifnidn %3, X
+
+    ; setup loop
+%if %3 == 8
+    mova          m3, [perm_hscale8]
+    shl           wq, 1                         ; see the SSE version
+%define wshr 1
+%else ; %3 == 4
+%define wshr 0
+%endif ; %3 == 8
+    lea      filterq, [filterq+wq*8]
+%if %2 == 15
+    lea         dstq, [dstq+wq*(2>>wshr)]
+%else ; %2 == 19
+    lea         dstq, [dstq+wq*(4>>wshr)]
+%endif ; %2 == 15/19
+    lea      fltposq, [fltposq+wq*(4>>wshr)]
+    neg           wq
+
+.loop:
+%if %3 == 4 ; filterSize == 4 scaling
+    ; load 8x4 source pixels into m0/m1, 2 output pixels per lane
+%assign %%i 0
+%rep 2
+    movsxd     pos0q, dword [fltposq+wq*4+%%i*16+ 0]
+    movsxd     pos1q, dword [fltposq+wq*4+%%i*16+ 4]
+%if %1 == 8
+    movd        xm %+ %%i, [srcq+pos0q]
+    pinsrd      xm %+ %%i, [srcq+pos1q], 1
+    movsxd     pos0q, dword [fltposq+wq*4+%%i*16+ 8]
+    movsxd     pos1q, dword [fltposq+wq*4+%%i*16+12]
+    pinsrd      xm %+ %%i, [srcq+pos0q], 2
+    pinsrd      xm %+ %%i, [srcq+pos1q], 3
+    pmovzxbw     m %+ %%i, xm %+ %%i            ; byte -> word
+%else ; %1 > 8
+    movq        xm %+ %%i, [srcq+pos0q*2]
+    movhps      xm %+ %%i, [srcq+pos1q*2]
+    movsxd     pos0q, dword [fltposq+wq*4+%%i*16+ 8]
+    movsxd     pos1q, dword [fltposq+wq*4+%%i*16+12]
+    movq          xm4, [srcq+pos0q*2]
+    movhps        xm4, [srcq+pos1q*2]
+    vinserti128  m %+ %%i, m %+ %%i, xm4, 1
+%endif ; %1 == 8/9-16
+%assign %%i %%i+1
+%endrep
+
+%if %1 == 16 ; pmaddwd needs signed adds, see the SSE version
+    psubw         m0, m6
+    psubw         m1, m6
+%endif ; %1 == 16
+    pmaddwd       m0, [filterq+wq*8+mmsize*0]   ; *= filter[{ 0, 1,..,14,15}]
+    pmaddwd       m1, [filterq+wq*8+mmsize*1]   ; *= filter[{16,17,..,30,31}]
+
+    ; add up horizontally, the qwords of m0 now hold the pixels {0,1}, {4,5},
+    ; {2,3} and {6,7}
+    phaddd        m0, m1
+    vpermq        m0, m0, q3120
+%else ; %3 == 8, i.e. filterSize == 8 scaling
+    ; load 8x8 source pixels into m0, m1, m4 and m5, 1 output pixel per lane
+%assign %%i 0
+%rep 4
+%if %%i < 2
+%assign %%reg %%i
+%else
+%assign %%reg %%i+2
+%endif
+    movsxd     pos0q, dword [fltposq+wq*2+%%i*8+0]
+    movsxd     pos1q, dword [fltposq+wq*2+%%i*8+4]
+%if %1 == 8
+    movq       xm %+ %%reg, [srcq+pos0q]
+    movhps     xm %+ %%reg, [srcq+pos1q]
+    pmovzxbw    m %+ %%reg, xm %+ %%reg         ; byte -> word
+%else ; %1 > 8
+    movu       xm %+ %%reg, [srcq+pos0q*2]
+    vinserti128 m %+ %%reg, m %+ %%reg, [srcq+pos1q*2], 1
+%endif ; %1 == 8/9-16
+%assign %%i %%i+1
+%endrep
+
+%if %1 == 16 ; pmaddwd needs signed adds, see the SSE version
+    psubw         m0, m6
+    psubw         m1, m6
+    psubw         m4, m6
+    psubw         m5, m6
+%endif ; %1 == 16
+    pmaddwd       m0, [filterq+wq*8+mmsize*0]   ; *= filter[{ 0, 1,..,14,15}]
+    pmaddwd       m1, [filterq+wq*8+mmsize*1]   ; *= filter[{16,17,..,30,31}]
+    pmaddwd       m4, [filterq+wq*8+mmsize*2]   ; *= filter[{32,33,..,46,47}]
+    pmaddwd       m5, [filterq+wq*8+mmsize*3]   ; *= filter[{48,49,..,62,63}]
+
+    ; add up horizontally, the low lane of m0 then holds the pixels
+    ; {0,2,4,6} and the high lane the pixels {1,3,5,7}
+    phaddd        m0, m1
+    phaddd        m4, m5
+    phaddd        m0, m4
+    vpermd        m0, m3, m0
+%endif ; %3 == 4/8
+
+%if %1 == 16 ; add 0x8000 * sum(coeffs), i.e. back from signed -> unsigned
+    paddd         m0, m7
+%endif ; %1 == 16
+
+    ; clip, store
+    psrad         m0, 14 + %1 - %2
+%if %2 == 15
+    vextracti128 xm1, m0, 1
+    packssdw     xm0, xm1
+    movu [dstq+wq*(2>>wshr)], xm0
+%else ; %2 == 19
+    pminsd        m0, m2
+    movu [dstq+wq*(4>>wshr)], m0
+%endif ; %2 == 15/19
+    add           wq, 8<<wshr
+    jl .loop
+    RET
+
+%else ; %3 == X, i.e. any filterSize scaling
+
+%ifidn %4, X4
+%define dlt 4
+%else ; %4 == X8
+%define dlt 0
+%endif ; %4 ==/!= X4
+    movsxd  fltsizeq, fltsized                  ; filterSize
+    lea      srcendq, [srcmemq+(fltsizeq-dlt)*srcmul] ; &src[filterSize&~4]
+    lea         fs6q, [fltsizeq*3]
+    lea         fs6q, [fs6q*2+dlt*2]            ; offset of the taps of dstpx[3]
+    lea      fltposq, [fltposq+wq*4]
+%if %2 == 15
+    lea         dstq, [dstq+wq*2]
+%else ; %2 == 19
+    lea         dstq, [dstq+wq*4]
+%endif ; %2 == 15/19
+    neg           wq
+
+.loop:
+    movsxd     pos0q, dword [fltposq+wq*4+ 0]   ; filterPos[0]
+    movsxd     pos1q, dword [fltposq+wq*4+ 4]   ; filterPos[1]
+    movsxd     pos2q, dword [fltposq+wq*4+ 8]   ; filterPos[2]
+    movsxd     pos3q, dword [fltposq+wq*4+12]   ; filterPos[3]
+    pxor          m4, m4
+    pxor          m5, m5
+    mov         srcq, srcmemq
+
+.innerloop:
+    ; load 2x8 source pixels of dstpx[0,1] into m0 and of dstpx[2,3] into m1
+%if %1 == 8
+    movq         xm0, [srcq+ pos0q     ]
+    movhps       xm0, [srcq+(pos1q+dlt)]
+    movq         xm1, [srcq+ pos2q     ]
+    movhps       xm1, [srcq+(pos3q+dlt)]
+    pmovzxbw      m0, xm0
+    pmovzxbw      m1, xm1
+%else ; %1 > 8
+    movu         xm0, [srcq+ pos0q     *2]
+    vinserti128   m0, m0, [srcq+(pos1q+dlt)*2], 1
+    movu         xm1, [srcq+ pos2q     *2]
+    vinserti128   m1, m1, [srcq+(pos3q+dlt)*2], 1
+%endif ; %1 == 8/9-16
+    movu         xm3, [filterq]
+    vinserti128   m3, m3, [filterq+(fltsizeq+dlt)*2], 1
+    movu         xm8, [filterq+fltsizeq*4]
+    vinserti128   m8, m8, [filterq+fs6q], 1
+
+    ; multiply
+%if %1 == 16 ; pmaddwd needs signed adds, see the SSE version
+    psubw         m0, m6
+    psubw         m1, m6
+%endif ; %1 == 16
+    pmaddwd       m0, m3
+    pmaddwd       m1, m8
+    paddd         m4, m0
+    paddd         m5, m1
+    add      filterq, 16
+    add         srcq, srcmul*8
+    cmp         srcq, srcendq                   ; while (src += 8) < &src[filterSize]
+    jl .innerloop
+
+    ; the qwords of m4 now hold the partial sums of dstpx[0,1|2,3]
+    phaddd        m4, m5
+    vpermq        m4, m4, q3120
+
+%ifidn %4, X4
+    sub        pos1q, fltsizeq                  ; last 4 srcpx of dstpx[0,2]
+    sub        pos3q, fltsizeq                  ; and first 4 srcpx of dstpx[1,3]
+%if %1 == 8
+    movd         xm0, [srcq+ pos0q     ]
+    pinsrd       xm0, [srcq+(pos1q+dlt)], 1
+    pinsrd       xm0, [srcq+ pos2q     ], 2
+    pinsrd       xm0, [srcq+(pos3q+dlt)], 3
+    pmovzxbw      m0, xm0
+%else ; %1 > 8
+    movq         xm0, [srcq+ pos0q     *2]
+    movhps       xm0, [srcq+(pos1q+dlt)*2]
+    movq         xm1, [srcq+ pos2q     *2]
+    movhps       xm1, [srcq+(pos3q+dlt)*2]
+    vinserti128   m0, m0, xm1, 1
+%endif ; %1 == 8/9-16
+%if %1 == 16 ; pmaddwd needs signed adds, see the SSE version
+    psubw         m0, m6
+%endif ; %1 == 16
+    movu         xm3, [filterq]
+    vinserti128   m3, m3, [filterq+fltsizeq*4], 1
+    pmaddwd       m0, m3
+    paddd         m4, m0
+%endif ; %4 == X4
+
+    add      filterq, fs6q
+    vextracti128 xm5, m4, 1
+    phaddd       xm0, xm4, xm5
+
+%if %1 == 16 ; add 0x8000 * sum(coeffs), i.e. back from signed -> unsigned
+    paddd        xm0, xm7
+%endif ; %1 == 16
+
+    ; clip, store
+    psrad        xm0, 14 + %1 - %2
+%if %2 == 15
+    packssdw     xm0, xm0
+    movq [dstq+wq*2], xm0
+%else ; %2 == 19
+    pminsd       xm0, xm2
+    movu [dstq+wq*4], xm0
+%endif ; %2 == 15/19
+    add           wq, 4
+    jl .loop
+    RET
+%endif ; %3 ==/!= X
+%endmacro
+
+; SCALE_FUNCS_AVX2 source_width, intermediate_nbits
+%macro SCALE_FUNCS_AVX2 2
+SCALE_FUNC_AVX2 %1, %2, 4, 4,  6, 8
+SCALE_FUNC_AVX2 %1, %2, 8, 8,  6, 8
+SCALE_FUNC_AVX2 %1, %2, X, X4, 7, 9
+SCALE_FUNC_AVX2 %1, %2, X, X8, 7, 9
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SCALE_FUNCS_AVX2  8, 15
+SCALE_FUNCS_AVX2  9, 15
+SCALE_FUNCS_AVX2 10, 15
+SCALE_FUNCS_AVX2 12, 15
+SCALE_FUNCS_AVX2 14, 15
+SCALE_FUNCS_AVX2 16, 15
+SCALE_FUNCS_AVX2  8, 19
+SCALE_FUNCS_AVX2  9, 19
+SCALE_FUNCS_AVX2 10, 19
+SCALE_FUNCS_AVX2 12, 19
+SCALE_FUNCS_AVX2 14, 19
+SCALE_FUNCS_AVX2 16, 19
+%endif
+
+;-----------------------------------------------------------------------------
+; void hscale8to15_lowp_<opt>(int16_t *dst, int dstW, const uint8_t *src,
+;                             const int8_t *filter, const int32_t *filterPos,
+;                             int filterSize);
+;
+; Scale one line of 8 bit input for SWS_LOW_PRECISION. The filter is 6 bits
+; (summing to 64) and laid out by groups of 8 output pixels, with 4 taps of
+; each of them per 32 bytes (see hLumFilter8 in swscale_internal.h), so that
+; pmaddubsw can work on 4 pixels per xmm register. The sums are accumulated
+; in 16 bits and doubled with saturation to make 15 bits. filterSize is a
+; multiple of 4; 8 pixels are written per iteration, up to 7 past dstW.
+;-----------------------------------------------------------------------------
+
+; LOAD_TAPS dst, tmp1, tmp2, pixel
+; Load 4 source bytes at the current tap for 4 pixels starting at pixel.
+%macro LOAD_TAPS 4
+    mov         pos0d, [fltposq + xq * 4 + (%4 + 0) * 4]
+    mov         pos1d, [fltposq + xq * 4 + (%4 + 1) * 4]
+    movd           %1, [srcq + pos0q]
+    movd           %2, [srcq + pos1q]
+    mov         pos0d, [fltposq + xq * 4 + (%4 + 2) * 4]
+    mov         pos1d, [fltposq + xq * 4 + (%4 + 3) * 4]
+    punpckldq      %1, %2
+    movd           %2, [srcq + pos0q]
+    movd           %3, [srcq + pos1q]
+    punpckldq      %2, %3
+    punpcklqdq     %1, %2
+%endmacro
+
+%macro HSCALE_LOWP 0
+cglobal hscale8to15_lowp, 6, 11, 7, dst, w, srcmem, filter, fltpos, fltsize, \
+                                    x, src, j, pos0, pos1
+    movsxdifnidn   wq, wd
+    movsxdifnidn fltsizeq, fltsized
+    xor            xq, xq
+.loop:
+    mov          srcq, srcmemq
+    mov            jq, fltsizeq
+    pxor           m4, m4
+%if mmsize == 32
+    movu           m6, [fltposq + xq * 4]
+%else
+    pxor           m5, m5
+%endif
+.tap_loop:
+%if mmsize == 32
+    pcmpeqb        m3, m3
+    vpgatherdd     m0, [srcq + m6], m3
+    pmaddubsw      m0, [filterq]
+    paddw          m4, m0
+%else
+    LOAD_TAPS      m0, m1, m2, 0
+    LOAD_TAPS      m1, m2, m3, 4
+    pmaddubsw      m0, [filterq]
+    pmaddubsw      m1, [filterq + 16]
+    paddw          m4, m0
+    paddw          m5, m1
+%endif
+    add       filterq, 32
+    add          srcq, 4
+    sub            jq, 4
+    jg .tap_loop
+%if mmsize == 32
+    vextracti128  xm5, m4, 1
+%endif
+    phaddw        xm4, xm5
+    paddsw        xm4, xm4
+    movu [dstq + xq * 2], xm4
+    add            xq, 8
+    cmp            xq, wq
+    jl .loop
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM ssse3
+HSCALE_LOWP
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+HSCALE_LOWP
+%endif
+%endif
@@ -315,6 +315,14 @@ SCALE_FUNCS_MMX(mmx);
 SCALE_FUNCS_SSE(sse2);
 SCALE_FUNCS_SSE(ssse3);
 SCALE_FUNCS_SSE(sse4);
+SCALE_FUNCS_SSE(avx2);
+
+void ff_hscale8to15_lowp_ssse3(int16_t *dst, int dstW, const uint8_t *src,
+                               const int8_t *filter, const int32_t *filterPos,
+                               int filterSize);
+void ff_hscale8to15_lowp_avx2(int16_t *dst, int dstW, const uint8_t *src,
+                              const int8_t *filter, const int32_t *filterPos,
+                              int filterSize);
 
 #define VSCALEX_FUNC(size, opt) \
 void ff_yuv2planeX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
@@ -332,6 +340,8 @@ VSCALEX_FUNCS(sse2);
 VSCALEX_FUNCS(sse4);
 VSCALEX_FUNC(16, sse4);
 VSCALEX_FUNCS(avx);
+VSCALEX_FUNCS(avx2);
+VSCALEX_FUNC(16, avx2);
 
 #define VSCALE_FUNC(size, opt) \
 void ff_yuv2plane1_ ## size ## _ ## opt(const int16_t *src, uint8_t *dst, int dstW, \
@@ -348,6 +358,7 @@ VSCALE_FUNCS(mmx, mmxext);
 VSCALE_FUNCS(sse2, sse2);
 VSCALE_FUNC(16, sse4);
 VSCALE_FUNCS(avx, avx);
+VSCALE_FUNCS(avx2, avx2);
 
 #define INPUT_Y_FUNC(fmt, opt) \
 void ff_ ## fmt ## ToY_  ## opt(uint8_t *dst, const uint8_t *src, \
@@ -380,6 +391,7 @@ INPUT_FUNCS(mmx);
 INPUT_FUNCS(sse2);
 INPUT_FUNCS(ssse3);
 INPUT_FUNCS(avx);
+INPUT_FUNCS(avx2);
 
 av_cold void ff_sws_init_swscale_x86(SwsContext *c)
 {
@@ -535,6 +547,8 @@ switch(c->dstBpc){ \
     if (EXTERNAL_SSSE3(cpu_flags)) {
         ASSIGN_SSE_SCALE_FUNC(c->hyScale, c->hLumFilterSize, ssse3, ssse3);
         ASSIGN_SSE_SCALE_FUNC(c->hcScale, c->hChrFilterSize, ssse3, ssse3);
+        if (ARCH_X86_64)
+            c->hScale8To15_lowp = ff_hscale8to15_lowp_ssse3;
         switch (c->srcFormat) {
         case_rgb(rgb24, RGB24, ssse3);
         case_rgb(bgr24, BGR24, ssse3);
@@ -581,4 +595,44 @@ switch(c->dstBpc){ \
             break;
         }
     }
+
+    if (ARCH_X86_64 && EXTERNAL_AVX2_FAST(cpu_flags)) {
+        ASSIGN_SSE_SCALE_FUNC(c->hyScale, c->hLumFilterSize, avx2, avx2);
+        ASSIGN_SSE_SCALE_FUNC(c->hcScale, c->hChrFilterSize, avx2, avx2);
+        c->hScale8To15_lowp = ff_hscale8to15_lowp_avx2;
+        ASSIGN_VSCALEX_FUNC(c->yuv2planeX, avx2,
+                            if (!isBE(c->dstFormat)) c->yuv2planeX = ff_yuv2planeX_16_avx2,
+                            1);
+        ASSIGN_VSCALE_FUNC(c->yuv2plane1, avx2, avx2, 1);
+
+        switch (c->srcFormat) {
+        case AV_PIX_FMT_YA8:
+            c->lumToYV12 = ff_yuyvToY_avx2;
+            if (c->needAlpha)
+                c->alpToYV12 = ff_uyvyToY_avx2;
+            break;
+        case AV_PIX_FMT_YUYV422:
+            c->lumToYV12 = ff_yuyvToY_avx2;
+            c->chrToYV12 = ff_yuyvToUV_avx2;
+            break;
+        case AV_PIX_FMT_UYVY422:
+            c->lumToYV12 = ff_uyvyToY_avx2;
+            c->chrToYV12 = ff_uyvyToUV_avx2;
+            break;
+        case AV_PIX_FMT_NV12:
+            c->chrToYV12 = ff_nv12ToUV_avx2;
+            break;
+        case AV_PIX_FMT_NV21:
+            c->chrToYV12 = ff_nv21ToUV_avx2;
+            break;
+        case_rgb(rgb24, RGB24, avx2);
+        case_rgb(bgr24, BGR24, avx2);
+        case_rgb(bgra,  BGRA,  avx2);
+        case_rgb(rgba,  RGBA,  avx2);
+        case_rgb(abgr,  ABGR,  avx2);
+        case_rgb(argb,  ARGB,  avx2);
+        default:
+            break;
+        }
+    }
 }
@@ -69,11 +69,167 @@ DECLARE_ASM_CONST(8, uint64_t, pb_07) = 0x0707070707070707ULL;
 
 #endif /* HAVE_INLINE_ASM */
 
+typedef void (*yuv420_line_func)(uint8_t *dst, const uint8_t *py,
+                                 const uint8_t *pu, const uint8_t *pv,
+                                 const uint64_t *coeffs, int width);
+typedef void (*nv12_line_func)(uint8_t *dst, const uint8_t *py,
+                               const uint8_t *puv, const uint64_t *coeffs,
+                               int width);
+
+#define YUV2RGB_LINE_FUNCS(fmt, opt)                                         \
+void ff_yuv420_ ## fmt ## _ ## opt(uint8_t *dst, const uint8_t *py,          \
+                                   const uint8_t *pu, const uint8_t *pv,     \
+                                   const uint64_t *coeffs, int width);       \
+void ff_nv12_ ## fmt ## _ ## opt(uint8_t *dst, const uint8_t *py,            \
+                                 const uint8_t *puv, const uint64_t *coeffs, \
+                                 int width);                                 \
+void ff_nv21_ ## fmt ## _ ## opt(uint8_t *dst, const uint8_t *py,            \
+                                 const uint8_t *puv, const uint64_t *coeffs, \
+                                 int width);
+
+#define YUV2RGB_LINE_FUNCS_OPT(opt) \
+    YUV2RGB_LINE_FUNCS(rgb24, opt)  \
+    YUV2RGB_LINE_FUNCS(bgr24, opt)  \
+    YUV2RGB_LINE_FUNCS(rgba,  opt)  \
+    YUV2RGB_LINE_FUNCS(bgra,  opt)  \
+    YUV2RGB_LINE_FUNCS(argb,  opt)  \
+    YUV2RGB_LINE_FUNCS(abgr,  opt)
+
+YUV2RGB_LINE_FUNCS_OPT(ssse3)
+YUV2RGB_LINE_FUNCS_OPT(avx2)
+
+/* Same fixed point arithmetic as the SIMD lines, for the last pixel of
+ * odd widths. */
+static av_always_inline void yuv2rgb_pixel(const SwsContext *c, uint8_t *dst,
+                                           int y, int u, int v,
+                                           enum AVPixelFormat dst_format)
+{
+    int r, g, b;
+
+    u = av_clip_int16(u * 8 - (int16_t)c->uOffset);
+    v = av_clip_int16(v * 8 - (int16_t)c->vOffset);
+    y = (int16_t)(y * 8 - (int16_t)c->yOffset);
+    y = y * (int16_t)c->yCoeff >> 16;
+    g = av_clip_int16((u * (int16_t)c->ugCoeff >> 16) +
+                      (v * (int16_t)c->vgCoeff >> 16));
+    r = av_clip_uint8(av_clip_int16(y + (v * (int16_t)c->vrCoeff >> 16)));
+    g = av_clip_uint8(av_clip_int16(y + g));
+    b = av_clip_uint8(av_clip_int16(y + (u * (int16_t)c->ubCoeff >> 16)));
+
+    switch (dst_format) {
+    case AV_PIX_FMT_RGB24: dst[0] = r;   dst[1] = g; dst[2] = b;              break;
+    case AV_PIX_FMT_BGR24: dst[0] = b;   dst[1] = g; dst[2] = r;              break;
+    case AV_PIX_FMT_RGBA:  dst[0] = r;   dst[1] = g; dst[2] = b; dst[3] = 255; break;
+    case AV_PIX_FMT_BGRA:  dst[0] = b;   dst[1] = g; dst[2] = r; dst[3] = 255; break;
+    case AV_PIX_FMT_ARGB:  dst[0] = 255; dst[1] = r; dst[2] = g; dst[3] = b;   break;
+    case AV_PIX_FMT_ABGR:  dst[0] = 255; dst[1] = b; dst[2] = g; dst[3] = r;   break;
+    }
+}
+
+/* The line functions need an even width of at least one vector. */
+static av_always_inline int yuv2rgb_lines(SwsContext *c, const uint8_t *src[],
+                                          int srcStride[],
+                                          int srcSliceY, int srcSliceH,
+                                          uint8_t *dst[], int dstStride[],
+                                          yuv420_line_func yuv420,
+                                          nv12_line_func nv12,
+                                          enum AVPixelFormat dst_format)
+{
+    const int vshift = c->srcFormat != AV_PIX_FMT_YUV422P;
+    const int nv21   = c->srcFormat == AV_PIX_FMT_NV21;
+    const int width  = c->dstW & ~1;
+    const int step   = dst_format == AV_PIX_FMT_RGB24 ||
+                       dst_format == AV_PIX_FMT_BGR24 ? 3 : 4;
+    int y;
+
+    for (y = 0; y < srcSliceH; y++) {
+        uint8_t *image    = dst[0] + (y + srcSliceY) * dstStride[0];
+        const uint8_t *py = src[0] +               y * srcStride[0];
+        const uint8_t *pu = src[1] +   (y >> vshift) * srcStride[1];
+        const uint8_t *pv = pu;
+
+        if (nv12) {
+            nv12(image, py, pu, &c->redDither, width);
+            pu += width +  nv21;
+            pv += width + !nv21;
+        } else {
+            pv = src[2] + (y >> vshift) * srcStride[2];
+            yuv420(image, py, pu, pv, &c->redDither, width);
+            pu += width >> 1;
+            pv += width >> 1;
+        }
+        if (c->dstW & 1)
+            yuv2rgb_pixel(c, image + width * step, py[width], *pu, *pv, dst_format);
+    }
+    return srcSliceH;
+}
+
+#define YUV2RGB_FUNC(src_fmt, yuv420, nv12, fmt, dst_format, opt)            \
+static int src_fmt ## _ ## fmt ## _ ## opt(SwsContext *c, const uint8_t *src[], \
+                                           int srcStride[], int srcSliceY,   \
+                                           int srcSliceH, uint8_t *dst[],    \
+                                           int dstStride[])                  \
+{                                                                            \
+    return yuv2rgb_lines(c, src, srcStride, srcSliceY, srcSliceH,            \
+                         dst, dstStride, yuv420, nv12, dst_format);          \
+}
+
+#define YUV2RGB_FUNCS(fmt, dst_format, opt)                                  \
+    YUV2RGB_FUNC(yuv420, ff_yuv420_ ## fmt ## _ ## opt, NULL,                \
+                 fmt, dst_format, opt)                                       \
+    YUV2RGB_FUNC(nv12, NULL, ff_nv12_ ## fmt ## _ ## opt,                    \
+                 fmt, dst_format, opt)                                       \
+    YUV2RGB_FUNC(nv21, NULL, ff_nv21_ ## fmt ## _ ## opt,                    \
+                 fmt, dst_format, opt)
+
+#define YUV2RGB_FUNCS_OPT(opt)                                               \
+    YUV2RGB_FUNCS(rgb24, AV_PIX_FMT_RGB24, opt)                              \
+    YUV2RGB_FUNCS(bgr24, AV_PIX_FMT_BGR24, opt)                              \
+    YUV2RGB_FUNCS(rgba,  AV_PIX_FMT_RGBA,  opt)                              \
+    YUV2RGB_FUNCS(bgra,  AV_PIX_FMT_BGRA,  opt)                              \
+    YUV2RGB_FUNCS(argb,  AV_PIX_FMT_ARGB,  opt)                              \
+    YUV2RGB_FUNCS(abgr,  AV_PIX_FMT_ABGR,  opt)                              \
+                                                                             \
+static av_cold SwsFunc yuv2rgb_init_ ## opt(SwsContext *c)                   \
+{                                                                            \
+    switch (c->dstFormat) {                                                  \
+    case AV_PIX_FMT_RGB24: return SELECT_SRC(rgb24, opt);                    \
+    case AV_PIX_FMT_BGR24: return SELECT_SRC(bgr24, opt);                    \
+    case AV_PIX_FMT_RGBA:  return SELECT_SRC(rgba,  opt);                    \
+    case AV_PIX_FMT_BGRA:  return SELECT_SRC(bgra,  opt);                    \
+    case AV_PIX_FMT_ARGB:  return SELECT_SRC(argb,  opt);                    \
+    case AV_PIX_FMT_ABGR:  return SELECT_SRC(abgr,  opt);                    \
+    }                                                                        \
+    return NULL;                                                             \
+}
+
+#define SELECT_SRC(fmt, opt)                                                 \
+    c->srcFormat == AV_PIX_FMT_NV12 ? nv12_   ## fmt ## _ ## opt :           \
+    c->srcFormat == AV_PIX_FMT_NV21 ? nv21_   ## fmt ## _ ## opt :           \
+                                      yuv420_ ## fmt ## _ ## opt
+
+YUV2RGB_FUNCS_OPT(ssse3)
+YUV2RGB_FUNCS_OPT(avx2)
+
 av_cold SwsFunc ff_yuv2rgb_init_x86(SwsContext *c)
 {
-#if HAVE_MMX_INLINE && HAVE_6REGS
     int cpu_flags = av_get_cpu_flags();
+    /* the SIMD lines leave the alpha of yuva420p to the MMX and C code */
+    const int simd = !(CONFIG_SWSCALE_ALPHA && isALPHA(c->srcFormat) &&
+                       c->dstFormatBpp == 32);
+    SwsFunc func;
 
+    if (ARCH_X86_64 && EXTERNAL_AVX2_FAST(cpu_flags) && simd && c->dstW >= 32 &&
+        (func = yuv2rgb_init_avx2(c)))
+        return func;
+    if (ARCH_X86_64 && EXTERNAL_SSSE3(cpu_flags) && simd && c->dstW >= 16 &&
+        (func = yuv2rgb_init_ssse3(c)))
+        return func;
+
+    if (c->srcFormat == AV_PIX_FMT_NV12 || c->srcFormat == AV_PIX_FMT_NV21)
+        return NULL;
+
+#if HAVE_MMX_INLINE && HAVE_6REGS
 #if HAVE_MMXEXT_INLINE
     if (INLINE_MMXEXT(cpu_flags)) {
         switch (c->dstFormat) {
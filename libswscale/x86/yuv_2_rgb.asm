@@ -0,0 +1,273 @@
+;******************************************************************************
+;* SIMD-optimized YUV 4:2:0 / NV12 to packed RGB conversion
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pw_00ff:         times 16 dw 0x00ff
+shuf_rgb0_to_24: times 2 db 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+
+SECTION .text
+
+; Offsets of the coefficients in the SwsContext block starting at redDither,
+; see the *_COEFF and *_OFFSET defines in swscale_internal.h. Each of them is
+; a 16 bit value repeated 4 times.
+%define Y_COEFF  3*8
+%define VR_COEFF 4*8
+%define UB_COEFF 5*8
+%define VG_COEFF 6*8
+%define UG_COEFF 7*8
+%define Y_OFFSET 8*8
+%define U_OFFSET 9*8
+%define V_OFFSET 10*8
+
+%macro LOAD_COEFF 2
+%if mmsize == 32
+    vpbroadcastq %1, [coeffsq + %2]
+%else
+    movddup      %1, [coeffsq + %2]
+%endif
+%endmacro
+
+; Load the U and V samples of mmsize pixels as words into m1 and m2.
+; %1 = yuv420, nv12 or nv21
+%macro LOAD_CHROMA 1
+%ifidn %1, yuv420
+    mov          tmpq, xq
+    shr          tmpq, 1
+%if mmsize == 32
+    pmovzxbw       m1, [puq + tmpq]
+    pmovzxbw       m2, [pvq + tmpq]
+%else
+    movq           m1, [puq + tmpq]
+    movq           m2, [pvq + tmpq]
+    punpcklbw      m1, m7
+    punpcklbw      m2, m7
+%endif
+%else ; nv12 / nv21
+    movu           m1, [puvq + xq]
+%ifidn %1, nv12
+    psrlw          m2, m1, 8
+    pand           m1, [pw_00ff]
+%else
+    mova           m2, m1
+    psrlw          m1, 8
+    pand           m2, [pw_00ff]
+%endif
+%endif
+%endmacro
+
+; Convert mmsize pixels to 8 bit R, G and B in m5, m6 and m3, in pixel order
+; within each lane. This is the same fixed point arithmetic as the MMX code
+; in yuv2rgb_template.c:
+;   X' = X * 8 - Xoffset
+;   R  = Y' * Ycoeff + V' * VRcoeff
+;   G  = Y' * Ycoeff + V' * VGcoeff + U' * UGcoeff
+;   B  = Y' * Ycoeff + U' * UBcoeff
+; with the even and odd pixels sharing a chroma sample handled separately.
+%macro YUV2RGB 1
+    LOAD_CHROMA    %1
+    movu           m0, [pyq + xq]
+    psllw          m1, 3
+    psllw          m2, 3
+    psubsw         m1, m10
+    psubsw         m2, m11
+    pmulhw         m4, m1, m14
+    pmulhw         m5, m2, m15
+    pmulhw         m1, m12
+    pmulhw         m2, m13
+    paddsw         m4, m5           ; G chroma
+    pand           m3, m0, [pw_00ff]
+    psrlw          m0, 8
+    psllw          m3, 3
+    psllw          m0, 3
+    psubw          m3, m9
+    psubw          m0, m9
+    pmulhw         m3, m8           ; Y even
+    pmulhw         m0, m8           ; Y odd
+
+    paddsw         m5, m3, m2       ; R even
+    paddsw         m2, m0           ; R odd
+    paddsw         m6, m3, m4       ; G even
+    paddsw         m4, m0           ; G odd
+    paddsw         m3, m1           ; B even
+    paddsw         m1, m0           ; B odd
+    packuswb       m5, m5
+    packuswb       m2, m2
+    packuswb       m6, m6
+    packuswb       m4, m4
+    packuswb       m3, m3
+    packuswb       m1, m1
+    punpcklbw      m5, m2           ; R
+    punpcklbw      m6, m4           ; G
+    punpcklbw      m3, m1           ; B
+%endmacro
+
+; %1-%3 = registers of the first to third byte of each pixel
+%macro STORE_RGB24 3
+    punpcklbw      m0, %1, %2
+    punpckhbw      %1, %2
+    punpcklbw      m2, %3, m7
+    punpckhbw      %3, m7
+    punpcklwd      m4, m0, m2       ; pixels 0-3
+    punpckhwd      m0, m2           ; pixels 4-7
+    punpcklwd      m2, %1, %3       ; pixels 8-11
+    punpckhwd      %1, %3           ; pixels 12-15
+    pshufb         m4, [shuf_rgb0_to_24]
+    pshufb         m0, [shuf_rgb0_to_24]
+    pshufb         m2, [shuf_rgb0_to_24]
+    pshufb         %1, [shuf_rgb0_to_24]
+    pslldq         m1, m0, 12
+    psrldq         m0, 4
+    por            m4, m1           ; bytes  0-15
+    pslldq         m1, m2, 8
+    psrldq         m2, 8
+    por            m0, m1           ; bytes 16-31
+    pslldq         %1, 4
+    por            m2, %1           ; bytes 32-47
+    lea          tmpq, [xq * 3]
+%if mmsize == 32
+    ; each lane holds 48 bytes of output
+    vperm2i128     m1, m4, m0, 0x20
+    vperm2i128     m4, m2, m4, 0x30
+    vperm2i128     m0, m0, m2, 0x31
+    movu [dstq + tmpq     ], m1
+    movu [dstq + tmpq + 32], m4
+    movu [dstq + tmpq + 64], m0
+%else
+    movu [dstq + tmpq     ], m4
+    movu [dstq + tmpq + 16], m0
+    movu [dstq + tmpq + 32], m2
+%endif
+%endmacro
+
+; %1-%4 = registers of the first to fourth byte of each pixel
+%macro STORE_RGB32 4
+    punpcklbw      m1, %1, %2
+    punpckhbw      %1, %2
+    punpcklbw      m2, %3, %4
+    punpckhbw      %3, %4
+    punpcklwd      m4, m1, m2       ; pixels 0-3
+    punpckhwd      m1, m2           ; pixels 4-7
+    punpcklwd      m2, %1, %3       ; pixels 8-11
+    punpckhwd      %1, %3           ; pixels 12-15
+%if mmsize == 32
+    vperm2i128     %3, m4, m1, 0x20
+    vperm2i128     m4, m4, m1, 0x31
+    vperm2i128     m1, m2, %1, 0x20
+    vperm2i128     m2, m2, %1, 0x31
+    movu [dstq + xq * 4      ], %3
+    movu [dstq + xq * 4 +  32], m1
+    movu [dstq + xq * 4 +  64], m4
+    movu [dstq + xq * 4 +  96], m2
+%else
+    movu [dstq + xq * 4      ], m4
+    movu [dstq + xq * 4 +  16], m1
+    movu [dstq + xq * 4 +  32], m2
+    movu [dstq + xq * 4 +  48], %1
+%endif
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_yuv420_<fmt>_<opt>(uint8_t *dst, const uint8_t *py,
+;                            const uint8_t *pu, const uint8_t *pv,
+;                            const uint64_t *coeffs, int width)
+; void ff_nv12_<fmt>_<opt>(uint8_t *dst, const uint8_t *py,
+;                          const uint8_t *puv, const uint64_t *coeffs,
+;                          int width)
+;
+; Convert one line to rgb24, bgr24, rgba, bgra, argb or abgr, with the
+; coefficients of the context starting at &c->redDither. The alpha of the
+; 32 bit formats is set to 255.
+; width is even and at least mmsize. The last block is moved back to end at
+; width, overlapping the previous one, so nothing is written past the line.
+;-----------------------------------------------------------------------------
+
+; %1 = source format, %2 = destination format
+%macro YUV2RGB_FN 2
+%ifidn %1, yuv420
+cglobal %1_%2, 6, 8, 16, dst, py, pu, pv, coeffs, w, x, tmp
+%else
+cglobal %1_%2, 5, 8, 16, dst, py, puv, coeffs, w, x, tmp
+%endif
+    movsxdifnidn   wq, wd
+    LOAD_COEFF     m8, Y_COEFF
+    LOAD_COEFF     m9, Y_OFFSET
+    LOAD_COEFF    m10, U_OFFSET
+    LOAD_COEFF    m11, V_OFFSET
+    LOAD_COEFF    m12, UB_COEFF
+    LOAD_COEFF    m13, VR_COEFF
+    LOAD_COEFF    m14, UG_COEFF
+    LOAD_COEFF    m15, VG_COEFF
+    pxor           m7, m7
+    xor            xq, xq
+.loop:
+    YUV2RGB        %1
+%ifidn %2, rgb24
+    STORE_RGB24    m5, m6, m3
+%elifidn %2, bgr24
+    STORE_RGB24    m3, m6, m5
+%else
+    pcmpeqb        m0, m0
+%ifidn %2, rgba
+    STORE_RGB32    m5, m6, m3, m0
+%elifidn %2, bgra
+    STORE_RGB32    m3, m6, m5, m0
+%elifidn %2, argb
+    STORE_RGB32    m0, m5, m6, m3
+%else ; abgr
+    STORE_RGB32    m0, m3, m6, m5
+%endif
+%endif
+    add            xq, mmsize
+    cmp            xq, wq
+    jge .end
+    lea          tmpq, [xq + mmsize]
+    cmp          tmpq, wq
+    jle .loop
+    lea            xq, [wq - mmsize]
+    jmp .loop
+.end:
+    RET
+%endmacro
+
+%macro YUV2RGB_FNS 1
+YUV2RGB_FN     %1, rgb24
+YUV2RGB_FN     %1, bgr24
+YUV2RGB_FN     %1, rgba
+YUV2RGB_FN     %1, bgra
+YUV2RGB_FN     %1, argb
+YUV2RGB_FN     %1, abgr
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM ssse3
+YUV2RGB_FNS yuv420
+YUV2RGB_FNS nv12
+YUV2RGB_FNS nv21
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+YUV2RGB_FNS yuv420
+YUV2RGB_FNS nv12
+YUV2RGB_FNS nv21
+%endif
+%endif
@@ -667,22 +667,8 @@ YUV2RGBFUNC(yuv2rgb_c_1_ordered_dither, uint8_t, 0)
     dst_2[0] = out_2;
 CLOSEYUV2RGBFUNC(1)
 
-SwsFunc ff_yuv2rgb_get_func_ptr(SwsContext *c)
+static SwsFunc yuv2rgb_c_func(SwsContext *c)
 {
-    SwsFunc t = NULL;
-
-    if (ARCH_PPC)
-        t = ff_yuv2rgb_init_ppc(c);
-    if (ARCH_X86)
-        t = ff_yuv2rgb_init_x86(c);
-
-    if (t)
-        return t;
-
-    av_log(c, AV_LOG_WARNING,
-           "No accelerated colorspace conversion found from %s to %s.\n",
-           av_get_pix_fmt_name(c->srcFormat), av_get_pix_fmt_name(c->dstFormat));
-
     switch (c->dstFormat) {
     case AV_PIX_FMT_BGR48BE:
     case AV_PIX_FMT_BGR48LE:
@@ -725,6 +711,60 @@ SwsFunc ff_yuv2rgb_get_func_ptr(SwsContext *c)
     return NULL;
 }
 
+/* The NV12 and NV21 chroma lines are deinterleaved 4 at a time, which keeps
+ * the 8 line period of the ordered dithers, and converted by the planar C
+ * functions. */
+static int nv12_yuv2rgb_c(SwsContext *c, const uint8_t *src[],
+                          int srcStride[], int srcSliceY, int srcSliceH,
+                          uint8_t *dst[], int dstStride[])
+{
+    const SwsFunc yuv2rgb = yuv2rgb_c_func(c);
+    const int chrW        = AV_CEIL_RSHIFT(c->srcW, 1);
+    const int chrStride   = FFALIGN(chrW, 16);
+    uint8_t *u = c->formatConvBuffer;
+    uint8_t *v = u + 4 * chrStride;
+    int y;
+
+    if (c->srcFormat == AV_PIX_FMT_NV21)
+        FFSWAP(uint8_t *, u, v);
+
+    for (y = 0; y < srcSliceH; y += 8) {
+        const int h = FFMIN(8, srcSliceH - y);
+        const uint8_t *planes[4] = { src[0] + y * srcStride[0],
+                                     c->formatConvBuffer,
+                                     c->formatConvBuffer + 4 * chrStride };
+        int strides[4] = { srcStride[0], chrStride, chrStride };
+
+        deinterleaveBytes(src[1] + (y >> 1) * srcStride[1], u, v, chrW,
+                          AV_CEIL_RSHIFT(h, 1), srcStride[1],
+                          chrStride, chrStride);
+        yuv2rgb(c, planes, strides, srcSliceY + y, h, dst, dstStride);
+    }
+    return srcSliceH;
+}
+
+SwsFunc ff_yuv2rgb_get_func_ptr(SwsContext *c)
+{
+    SwsFunc t = NULL;
+
+    if (ARCH_PPC)
+        t = ff_yuv2rgb_init_ppc(c);
+    if (ARCH_X86)
+        t = ff_yuv2rgb_init_x86(c);
+
+    if (t)
+        return t;
+
+    av_log(c, AV_LOG_WARNING,
+           "No accelerated colorspace conversion found from %s to %s.\n",
+           av_get_pix_fmt_name(c->srcFormat), av_get_pix_fmt_name(c->dstFormat));
+
+    t = yuv2rgb_c_func(c);
+    if (t && (c->srcFormat == AV_PIX_FMT_NV12 || c->srcFormat == AV_PIX_FMT_NV21))
+        return nv12_yuv2rgb_c;
+    return t;
+}
+
 static void fill_table(uint8_t* table[256 + 2*YUVRGB_TABLE_HEADROOM], const int elemsize,
                        const int64_t inc, void *y_tab)
 {
@@ -0,0 +1,87 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/amix.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define LEN     1024
+#define MAX_SRC 128
+
+static const int lens[] = { 1, 7, 16, 33, 100, LEN };
+
+static const int nb_srcs[] = { 1, 2, 8, 32, MAX_SRC };
+
+#define randomize_float(buf, len)                                   \
+    do {                                                            \
+        int k;                                                      \
+        for (k = 0; k < len; k++)                                   \
+            (buf)[k] = (float)rnd() / (UINT_MAX >> 1) - 1.0f;       \
+    } while (0)
+
+void checkasm_check_amix(void)
+{
+    static float samples[MAX_SRC][LEN + 1];
+    LOCAL_ALIGNED_32(float, dst_ref, [LEN]);
+    LOCAL_ALIGNED_32(float, dst_new, [LEN]);
+    const float *src[MAX_SRC];
+    float scale[MAX_SRC];
+    AMixDSPContext dsp;
+    int i, j, k, n0, n1;
+
+    declare_func(int, float *dst, const float **src, const float *scale,
+                 int nb_src, int len);
+
+    ff_amix_init(&dsp);
+
+    for (i = 0; i < MAX_SRC; i++) {
+        randomize_float(samples[i], LEN + 1);
+        /* the samples need no alignment, the odd inputs test it */
+        src[i]   = samples[i] + (i & 1);
+        scale[i] = 1.0f / (1 + (rnd() & 127));
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(nb_srcs); i++) {
+        const int nb_src = nb_srcs[i];
+
+        if (check_func(dsp.mix, "amix_mix_%d", nb_src)) {
+            for (j = 0; j < FF_ARRAY_ELEMS(lens); j++) {
+                const int len = lens[j];
+
+                memset(dst_ref, 0, LEN * sizeof(*dst_ref));
+                memset(dst_new, 0, LEN * sizeof(*dst_new));
+                n0 = call_ref(dst_ref, src, scale, nb_src, len);
+                n1 = call_new(dst_new, src, scale, nb_src, len);
+                /* the samples not processed are left to the caller, by the
+                 * reference too when it is a SIMD version */
+                for (k = n1; k < LEN && !dst_new[k]; k++);
+                /* the sums may be fused multiply-adds */
+                if (n0 < 0 || n0 > len || n1 < 0 || n1 > len || k < LEN ||
+                    !float_near_abs_eps_array(dst_ref, dst_new, 1e-5,
+                                              FFMIN(n0, n1)))
+                    fail();
+            }
+            if (nb_src >= 8)
+                bench_new(dst_new, src, scale, nb_src, LEN);
+        }
+    }
+    report("mix");
+}
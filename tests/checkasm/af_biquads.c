@@ -0,0 +1,104 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/biquads.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define LEN   1024
+/* odd plane sizes give unaligned planes */
+#define PLANE (LEN + 1)
+
+static const int lens[] = { 1, 3, 4, 7, 100, LEN };
+
+/* an equalizer at fs / 48 with a Q of 1 and a gain of 6 dB */
+static const double coeffs[5] = {
+    1.0416463, -1.9619437, 0.9266916, 1.9619437, -0.9683379
+};
+
+#define CHECK_FILTER4(name, type)                                               \
+static void check_filter4_##name(const BiquadsDSPContext *dsp)                 \
+{                                                                               \
+    LOCAL_ALIGNED_32(type, src,     [4 * PLANE]);                               \
+    LOCAL_ALIGNED_32(type, dst_ref, [4 * PLANE]);                               \
+    LOCAL_ALIGNED_32(type, dst_new, [4 * PLANE]);                               \
+    LOCAL_ALIGNED_32(double, c,     [20]);                                      \
+    double state_init[16], state_ref[16], state_new[16];                       \
+    const uint8_t *in[4], *tail_in[4];                                          \
+    uint8_t *out_ref[4], *out_new[4], *tail_out[4];                             \
+    int i, k, n0, n1;                                                           \
+                                                                                \
+    declare_func(int, uint8_t *const *dst, const uint8_t *const *src, int len,  \
+                 double *state, const double *coeffs);                          \
+                                                                                \
+    for (i = 0; i < 20; i++)                                                    \
+        c[i] = coeffs[i / 4];                                                   \
+    for (i = 0; i < 4 * PLANE; i++)                                             \
+        src[i] = (double)rnd() / (UINT_MAX >> 1) - 1.0;                         \
+    for (i = 0; i < 16; i++)                                                    \
+        state_init[i] = (double)rnd() / (UINT_MAX >> 1) - 1.0;                  \
+    for (k = 0; k < 4; k++) {                                                   \
+        in[k]      = (const uint8_t *)(src + k * PLANE);                        \
+        out_ref[k] = (uint8_t *)(dst_ref + k * PLANE);                          \
+        out_new[k] = (uint8_t *)(dst_new + k * PLANE);                          \
+    }                                                                           \
+                                                                                \
+    if (check_func(dsp->filter4_##name, "biquads_filter4_" #name)) {            \
+        for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {                            \
+            const int len = lens[i];                                            \
+                                                                                \
+            memset(dst_ref, 0, 4 * PLANE * sizeof(type));                       \
+            memset(dst_new, 0, 4 * PLANE * sizeof(type));                       \
+            memcpy(state_ref, state_init, sizeof(state_ref));                   \
+            memcpy(state_new, state_init, sizeof(state_new));                   \
+            n0 = call_ref(out_ref, in, len, state_ref, c);                      \
+            n1 = call_new(out_new, in, len, state_new, c);                      \
+            /* the samples not processed are left to the caller */              \
+            if (n1 < len) {                                                     \
+                for (k = 0; k < 4; k++) {                                       \
+                    tail_in[k]  = in[k]      + n1 * sizeof(type);               \
+                    tail_out[k] = out_new[k] + n1 * sizeof(type);               \
+                }                                                               \
+                call_ref(tail_out, tail_in, len - n1, state_new, c);            \
+            }                                                                   \
+            /* the operations are done in the same order, without fma */        \
+            if (n1 > len || n0 != len ||                                        \
+                memcmp(dst_ref, dst_new, 4 * PLANE * sizeof(type)) ||           \
+                memcmp(state_ref, state_new, sizeof(state_ref)))                \
+                fail();                                                         \
+        }                                                                       \
+        bench_new(out_new, in, LEN, state_new, c);                              \
+    }                                                                           \
+    report("filter4_" #name);                                                   \
+}
+
+CHECK_FILTER4(flt, float)
+CHECK_FILTER4(dbl, double)
+
+void checkasm_check_biquads(void)
+{
+    BiquadsDSPContext dsp;
+
+    ff_biquads_init(&dsp);
+
+    check_filter4_flt(&dsp);
+    check_filter4_dbl(&dsp);
+}
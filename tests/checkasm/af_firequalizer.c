@@ -0,0 +1,78 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/firequalizer.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define LEN 2047
+
+static const int lens[] = { 1, 2, 5, 8, 100, LEN };
+
+#define randomize_float(buf, len)                                   \
+    do {                                                            \
+        int k;                                                      \
+        for (k = 0; k < len; k++)                                   \
+            (buf)[k] = (float)rnd() / (UINT_MAX >> 1) - 1.0f;       \
+    } while (0)
+
+void checkasm_check_firequalizer(void)
+{
+    /* the spectra of av_rdft_calc() start with the packed dc and nyquist
+     * values, so the complex numbers are offset by 8 bytes */
+    LOCAL_ALIGNED_32(float, spec,     [2 * LEN + 2]);
+    LOCAL_ALIGNED_32(float, kernel,   [2 * LEN + 2]);
+    LOCAL_ALIGNED_32(float, sum_init, [2 * LEN + 2]);
+    LOCAL_ALIGNED_32(float, sum_ref,  [2 * LEN + 2]);
+    LOCAL_ALIGNED_32(float, sum_new,  [2 * LEN + 2]);
+    FIREqualizerDSPContext dsp;
+    int i, n, n0, n1;
+
+    declare_func(int, float *sum, const float *t, const float *c, int len);
+
+    ff_firequalizer_init(&dsp);
+
+    randomize_float(spec,     2 * LEN + 2);
+    randomize_float(kernel,   2 * LEN + 2);
+    randomize_float(sum_init, 2 * LEN + 2);
+
+    if (check_func(dsp.fcmul_add, "firequalizer_fcmul_add")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+            const int len = lens[i];
+
+            memcpy(sum_ref, sum_init, (2 * LEN + 2) * sizeof(*sum_ref));
+            memcpy(sum_new, sum_init, (2 * LEN + 2) * sizeof(*sum_new));
+            n0 = call_ref(sum_ref + 2, spec + 2, kernel + 2, len);
+            n1 = call_new(sum_new + 2, spec + 2, kernel + 2, len);
+            n  = FFMIN(n0, n1);
+            /* the numbers not processed are left to the caller, by the
+             * reference too when it is a SIMD version; the products are
+             * not fused */
+            if (n0 < 0 || n0 > len || n1 < 0 || n1 > len ||
+                memcmp(sum_ref, sum_new, (2 * n + 2) * sizeof(*sum_ref)) ||
+                memcmp(sum_new + 2 + 2 * n1, sum_init + 2 + 2 * n1,
+                       2 * (LEN - n1) * sizeof(*sum_new)))
+                fail();
+        }
+        bench_new(sum_new + 2, spec + 2, kernel + 2, LEN);
+    }
+    report("fcmul_add");
+}
@@ -106,12 +106,50 @@ static const struct {
     #endif
 #endif
 #if CONFIG_AVFILTER
+        { "drawutils", checkasm_check_drawutils },
+    #if CONFIG_AMIX_FILTER
+        { "af_amix", checkasm_check_amix },
+    #endif
+    #if CONFIG_BIQUAD_FILTER
+        { "af_biquads", checkasm_check_biquads },
+    #endif
+    #if CONFIG_FIREQUALIZER_FILTER
+        { "af_firequalizer", checkasm_check_firequalizer },
+    #endif
+    #if CONFIG_EBUR128_FILTER
+        { "ebur128", checkasm_check_ebur128 },
+    #endif
     #if CONFIG_BLEND_FILTER
         { "vf_blend", checkasm_check_blend },
     #endif
+    #if CONFIG_BOXBLUR_FILTER
+        { "vf_boxblur", checkasm_check_boxblur },
+    #endif
     #if CONFIG_COLORSPACE_FILTER
         { "vf_colorspace", checkasm_check_colorspace },
     #endif
+    #if CONFIG_HQDN3D_FILTER
+        { "vf_hqdn3d", checkasm_check_hqdn3d },
+    #endif
+    #if CONFIG_LUT_FILTER
+        { "vf_lut", checkasm_check_lut },
+    #endif
+    #if CONFIG_LUT3D_FILTER
+        { "vf_lut3d", checkasm_check_lut3d },
+    #endif
+    #if CONFIG_OVERLAY_FILTER
+        { "vf_overlay", checkasm_check_overlay },
+    #endif
+    #if CONFIG_PALETTEUSE_FILTER
+        { "vf_paletteuse", checkasm_check_paletteuse },
+    #endif
+    #if CONFIG_UNSHARP_FILTER
+        { "vf_unsharp", checkasm_check_unsharp },
+    #endif
+#endif
+#if CONFIG_SWSCALE
+    { "sw_rgb", checkasm_check_sw_rgb },
+    { "sw_scale", checkasm_check_sw_scale },
 #endif
     { NULL }
 };
@@ -0,0 +1,90 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/drawutils.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 256
+#define MASK_LINESIZE (2 * WIDTH)
+
+#define randomize_buffers(buf, size)       \
+    do {                                   \
+        int j;                             \
+        for (j = 0; j < size; j += 4)      \
+            AV_WN32(buf + j, rnd());       \
+    } while (0)
+
+static void check_blend_mask_row(enum AVPixelFormat format, int plane,
+                                 const char *name)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst0, [2 * WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [2 * WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, orig, [2 * WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, mask, [2 * MASK_LINESIZE]);
+    /* odd widths exercise the scalar tail in the caller */
+    static const int widths[] = { WIDTH, WIDTH - 1, 17, 1 };
+    static const uint8_t alphas[] = { 255, 128, 1 };
+    FFDrawContext draw;
+    int i, step, ret0, ret1;
+
+    declare_func(int, uint8_t *dst, const uint8_t *mask,
+                 ptrdiff_t mask_linesize, const uint8_t *color,
+                 unsigned alpha, int w);
+
+    if (ff_draw_init(&draw, format, 0) < 0)
+        return;
+    step = draw.pixelstep[plane];
+
+    if (check_func(draw.blend_mask_row[plane], "blend_mask_row_%s", name)) {
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            /* same alpha scaling as ff_blend_mask() */
+            unsigned alpha = (0x10307 * alphas[i % FF_ARRAY_ELEMS(alphas)] + 0x3) >> 8;
+            uint8_t color[2] = { rnd(), rnd() };
+
+            randomize_buffers(orig, 2 * WIDTH);
+            randomize_buffers(mask, 2 * MASK_LINESIZE);
+            /* make sure the fully transparent and opaque cases are hit */
+            mask[0] = mask[1] = mask[MASK_LINESIZE] = mask[MASK_LINESIZE + 1] = 0;
+            mask[2] = mask[3] = mask[MASK_LINESIZE + 2] = mask[MASK_LINESIZE + 3] = 255;
+            memcpy(dst0, orig, 2 * WIDTH);
+            memcpy(dst1, orig, 2 * WIDTH);
+
+            ret0 = call_ref(dst0, mask, MASK_LINESIZE, color, alpha, widths[i]);
+            ret1 = call_new(dst1, mask, MASK_LINESIZE, color, alpha, widths[i]);
+            /* the reference may be a SIMD version leaving a tail too */
+            if (ret0 < 0 || ret0 > widths[i] || ret1 < 0 || ret1 > widths[i] ||
+                memcmp(dst0, dst1, FFMIN(ret0, ret1) * step) ||
+                memcmp(dst1 + ret1 * step, orig + ret1 * step,
+                       (WIDTH - ret1) * step))
+                fail();
+        }
+        bench_new(dst1, mask, MASK_LINESIZE, orig, 0x10203, WIDTH);
+    }
+    report("blend_mask_row_%s", name);
+}
+
+void checkasm_check_drawutils(void)
+{
+    check_blend_mask_row(AV_PIX_FMT_YUV420P, 0, "1x1");
+    check_blend_mask_row(AV_PIX_FMT_YUV420P, 1, "2x2");
+    check_blend_mask_row(AV_PIX_FMT_NV12,    1, "2x2_uv");
+}
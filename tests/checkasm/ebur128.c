@@ -0,0 +1,74 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/ebur128.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define LEN      4800
+#define CHANNELS 6
+
+static const int lens[] = { 1, 2, 7, 100, LEN };
+
+static const int strides[] = { 2, CHANNELS };
+
+void checkasm_check_ebur128(void)
+{
+    static double src[LEN * CHANNELS];
+    double state_ref[12], state_new[12], state_init[12];
+    double energy_ref[2], energy_new[2];
+    EBUR128State st = { 0 };
+    int i, j, k;
+
+    declare_func(void, const double *src, ptrdiff_t stride, int nb_samples,
+                 double *state, double *energy, const double *coeffs);
+
+    if (ff_ebur128_init(&st, 2, 0, 48000, 0, 1) < 0) {
+        fail();
+        return;
+    }
+
+    for (i = 0; i < LEN * CHANNELS; i++)
+        src[i] = (double)rnd() / (UINT_MAX >> 1) - 1.0;
+    for (i = 0; i < 12; i++)
+        state_init[i] = (double)rnd() / (UINT_MAX >> 1) - 1.0;
+
+    if (check_func(st.dsp.kweight2, "ebur128_kweight2")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(strides); i++) {
+            for (j = 0; j < FF_ARRAY_ELEMS(lens); j++) {
+                memcpy(state_ref, state_init, sizeof(state_ref));
+                memcpy(state_new, state_init, sizeof(state_new));
+                for (k = 0; k < 2; k++)
+                    energy_ref[k] = energy_new[k] = k;
+                call_ref(src, strides[i], lens[j], state_ref, energy_ref, st.coeffs[0]);
+                call_new(src, strides[i], lens[j], state_new, energy_new, st.coeffs[0]);
+                /* the filters are evaluated in the same order, without fma */
+                if (memcmp(state_ref,  state_new,  sizeof(state_ref)) ||
+                    memcmp(energy_ref, energy_new, sizeof(energy_ref)))
+                    fail();
+            }
+        }
+        bench_new(src, CHANNELS, LEN, state_new, energy_new, st.coeffs[0]);
+    }
+    report("kweight2");
+
+    ff_ebur128_uninit(&st);
+}
@@ -0,0 +1,739 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/rgb2rgb.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#define WIDTH  512
+#define HEIGHT 4
+/* room for the largest pixels and the overwrite of the SIMD functions */
+#define STRIDE (WIDTH * 4 + 64)
+
+static const int widths[] = { 1, 2, 3, 15, 16, 17, 33, 100, WIDTH };
+
+static void randomize(uint8_t *buf, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        buf[i] = rnd();
+}
+
+static int max_diff(const uint8_t *a, const uint8_t *b, int size)
+{
+    int i, diff = 0;
+
+    for (i = 0; i < size; i++)
+        diff = FFMAX(diff, abs(a[i] - b[i]));
+    return diff;
+}
+
+static const struct {
+    const char *name;
+    void (**func)(const uint8_t *src, uint8_t *dst, int src_size);
+    int src_bpp, dst_bpp;
+} packed_funcs[] = {
+    { "rgb15to16",          &rgb15to16,          2, 2 },
+    { "rgb15to32",          &rgb15to32,          2, 4 },
+    { "rgb15tobgr24",       &rgb15tobgr24,       2, 3 },
+    { "rgb16to15",          &rgb16to15,          2, 2 },
+    { "rgb16to32",          &rgb16to32,          2, 4 },
+    { "rgb16tobgr24",       &rgb16tobgr24,       2, 3 },
+    { "rgb24to15",          &rgb24to15,          3, 2 },
+    { "rgb24to16",          &rgb24to16,          3, 2 },
+    { "rgb24tobgr15",       &rgb24tobgr15,       3, 2 },
+    { "rgb24tobgr16",       &rgb24tobgr16,       3, 2 },
+    { "rgb24tobgr24",       &rgb24tobgr24,       3, 3 },
+    { "rgb24tobgr32",       &rgb24tobgr32,       3, 4 },
+    { "rgb32to15",          &rgb32to15,          4, 2 },
+    { "rgb32to16",          &rgb32to16,          4, 2 },
+    { "rgb32tobgr15",       &rgb32tobgr15,       4, 2 },
+    { "rgb32tobgr16",       &rgb32tobgr16,       4, 2 },
+    { "rgb32tobgr24",       &rgb32tobgr24,       4, 3 },
+    { "shuffle_bytes_0321", &shuffle_bytes_0321, 4, 4 },
+    { "shuffle_bytes_2103", &shuffle_bytes_2103, 4, 4 },
+};
+
+static void check_packed(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [STRIDE]);
+    int f, i;
+
+    declare_func(void, const uint8_t *src, uint8_t *dst, int src_size);
+
+    randomize(src, STRIDE);
+    for (f = 0; f < FF_ARRAY_ELEMS(packed_funcs); f++) {
+        const int src_bpp = packed_funcs[f].src_bpp;
+        const int dst_bpp = packed_funcs[f].dst_bpp;
+
+        if (!check_func(*packed_funcs[f].func, "%s", packed_funcs[f].name))
+            continue;
+
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i];
+
+            memset(dst_ref, 0, STRIDE);
+            memset(dst_new, 0, STRIDE);
+            call_ref(src, dst_ref, w * src_bpp);
+            call_new(src, dst_new, w * src_bpp);
+            if (memcmp(dst_ref, dst_new, w * dst_bpp))
+                fail();
+        }
+        bench_new(src, dst_new, WIDTH * src_bpp);
+    }
+    report("packed");
+}
+
+static void check_interleave_bytes(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src0,    [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src1,    [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [HEIGHT * STRIDE]);
+    int i, y;
+
+    declare_func(void, const uint8_t *src1, const uint8_t *src2, uint8_t *dst,
+                 int width, int height, int src1Stride, int src2Stride,
+                 int dstStride);
+
+    if (check_func(interleaveBytes, "interleave_bytes")) {
+        randomize(src0, HEIGHT * STRIDE);
+        randomize(src1, HEIGHT * STRIDE);
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i];
+
+            memset(dst_ref, 0, HEIGHT * STRIDE);
+            memset(dst_new, 0, HEIGHT * STRIDE);
+            call_ref(src0, src1, dst_ref, w, HEIGHT, STRIDE / 2, STRIDE / 2, STRIDE);
+            call_new(src0, src1, dst_new, w, HEIGHT, STRIDE / 2, STRIDE / 2, STRIDE);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst_ref + y * STRIDE, dst_new + y * STRIDE, 2 * w))
+                    fail();
+        }
+        bench_new(src0, src1, dst_new, WIDTH, HEIGHT, STRIDE / 2, STRIDE / 2, STRIDE);
+    }
+    report("interleave_bytes");
+}
+
+static void check_deinterleave_bytes(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,      [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_new, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_new, [HEIGHT * STRIDE]);
+    int i, y;
+
+    declare_func(void, const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                 int width, int height, int srcStride,
+                 int dst1Stride, int dst2Stride);
+
+    if (check_func(deinterleaveBytes, "deinterleave_bytes")) {
+        randomize(src, HEIGHT * STRIDE);
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i];
+
+            memset(dst0_ref, 0, HEIGHT * STRIDE);
+            memset(dst0_new, 0, HEIGHT * STRIDE);
+            memset(dst1_ref, 0, HEIGHT * STRIDE);
+            memset(dst1_new, 0, HEIGHT * STRIDE);
+            call_ref(src, dst0_ref, dst1_ref, w, HEIGHT, STRIDE, STRIDE, STRIDE);
+            call_new(src, dst0_new, dst1_new, w, HEIGHT, STRIDE, STRIDE, STRIDE);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst0_ref + y * STRIDE, dst0_new + y * STRIDE, w) ||
+                    memcmp(dst1_ref + y * STRIDE, dst1_new + y * STRIDE, w))
+                    fail();
+        }
+        bench_new(src, dst0_new, dst1_new, WIDTH, HEIGHT, STRIDE, STRIDE, STRIDE);
+    }
+    report("deinterleave_bytes");
+}
+
+static void check_shift_words(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,     [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [HEIGHT * STRIDE / 2]);
+    int i, y;
+
+    declare_func(void, const uint16_t *src, uint16_t *dst, int width,
+                 int height, int srcStride, int dstStride, int shift);
+
+    if (check_func(shiftWords, "shift_words")) {
+        randomize((uint8_t *)src, HEIGHT * STRIDE);
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i];
+
+            memset(dst_ref, 0, HEIGHT * STRIDE);
+            memset(dst_new, 0, HEIGHT * STRIDE);
+            call_ref(src, dst_ref, w, HEIGHT, STRIDE, STRIDE, 6);
+            call_new(src, dst_new, w, HEIGHT, STRIDE, STRIDE, 6);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst_ref + y * STRIDE / 2, dst_new + y * STRIDE / 2, 2 * w))
+                    fail();
+        }
+        bench_new(src, dst_new, WIDTH, HEIGHT, STRIDE, STRIDE, 6);
+    }
+    report("shift_words");
+}
+
+static void check_shift_words_right(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,     [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [HEIGHT * STRIDE / 2]);
+    int i, y;
+
+    declare_func(void, const uint16_t *src, uint16_t *dst, int width,
+                 int height, int srcStride, int dstStride, int shift);
+
+    if (check_func(shiftWordsRight, "shift_words_right")) {
+        randomize((uint8_t *)src, HEIGHT * STRIDE);
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i];
+
+            memset(dst_ref, 0, HEIGHT * STRIDE);
+            memset(dst_new, 0, HEIGHT * STRIDE);
+            call_ref(src, dst_ref, w, HEIGHT, STRIDE, STRIDE, 6);
+            call_new(src, dst_new, w, HEIGHT, STRIDE, STRIDE, 6);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst_ref + y * STRIDE / 2, dst_new + y * STRIDE / 2, 2 * w))
+                    fail();
+        }
+        bench_new(src, dst_new, WIDTH, HEIGHT, STRIDE, STRIDE, 6);
+    }
+    report("shift_words_right");
+}
+
+static void check_interleave_words(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src0,    [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, src1,    [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [HEIGHT * STRIDE / 2]);
+    int i, y;
+
+    declare_func(void, const uint16_t *src1, const uint16_t *src2,
+                 uint16_t *dst, int width, int height, int src1Stride,
+                 int src2Stride, int dstStride, int shift);
+
+    if (check_func(interleaveWords, "interleave_words")) {
+        randomize((uint8_t *)src0, HEIGHT * STRIDE);
+        randomize((uint8_t *)src1, HEIGHT * STRIDE);
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i] / 2;
+
+            memset(dst_ref, 0, HEIGHT * STRIDE);
+            memset(dst_new, 0, HEIGHT * STRIDE);
+            call_ref(src0, src1, dst_ref, w, HEIGHT, STRIDE / 2, STRIDE / 2, STRIDE, 6);
+            call_new(src0, src1, dst_new, w, HEIGHT, STRIDE / 2, STRIDE / 2, STRIDE, 6);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst_ref + y * STRIDE / 2, dst_new + y * STRIDE / 2, 4 * w))
+                    fail();
+        }
+        bench_new(src0, src1, dst_new, WIDTH / 2, HEIGHT, STRIDE / 2, STRIDE / 2, STRIDE, 6);
+    }
+    report("interleave_words");
+}
+
+static void check_deinterleave_words(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,      [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_ref, [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_new, [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_ref, [HEIGHT * STRIDE / 2]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_new, [HEIGHT * STRIDE / 2]);
+    int i, y;
+
+    declare_func(void, const uint16_t *src, uint16_t *dst1, uint16_t *dst2,
+                 int width, int height, int srcStride, int dst1Stride,
+                 int dst2Stride, int shift);
+
+    if (check_func(deinterleaveWords, "deinterleave_words")) {
+        randomize((uint8_t *)src, HEIGHT * STRIDE);
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i] / 2;
+            /* shift 0 checks that full 16 bit samples pass unchanged */
+            const int shift = i & 1 ? 6 : 0;
+
+            memset(dst0_ref, 0, HEIGHT * STRIDE);
+            memset(dst0_new, 0, HEIGHT * STRIDE);
+            memset(dst1_ref, 0, HEIGHT * STRIDE);
+            memset(dst1_new, 0, HEIGHT * STRIDE);
+            call_ref(src, dst0_ref, dst1_ref, w, HEIGHT, STRIDE, STRIDE / 2, STRIDE / 2, shift);
+            call_new(src, dst0_new, dst1_new, w, HEIGHT, STRIDE, STRIDE / 2, STRIDE / 2, shift);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst0_ref + y * STRIDE / 4, dst0_new + y * STRIDE / 4, 2 * w) ||
+                    memcmp(dst1_ref + y * STRIDE / 4, dst1_new + y * STRIDE / 4, 2 * w))
+                    fail();
+        }
+        bench_new(src, dst0_new, dst1_new, WIDTH / 2, HEIGHT, STRIDE, STRIDE / 2, STRIDE / 2, 6);
+    }
+    report("deinterleave_words");
+}
+
+static void check_interleave_bytes_to_words(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src0,    [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src1,    [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [HEIGHT * STRIDE]);
+    int i, y;
+
+    declare_func(void, const uint8_t *src1, const uint8_t *src2, uint8_t *dst,
+                 int width, int height, int src1Stride, int src2Stride,
+                 int dstStride);
+
+    if (check_func(interleaveBytesToWords, "interleave_bytes_to_words")) {
+        randomize(src0, HEIGHT * STRIDE);
+        randomize(src1, HEIGHT * STRIDE);
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i];
+
+            memset(dst_ref, 0, HEIGHT * STRIDE);
+            memset(dst_new, 0, HEIGHT * STRIDE);
+            call_ref(src0, src1, dst_ref, w, HEIGHT, STRIDE / 4, STRIDE / 4, STRIDE);
+            call_new(src0, src1, dst_new, w, HEIGHT, STRIDE / 4, STRIDE / 4, STRIDE);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst_ref + y * STRIDE, dst_new + y * STRIDE, 4 * w))
+                    fail();
+        }
+        bench_new(src0, src1, dst_new, WIDTH, HEIGHT, STRIDE / 4, STRIDE / 4, STRIDE);
+    }
+    report("interleave_bytes_to_words");
+}
+
+/* the planar <-> packed YUV functions want widths multiple of 16 */
+static const int planar_widths[] = { 16, 32, 48, 112, WIDTH };
+
+static const struct {
+    const char *name;
+    void (**func)(const uint8_t *ysrc, const uint8_t *usrc, const uint8_t *vsrc,
+                  uint8_t *dst, int width, int height,
+                  int lumStride, int chromStride, int dstStride);
+} to_packed_funcs[] = {
+    { "yv12toyuy2",    &yv12toyuy2    },
+    { "yv12touyvy",    &yv12touyvy    },
+    { "yuv422ptoyuy2", &yuv422ptoyuy2 },
+    { "yuv422ptouyvy", &yuv422ptouyvy },
+};
+
+static void check_planar_to_packed(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src_y,   [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src_u,   [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src_v,   [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [HEIGHT * STRIDE]);
+    int f, i, y;
+
+    declare_func(void, const uint8_t *ysrc, const uint8_t *usrc,
+                 const uint8_t *vsrc, uint8_t *dst, int width, int height,
+                 int lumStride, int chromStride, int dstStride);
+
+    randomize(src_y, HEIGHT * STRIDE);
+    randomize(src_u, HEIGHT * STRIDE);
+    randomize(src_v, HEIGHT * STRIDE);
+    for (f = 0; f < FF_ARRAY_ELEMS(to_packed_funcs); f++) {
+        if (!check_func(*to_packed_funcs[f].func, "%s", to_packed_funcs[f].name))
+            continue;
+
+        for (i = 0; i < FF_ARRAY_ELEMS(planar_widths); i++) {
+            const int w = planar_widths[i];
+
+            memset(dst_ref, 0, HEIGHT * STRIDE);
+            memset(dst_new, 0, HEIGHT * STRIDE);
+            call_ref(src_y, src_u, src_v, dst_ref, w, HEIGHT,
+                     STRIDE / 2, STRIDE / 4, STRIDE);
+            call_new(src_y, src_u, src_v, dst_new, w, HEIGHT,
+                     STRIDE / 2, STRIDE / 4, STRIDE);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst_ref + y * STRIDE, dst_new + y * STRIDE, 2 * w))
+                    fail();
+        }
+        bench_new(src_y, src_u, src_v, dst_new, WIDTH, HEIGHT,
+                  STRIDE / 2, STRIDE / 4, STRIDE);
+    }
+    report("planar_to_packed");
+}
+
+static const struct {
+    const char *name;
+    void (**func)(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                  const uint8_t *src, int width, int height,
+                  int lumStride, int chromStride, int srcStride);
+    int log2_chroma_h;
+} from_packed_funcs[] = {
+    { "uyvytoyuv420", &uyvytoyuv420, 1 },
+    { "uyvytoyuv422", &uyvytoyuv422, 0 },
+    { "yuyvtoyuv420", &yuyvtoyuv420, 1 },
+    { "yuyvtoyuv422", &yuyvtoyuv422, 0 },
+};
+
+static void check_packed_to_planar(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,       [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_y_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_y_new, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_u_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_u_new, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_v_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_v_new, [HEIGHT * STRIDE]);
+    int f, i, y;
+
+    declare_func(void, uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                 const uint8_t *src, int width, int height,
+                 int lumStride, int chromStride, int srcStride);
+
+    randomize(src, HEIGHT * STRIDE);
+    for (f = 0; f < FF_ARRAY_ELEMS(from_packed_funcs); f++) {
+        const int chroma_h = HEIGHT >> from_packed_funcs[f].log2_chroma_h;
+        /* the SIMD versions round the average of the chroma lines of 4:2:0
+         * up, the C ones down */
+        const int tolerance = from_packed_funcs[f].log2_chroma_h;
+
+        if (!check_func(*from_packed_funcs[f].func, "%s", from_packed_funcs[f].name))
+            continue;
+
+        for (i = 0; i < FF_ARRAY_ELEMS(planar_widths); i++) {
+            const int w = planar_widths[i];
+
+            memset(dst_y_ref, 0, HEIGHT * STRIDE);
+            memset(dst_y_new, 0, HEIGHT * STRIDE);
+            memset(dst_u_ref, 0, HEIGHT * STRIDE);
+            memset(dst_u_new, 0, HEIGHT * STRIDE);
+            memset(dst_v_ref, 0, HEIGHT * STRIDE);
+            memset(dst_v_new, 0, HEIGHT * STRIDE);
+            call_ref(dst_y_ref, dst_u_ref, dst_v_ref, src, w, HEIGHT,
+                     STRIDE / 2, STRIDE / 4, STRIDE);
+            call_new(dst_y_new, dst_u_new, dst_v_new, src, w, HEIGHT,
+                     STRIDE / 2, STRIDE / 4, STRIDE);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst_y_ref + y * STRIDE / 2, dst_y_new + y * STRIDE / 2, w))
+                    fail();
+            for (y = 0; y < chroma_h; y++)
+                if (max_diff(dst_u_ref + y * STRIDE / 4, dst_u_new + y * STRIDE / 4, w / 2) > tolerance ||
+                    max_diff(dst_v_ref + y * STRIDE / 4, dst_v_new + y * STRIDE / 4, w / 2) > tolerance)
+                    fail();
+        }
+        bench_new(dst_y_new, dst_u_new, dst_v_new, src, WIDTH, HEIGHT,
+                  STRIDE / 2, STRIDE / 4, STRIDE);
+    }
+    report("packed_to_planar");
+}
+
+/* The SIMD versions take the chroma from the average of each 2x2 block, the
+ * C one from its top left pixel, so the blocks are filled with one color. */
+static void check_rgb24toyv12(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,       [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_y_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_y_new, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_u_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_u_new, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_v_ref, [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_v_new, [HEIGHT * STRIDE]);
+    SwsContext *ctx = sws_getContext(WIDTH, HEIGHT, AV_PIX_FMT_BGR24,
+                                     WIDTH, HEIGHT, AV_PIX_FMT_YUV420P,
+                                     SWS_BILINEAR, NULL, NULL, NULL);
+    int i, x, y;
+
+    declare_func(void, const uint8_t *src, uint8_t *ydst, uint8_t *udst,
+                 uint8_t *vdst, int width, int height, int lumStride,
+                 int chromStride, int srcStride, int32_t *rgb2yuv);
+
+    if (!ctx)
+        return;
+
+    for (y = 0; y < HEIGHT; y += 2) {
+        for (x = 0; x < WIDTH * 3; x += 6) {
+            uint8_t *p = src + y * STRIDE + x;
+
+            p[0] = p[3] = p[STRIDE + 0] = p[STRIDE + 3] = rnd();
+            p[1] = p[4] = p[STRIDE + 1] = p[STRIDE + 4] = rnd();
+            p[2] = p[5] = p[STRIDE + 2] = p[STRIDE + 5] = rnd();
+        }
+    }
+
+    if (check_func(ff_rgb24toyv12, "rgb24toyv12")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(planar_widths); i++) {
+            const int w = planar_widths[i];
+
+            memset(dst_y_ref, 0, HEIGHT * STRIDE);
+            memset(dst_y_new, 0, HEIGHT * STRIDE);
+            memset(dst_u_ref, 0, HEIGHT * STRIDE);
+            memset(dst_u_new, 0, HEIGHT * STRIDE);
+            memset(dst_v_ref, 0, HEIGHT * STRIDE);
+            memset(dst_v_new, 0, HEIGHT * STRIDE);
+            call_ref(src, dst_y_ref, dst_u_ref, dst_v_ref, w, HEIGHT,
+                     STRIDE / 2, STRIDE / 4, STRIDE, ctx->input_rgb2yuv_table);
+            call_new(src, dst_y_new, dst_u_new, dst_v_new, w, HEIGHT,
+                     STRIDE / 2, STRIDE / 4, STRIDE, ctx->input_rgb2yuv_table);
+            for (y = 0; y < HEIGHT; y++)
+                if (memcmp(dst_y_ref + y * STRIDE / 2, dst_y_new + y * STRIDE / 2, w))
+                    fail();
+            for (y = 0; y < HEIGHT / 2; y++)
+                if (memcmp(dst_u_ref + y * STRIDE / 4, dst_u_new + y * STRIDE / 4, w / 2) ||
+                    memcmp(dst_v_ref + y * STRIDE / 4, dst_v_new + y * STRIDE / 4, w / 2))
+                    fail();
+        }
+        bench_new(src, dst_y_new, dst_u_new, dst_v_new, WIDTH, HEIGHT,
+                  STRIDE / 2, STRIDE / 4, STRIDE, ctx->input_rgb2yuv_table);
+    }
+    sws_freeContext(ctx);
+    report("rgb24toyv12");
+}
+
+/* The C yuv422p converters skip every other chroma line, unlike the
+ * SIMD ones, so only 4:2:0 input is compared. */
+static const enum AVPixelFormat yuv2rgb_srcs[] = {
+    AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUVA420P, AV_PIX_FMT_NV12, AV_PIX_FMT_NV21,
+};
+
+static const int yuv2rgb_widths[] = { 8, 16, 24, 64, 200, WIDTH };
+
+/* Largest difference between the components of two lines of RGB565/555
+ * pixels, in their own precision. */
+static int max_component_diff(const uint8_t *a, const uint8_t *b, int w,
+                              const AVPixFmtDescriptor *desc)
+{
+    int i, c, diff = 0;
+
+    for (i = 0; i < w; i++) {
+        const int pa = AV_RL16(a + 2 * i), pb = AV_RL16(b + 2 * i);
+        for (c = 0; c < 3; c++) {
+            const int shift = desc->comp[c].offset * 8 + desc->comp[c].shift;
+            const int depth = desc->comp[c].depth;
+            const int mask  = (1 << depth) - 1;
+            diff = FFMAX(diff, abs(((pa >> shift) & mask) - ((pb >> shift) & mask)));
+        }
+    }
+    return diff;
+}
+
+#if ARCH_X86
+/* The fixed point arithmetic of the x86 SIMD converters of the 24 and 32
+ * bit formats, which the table based C ones only approximate, for the pixel
+ * x of the line y. Returns the size of the pixel, 0 for the other formats. */
+static int yuv2rgb_model(const SwsContext *c, const uint8_t *src[4],
+                         const int src_stride[4], int x, int y,
+                         enum AVPixelFormat dst_format, uint8_t *dst)
+{
+    const uint8_t *pc = src[1] + (y >> 1) * src_stride[1];
+    int u, v, r, g, b, a = 255;
+
+    if (c->srcFormat == AV_PIX_FMT_NV12 || c->srcFormat == AV_PIX_FMT_NV21) {
+        u = pc[(x & ~1) + (c->srcFormat == AV_PIX_FMT_NV21)];
+        v = pc[(x & ~1) + (c->srcFormat == AV_PIX_FMT_NV12)];
+    } else {
+        u = pc[x >> 1];
+        v = src[2][(y >> 1) * src_stride[2] + (x >> 1)];
+    }
+    if (c->srcFormat == AV_PIX_FMT_YUVA420P)
+        a = src[3][y * src_stride[3] + x];
+
+    u = av_clip_int16(u * 8 - (int16_t)c->uOffset);
+    v = av_clip_int16(v * 8 - (int16_t)c->vOffset);
+    y = (int16_t)(src[0][y * src_stride[0] + x] * 8 - (int16_t)c->yOffset);
+    y = y * (int16_t)c->yCoeff >> 16;
+    g = av_clip_int16((u * (int16_t)c->ugCoeff >> 16) +
+                      (v * (int16_t)c->vgCoeff >> 16));
+    r = av_clip_uint8(av_clip_int16(y + (v * (int16_t)c->vrCoeff >> 16)));
+    g = av_clip_uint8(av_clip_int16(y + g));
+    b = av_clip_uint8(av_clip_int16(y + (u * (int16_t)c->ubCoeff >> 16)));
+
+    switch (dst_format) {
+    case AV_PIX_FMT_RGB24: dst[0] = r; dst[1] = g; dst[2] = b;             return 3;
+    case AV_PIX_FMT_BGR24: dst[0] = b; dst[1] = g; dst[2] = r;             return 3;
+    case AV_PIX_FMT_RGBA:  dst[0] = r; dst[1] = g; dst[2] = b; dst[3] = a; return 4;
+    case AV_PIX_FMT_BGRA:  dst[0] = b; dst[1] = g; dst[2] = r; dst[3] = a; return 4;
+    case AV_PIX_FMT_ARGB:  dst[0] = a; dst[1] = r; dst[2] = g; dst[3] = b; return 4;
+    case AV_PIX_FMT_ABGR:  dst[0] = a; dst[1] = b; dst[2] = g; dst[3] = r; return 4;
+    }
+    return 0;
+}
+#endif
+
+/* Check the output of a converter against the one of the C converter: up to
+ * a difference of 3 for the 24 and 32 bit formats, of 2 for RGB565/555,
+ * which are dithered differently. The x86 SIMD converters of the 24 and 32
+ * bit formats are also checked exactly against the model. */
+static int check_yuv2rgb_output(const SwsContext *c, const uint8_t *src[4],
+                                const int src_stride[4],
+                                const AVPixFmtDescriptor *desc,
+                                const uint8_t *dst_c, const uint8_t *dst_new,
+                                int simd)
+{
+    const int bpp = av_get_padded_bits_per_pixel(desc) >> 3;
+    int y;
+
+    for (y = 0; y < HEIGHT; y++) {
+        const uint8_t *line_c   = dst_c   + y * STRIDE;
+        const uint8_t *line_new = dst_new + y * STRIDE;
+
+        if (bpp == 2) {
+            if (max_component_diff(line_c, line_new, c->dstW, desc) > 2)
+                return 1;
+            continue;
+        }
+        if (max_diff(line_c, line_new, c->dstW * bpp) > 3)
+            return 1;
+#if ARCH_X86
+        if (simd) {
+            const enum AVPixelFormat dst_format = av_pix_fmt_desc_get_id(desc);
+            uint8_t pixel[4];
+            int x;
+
+            for (x = 0; x < c->dstW; x++) {
+                yuv2rgb_model(c, src, src_stride, x, y, dst_format, pixel);
+                if (memcmp(pixel, line_new + x * bpp, bpp))
+                    return 1;
+            }
+        }
+#endif
+    }
+    return 0;
+}
+
+/* Get a context using the C converter, whatever the cpu flags of the test. */
+static SwsContext *get_c_context(int w, enum AVPixelFormat src_format,
+                                 enum AVPixelFormat dst_format)
+{
+    const int cpu_flags = av_get_cpu_flags();
+    SwsContext *c;
+
+    av_force_cpu_flags(0);
+    c = sws_getContext(w, HEIGHT, src_format, w, HEIGHT, dst_format,
+                       SWS_BILINEAR, NULL, NULL, NULL);
+    av_force_cpu_flags(cpu_flags);
+    return c;
+}
+
+static const enum AVPixelFormat yuv2rgb_dsts[] = {
+    AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24,
+    AV_PIX_FMT_RGBA,  AV_PIX_FMT_BGRA, AV_PIX_FMT_ARGB, AV_PIX_FMT_ABGR,
+    AV_PIX_FMT_RGB565, AV_PIX_FMT_RGB555,
+};
+
+static void check_yuv2rgb(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src_y,   [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src_u,   [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src_v,   [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src_a,   [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_c,   [HEIGHT * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [HEIGHT * STRIDE]);
+    const uint8_t *src[4] = { src_y, src_u, src_v, src_a };
+    int src_stride[4] = { STRIDE, STRIDE / 2, STRIDE / 2, STRIDE };
+    uint8_t *dst_c_planes[4]   = { dst_c };
+    uint8_t *dst_new_planes[4] = { dst_new };
+    int dst_stride[4] = { STRIDE };
+    const int log_level = av_log_get_level();
+    int s, d, i;
+
+    declare_func(int, SwsContext *c, const uint8_t *src[], int srcStride[],
+                 int srcSliceY, int srcSliceH, uint8_t *dst[], int dstStride[]);
+
+    randomize(src_y, HEIGHT * STRIDE);
+    randomize(src_u, HEIGHT * STRIDE);
+    randomize(src_v, HEIGHT * STRIDE);
+    randomize(src_a, HEIGHT * STRIDE);
+    /* the contexts without accelerated converters are not worth a warning */
+    av_log_set_level(AV_LOG_ERROR);
+
+    for (s = 0; s < FF_ARRAY_ELEMS(yuv2rgb_srcs); s++) {
+        for (d = 0; d < FF_ARRAY_ELEMS(yuv2rgb_dsts); d++) {
+            const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(yuv2rgb_dsts[d]);
+            const int nv12 = yuv2rgb_srcs[s] == AV_PIX_FMT_NV12 ||
+                             yuv2rgb_srcs[s] == AV_PIX_FMT_NV21;
+            SwsContext *ctx = sws_getContext(WIDTH, HEIGHT, yuv2rgb_srcs[s],
+                                             WIDTH, HEIGHT, yuv2rgb_dsts[d],
+                                             SWS_BILINEAR, NULL, NULL, NULL);
+
+            if (!ctx)
+                continue;
+            src_stride[1] = nv12 ? STRIDE : STRIDE / 2;
+            /* the converter only depends on the formats, the width is
+             * taken from the context it is called with */
+            if (check_func(ctx->swscale, "%s_to_%s",
+                           av_get_pix_fmt_name(yuv2rgb_srcs[s]), desc->name)) {
+                for (i = 0; i < FF_ARRAY_ELEMS(yuv2rgb_widths); i++) {
+                    const int w = yuv2rgb_widths[i];
+                    SwsContext *wctx = sws_getContext(w, HEIGHT, yuv2rgb_srcs[s],
+                                                      w, HEIGHT, yuv2rgb_dsts[d],
+                                                      SWS_BILINEAR, NULL, NULL, NULL);
+                    SwsContext *cctx = get_c_context(w, yuv2rgb_srcs[s],
+                                                     yuv2rgb_dsts[d]);
+
+                    if (!wctx || !cctx || wctx->swscale != ctx->swscale) {
+                        sws_freeContext(wctx);
+                        sws_freeContext(cctx);
+                        continue;
+                    }
+                    memset(dst_c,   0, HEIGHT * STRIDE);
+                    memset(dst_new, 0, HEIGHT * STRIDE);
+                    /* the reference is the C converter, not the previously
+                     * tested version */
+                    cctx->swscale(cctx, src, src_stride, 0, HEIGHT,
+                                  dst_c_planes, dst_stride);
+                    call_new(wctx, src, src_stride, 0, HEIGHT,
+                             dst_new_planes, dst_stride);
+                    if (check_yuv2rgb_output(wctx, src, src_stride, desc,
+                                             dst_c, dst_new,
+                                             wctx->swscale != cctx->swscale))
+                        fail();
+                    sws_freeContext(wctx);
+                    sws_freeContext(cctx);
+                }
+                bench_new(ctx, src, src_stride, 0, HEIGHT,
+                          dst_new_planes, dst_stride);
+            }
+            sws_freeContext(ctx);
+        }
+    }
+    av_log_set_level(log_level);
+    report("yuv2rgb");
+}
+
+void checkasm_check_sw_rgb(void)
+{
+    ff_sws_rgb2rgb_init();
+
+    check_packed();
+    check_interleave_bytes();
+    check_deinterleave_bytes();
+    check_shift_words();
+    check_shift_words_right();
+    check_interleave_words();
+    check_deinterleave_words();
+    check_interleave_bytes_to_words();
+    check_planar_to_packed();
+    check_packed_to_planar();
+    check_rgb24toyv12();
+    check_yuv2rgb();
+}
@@ -0,0 +1,421 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#define WIDTH      512
+#define SRC_WIDTH  (2 * WIDTH)
+#define MAX_FILTER 40
+/* the SIMD functions process up to 32 pixels past the requested width */
+#define PAD        32
+
+static const int widths[] = { 1, 7, 16, 33, 100, WIDTH };
+
+/* Random filter of nb_rows rows of size taps summing to sum, like the
+ * normalized filters of initFilter(). */
+static void fill_filter(int16_t *filter, int nb_rows, int size, int sum, int range)
+{
+    int i, j;
+
+    for (i = 0; i < nb_rows; i++) {
+        int acc = 0;
+        for (j = 0; j < size - 1; j++) {
+            filter[i * size + j] = rnd() % range - range / 8;
+            acc += filter[i * size + j];
+        }
+        filter[i * size + j] = sum - acc;
+    }
+}
+
+static void check_hscale(SwsContext *ctx)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,     [SRC_WIDTH + PAD]);
+    LOCAL_ALIGNED_32(int32_t,  dst_ref, [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(int32_t,  dst_new, [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(int16_t,  filter,  [(WIDTH + 7) * MAX_FILTER]);
+    LOCAL_ALIGNED_32(int32_t,  filter_pos, [WIDTH + 7]);
+    static const struct {
+        enum AVPixelFormat fmt;
+        int bpc;
+    } srcs[] = {
+        { AV_PIX_FMT_YUV420P,     8 },
+        { AV_PIX_FMT_YUV420P9LE,  9 },
+        { AV_PIX_FMT_YUV420P10LE, 10 },
+        { AV_PIX_FMT_YUV420P12LE, 12 },
+        { AV_PIX_FMT_YUV420P14LE, 14 },
+        { AV_PIX_FMT_YUV420P16LE, 16 },
+    };
+    static const int filter_sizes[] = { 4, 8, 12, 16, 20, 40 };
+    int s, d, f, i, p, w;
+
+    declare_func(void, SwsContext *c, int16_t *dst, int dstW,
+                 const uint8_t *src, const int16_t *filter,
+                 const int32_t *filterPos, int filterSize);
+
+    for (s = 0; s < FF_ARRAY_ELEMS(srcs); s++) {
+        const int bpc = srcs[s].bpc;
+
+        for (i = 0; i < SRC_WIDTH + PAD; i++)
+            src[i] = rnd() & ((1 << bpc) - 1);
+        if (bpc == 8)
+            for (i = 0; i < SRC_WIDTH + PAD; i++)
+                ((uint8_t *)src)[i] = rnd();
+
+        for (d = 0; d < 2; d++) {
+            const int out_bits = d ? 19 : 15;
+
+            for (f = 0; f < FF_ARRAY_ELEMS(filter_sizes); f++) {
+                const int size = filter_sizes[f];
+
+                ctx->srcFormat      = srcs[s].fmt;
+                ctx->srcBpc         = bpc;
+                ctx->dstBpc         = d ? 16 : 8;
+                ctx->hLumFilterSize = ctx->hChrFilterSize = size;
+                ff_getSwsFunc(ctx);
+
+                for (p = 0; p < 2; p++) {
+                    /* dispatched on the luma and chroma filter sizes */
+                    if (!check_func(p ? ctx->hcScale : ctx->hyScale,
+                                    "%s_%d_to_%d_%d", p ? "hcscale" : "hyscale",
+                                    bpc, out_bits, size))
+                        continue;
+
+                    /* the taps sum to 1.0 in 1.14, as the 16 bit input
+                     * functions rely on it */
+                    fill_filter(filter, WIDTH + 7, size, 1 << 14, 32768 / size);
+                    for (i = 0; i < WIDTH; i++)
+                        filter_pos[i] = rnd() % (SRC_WIDTH - size + 1);
+                    /* padded like initFilter() does */
+                    for (; i < WIDTH + 7; i++) {
+                        filter_pos[i] = filter_pos[WIDTH - 1];
+                        memcpy(filter + i * size, filter + (WIDTH - 1) * size,
+                               size * sizeof(*filter));
+                    }
+
+                    for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+                        w = widths[i];
+                        memset(dst_ref, 0, (WIDTH + PAD) * sizeof(*dst_ref));
+                        memset(dst_new, 0, (WIDTH + PAD) * sizeof(*dst_new));
+                        call_ref(ctx, (int16_t *)dst_ref, w, (const uint8_t *)src,
+                                 filter, filter_pos, size);
+                        call_new(ctx, (int16_t *)dst_new, w, (const uint8_t *)src,
+                                 filter, filter_pos, size);
+                        if (memcmp(dst_ref, dst_new, w * (d ? 4 : 2)))
+                            fail();
+                    }
+                    bench_new(ctx, (int16_t *)dst_new, WIDTH, (const uint8_t *)src,
+                              filter, filter_pos, size);
+                }
+            }
+        }
+    }
+    report("hscale");
+}
+
+static void check_hscale_lowp(SwsContext *ctx)
+{
+    LOCAL_ALIGNED_32(uint8_t,  src,     [SRC_WIDTH + PAD]);
+    LOCAL_ALIGNED_32(int16_t,  dst_ref, [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(int16_t,  dst_new, [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(int8_t,   filter,  [WIDTH * MAX_FILTER]);
+    LOCAL_ALIGNED_32(int32_t,  filter_pos, [WIDTH + 7]);
+    static const int filter_sizes[] = { 4, 8, 12, 16, 20, 40 };
+    int f, i, j, w;
+
+    declare_func(void, int16_t *dst, int dstW, const uint8_t *src,
+                 const int8_t *filter, const int32_t *filterPos, int filterSize);
+
+    for (i = 0; i < SRC_WIDTH + PAD; i++)
+        src[i] = rnd();
+
+    ctx->srcFormat = AV_PIX_FMT_YUV420P;
+    ctx->srcBpc    = 8;
+    ctx->dstBpc    = 8;
+    ff_getSwsFunc(ctx);
+
+    for (f = 0; f < FF_ARRAY_ELEMS(filter_sizes); f++) {
+        const int size   = filter_sizes[f];
+        const int blocks = size / 4;
+        const int range  = 48 / size + 1;
+
+        if (!check_func(ctx->hScale8To15_lowp, "hscale8to15_lowp_%d", size))
+            continue;
+
+        /* 6 bit taps summing to 64 in the layout of hLumFilter8, small
+         * enough for the 16 bit accumulation not to overflow */
+        for (i = 0; i < WIDTH; i++) {
+            int8_t *row = filter + ((i >> 3) * blocks * 8 + (i & 7)) * 4;
+            int acc = 0;
+            for (j = 0; j < size - 1; j++) {
+                row[(j >> 2) * 32 + (j & 3)] = rnd() % range - range / 8;
+                acc += row[(j >> 2) * 32 + (j & 3)];
+            }
+            row[(j >> 2) * 32 + (j & 3)] = 64 - acc;
+        }
+        for (i = 0; i < WIDTH; i++)
+            filter_pos[i] = rnd() % (SRC_WIDTH - size + 1);
+        for (; i < WIDTH + 7; i++)
+            filter_pos[i] = filter_pos[WIDTH - 1];
+
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            w = widths[i];
+            memset(dst_ref, 0, (WIDTH + PAD) * sizeof(*dst_ref));
+            memset(dst_new, 0, (WIDTH + PAD) * sizeof(*dst_new));
+            call_ref(dst_ref, w, src, filter, filter_pos, size);
+            call_new(dst_new, w, src, filter, filter_pos, size);
+            if (memcmp(dst_ref, dst_new, w * sizeof(*dst_ref)))
+                fail();
+        }
+        bench_new(dst_new, WIDTH, src, filter, filter_pos, size);
+    }
+    report("hscale_lowp");
+}
+
+static const struct {
+    enum AVPixelFormat fmt;
+    int bpc;
+} vscale_dsts[] = {
+    { AV_PIX_FMT_YUV420P,     8 },
+    { AV_PIX_FMT_YUV420P9LE,  9 },
+    { AV_PIX_FMT_YUV420P10LE, 10 },
+    { AV_PIX_FMT_YUV420P16LE, 16 },
+};
+
+static void fill_lines(int32_t *lines, int nb_lines, int bpc)
+{
+    int i;
+
+    /* 15 bit input in int16_t, 19 bit input in int32_t for 16 bit output */
+    if (bpc == 16) {
+        for (i = 0; i < nb_lines * (WIDTH + PAD); i++)
+            lines[i] = rnd() & 0x7ffff;
+    } else {
+        int16_t *l = (int16_t *)lines;
+        for (i = 0; i < nb_lines * (WIDTH + PAD); i++)
+            l[i] = rnd() & 0x7fff;
+    }
+}
+
+static void check_yuv2planeX(SwsContext *ctx)
+{
+    LOCAL_ALIGNED_32(int32_t, lines,   [16 * (WIDTH + PAD)]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [WIDTH + PAD]);
+    LOCAL_ALIGNED_8(uint8_t,  dither,  [8]);
+    const int16_t *src[16];
+    int16_t filter[16];
+    static const int filter_sizes[] = { 2, 4, 6, 8, 16 };
+    int d, f, i, j, w;
+
+    declare_func(void, const int16_t *filter, int filterSize,
+                 const int16_t **src, uint8_t *dest, int dstW,
+                 const uint8_t *dither, int offset);
+
+    for (i = 0; i < 8; i++)
+        dither[i] = rnd() & 0x7f;
+
+    for (d = 0; d < FF_ARRAY_ELEMS(vscale_dsts); d++) {
+        const int bpc = vscale_dsts[d].bpc;
+
+        ctx->dstFormat = vscale_dsts[d].fmt;
+        ctx->dstBpc    = bpc;
+        ctx->flags    |= SWS_ACCURATE_RND;
+        ctx->use_mmx_vfilter = 0;
+        ff_getSwsFunc(ctx);
+
+        if (!check_func(ctx->yuv2planeX, "yuv2planeX_%d", bpc))
+            continue;
+
+        fill_lines(lines, 16, bpc);
+        for (i = 0; i < 16; i++)
+            src[i] = (const int16_t *)(lines + i * (WIDTH + PAD));
+
+        for (f = 0; f < FF_ARRAY_ELEMS(filter_sizes); f++) {
+            const int size = filter_sizes[f];
+
+            /* 1.0 is 1 << 12 */
+            fill_filter(filter, 1, size, 1 << 12, 8192 / size);
+            for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+                w = widths[i];
+                for (j = 0; j < 2; j++) {
+                    const int offset = j * 3;
+
+                    memset(dst_ref, 0, (WIDTH + PAD) * sizeof(*dst_ref));
+                    memset(dst_new, 0, (WIDTH + PAD) * sizeof(*dst_new));
+                    call_ref(filter, size, src, (uint8_t *)dst_ref, w, dither, offset);
+                    call_new(filter, size, src, (uint8_t *)dst_new, w, dither, offset);
+                    if (memcmp(dst_ref, dst_new, w * (bpc > 8 ? 2 : 1)))
+                        fail();
+                }
+            }
+            if (size == 4 || size == 8)
+                bench_new(filter, size, src, (uint8_t *)dst_new, WIDTH, dither, 0);
+        }
+    }
+    report("yuv2planeX");
+}
+
+static void check_yuv2plane1(SwsContext *ctx)
+{
+    LOCAL_ALIGNED_32(int32_t, line,    [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [WIDTH + PAD]);
+    LOCAL_ALIGNED_8(uint8_t,  dither,  [8]);
+    int d, i, j, w;
+
+    declare_func(void, const int16_t *src, uint8_t *dest, int dstW,
+                 const uint8_t *dither, int offset);
+
+    for (i = 0; i < 8; i++)
+        dither[i] = rnd() & 0x7f;
+
+    for (d = 0; d < FF_ARRAY_ELEMS(vscale_dsts); d++) {
+        const int bpc = vscale_dsts[d].bpc;
+
+        ctx->dstFormat = vscale_dsts[d].fmt;
+        ctx->dstBpc    = bpc;
+        ff_getSwsFunc(ctx);
+
+        if (!check_func(ctx->yuv2plane1, "yuv2plane1_%d", bpc))
+            continue;
+
+        fill_lines(line, 1, bpc);
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            w = widths[i];
+            for (j = 0; j < 2; j++) {
+                const int offset = j * 3;
+
+                memset(dst_ref, 0, (WIDTH + PAD) * sizeof(*dst_ref));
+                memset(dst_new, 0, (WIDTH + PAD) * sizeof(*dst_new));
+                call_ref((const int16_t *)line, (uint8_t *)dst_ref, w, dither, offset);
+                call_new((const int16_t *)line, (uint8_t *)dst_new, w, dither, offset);
+                if (memcmp(dst_ref, dst_new, w * (bpc > 8 ? 2 : 1)))
+                    fail();
+            }
+        }
+        bench_new((const int16_t *)line, (uint8_t *)dst_new, WIDTH, dither, 0);
+    }
+    report("yuv2plane1");
+}
+
+static const enum AVPixelFormat input_fmts[] = {
+    AV_PIX_FMT_YA8, AV_PIX_FMT_YUYV422, AV_PIX_FMT_UYVY422,
+    AV_PIX_FMT_NV12, AV_PIX_FMT_NV21,
+    AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24,
+    AV_PIX_FMT_RGBA, AV_PIX_FMT_BGRA, AV_PIX_FMT_ARGB, AV_PIX_FMT_ABGR,
+};
+
+static void check_input(SwsContext *ctx)
+{
+    LOCAL_ALIGNED_32(uint8_t,  src,       [WIDTH * 4 + PAD * 4]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_ref,  [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_new,  [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_ref,  [WIDTH + PAD]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_new,  [WIDTH + PAD]);
+    uint32_t *table = (uint32_t *)ctx->input_rgb2yuv_table;
+    int f, i, p, w;
+
+    for (i = 0; i < WIDTH * 4 + PAD * 4; i++)
+        src[i] = rnd();
+
+    for (f = 0; f < FF_ARRAY_ELEMS(input_fmts); f++) {
+        const enum AVPixelFormat fmt = input_fmts[f];
+        const char *name = av_get_pix_fmt_name(fmt);
+        /* 8 bit packed and semi-planar input is copied, RGB is converted
+         * to 15 bit */
+        const int out_size = isAnyRGB(fmt) ? 2 : 1;
+
+        ctx->srcFormat        = fmt;
+        ctx->srcBpc           = 8;
+        ctx->chrSrcHSubSample = 0;
+        ctx->needAlpha        = isALPHA(fmt);
+        ff_getSwsFunc(ctx);
+
+        for (p = 0; p < 2; p++) {
+            declare_func(void, uint8_t *dst, const uint8_t *src,
+                         const uint8_t *src2, const uint8_t *src3,
+                         int width, uint32_t *pal);
+
+            if (check_func(p ? ctx->alpToYV12 : ctx->lumToYV12, "%s_to_%s",
+                           name, p ? "a" : "y")) {
+                for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+                    w = widths[i];
+                    memset(dst0_ref, 0, (WIDTH + PAD) * sizeof(*dst0_ref));
+                    memset(dst0_new, 0, (WIDTH + PAD) * sizeof(*dst0_new));
+                    call_ref((uint8_t *)dst0_ref, src, src, src, w, table);
+                    call_new((uint8_t *)dst0_new, src, src, src, w, table);
+                    if (memcmp(dst0_ref, dst0_new, w * out_size))
+                        fail();
+                }
+                bench_new((uint8_t *)dst0_new, src, src, src, WIDTH, table);
+            }
+        }
+
+        if (ctx->chrToYV12) {
+            declare_func(void, uint8_t *dstU, uint8_t *dstV,
+                         const uint8_t *src1, const uint8_t *src2,
+                         const uint8_t *src3, int width, uint32_t *pal);
+
+            if (check_func(ctx->chrToYV12, "%s_to_uv", name)) {
+                for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+                    w = widths[i];
+                    memset(dst0_ref, 0, (WIDTH + PAD) * sizeof(*dst0_ref));
+                    memset(dst0_new, 0, (WIDTH + PAD) * sizeof(*dst0_new));
+                    memset(dst1_ref, 0, (WIDTH + PAD) * sizeof(*dst1_ref));
+                    memset(dst1_new, 0, (WIDTH + PAD) * sizeof(*dst1_new));
+                    call_ref((uint8_t *)dst0_ref, (uint8_t *)dst1_ref,
+                             src, src, src, w, table);
+                    call_new((uint8_t *)dst0_new, (uint8_t *)dst1_new,
+                             src, src, src, w, table);
+                    if (memcmp(dst0_ref, dst0_new, w * out_size) ||
+                        memcmp(dst1_ref, dst1_new, w * out_size))
+                        fail();
+                }
+                bench_new((uint8_t *)dst0_new, (uint8_t *)dst1_new,
+                          src, src, src, WIDTH, table);
+            }
+        }
+    }
+    report("input");
+}
+
+void checkasm_check_sw_scale(void)
+{
+    SwsContext *ctx = sws_alloc_context();
+
+    /* a default context, whose function pointers are then redispatched
+     * for each tested configuration */
+    if (!ctx || sws_init_context(ctx, NULL, NULL) < 0)
+        goto end;
+
+    check_hscale(ctx);
+    check_hscale_lowp(ctx);
+    check_yuv2planeX(ctx);
+    check_yuv2plane1(ctx);
+    check_input(ctx);
+
+end:
+    sws_freeContext(ctx);
+}
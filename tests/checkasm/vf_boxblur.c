@@ -0,0 +1,91 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/boxblur.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 64
+
+static const int widths[] = { 1, 3, 4, 8, 17, WIDTH };
+
+/* the inverses of the box lengths of radius 1, 2, 10 and 100 */
+static const int invs[] = { 21845, 13107, 3121, 326 };
+
+#define CHECK_BLUR_ROW(depth, type, mask)                                           \
+static void check_blur_row##depth(const BoxBlurDSPContext *dsp)                     \
+{                                                                                   \
+    LOCAL_ALIGNED_32(uint32_t, sum_init, [WIDTH]);                                  \
+    LOCAL_ALIGNED_32(uint32_t, sum_ref, [WIDTH]);                                   \
+    LOCAL_ALIGNED_32(uint32_t, sum_new, [WIDTH]);                                   \
+    LOCAL_ALIGNED_32(type,     dst_ref, [WIDTH]);                                   \
+    LOCAL_ALIGNED_32(type,     dst_new, [WIDTH]);                                   \
+    LOCAL_ALIGNED_32(type,     add,     [WIDTH]);                                   \
+    LOCAL_ALIGNED_32(type,     sub,     [WIDTH]);                                   \
+    int i, j, k, n, n0, n1;                                                         \
+                                                                                    \
+    declare_func(int, uint32_t *sum, type *dst, const type *add,                    \
+                 const type *sub, int inv, int width);                              \
+                                                                                    \
+    if (check_func(dsp->blur_row##depth, "boxblur_blur_row" #depth)) {              \
+        for (i = 0; i < FF_ARRAY_ELEMS(invs); i++) {                                \
+            for (j = 0; j < FF_ARRAY_ELEMS(widths); j++) {                          \
+                const int w = widths[j];                                            \
+                                                                                    \
+                /* any sum, the C code relies on them wrapping */                   \
+                for (k = 0; k < WIDTH; k++) {                                       \
+                    sum_init[k] = sum_ref[k] = sum_new[k] = rnd();                  \
+                    add[k] = rnd() & mask;                                          \
+                    sub[k] = rnd() & mask;                                          \
+                }                                                                   \
+                memset(dst_ref, 0, WIDTH * sizeof(type));                           \
+                memset(dst_new, 0, WIDTH * sizeof(type));                           \
+                n0 = call_ref(sum_ref, dst_ref, add, sub, invs[i], w);              \
+                n1 = call_new(sum_new, dst_new, add, sub, invs[i], w);              \
+                /* the samples not processed are left to the caller, by the         \
+                 * reference too when it is a SIMD version */                       \
+                n  = FFMIN(n0, n1);                                                 \
+                for (k = n1; k < WIDTH && !dst_new[k]; k++);                        \
+                if (n0 < 0 || n0 > w || n1 < 0 || n1 > w || k < WIDTH ||            \
+                    memcmp(sum_ref, sum_new, n * sizeof(*sum_ref)) ||               \
+                    memcmp(sum_new + n1, sum_init + n1,                             \
+                           (WIDTH - n1) * sizeof(*sum_new)) ||                      \
+                    memcmp(dst_ref, dst_new, n * sizeof(type)))                     \
+                    fail();                                                         \
+            }                                                                       \
+        }                                                                           \
+        bench_new(sum_new, dst_new, add, sub, invs[1], WIDTH);                      \
+    }                                                                               \
+    report("blur_row" #depth);                                                      \
+}
+
+CHECK_BLUR_ROW(8,  uint8_t,  0xff)
+CHECK_BLUR_ROW(16, uint16_t, 0xffff)
+
+void checkasm_check_boxblur(void)
+{
+    BoxBlurDSPContext dsp;
+
+    ff_boxblur_init(&dsp);
+
+    check_blur_row8(&dsp);
+    check_blur_row16(&dsp);
+}
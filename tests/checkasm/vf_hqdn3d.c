@@ -0,0 +1,101 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/vf_hqdn3d.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 64
+
+/* the SIMD versions are only called on multiples of 8 pixels */
+static const int widths[] = { 0, 8, 24, WIDTH };
+
+/* Like the tables of the filter, keep the filtered value between the
+ * current and the previous one: each coefficient is a random fraction of
+ * the difference nearest to zero in its bin. */
+static void init_coefs(int16_t *ct, int lut_bits)
+{
+    int i;
+
+    for (i = -256 << lut_bits; i < 256 << lut_bits; i++) {
+        const int low = i >= 0 ? i << (8 - lut_bits)
+                               : ((i + 1) << (8 - lut_bits)) - 1;
+        ct[(256 << lut_bits) + i] = av_clip_int16(low * (int)(rnd() % 17) / 16);
+    }
+    ct[512 << lut_bits] = rnd();
+}
+
+static void check_tmp_row(const HQDN3DContext *s, int depth)
+{
+    const int lut_bits = depth == 16 ? 8 : 4;
+    const int bytes    = depth == 8 ? 1 : 2;
+    LOCAL_ALIGNED_32(uint8_t,  src,      [WIDTH * 2]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_ref,  [WIDTH * 2]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_new,  [WIDTH * 2]);
+    LOCAL_ALIGNED_32(uint16_t, ant_ref,  [WIDTH]);
+    LOCAL_ALIGNED_32(uint16_t, ant_new,  [WIDTH]);
+    /* one spare entry, read by the gathers at the last index */
+    static int16_t coefs[(512 << 8) + 1];
+    int i, x;
+
+    declare_func(void, uint8_t *src, uint8_t *dst, uint16_t *frame_ant,
+                 ptrdiff_t w, int16_t *temporal);
+
+    if (!check_func(s->denoise_tmp_row[depth], "hqdn3d_tmp_row_%d", depth))
+        return;
+
+    init_coefs(coefs, lut_bits);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+        const int w = widths[i];
+
+        for (x = 0; x < WIDTH; x++) {
+            if (depth == 8)
+                src[x] = rnd();
+            else
+                AV_WN16A(src + 2 * x, rnd() & ((1 << depth) - 1));
+            ant_ref[x] = ant_new[x] = rnd();
+        }
+        memset(dst_ref, 0, WIDTH * bytes);
+        memset(dst_new, 0, WIDTH * bytes);
+
+        call_ref(src, dst_ref, ant_ref, w, coefs + (256 << lut_bits));
+        call_new(src, dst_new, ant_new, w, coefs + (256 << lut_bits));
+        if (memcmp(dst_ref, dst_new, WIDTH * bytes) ||
+            memcmp(ant_ref, ant_new, WIDTH * sizeof(*ant_ref)))
+            fail();
+    }
+    bench_new(src, dst_new, ant_new, WIDTH, coefs + (256 << lut_bits));
+}
+
+void checkasm_check_hqdn3d(void)
+{
+    static const int depths[] = { 8, 9, 10, 16 };
+    HQDN3DContext s = { 0 };
+    int i;
+
+    ff_hqdn3d_init(&s);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(depths); i++)
+        check_tmp_row(&s, depths[i]);
+    report("tmp_row");
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/lut.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 1024
+
+static const int widths[] = { 1, 15, 16, 33, 100, WIDTH };
+
+static void fill_lut(uint16_t *lut, int nb_entries, int max)
+{
+    int i;
+
+    /* one more entry than needed, the functions may read it */
+    for (i = 0; i <= nb_entries; i++)
+        lut[i] = rnd() % (max + 1);
+}
+
+static void check_lut_row8(const LutDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint8_t,  src,      [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_ref,  [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_new,  [WIDTH]);
+    LOCAL_ALIGNED_32(uint16_t, lut,      [256 + 1]);
+    int i, j, n0, n1;
+
+    declare_func(int, uint8_t *dst, const uint8_t *src, const uint16_t *lut, int width);
+
+    if (check_func(dsp->lut_row8, "lut_row8")) {
+        fill_lut(lut, 256, 255);
+        for (i = 0; i < WIDTH; i++)
+            src[i] = rnd();
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int w = widths[i];
+
+            memset(dst_ref, 0, WIDTH);
+            memset(dst_new, 0, WIDTH);
+            n0 = call_ref(dst_ref, src, lut, w);
+            n1 = call_new(dst_new, src, lut, w);
+            /* the samples not processed are left to the caller */
+            for (j = n1; j < w; j++)
+                dst_new[j] = lut[src[j]];
+            if (n1 > w || n0 != w || memcmp(dst_ref, dst_new, WIDTH))
+                fail();
+        }
+        bench_new(dst_new, src, lut, WIDTH);
+    }
+    report("lut_row8");
+}
+
+static void check_lut_row16(const LutDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,      [WIDTH]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref,  [WIDTH]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new,  [WIDTH]);
+    static uint16_t lut[65536 + 1];
+    static const int depths[] = { 9, 10, 12, 16 };
+    int d, i, j, n0, n1;
+
+    declare_func(int, uint16_t *dst, const uint16_t *src, const uint16_t *lut, int width);
+
+    if (check_func(dsp->lut_row16, "lut_row16")) {
+        for (d = 0; d < FF_ARRAY_ELEMS(depths); d++) {
+            const int max = (1 << depths[d]) - 1;
+
+            fill_lut(lut, max + 1, max);
+            for (i = 0; i < WIDTH; i++)
+                src[i] = rnd() & max;
+            for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+                const int w = widths[i];
+
+                memset(dst_ref, 0, WIDTH * sizeof(*dst_ref));
+                memset(dst_new, 0, WIDTH * sizeof(*dst_new));
+                n0 = call_ref(dst_ref, src, lut, w);
+                n1 = call_new(dst_new, src, lut, w);
+                for (j = n1; j < w; j++)
+                    dst_new[j] = lut[src[j]];
+                if (n1 > w || n0 != w || memcmp(dst_ref, dst_new, WIDTH * sizeof(*dst_ref)))
+                    fail();
+            }
+            if (depths[d] == 10 || depths[d] == 16)
+                bench_new(dst_new, src, lut, WIDTH);
+        }
+    }
+    report("lut_row16");
+}
+
+void checkasm_check_lut(void)
+{
+    LutDSPContext dsp;
+
+    ff_lut_init(&dsp);
+
+    check_lut_row8(&dsp);
+    check_lut_row16(&dsp);
+}
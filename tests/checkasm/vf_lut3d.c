@@ -0,0 +1,120 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/lut3d.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 256
+#define MAX_LEVEL 64
+
+static const int sizes[] = { 2, 17, 33, MAX_LEVEL };
+
+/* byte positions of r, g and b in RGBA, BGRA, ARGB and ABGR pixels */
+static const uint8_t layouts[][3] = {
+    { 0, 1, 2 }, { 2, 1, 0 }, { 1, 2, 3 }, { 3, 2, 1 },
+};
+
+static void init_tables(int16_t *lut, uint32_t *coord, uint32_t *params,
+                        int size, const uint8_t *layout)
+{
+    int i, v;
+
+    params[LUT3D_STRIDE_R] = size * size;
+    params[LUT3D_STRIDE_G] = size;
+    params[LUT3D_STRIDE_B] = 1;
+    params[LUT3D_ALPHA_MASK] = 0xffffffff;
+    for (i = 0; i < 3; i++) {
+        params[LUT3D_SHIFT_R + i] = 8 * layout[i];
+        params[LUT3D_ALPHA_MASK] &= ~(0xffU << (8 * layout[i]));
+    }
+
+    /* values slightly out of the output range, to test the clipping */
+    for (i = 0; i < size * size * size; i++) {
+        lut[4 * i    ] = (int)(rnd() % 18000) - 1000;
+        lut[4 * i + 1] = (int)(rnd() % 18000) - 1000;
+        lut[4 * i + 2] = (int)(rnd() % 18000) - 1000;
+        lut[4 * i + 3] = 0;
+    }
+
+    for (i = 0; i < 3; i++) {
+        for (v = 0; v < 256; v++) {
+            const int num  = v * (size - 1);
+            const int prev = num / 255;
+            const int frac = ((num - prev * 255) * LUT3D_COORD_NEXT + 127) / 255;
+            coord[256 * i + v] = frac | (prev < size - 1 ? LUT3D_COORD_NEXT : 0) |
+                                 (uint32_t)prev * params[LUT3D_STRIDE_R + i] << LUT3D_COORD_SHIFT;
+        }
+    }
+}
+
+static void check_interp_tetrahedral_row(void)
+{
+    LOCAL_ALIGNED_32(uint8_t,  src,     [WIDTH * 4]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_ref, [WIDTH * 4]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_new, [WIDTH * 4]);
+    LOCAL_ALIGNED_32(uint32_t, coord,   [3 * 256]);
+    LOCAL_ALIGNED_32(uint32_t, params,  [LUT3D_NB_PARAMS]);
+    static int16_t lut[MAX_LEVEL * MAX_LEVEL * MAX_LEVEL * 4];
+    static const int widths[] = { 1, 7, 8, 37, WIDTH };
+    LUT3DDSPContext dsp;
+    int i, j, k, n0, n1;
+
+    declare_func(int, uint8_t *dst, const uint8_t *src, int width,
+                 const int16_t *lut, const uint32_t *coord, const uint32_t *params);
+
+    ff_lut3d_init(&dsp);
+
+    if (check_func(dsp.interp_tetrahedral_row, "lut3d_interp_tetrahedral_row")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+            for (j = 0; j < FF_ARRAY_ELEMS(layouts); j++) {
+                init_tables(lut, coord, params, sizes[i], layouts[j]);
+                for (k = 0; k < WIDTH * 4; k++)
+                    src[k] = rnd();
+                /* the extreme values, without a next level */
+                src[0] = src[1] = src[2] = src[3] = 0xff;
+                src[4] = src[5] = src[6] = src[7] = 0;
+
+                for (k = 0; k < FF_ARRAY_ELEMS(widths); k++) {
+                    const int w = widths[k];
+
+                    memset(dst_ref, 0, WIDTH * 4);
+                    memset(dst_new, 0, WIDTH * 4);
+                    n0 = call_ref(dst_ref, src, w, lut, coord, params);
+                    n1 = call_new(dst_new, src, w, lut, coord, params);
+                    /* the pixels not processed are left to the caller */
+                    if (n1 < w)
+                        call_ref(dst_new + 4 * n1, src + 4 * n1, w - n1, lut, coord, params);
+                    if (n1 > w || n0 != w || memcmp(dst_ref, dst_new, WIDTH * 4))
+                        fail();
+                }
+                if (sizes[i] == 33 && !j)
+                    bench_new(dst_new, src, WIDTH, lut, coord, params);
+            }
+        }
+    }
+    report("interp_tetrahedral_row");
+}
+
+void checkasm_check_lut3d(void)
+{
+    check_interp_tetrahedral_row();
+}
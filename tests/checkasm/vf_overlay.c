@@ -0,0 +1,85 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/vf_overlay.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 256
+#define ALINESIZE (2 * WIDTH)
+
+#define randomize_buffers(buf, size)       \
+    do {                                   \
+        int j;                             \
+        for (j = 0; j < size; j += 4)      \
+            AV_WN32(buf + j, rnd());       \
+    } while (0)
+
+static void check_overlay_row(int plane, const char *name)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst0, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, orig, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, src,  [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, alpha, [2 * ALINESIZE]);
+    OverlayContext s;
+    /* odd widths exercise the scalar tail in the caller, widths below the
+     * SIMD block size must not be written at all */
+    static const int widths[] = { WIDTH, WIDTH - 1, 33, 17 };
+    int i, w, ret0, ret1;
+
+    declare_func(int, uint8_t *d, const uint8_t *s, const uint8_t *a,
+                 int w, ptrdiff_t alinesize);
+
+    memset(&s, 0, sizeof(s));
+    ff_overlay_init(&s, OVERLAY_FORMAT_YUV420, 0);
+
+    if (check_func(s.blend_row[plane], "overlay_row_%s", name)) {
+        for (i = 0; i < FF_ARRAY_ELEMS(widths) + 32; i++) {
+            w = i < FF_ARRAY_ELEMS(widths) ? widths[i] : i - FF_ARRAY_ELEMS(widths);
+            randomize_buffers(orig, WIDTH);
+            randomize_buffers(src, WIDTH);
+            randomize_buffers(alpha, 2 * ALINESIZE);
+            /* make sure the fully transparent and opaque cases are hit */
+            alpha[0] = alpha[1] = alpha[ALINESIZE] = alpha[ALINESIZE + 1] = 0;
+            alpha[2] = alpha[3] = alpha[ALINESIZE + 2] = alpha[ALINESIZE + 3] = 255;
+            memcpy(dst0, orig, WIDTH);
+            memcpy(dst1, orig, WIDTH);
+
+            ret0 = call_ref(dst0, src, alpha, w, ALINESIZE);
+            ret1 = call_new(dst1, src, alpha, w, ALINESIZE);
+            /* the reference may be a SIMD version leaving a tail too */
+            if (ret0 < 0 || ret0 > w || ret1 < 0 || ret1 > w ||
+                memcmp(dst0, dst1, FFMIN(ret0, ret1)) ||
+                memcmp(dst1 + ret1, orig + ret1, WIDTH - ret1))
+                fail();
+        }
+        bench_new(dst1, src, alpha, WIDTH, ALINESIZE);
+    }
+}
+
+void checkasm_check_overlay(void)
+{
+    check_overlay_row(0, "44");
+    report("overlay_row_44");
+
+    check_overlay_row(1, "20");
+    report("overlay_row_20");
+}
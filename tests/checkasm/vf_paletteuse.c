@@ -0,0 +1,88 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/paletteuse.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define MAX_ENTRIES 256
+
+static const int nb_colors[] = { 1, 7, 16, 32, 100, 255, 256 };
+
+static void pack_palette(int16_t *rg, int16_t *b, int nb, int nb_entries, int few_values)
+{
+    int i;
+
+    for (i = 0; i < nb; i++) {
+        /* few distinct values to get ties */
+        const int mask = few_values ? 0xc0 : 0xff;
+        rg[2*i    ] = rnd() & mask;
+        rg[2*i + 1] = rnd() & mask;
+        b [2*i    ] = rnd() & mask;
+        b [2*i + 1] = 0;
+    }
+    for (; i < nb_entries; i++) {
+        rg[2*i] = rg[2*i + 1] = b[2*i] = PALETTEUSE_PACKED_PAD;
+        b[2*i + 1] = 0;
+    }
+}
+
+static void check_nearest_color(void)
+{
+    LOCAL_ALIGNED_32(int16_t, rg, [2 * MAX_ENTRIES]);
+    LOCAL_ALIGNED_32(int16_t, b,  [2 * MAX_ENTRIES]);
+    PaletteUseDSPContext dsp;
+    int i, j, k, r0, r1;
+
+    declare_func(int, const int16_t *rg, const int16_t *b, int nb_entries,
+                 uint32_t color);
+
+    ff_paletteuse_init(&dsp);
+
+    if (check_func(dsp.nearest_color, "paletteuse_nearest_color")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(nb_colors); i++) {
+            const int nb_entries = FFALIGN(nb_colors[i], PALETTEUSE_PACKED_ALIGN);
+
+            for (j = 0; j < 2; j++) {
+                pack_palette(rg, b, nb_colors[i], nb_entries, j);
+                for (k = 0; k < 64; k++) {
+                    /* the top byte must be ignored */
+                    const uint32_t color = rnd();
+
+                    r0 = call_ref(rg, b, nb_entries, color);
+                    r1 = call_new(rg, b, nb_entries, color);
+                    if (r0 != r1) {
+                        fail();
+                        break;
+                    }
+                }
+            }
+            if (nb_colors[i] == 16 || nb_colors[i] == 256)
+                bench_new(rg, b, nb_entries, 0x804020);
+        }
+    }
+    report("nearest_color");
+}
+
+void checkasm_check_paletteuse(void)
+{
+    check_nearest_color();
+}
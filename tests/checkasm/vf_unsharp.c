@@ -0,0 +1,122 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/unsharp.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define MAX_WIDTH 3840
+#define MAX_STEPS 11
+/* row sums plus the state rows, padded like the filter does */
+#define STRIDE (MAX_WIDTH + 2 * MAX_STEPS + 8)
+
+static const int widths[] = { 1920, 3840 };
+
+static void check_vblur_row(UnsharpContext *s)
+{
+    uint32_t *sc0  = av_malloc(2 * MAX_STEPS * STRIDE * sizeof(*sc0));
+    uint32_t *sc1  = av_malloc(2 * MAX_STEPS * STRIDE * sizeof(*sc1));
+    uint32_t *row0 = av_malloc(STRIDE * sizeof(*row0));
+    uint32_t *row1 = av_malloc(STRIDE * sizeof(*row1));
+    static const int steps[] = { 1, 2, 5, 11 };
+    int i, j, k;
+
+    declare_func(void, uint32_t *sc, ptrdiff_t sc_stride, uint32_t *row,
+                 int steps, int width);
+
+    if (check_func(s->vblur_row, "unsharp_vblur_row")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(steps); i++) {
+            for (j = 0; j < FF_ARRAY_ELEMS(widths); j++) {
+                int w = widths[j] + 2 * steps[i] - 1;
+
+                for (k = 0; k < 2 * MAX_STEPS * STRIDE; k++)
+                    sc0[k] = sc1[k] = rnd();
+                for (k = 0; k < STRIDE; k++)
+                    row0[k] = row1[k] = rnd() & 0xffffff;
+
+                call_ref(sc0, STRIDE, row0, steps[i], w);
+                call_new(sc1, STRIDE, row1, steps[i], w);
+                for (k = 0; k < 2 * steps[i]; k++)
+                    if (memcmp(sc0 + k * STRIDE, sc1 + k * STRIDE, w * sizeof(*sc0)))
+                        fail();
+                if (memcmp(row0, row1, w * sizeof(*row0)))
+                    fail();
+                if (i == 1)
+                    bench_new(sc1, STRIDE, row1, steps[i], w);
+            }
+        }
+    }
+    report("vblur_row");
+
+    av_freep(&sc0);
+    av_freep(&sc1);
+    av_freep(&row0);
+    av_freep(&row1);
+}
+
+static void check_sharpen_row(UnsharpContext *s)
+{
+    LOCAL_ALIGNED_32(uint8_t,  src,  [MAX_WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t,  dst0, [MAX_WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t,  dst1, [MAX_WIDTH]);
+    LOCAL_ALIGNED_32(uint32_t, blur, [MAX_WIDTH]);
+    /* luma_amount range of the filter is -2..5 */
+    static const int amounts[] = { -2 * 65536, -98304, -1, 1, 32768, 65536, 98304, 5 * 65536 };
+    static const int scalebits[] = { 4, 12, 24 };
+    int i, j, k, n0, n1;
+
+    declare_func(int, uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                 int width, int amount, int scalebits, int32_t halfscale);
+
+    if (check_func(s->sharpen_row, "unsharp_sharpen_row")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(amounts); i++) {
+            for (j = 0; j < FF_ARRAY_ELEMS(scalebits); j++) {
+                int sb = scalebits[j];
+
+                for (k = 0; k < MAX_WIDTH; k++) {
+                    src[k]  = rnd();
+                    blur[k] = ((uint32_t)(rnd() & 0xff) << sb) + (rnd() & ((1U << sb) - 1));
+                }
+                memset(dst0, 0, MAX_WIDTH);
+                memset(dst1, 0, MAX_WIDTH);
+
+                n0 = call_ref(dst0, src, blur, MAX_WIDTH - 3, amounts[i], sb, 1 << (sb - 1));
+                n1 = call_new(dst1, src, blur, MAX_WIDTH - 3, amounts[i], sb, 1 << (sb - 1));
+                if (n1 < 0 || n1 > n0 || memcmp(dst0, dst1, n1) ||
+                    dst1[n1] || dst1[MAX_WIDTH - 3])
+                    fail();
+            }
+        }
+        for (j = 0; j < FF_ARRAY_ELEMS(widths); j++)
+            bench_new(dst1, src, blur, widths[j], 65536, 8, 128);
+    }
+    report("sharpen_row");
+}
+
+void checkasm_check_unsharp(void)
+{
+    UnsharpContext s;
+
+    memset(&s, 0, sizeof(s));
+    ff_unsharp_init(&s);
+
+    check_vblur_row(&s);
+    check_sharpen_row(&s);
+}
@@ -25,6 +25,16 @@ fate-ffmpeg-filter_colorkey: CMD = framecrc -idct simple -fflags +bitexact -flag
 FATE_FFMPEG-$(CONFIG_COLOR_FILTER) += fate-ffmpeg-lavfi
 fate-ffmpeg-lavfi: CMD = framecrc -lavfi color=d=1:r=5 -fflags +bitexact
 
+# frames of 4096 samples and a partial last frame
+FATE_FFMPEG-$(call FILTERDEMDECENCMUX, ANULL, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-ffmpeg-filter_audio_frame_size
+fate-ffmpeg-filter_audio_frame_size: tests/data/asynth-44100-2.wav
+fate-ffmpeg-filter_audio_frame_size: CMD = framecrc -filter_audio_frame_size 4096 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af anull
+
+# dynaudnorm sets the framing of its input, which must be kept
+FATE_FFMPEG-$(call FILTERDEMDECENCMUX, DYNAUDNORM, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-ffmpeg-filter_audio_frame_size-min_samples
+fate-ffmpeg-filter_audio_frame_size-min_samples: tests/data/asynth-44100-2.wav
+fate-ffmpeg-filter_audio_frame_size-min_samples: CMD = framecrc -filter_audio_frame_size 4096 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af dynaudnorm
+
 FATE_SAMPLES_FFMPEG-$(CONFIG_RAWVIDEO_DEMUXER) += fate-force_key_frames
 fate-force_key_frames: tests/data/vsynth_lena.yuv
 fate-force_key_frames: CMD = enc_dec \
@@ -114,6 +114,17 @@ fate-filter-extrastereo: tests/data/asynth-44100-2.wav
 fate-filter-extrastereo: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
 fate-filter-extrastereo: CMD = framecrc -i $(SRC) -aframes 20 -af extrastereo=m=2
 
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, FIREQUALIZER, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-firequalizer
+fate-filter-firequalizer: tests/data/asynth-44100-2.wav
+fate-filter-firequalizer: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-firequalizer: CMD = framecrc -i $(SRC) -af "firequalizer=gain=if(lt(f\,1000)\,0\,-20)"
+
+# a delay long enough for a 64k rdft, convolved by partitions
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, FIREQUALIZER, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-firequalizer-partitioned
+fate-filter-firequalizer-partitioned: tests/data/asynth-44100-2.wav
+fate-filter-firequalizer-partitioned: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-firequalizer-partitioned: CMD = framecrc -i $(SRC) -af "firequalizer=delay=0.4:gain=if(lt(f\,1000)\,0\,-20)"
+
 FATE_AFILTER_SAMPLES-$(call FILTERDEMDECENCMUX, SILENCEREMOVE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-silenceremove
 fate-filter-silenceremove: SRC = $(TARGET_SAMPLES)/audio-reference/divertimenti_2ch_96kHz_s24.wav
 fate-filter-silenceremove: CMD = framecrc -i $(SRC) -aframes 30 -af silenceremove=0:0:0:-1:0:-90dB
@@ -58,6 +58,23 @@ fate-filter-paletteuse-sierra2_4a: CMD = framecrc -i $(TARGET_SAMPLES)/filter/an
 fate-filter-paletteuse: $(FATE_FILTER_PALETTEUSE)
 FATE_FILTER_SAMPLES-$(call ALLYES, PALETTEUSE_FILTER MATROSKA_DEMUXER H264_DECODER IMAGE2_DEMUXER PNG_DECODER) += $(FATE_FILTER_PALETTEUSE)
 
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER PALETTEGEN_FILTER PALETTEUSE_FILTER) += fate-filter-paletteuse-small
+fate-filter-paletteuse-small: CMD = framecrc -lavfi "testsrc2=s=160x120:r=5:d=2,split[a][b];[a]palettegen=max_colors=16[p];[b][p]paletteuse=none" -pix_fmt bgra
+
+# the brute-force search must find the same colors as the k-d tree
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER PALETTEGEN_FILTER PALETTEUSE_FILTER) += fate-filter-paletteuse-small-bruteforce
+fate-filter-paletteuse-small-bruteforce: CMD = framecrc -lavfi "testsrc2=s=160x120:r=5:d=2,split[a][b];[a]palettegen=max_colors=16[p];[b][p]paletteuse=none:color_search=bruteforce" -pix_fmt bgra
+fate-filter-paletteuse-small-bruteforce: REF = $(SRC_PATH)/tests/ref/fate/filter-paletteuse-small
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SPLIT_FILTER HFLIP_FILTER LUT_FILTER) += fate-filter-framepool
+fate-filter-framepool: libavfilter/tests/framepool$(EXESUF)
+fate-filter-framepool: CMD = run libavfilter/tests/framepool
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SPLIT_FILTER LUT_FILTER LUTRGB_FILTER HFLIP_FILTER CURVES_FILTER COLORLEVELS_FILTER COLORBALANCE_FILTER COLORCHANNELMIXER_FILTER TRANSPOSE_FILTER HSTACK_FILTER) += fate-filter-framethreads
+fate-filter-framethreads: libavfilter/tests/framethreads$(EXESUF)
+fate-filter-framethreads: CMD = run libavfilter/tests/framethreads
+fate-filter-framethreads: REF = /dev/null
+
 FATE_FILTER-$(call ALLYES, AVDEVICE LIFE_FILTER) += fate-filter-lavd-life
 fate-filter-lavd-life: CMD = framecrc -f lavfi -i life=s=40x40:r=5:seed=42:mold=64:ratio=0.1:death_color=red:life_color=green -t 2
 
@@ -393,6 +410,16 @@ FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scalechroma
 fate-filter-scalechroma: tests/data/vsynth1.yuv
 fate-filter-scalechroma: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv444p -i tests/data/vsynth1.yuv -pix_fmt yuv420p -sws_flags +bitexact -vf scale=out_v_chr_pos=33:out_h_chr_pos=151
 
+# the unscaled yuv2rgb converters, used without accurate_rnd, are only
+# bitexact in C
+FATE_FILTER_VSYNTH-$(call ALLYES, FORMAT_FILTER SCALE_FILTER) += fate-filter-scale-nv12-rgb24
+fate-filter-scale-nv12-rgb24: tests/data/vsynth1.yuv
+fate-filter-scale-nv12-rgb24: CMD = framecrc -cpuflags 0 -flags bitexact -s 352x288 -pix_fmt yuv420p -i tests/data/vsynth1.yuv -vf format=nv12 -pix_fmt rgb24 -sws_flags +bitexact
+
+FATE_FILTER_VSYNTH-$(call ALLYES, FORMAT_FILTER SCALE_FILTER) += fate-filter-scale-nv21-rgb565
+fate-filter-scale-nv21-rgb565: tests/data/vsynth1.yuv
+fate-filter-scale-nv21-rgb565: CMD = framecrc -cpuflags 0 -flags bitexact -s 352x288 -pix_fmt yuv420p -i tests/data/vsynth1.yuv -vf format=nv21 -pix_fmt rgb565le -sws_flags +bitexact
+
 FATE_FILTER_VSYNTH-$(CONFIG_VFLIP_FILTER) += fate-filter-vflip
 fate-filter-vflip: CMD = video_filter "vflip"
 
@@ -627,6 +654,10 @@ FATE_METADATA_FILTER-$(call ALLYES, $(SCENEDETECT_DEPS)) += fate-filter-metadata
 fate-filter-metadata-scenedetect: SRC = $(TARGET_SAMPLES)/svq3/Vertical400kbit.sorenson3.mov
 fate-filter-metadata-scenedetect: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;movie='$(SRC)',select=gt(scene\,.4)"
 
+SCENEDETECT_LUMA_DEPS = FFPROBE LAVFI_INDEV TESTSRC_FILTER SMPTEBARS_FILTER CONCAT_FILTER SCENEDETECT_FILTER
+FATE_METADATA_FILTER_LAVFI-$(call ALLYES, $(SCENEDETECT_LUMA_DEPS)) += fate-filter-metadata-scenedetect-luma
+fate-filter-metadata-scenedetect-luma: CMD = run $(FILTER_METADATA_COMMAND) "testsrc=s=320x240:r=5:d=1[a];smptebars=s=320x240:r=5:d=1[b];[a][b]concat,scenedetect=threshold=.4"
+
 CROPDETECT_DEPS = FFPROBE LAVFI_INDEV MOVIE_FILTER CROPDETECT_FILTER SCALE_FILTER \
                   AVCODEC AVDEVICE MOV_DEMUXER H264_DECODER
 FATE_METADATA_FILTER-$(call ALLYES, $(CROPDETECT_DEPS)) += fate-filter-metadata-cropdetect
@@ -663,9 +694,10 @@ fate-filter-meta-4560-rotate0: tests/data/file4560-override2rotate0.mov
 fate-filter-meta-4560-rotate0: CMD = framecrc -flags +bitexact -c:a aac_fixed -i $(TARGET_PATH)/tests/data/file4560-override2rotate0.mov
 
 FATE_SAMPLES_FFPROBE += $(FATE_METADATA_FILTER-yes)
+FATE_FFPROBE += $(FATE_METADATA_FILTER_LAVFI-yes)
 FATE_SAMPLES_FFMPEG += $(FATE_FILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_FILTER-yes)
 
 fate-vfilter: $(FATE_FILTER-yes) $(FATE_FILTER_SAMPLES-yes) $(FATE_FILTER_VSYNTH-yes)
 
-fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes)
+fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes) $(FATE_METADATA_FILTER_LAVFI-yes)
@@ -0,0 +1,12 @@
+FATE_LIBSWSCALE += fate-sws-context-cache
+fate-sws-context-cache: libswscale/tests/context_cache$(EXESUF)
+fate-sws-context-cache: CMD = run libswscale/tests/context_cache
+fate-sws-context-cache: REF = /dev/null
+
+FATE_LIBSWSCALE += fate-sws-threads
+fate-sws-threads: libswscale/tests/threads$(EXESUF)
+fate-sws-threads: CMD = run libswscale/tests/threads
+fate-sws-threads: REF = /dev/null
+
+FATE-$(CONFIG_SWSCALE) += $(FATE_LIBSWSCALE)
+fate-libswscale: $(FATE_LIBSWSCALE)